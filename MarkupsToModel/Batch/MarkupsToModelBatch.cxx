@@ -0,0 +1,530 @@
+/*==============================================================================
+
+  Program: 3D Slicer
+
+  Portions (c) Copyright Brigham and Women's Hospital (BWH) All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+  ==============================================================================*/
+
+// Generates models from markups files (.mrk.json, .fcsv) without starting the application.
+// Input files are read one after the other, models are generated and written in parallel (see PrintUsage).
+
+// MarkupsToModel includes
+#include "vtkMRMLMarkupsToModelNode.h"
+#include "vtkSlicerMarkupsToModelClosedSurfaceGeneration.h"
+#include "vtkSlicerMarkupsToModelLogic.h"
+#include "vtkSlicerMarkupsToModelSessionRecorder.h"
+
+// MRML includes
+#include "vtkMRMLMarkupsAngleNode.h"
+#include "vtkMRMLMarkupsClosedCurveNode.h"
+#include "vtkMRMLMarkupsCurveNode.h"
+#include "vtkMRMLMarkupsFiducialNode.h"
+#include "vtkMRMLMarkupsFiducialStorageNode.h"
+#include "vtkMRMLMarkupsJsonStorageNode.h"
+#include "vtkMRMLMarkupsLineNode.h"
+#include <vtkMRMLStorageNode.h>
+#include <vtkMRMLScene.h>
+
+// VTK includes
+#include <vtkCurveGenerator.h>
+#include <vtkPLYWriter.h>
+#include <vtkPoints.h>
+#include <vtkPolyData.h>
+#include <vtkSMPTools.h>
+#include <vtkSmartPointer.h>
+#include <vtkSTLWriter.h>
+#include <vtkXMLDataElement.h>
+#include <vtkXMLDataParser.h>
+#include <vtkXMLPolyDataWriter.h>
+#include <vtksys/Directory.hxx>
+#include <vtksys/SystemTools.hxx>
+
+// STD includes
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+//------------------------------------------------------------------------------
+// constants within this file
+static const char* FCSV_EXTENSION = ".fcsv";
+static const char* MARKUPS_JSON_EXTENSION = ".mrk.json";
+
+enum OutputFormat
+{
+  VtpOutputFormat = 0,
+  StlOutputFormat,
+  PlyOutputFormat,
+  OutputFormat_Last // insert valid types above this line
+};
+
+static const char* OUTPUT_FORMAT_EXTENSIONS[ OutputFormat_Last ] = { ".vtp", ".stl", ".ply" };
+
+//------------------------------------------------------------------------------
+struct ConversionTask
+{
+  ConversionTask()
+    : Success( false )
+  {
+  }
+
+  std::string InputFileName;
+  std::string OutputFileName;
+  vtkSmartPointer< vtkPoints > ControlPoints;
+  bool Success;
+};
+
+//------------------------------------------------------------------------------
+// Functor for vtkSMPTools, generates and writes the output models of a range of tasks.
+// Each task has its own generators and output, the parameter node is only read.
+class vtkConversionWorker
+{
+public:
+  ConversionTask* Tasks;
+  vtkMRMLMarkupsToModelNode* ParameterNode;
+  int Format;
+
+  void operator()( vtkIdType beginTaskIndex, vtkIdType endTaskIndex ) const
+  {
+    for ( vtkIdType taskIndex = beginTaskIndex; taskIndex < endTaskIndex; taskIndex++ )
+    {
+      ConversionTask& task = this->Tasks[ taskIndex ];
+      vtkSmartPointer< vtkPolyData > outputPolyData = vtkSmartPointer< vtkPolyData >::New();
+      vtkSmartPointer< vtkSlicerMarkupsToModelClosedSurfaceGeneration > closedSurfaceGenerator = vtkSmartPointer< vtkSlicerMarkupsToModelClosedSurfaceGeneration >::New();
+      vtkSmartPointer< vtkCurveGenerator > curveGenerator = vtkSmartPointer< vtkCurveGenerator >::New();
+      double outputCurveLength = 0.0;
+      if ( !vtkSlicerMarkupsToModelLogic::GenerateOutputModel( this->ParameterNode, task.ControlPoints, outputPolyData,
+        closedSurfaceGenerator, curveGenerator, NULL, outputCurveLength ) )
+      {
+        vtkGenericWarningMacro( "Failed to generate model from " << task.InputFileName );
+        continue;
+      }
+      task.Success = WriteModel( outputPolyData, task.OutputFileName, this->Format );
+      if ( !task.Success )
+      {
+        vtkGenericWarningMacro( "Failed to write model to " << task.OutputFileName );
+      }
+    }
+  }
+
+  static bool WriteModel( vtkPolyData* polyData, const std::string& fileName, int format )
+  {
+    switch ( format )
+    {
+    case StlOutputFormat:
+      {
+        vtkSmartPointer< vtkSTLWriter > writer = vtkSmartPointer< vtkSTLWriter >::New();
+        writer->SetInputData( polyData );
+        writer->SetFileName( fileName.c_str() );
+        writer->SetFileTypeToBinary();
+        return writer->Write() != 0;
+      }
+    case PlyOutputFormat:
+      {
+        vtkSmartPointer< vtkPLYWriter > writer = vtkSmartPointer< vtkPLYWriter >::New();
+        writer->SetInputData( polyData );
+        writer->SetFileName( fileName.c_str() );
+        writer->SetFileTypeToBinary();
+        return writer->Write() != 0;
+      }
+    default:
+      {
+        vtkSmartPointer< vtkXMLPolyDataWriter > writer = vtkSmartPointer< vtkXMLPolyDataWriter >::New();
+        writer->SetInputData( polyData );
+        writer->SetFileName( fileName.c_str() );
+        writer->SetDataModeToBinary();
+        return writer->Write() != 0;
+      }
+    }
+  }
+};
+
+//------------------------------------------------------------------------------
+static void PrintUsage()
+{
+  std::cerr << "Usage: MarkupsToModelBatch [options] <markups file or directory> ..." << std::endl
+    << "Generates a model from each .mrk.json and .fcsv file (directories are searched for these files, not recursively)." << std::endl
+    << "Files that would be written to the same output file (e.g., a.fcsv and a.mrk.json) are not converted." << std::endl
+    << "Options:" << std::endl
+    << "  --output-dir <directory>   directory of the output models (default: directory of each input file)" << std::endl
+    << "  --format vtp|stl|ply       output file format (default: vtp)" << std::endl
+    << "  --parameters <file>        scene (.mrml) file with a MarkupsToModel parameter node, its parameters are used" << std::endl
+    << "  --parameter <name>=<value> parameter in the same form as in scene files (e.g., modelType=curve, tubeRadius=2.5)," << std::endl
+    << "                             applied after the parameters file, can be repeated" << std::endl
+    << "  --threads <number>         number of threads (default: all cores)" << std::endl;
+}
+
+//------------------------------------------------------------------------------
+static bool EndsWith( const std::string& text, const char* suffix )
+{
+  std::string lowerCaseText = vtksys::SystemTools::LowerCase( text );
+  std::string suffixString = suffix;
+  return lowerCaseText.size() >= suffixString.size()
+    && lowerCaseText.compare( lowerCaseText.size() - suffixString.size(), suffixString.size(), suffixString ) == 0;
+}
+
+//------------------------------------------------------------------------------
+static bool IsMarkupsFile( const std::string& fileName )
+{
+  return EndsWith( fileName, FCSV_EXTENSION ) || EndsWith( fileName, MARKUPS_JSON_EXTENSION );
+}
+
+//------------------------------------------------------------------------------
+// First element with the given name in the element and its nested elements (depth-first), NULL if none
+static vtkXMLDataElement* FindElementWithName( vtkXMLDataElement* element, const char* name )
+{
+  if ( element == NULL )
+  {
+    return NULL;
+  }
+  if ( element->GetName() != NULL && strcmp( element->GetName(), name ) == 0 )
+  {
+    return element;
+  }
+  for ( int nestedElementIndex = 0; nestedElementIndex < element->GetNumberOfNestedElements(); nestedElementIndex++ )
+  {
+    vtkXMLDataElement* foundElement = FindElementWithName( element->GetNestedElement( nestedElementIndex ), name );
+    if ( foundElement != NULL )
+    {
+      return foundElement;
+    }
+  }
+  return NULL;
+}
+
+//------------------------------------------------------------------------------
+// Get the parameters of the first MarkupsToModel node in a scene file as XML attributes.
+// The file is parsed as XML, so entities in attribute values are replaced and malformed files are rejected.
+static bool ReadParametersFile( const std::string& fileName, std::string& parameters )
+{
+  if ( !vtksys::SystemTools::FileExists( fileName ) )
+  {
+    std::cerr << "Cannot read parameters file " << fileName << std::endl;
+    return false;
+  }
+  vtkSmartPointer< vtkXMLDataParser > parser = vtkSmartPointer< vtkXMLDataParser >::New();
+  parser->SetFileName( fileName.c_str() );
+  if ( !parser->Parse() )
+  {
+    std::cerr << "Parameters file " << fileName << " is not a valid XML file" << std::endl;
+    return false;
+  }
+  vtkXMLDataElement* parameterElement = FindElementWithName( parser->GetRootElement(), "MarkupsToModel" );
+  if ( parameterElement == NULL )
+  {
+    std::cerr << "No MarkupsToModel parameter node is found in " << fileName << std::endl;
+    return false;
+  }
+  std::ostringstream attributes;
+  for ( int attributeIndex = 0; attributeIndex < parameterElement->GetNumberOfAttributes(); attributeIndex++ )
+  {
+    std::string value = parameterElement->GetAttributeValue( attributeIndex );
+    if ( value.find( '"' ) != std::string::npos )
+    {
+      // cannot be represented in the parameters string (and no parameter value contains quotes)
+      std::cerr << "Invalid value of attribute " << parameterElement->GetAttributeName( attributeIndex )
+        << " in parameters file " << fileName << std::endl;
+      return false;
+    }
+    attributes << ( attributeIndex > 0 ? " " : "" ) << parameterElement->GetAttributeName( attributeIndex ) << "=\"" << value << "\"";
+  }
+  parameters = attributes.str();
+  return true;
+}
+
+//------------------------------------------------------------------------------
+// Output file of an input file: the input file name with the extension of the output format
+static std::string GetOutputFileName( const std::string& inputFileName, const std::string& outputDirectory, int format )
+{
+  std::string fileName = vtksys::SystemTools::GetFilenameName( inputFileName );
+  fileName = fileName.substr( 0, fileName.size() - ( EndsWith( fileName, FCSV_EXTENSION ) ? strlen( FCSV_EXTENSION ) : strlen( MARKUPS_JSON_EXTENSION ) ) );
+  std::string directory = ( outputDirectory.empty() ? vtksys::SystemTools::GetFilenamePath( inputFileName ) : outputDirectory );
+  return directory + "/" + fileName + OUTPUT_FORMAT_EXTENSIONS[ format ];
+}
+
+//------------------------------------------------------------------------------
+// Markups node classes that the input files are read into. The scene does not register them without the markups module.
+static void RegisterMarkupsNodeClasses( vtkMRMLScene* scene )
+{
+  scene->RegisterNodeClass( vtkSmartPointer< vtkMRMLMarkupsFiducialNode >::New() );
+  scene->RegisterNodeClass( vtkSmartPointer< vtkMRMLMarkupsLineNode >::New() );
+  scene->RegisterNodeClass( vtkSmartPointer< vtkMRMLMarkupsAngleNode >::New() );
+  scene->RegisterNodeClass( vtkSmartPointer< vtkMRMLMarkupsCurveNode >::New() );
+  scene->RegisterNodeClass( vtkSmartPointer< vtkMRMLMarkupsClosedCurveNode >::New() );
+}
+
+//------------------------------------------------------------------------------
+// Read the control points of a markups file. MRML nodes are not thread-safe, so this is called on the main thread.
+// The markups node class is the one that the file was saved from (e.g., curve), .fcsv files always contain fiducials.
+static bool ReadControlPoints( vtkMRMLScene* scene, const std::string& fileName, vtkPoints* controlPoints )
+{
+  vtkSmartPointer< vtkMRMLStorageNode > storageNode;
+  std::string markupsClassName = "vtkMRMLMarkupsFiducialNode";
+  if ( EndsWith( fileName, FCSV_EXTENSION ) )
+  {
+    storageNode = vtkSmartPointer< vtkMRMLMarkupsFiducialStorageNode >::New();
+    scene->AddNode( storageNode );
+  }
+  else
+  {
+    vtkSmartPointer< vtkMRMLMarkupsJsonStorageNode > jsonStorageNode = vtkSmartPointer< vtkMRMLMarkupsJsonStorageNode >::New();
+    storageNode = jsonStorageNode;
+    scene->AddNode( storageNode );
+    std::vector< std::string > markupsClassNames = jsonStorageNode->GetMarkupsClassNamesForFile( fileName.c_str() );
+    if ( markupsClassNames.empty() )
+    {
+      std::cerr << "No markups are found in " << fileName << std::endl;
+      scene->RemoveNode( storageNode );
+      return false;
+    }
+    if ( markupsClassNames.size() > 1 )
+    {
+      std::cerr << "Warning: " << fileName << " contains " << markupsClassNames.size() << " markups, only the first one is used" << std::endl;
+    }
+    markupsClassName = markupsClassNames[ 0 ];
+  }
+  vtkMRMLMarkupsNode* markupsNode = vtkMRMLMarkupsNode::SafeDownCast( scene->AddNewNodeByClass( markupsClassName.c_str() ) );
+  if ( markupsNode == NULL )
+  {
+    std::cerr << "Markups type " << markupsClassName << " of " << fileName << " is not supported" << std::endl;
+    scene->RemoveNode( storageNode );
+    return false;
+  }
+  storageNode->SetFileName( fileName.c_str() );
+  bool success = ( storageNode->ReadData( markupsNode ) != 0 );
+  if ( success )
+  {
+    vtkSlicerMarkupsToModelLogic::MarkupsToPoints( markupsNode, controlPoints );
+  }
+  scene->RemoveNode( storageNode );
+  scene->RemoveNode( markupsNode );
+  return success;
+}
+
+//------------------------------------------------------------------------------
+int main( int argc, char* argv[] )
+{
+  std::string outputDirectory;
+  int format = VtpOutputFormat;
+  std::string parametersFileName;
+  std::vector< std::string > parameterArguments;
+  int numberOfThreads = 0;
+  std::vector< std::string > inputs;
+  for ( int argIndex = 1; argIndex < argc; argIndex++ )
+  {
+    std::string arg = argv[ argIndex ];
+    if ( arg == "--help" || arg == "-h" )
+    {
+      PrintUsage();
+      return EXIT_SUCCESS;
+    }
+    if ( arg.compare( 0, 2, "--" ) != 0 )
+    {
+      inputs.push_back( arg );
+      continue;
+    }
+    if ( argIndex + 1 >= argc )
+    {
+      std::cerr << "Missing value of argument " << arg << std::endl;
+      return EXIT_FAILURE;
+    }
+    std::string value = argv[ ++argIndex ];
+    if ( arg == "--output-dir" )
+    {
+      outputDirectory = value;
+    }
+    else if ( arg == "--format" )
+    {
+      std::string extension = "." + vtksys::SystemTools::LowerCase( value );
+      format = std::find( OUTPUT_FORMAT_EXTENSIONS, OUTPUT_FORMAT_EXTENSIONS + OutputFormat_Last, extension ) - OUTPUT_FORMAT_EXTENSIONS;
+      if ( format == OutputFormat_Last )
+      {
+        std::cerr << "Unknown output format " << value << std::endl;
+        return EXIT_FAILURE;
+      }
+    }
+    else if ( arg == "--parameters" )
+    {
+      parametersFileName = value;
+    }
+    else if ( arg == "--parameter" )
+    {
+      size_t separator = value.find( '=' );
+      if ( separator == std::string::npos || separator == 0 )
+      {
+        std::cerr << "Invalid parameter " << value << ", expected <name>=<value>" << std::endl;
+        return EXIT_FAILURE;
+      }
+      parameterArguments.push_back( value.substr( 0, separator ) + "=\"" + value.substr( separator + 1 ) + "\"" );
+    }
+    else if ( arg == "--threads" )
+    {
+      numberOfThreads = std::atoi( value.c_str() );
+    }
+    else
+    {
+      std::cerr << "Unknown argument " << arg << std::endl;
+      PrintUsage();
+      return EXIT_FAILURE;
+    }
+  }
+  if ( inputs.empty() )
+  {
+    PrintUsage();
+    return EXIT_FAILURE;
+  }
+
+  std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+
+  // Parameters: defaults of the parameter node, then the parameters file, then the parameter arguments
+  vtkSmartPointer< vtkMRMLMarkupsToModelNode > parameterNode = vtkSmartPointer< vtkMRMLMarkupsToModelNode >::New();
+  if ( !parametersFileName.empty() )
+  {
+    std::string parameters;
+    if ( !ReadParametersFile( parametersFileName, parameters )
+      || !vtkSlicerMarkupsToModelSessionRecorder::SetParametersFromString( parameterNode, parameters ) )
+    {
+      return EXIT_FAILURE;
+    }
+  }
+  for ( std::vector< std::string >::iterator parameterIt = parameterArguments.begin(); parameterIt != parameterArguments.end(); ++parameterIt )
+  {
+    if ( !vtkSlicerMarkupsToModelSessionRecorder::SetParametersFromString( parameterNode, *parameterIt ) )
+    {
+      return EXIT_FAILURE;
+    }
+  }
+
+  // Collect the input files
+  std::vector< std::string > inputFileNames;
+  for ( std::vector< std::string >::iterator inputIt = inputs.begin(); inputIt != inputs.end(); ++inputIt )
+  {
+    std::string inputPath = vtksys::SystemTools::CollapseFullPath( *inputIt );
+    if ( !vtksys::SystemTools::FileIsDirectory( inputPath ) )
+    {
+      inputFileNames.push_back( inputPath );
+      continue;
+    }
+    vtksys::Directory directory;
+    if ( !directory.Load( inputPath ) )
+    {
+      std::cerr << "Cannot read directory " << inputPath << std::endl;
+      return EXIT_FAILURE;
+    }
+    std::vector< std::string > directoryFileNames;
+    for ( unsigned long fileIndex = 0; fileIndex < directory.GetNumberOfFiles(); fileIndex++ )
+    {
+      std::string fileName = directory.GetFile( fileIndex );
+      if ( IsMarkupsFile( fileName ) )
+      {
+        directoryFileNames.push_back( inputPath + "/" + fileName );
+      }
+    }
+    std::sort( directoryFileNames.begin(), directoryFileNames.end() );
+    inputFileNames.insert( inputFileNames.end(), directoryFileNames.begin(), directoryFileNames.end() );
+  }
+  // files that are specified more than once (e.g., by name and by directory) are converted once
+  std::vector< std::string > uniqueInputFileNames;
+  for ( std::vector< std::string >::iterator fileNameIt = inputFileNames.begin(); fileNameIt != inputFileNames.end(); ++fileNameIt )
+  {
+    if ( std::find( uniqueInputFileNames.begin(), uniqueInputFileNames.end(), *fileNameIt ) == uniqueInputFileNames.end() )
+    {
+      uniqueInputFileNames.push_back( *fileNameIt );
+    }
+  }
+  inputFileNames.swap( uniqueInputFileNames );
+
+  // Input files that would be written to the same output file (e.g., a.fcsv and a.mrk.json) are not converted,
+  // as the models would overwrite each other. Names are compared case-insensitively, as file systems may be.
+  std::map< std::string, std::vector< std::string > > inputFileNamesByOutput;
+  for ( std::vector< std::string >::iterator fileNameIt = inputFileNames.begin(); fileNameIt != inputFileNames.end(); ++fileNameIt )
+  {
+    std::string outputFileName = vtksys::SystemTools::LowerCase( GetOutputFileName( *fileNameIt, outputDirectory, format ) );
+    inputFileNamesByOutput[ outputFileName ].push_back( *fileNameIt );
+  }
+  if ( !outputDirectory.empty() && !vtksys::SystemTools::MakeDirectory( outputDirectory ) )
+  {
+    std::cerr << "Cannot create output directory " << outputDirectory << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  // Read the control points
+  std::vector< ConversionTask > tasks;
+  vtkSmartPointer< vtkMRMLScene > scene = vtkSmartPointer< vtkMRMLScene >::New();
+  RegisterMarkupsNodeClasses( scene );
+  int numberOfFailedFiles = 0;
+  for ( std::vector< std::string >::iterator fileNameIt = inputFileNames.begin(); fileNameIt != inputFileNames.end(); ++fileNameIt )
+  {
+    ConversionTask task;
+    task.InputFileName = *fileNameIt;
+    task.ControlPoints = vtkSmartPointer< vtkPoints >::New();
+    task.OutputFileName = GetOutputFileName( task.InputFileName, outputDirectory, format );
+    const std::vector< std::string >& sameOutputFileNames = inputFileNamesByOutput[ vtksys::SystemTools::LowerCase( task.OutputFileName ) ];
+    if ( sameOutputFileNames.size() > 1 )
+    {
+      std::cerr << "Cannot convert " << task.InputFileName << ": output file " << task.OutputFileName << " would also be written from";
+      for ( std::vector< std::string >::const_iterator otherFileNameIt = sameOutputFileNames.begin(); otherFileNameIt != sameOutputFileNames.end(); ++otherFileNameIt )
+      {
+        if ( *otherFileNameIt != task.InputFileName )
+        {
+          std::cerr << " " << *otherFileNameIt;
+        }
+      }
+      std::cerr << std::endl;
+      numberOfFailedFiles++;
+      continue;
+    }
+    if ( !IsMarkupsFile( task.InputFileName ) || !ReadControlPoints( scene, task.InputFileName, task.ControlPoints ) )
+    {
+      std::cerr << "Cannot read markups file " << task.InputFileName << std::endl;
+      numberOfFailedFiles++;
+      continue;
+    }
+    tasks.push_back( task );
+  }
+
+  // Generate and write the models in parallel
+  if ( !tasks.empty() )
+  {
+    if ( numberOfThreads > 0 )
+    {
+      vtkSMPTools::Initialize( numberOfThreads );
+    }
+    vtkConversionWorker worker;
+    worker.Tasks = &tasks[ 0 ];
+    worker.ParameterNode = parameterNode;
+    worker.Format = format;
+    vtkSMPTools::For( 0, static_cast< vtkIdType >( tasks.size() ), 1, worker );
+  }
+
+  int numberOfConvertedFiles = 0;
+  for ( std::vector< ConversionTask >::iterator taskIt = tasks.begin(); taskIt != tasks.end(); ++taskIt )
+  {
+    if ( taskIt->Success )
+    {
+      numberOfConvertedFiles++;
+    }
+    else
+    {
+      numberOfFailedFiles++;
+    }
+  }
+  double elapsedTime = std::chrono::duration< double >( std::chrono::steady_clock::now() - startTime ).count();
+  std::cout << "Converted " << numberOfConvertedFiles << " of " << inputFileNames.size() << " files in " << elapsedTime << "s" << std::endl;
+  return ( numberOfFailedFiles == 0 ? EXIT_SUCCESS : EXIT_FAILURE );
+}
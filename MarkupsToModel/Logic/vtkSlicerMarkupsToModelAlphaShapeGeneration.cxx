@@ -0,0 +1,404 @@
+#include "vtkSlicerMarkupsToModelAlphaShapeGeneration.h"
+
+#include <vtkCellArray.h>
+#include <vtkCellType.h>
+#include <vtkDelaunay3D.h>
+#include <vtkMath.h>
+#include <vtkObjectFactory.h>
+#include <vtkSmartPointer.h>
+#include <vtkTetra.h>
+#include <vtkUnstructuredGrid.h>
+
+// STD includes
+#include <algorithm>
+#include <array>
+#include <map>
+#include <numeric>
+#include <vector>
+
+//------------------------------------------------------------------------------
+class vtkSlicerMarkupsToModelAlphaShapeGeneration::vtkInternal
+{
+public:
+  struct Triangle
+  {
+    vtkIdType PointIds[ 3 ]; // oriented outward from the tetrahedron with the smaller circumsphere
+    double MinimumAlpha; // the triangle is on the boundary if MinimumAlpha <= alpha < MaximumAlpha
+    double MaximumAlpha;
+    vtkIdType TetraIds[ 2 ]; // -1 if the triangle is on the convex hull
+  };
+
+  struct Tetra
+  {
+    vtkIdType PointIds[ 4 ];
+    vtkIdType TriangleIds[ 4 ];
+    double Radius; // circumsphere radius
+  };
+
+  vtkInternal()
+  : Built( false )
+  {
+  }
+
+  void Reset()
+  {
+    this->Built = false;
+    this->Coordinates.clear();
+    this->Points = NULL;
+    this->Triangles.clear();
+    this->Tetras.clear();
+  }
+
+  bool HasSamePoints( vtkPoints* points );
+  void Build( vtkPoints* points );
+  void AddTriangle( vtkIdType tetraId, int triangleIndexInTetra, vtkIdType pointId0, vtkIdType pointId1, vtkIdType pointId2, vtkIdType oppositePointId,
+    std::map< std::array< vtkIdType, 3 >, vtkIdType >& triangleIdsByPoints );
+  double GetAutomaticAlpha();
+
+  bool Built;
+  std::vector< double > Coordinates; // input points of the last build, for detecting changes
+  vtkSmartPointer< vtkPoints > Points; // points of the tetrahedralization
+  std::vector< Triangle > Triangles; // sorted by MinimumAlpha
+  std::vector< Tetra > Tetras; // sorted by Radius
+};
+
+//------------------------------------------------------------------------------
+bool vtkSlicerMarkupsToModelAlphaShapeGeneration::vtkInternal::HasSamePoints( vtkPoints* points )
+{
+  vtkIdType numberOfPoints = points->GetNumberOfPoints();
+  if ( !this->Built || static_cast< vtkIdType >( this->Coordinates.size() ) != 3 * numberOfPoints )
+  {
+    return false;
+  }
+  for ( vtkIdType pointIndex = 0; pointIndex < numberOfPoints; pointIndex++ )
+  {
+    double point[ 3 ] = { 0.0, 0.0, 0.0 };
+    points->GetPoint( pointIndex, point );
+    if ( point[ 0 ] != this->Coordinates[ 3 * pointIndex ]
+      || point[ 1 ] != this->Coordinates[ 3 * pointIndex + 1 ]
+      || point[ 2 ] != this->Coordinates[ 3 * pointIndex + 2 ] )
+    {
+      return false;
+    }
+  }
+  return true;
+}
+
+//------------------------------------------------------------------------------
+void vtkSlicerMarkupsToModelAlphaShapeGeneration::vtkInternal::Build( vtkPoints* points )
+{
+  this->Reset();
+  vtkIdType numberOfPoints = points->GetNumberOfPoints();
+  this->Coordinates.resize( 3 * numberOfPoints );
+  for ( vtkIdType pointIndex = 0; pointIndex < numberOfPoints; pointIndex++ )
+  {
+    points->GetPoint( pointIndex, &this->Coordinates[ 3 * pointIndex ] );
+  }
+  this->Built = true;
+
+  // Full tetrahedralization (alpha = 0)
+  vtkSmartPointer< vtkPolyData > pointsPolyData = vtkSmartPointer< vtkPolyData >::New();
+  pointsPolyData->SetPoints( points );
+  vtkSmartPointer< vtkDelaunay3D > delaunay = vtkSmartPointer< vtkDelaunay3D >::New();
+  delaunay->SetInputData( pointsPolyData );
+  delaunay->Update();
+  vtkUnstructuredGrid* tetrahedralization = delaunay->GetOutput();
+  this->Points = tetrahedralization->GetPoints();
+  if ( this->Points == NULL )
+  {
+    return;
+  }
+
+  std::map< std::array< vtkIdType, 3 >, vtkIdType > triangleIdsByPoints;
+  vtkIdType numberOfCells = tetrahedralization->GetNumberOfCells();
+  this->Tetras.reserve( numberOfCells );
+  for ( vtkIdType cellId = 0; cellId < numberOfCells; cellId++ )
+  {
+    if ( tetrahedralization->GetCellType( cellId ) != VTK_TETRA )
+    {
+      continue;
+    }
+    vtkIdType numberOfCellPoints = 0;
+    const vtkIdType* cellPointIds = NULL;
+    tetrahedralization->GetCellPoints( cellId, numberOfCellPoints, cellPointIds );
+    Tetra tetra;
+    double tetraPoints[ 4 ][ 3 ];
+    for ( int i = 0; i < 4; i++ )
+    {
+      tetra.PointIds[ i ] = cellPointIds[ i ];
+      this->Points->GetPoint( cellPointIds[ i ], tetraPoints[ i ] );
+    }
+    double center[ 3 ] = { 0.0, 0.0, 0.0 };
+    // vtkDelaunay3D keeps a tetrahedron if its squared circumsphere radius is not larger than alpha^2
+    tetra.Radius = sqrt( vtkTetra::Circumsphere( tetraPoints[ 0 ], tetraPoints[ 1 ], tetraPoints[ 2 ], tetraPoints[ 3 ], center ) );
+    this->Tetras.push_back( tetra );
+  }
+
+  // Tetrahedra are processed by increasing radius, which makes the automatic alpha computation a single sweep
+  std::sort( this->Tetras.begin(), this->Tetras.end(),
+    []( const Tetra& a, const Tetra& b ) { return a.Radius < b.Radius; } );
+  for ( vtkIdType tetraId = 0; tetraId < static_cast< vtkIdType >( this->Tetras.size() ); tetraId++ )
+  {
+    const vtkIdType* p = this->Tetras[ tetraId ].PointIds;
+    this->AddTriangle( tetraId, 0, p[ 1 ], p[ 2 ], p[ 3 ], p[ 0 ], triangleIdsByPoints );
+    this->AddTriangle( tetraId, 1, p[ 0 ], p[ 2 ], p[ 3 ], p[ 1 ], triangleIdsByPoints );
+    this->AddTriangle( tetraId, 2, p[ 0 ], p[ 1 ], p[ 3 ], p[ 2 ], triangleIdsByPoints );
+    this->AddTriangle( tetraId, 3, p[ 0 ], p[ 1 ], p[ 2 ], p[ 3 ], triangleIdsByPoints );
+  }
+
+  // Sort triangles by the start of their range, keeping the triangle references of the tetrahedra valid
+  std::vector< vtkIdType > sortedTriangleIds( this->Triangles.size() );
+  std::iota( sortedTriangleIds.begin(), sortedTriangleIds.end(), 0 );
+  std::stable_sort( sortedTriangleIds.begin(), sortedTriangleIds.end(),
+    [this]( vtkIdType a, vtkIdType b ) { return this->Triangles[ a ].MinimumAlpha < this->Triangles[ b ].MinimumAlpha; } );
+  std::vector< vtkIdType > newTriangleIds( this->Triangles.size() );
+  std::vector< Triangle > sortedTriangles;
+  sortedTriangles.reserve( this->Triangles.size() );
+  for ( size_t i = 0; i < sortedTriangleIds.size(); i++ )
+  {
+    newTriangleIds[ sortedTriangleIds[ i ] ] = static_cast< vtkIdType >( i );
+    sortedTriangles.push_back( this->Triangles[ sortedTriangleIds[ i ] ] );
+  }
+  this->Triangles.swap( sortedTriangles );
+  for ( std::vector< Tetra >::iterator tetraIt = this->Tetras.begin(); tetraIt != this->Tetras.end(); ++tetraIt )
+  {
+    for ( int i = 0; i < 4; i++ )
+    {
+      tetraIt->TriangleIds[ i ] = newTriangleIds[ tetraIt->TriangleIds[ i ] ];
+    }
+  }
+}
+
+//------------------------------------------------------------------------------
+void vtkSlicerMarkupsToModelAlphaShapeGeneration::vtkInternal::AddTriangle( vtkIdType tetraId, int triangleIndexInTetra,
+  vtkIdType pointId0, vtkIdType pointId1, vtkIdType pointId2, vtkIdType oppositePointId,
+  std::map< std::array< vtkIdType, 3 >, vtkIdType >& triangleIdsByPoints )
+{
+  // orient the triangle so that its normal points away from the opposite point of the tetrahedron
+  double point0[ 3 ] = { 0.0, 0.0, 0.0 };
+  double point1[ 3 ] = { 0.0, 0.0, 0.0 };
+  double point2[ 3 ] = { 0.0, 0.0, 0.0 };
+  double oppositePoint[ 3 ] = { 0.0, 0.0, 0.0 };
+  this->Points->GetPoint( pointId0, point0 );
+  this->Points->GetPoint( pointId1, point1 );
+  this->Points->GetPoint( pointId2, point2 );
+  this->Points->GetPoint( oppositePointId, oppositePoint );
+  double edge1[ 3 ] = { 0.0, 0.0, 0.0 };
+  double edge2[ 3 ] = { 0.0, 0.0, 0.0 };
+  double toOppositePoint[ 3 ] = { 0.0, 0.0, 0.0 };
+  double normal[ 3 ] = { 0.0, 0.0, 0.0 };
+  vtkMath::Subtract( point1, point0, edge1 );
+  vtkMath::Subtract( point2, point0, edge2 );
+  vtkMath::Subtract( oppositePoint, point0, toOppositePoint );
+  vtkMath::Cross( edge1, edge2, normal );
+  if ( vtkMath::Dot( normal, toOppositePoint ) > 0.0 )
+  {
+    std::swap( pointId1, pointId2 );
+  }
+
+  double radius = this->Tetras[ tetraId ].Radius;
+  std::array< vtkIdType, 3 > key = { { pointId0, pointId1, pointId2 } };
+  std::sort( key.begin(), key.end() );
+  std::map< std::array< vtkIdType, 3 >, vtkIdType >::iterator triangleIt = triangleIdsByPoints.find( key );
+  if ( triangleIt == triangleIdsByPoints.end() )
+  {
+    // tetrahedra are added by increasing radius, so this is the tetrahedron with the smaller radius
+    Triangle triangle;
+    triangle.PointIds[ 0 ] = pointId0;
+    triangle.PointIds[ 1 ] = pointId1;
+    triangle.PointIds[ 2 ] = pointId2;
+    triangle.MinimumAlpha = radius;
+    triangle.MaximumAlpha = VTK_DOUBLE_MAX; // on the convex hull, unless another tetrahedron is found
+    triangle.TetraIds[ 0 ] = tetraId;
+    triangle.TetraIds[ 1 ] = -1;
+    vtkIdType triangleId = static_cast< vtkIdType >( this->Triangles.size() );
+    this->Triangles.push_back( triangle );
+    triangleIdsByPoints[ key ] = triangleId;
+    this->Tetras[ tetraId ].TriangleIds[ triangleIndexInTetra ] = triangleId;
+  }
+  else
+  {
+    // both tetrahedra are included above this alpha, so the triangle is internal
+    Triangle& triangle = this->Triangles[ triangleIt->second ];
+    triangle.MaximumAlpha = radius;
+    triangle.TetraIds[ 1 ] = tetraId;
+    this->Tetras[ tetraId ].TriangleIds[ triangleIndexInTetra ] = triangleIt->second;
+    // each triangle is shared by at most two tetrahedra
+    triangleIdsByPoints.erase( triangleIt );
+  }
+}
+
+//------------------------------------------------------------------------------
+double vtkSlicerMarkupsToModelAlphaShapeGeneration::vtkInternal::GetAutomaticAlpha()
+{
+  if ( this->Tetras.empty() || this->Points == NULL )
+  {
+    return 0.0;
+  }
+
+  // Add tetrahedra by increasing radius and track the connected components (tetrahedra connected through triangles)
+  // and the number of points in the solid. Stop when all the points are in a single component.
+  vtkIdType numberOfPoints = this->Points->GetNumberOfPoints();
+  std::vector< bool > pointInSolid( numberOfPoints, false );
+  vtkIdType numberOfPointsToInclude = 0;
+  for ( std::vector< Tetra >::iterator tetraIt = this->Tetras.begin(); tetraIt != this->Tetras.end(); ++tetraIt )
+  {
+    for ( int i = 0; i < 4; i++ )
+    {
+      if ( !pointInSolid[ tetraIt->PointIds[ i ] ] )
+      {
+        pointInSolid[ tetraIt->PointIds[ i ] ] = true;
+        numberOfPointsToInclude++;
+      }
+    }
+  }
+  std::fill( pointInSolid.begin(), pointInSolid.end(), false );
+
+  std::vector< vtkIdType > componentParents( this->Tetras.size() );
+  std::iota( componentParents.begin(), componentParents.end(), 0 );
+  auto findComponent = [ &componentParents ]( vtkIdType tetraId )
+  {
+    while ( componentParents[ tetraId ] != tetraId )
+    {
+      componentParents[ tetraId ] = componentParents[ componentParents[ tetraId ] ];
+      tetraId = componentParents[ tetraId ];
+    }
+    return tetraId;
+  };
+
+  vtkIdType numberOfPointsInSolid = 0;
+  vtkIdType numberOfComponents = 0;
+  vtkIdType numberOfTetras = static_cast< vtkIdType >( this->Tetras.size() );
+  for ( vtkIdType tetraId = 0; tetraId < numberOfTetras; tetraId++ )
+  {
+    const Tetra& tetra = this->Tetras[ tetraId ];
+    numberOfComponents++;
+    for ( int i = 0; i < 4; i++ )
+    {
+      if ( !pointInSolid[ tetra.PointIds[ i ] ] )
+      {
+        pointInSolid[ tetra.PointIds[ i ] ] = true;
+        numberOfPointsInSolid++;
+      }
+      // tetrahedra before this one in the sorted list are already in the solid
+      const Triangle& triangle = this->Triangles[ tetra.TriangleIds[ i ] ];
+      vtkIdType neighborTetraId = ( triangle.TetraIds[ 0 ] == tetraId ? triangle.TetraIds[ 1 ] : triangle.TetraIds[ 0 ] );
+      if ( neighborTetraId < 0 || neighborTetraId > tetraId )
+      {
+        continue;
+      }
+      vtkIdType component = findComponent( tetraId );
+      vtkIdType neighborComponent = findComponent( neighborTetraId );
+      if ( component != neighborComponent )
+      {
+        componentParents[ component ] = neighborComponent;
+        numberOfComponents--;
+      }
+    }
+    // tetrahedra with the same radius are added together
+    bool lastTetraWithThisRadius = ( tetraId + 1 == numberOfTetras || this->Tetras[ tetraId + 1 ].Radius > tetra.Radius );
+    if ( lastTetraWithThisRadius && numberOfComponents == 1 && numberOfPointsInSolid == numberOfPointsToInclude )
+    {
+      return tetra.Radius;
+    }
+  }
+  return this->Tetras.back().Radius;
+}
+
+//------------------------------------------------------------------------------
+vtkStandardNewMacro( vtkSlicerMarkupsToModelAlphaShapeGeneration );
+
+//------------------------------------------------------------------------------
+vtkSlicerMarkupsToModelAlphaShapeGeneration::vtkSlicerMarkupsToModelAlphaShapeGeneration()
+{
+  this->Internal = new vtkInternal;
+}
+
+//------------------------------------------------------------------------------
+vtkSlicerMarkupsToModelAlphaShapeGeneration::~vtkSlicerMarkupsToModelAlphaShapeGeneration()
+{
+  delete this->Internal;
+}
+
+//------------------------------------------------------------------------------
+void vtkSlicerMarkupsToModelAlphaShapeGeneration::Build( vtkPoints* points )
+{
+  if ( points == NULL )
+  {
+    vtkGenericWarningMacro( "Input points are null. No tetrahedralization computed." );
+    this->Internal->Reset();
+    return;
+  }
+  if ( this->Internal->HasSamePoints( points ) )
+  {
+    return;
+  }
+  this->Internal->Build( points );
+}
+
+//------------------------------------------------------------------------------
+void vtkSlicerMarkupsToModelAlphaShapeGeneration::Reset()
+{
+  this->Internal->Reset();
+}
+
+//------------------------------------------------------------------------------
+void vtkSlicerMarkupsToModelAlphaShapeGeneration::GetSurface( double alpha, vtkPolyData* outputPolyData )
+{
+  if ( outputPolyData == NULL )
+  {
+    vtkGenericWarningMacro( "Output poly data is null. No surface generated." );
+    return;
+  }
+  outputPolyData->Initialize();
+  if ( this->Internal->Points == NULL )
+  {
+    return;
+  }
+  if ( alpha <= 0.0 || this->Internal->Tetras.empty() )
+  {
+    // all tetrahedra (triangles on the convex hull have VTK_DOUBLE_MAX as maximum alpha)
+    alpha = this->Internal->Tetras.empty() ? 0.0 : this->Internal->Tetras.back().Radius;
+  }
+
+  vtkIdType numberOfInputPoints = this->Internal->Points->GetNumberOfPoints();
+  std::vector< vtkIdType > outputPointIds( numberOfInputPoints, -1 );
+  vtkSmartPointer< vtkPoints > surfacePoints = vtkSmartPointer< vtkPoints >::New();
+  vtkSmartPointer< vtkCellArray > surfacePolys = vtkSmartPointer< vtkCellArray >::New();
+  for ( std::vector< vtkInternal::Triangle >::iterator triangleIt = this->Internal->Triangles.begin();
+    triangleIt != this->Internal->Triangles.end() && triangleIt->MinimumAlpha <= alpha; ++triangleIt )
+  {
+    if ( triangleIt->MaximumAlpha <= alpha )
+    {
+      // internal triangle
+      continue;
+    }
+    vtkIdType trianglePointIds[ 3 ] = { 0, 0, 0 };
+    for ( int i = 0; i < 3; i++ )
+    {
+      vtkIdType inputPointId = triangleIt->PointIds[ i ];
+      if ( outputPointIds[ inputPointId ] < 0 )
+      {
+        outputPointIds[ inputPointId ] = surfacePoints->InsertNextPoint( this->Internal->Points->GetPoint( inputPointId ) );
+      }
+      trianglePointIds[ i ] = outputPointIds[ inputPointId ];
+    }
+    surfacePolys->InsertNextCell( 3, trianglePointIds );
+  }
+  outputPolyData->SetPoints( surfacePoints );
+  outputPolyData->SetPolys( surfacePolys );
+}
+
+//------------------------------------------------------------------------------
+double vtkSlicerMarkupsToModelAlphaShapeGeneration::GetAutomaticAlpha()
+{
+  return this->Internal->GetAutomaticAlpha();
+}
+
+//------------------------------------------------------------------------------
+void vtkSlicerMarkupsToModelAlphaShapeGeneration::PrintSelf( ostream &os, vtkIndent indent )
+{
+  Superclass::PrintSelf( os, indent );
+  os << indent << "NumberOfTetrahedra: " << this->Internal->Tetras.size() << std::endl;
+  os << indent << "NumberOfTriangles: " << this->Internal->Triangles.size() << std::endl;
+}
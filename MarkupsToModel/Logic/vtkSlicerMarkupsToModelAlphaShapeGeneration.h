@@ -0,0 +1,54 @@
+#ifndef __vtkSlicerMarkupsToModelAlphaShapeGeneration_h
+#define __vtkSlicerMarkupsToModelAlphaShapeGeneration_h
+
+// vtk includes
+#include <vtkObject.h>
+#include <vtkPoints.h>
+#include <vtkPolyData.h>
+
+#include "vtkSlicerMarkupsToModelModuleLogicExport.h"
+
+// Computes alpha shapes of a point set from a single Delaunay tetrahedralization.
+//
+// The surface that vtkDelaunay3D (with AlphaTris, AlphaLines, AlphaVerts off) and vtkDataSetSurfaceFilter produce for an alpha value
+// is the boundary of the tetrahedra whose circumsphere radius is not larger than alpha. The tetrahedralization does not depend on alpha,
+// so it is computed only once for a point set, and the alpha range in which each triangle is on the boundary is stored.
+// The surface for any alpha value is then extracted by a single pass over the triangles, sorted by the start of their range.
+class VTK_SLICER_MARKUPSTOMODEL_MODULE_LOGIC_EXPORT vtkSlicerMarkupsToModelAlphaShapeGeneration : public vtkObject
+{
+  public:
+    // standard vtk object methods
+    vtkTypeMacro( vtkSlicerMarkupsToModelAlphaShapeGeneration, vtkObject );
+    void PrintSelf( ostream& os, vtkIndent indent ) override;
+    static vtkSlicerMarkupsToModelAlphaShapeGeneration *New();
+
+    // Compute the Delaunay tetrahedralization of the points and the alpha range of each triangle.
+    // Nothing is computed if the points are the same as in the previous call.
+    void Build( vtkPoints* points );
+
+    // Remove the tetrahedralization.
+    void Reset();
+
+    // Get the boundary of the tetrahedra whose circumsphere radius is not larger than alpha.
+    // If alpha is 0 then all tetrahedra are used (the surface is the convex hull).
+    // Any previous content of outputPolyData is replaced.
+    void GetSurface( double alpha, vtkPolyData* outputPolyData );
+
+    // Get the smallest alpha value for which the tetrahedra form a single connected solid that contains all the points.
+    // Returns 0 if the points cannot be tetrahedralized.
+    double GetAutomaticAlpha();
+
+  protected:
+    vtkSlicerMarkupsToModelAlphaShapeGeneration();
+    ~vtkSlicerMarkupsToModelAlphaShapeGeneration();
+
+  private:
+    class vtkInternal;
+    vtkInternal* Internal;
+
+    // not used
+    vtkSlicerMarkupsToModelAlphaShapeGeneration ( const vtkSlicerMarkupsToModelAlphaShapeGeneration& ) =delete;
+    void operator= ( const vtkSlicerMarkupsToModelAlphaShapeGeneration& ) =delete;
+};
+
+#endif
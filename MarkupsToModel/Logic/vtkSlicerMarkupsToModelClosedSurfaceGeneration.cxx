@@ -1,45 +1,124 @@
 #include "vtkSlicerMarkupsToModelClosedSurfaceGeneration.h"
+#include "vtkSlicerMarkupsToModelAlphaShapeGeneration.h"
+#include "vtkSlicerMarkupsToModelConvexHullGeneration.h"
 
 #include "vtkMRMLModelNode.h"
 #include "vtkMRMLMarkupsFiducialNode.h"
+#include "vtkMRMLMarkupsToModelTracer.h"
 
 #include <vtkButterflySubdivisionFilter.h>
 #include <vtkCleanPolyData.h>
 #include <vtkCubeSource.h>
-#include <vtkDataSetSurfaceFilter.h>
-#include <vtkDelaunay3D.h>
 #include <vtkGlyph3D.h>
 #include <vtkLinearSubdivisionFilter.h>
 #include <vtkLineSource.h>
 #include <vtkNew.h>
-#include <vtkOBBTree.h>
+#include <vtkObjectFactory.h>
 #include <vtkPolyDataNormals.h>
 #include <vtkRegularPolygonSource.h>
-#include <vtkTransform.h>
-#include <vtkTransformFilter.h>
 #include <vtkUnstructuredGrid.h>
 
+// STD includes
+#include <algorithm>
+#include <chrono>
+#include <vector>
+
 //------------------------------------------------------------------------------
 // constants within this file
 static const double COMPARE_TO_ZERO_TOLERANCE = 0.0001;
 static const double MINIMUM_SURFACE_EXTRUSION_AMOUNT = 0.01; // if a surface is flat/linear, give it at least this much depth
 
+//------------------------------------------------------------------------------
+// Add the time elapsed since startTime to the duration of the stage in stageTimes (if specified),
+// and record the stage as a span if tracing is enabled
+static void AddElapsedStageTime( double* stageTimes, int stage, std::chrono::steady_clock::time_point startTime )
+{
+  double elapsedTime = std::chrono::duration< double >( std::chrono::steady_clock::now() - startTime ).count();
+  if ( vtkMRMLMarkupsToModelTracer::IsTracing() )
+  {
+    vtkMRMLMarkupsToModelTracer* tracer = vtkMRMLMarkupsToModelTracer::GetInstance();
+    tracer->AddSpan( vtkMRMLMarkupsToModelNode::GetTimedStageAsString( stage ), "stage", tracer->GetTime() - elapsedTime * 1.0e6 );
+  }
+  if ( stageTimes == NULL )
+  {
+    return;
+  }
+  stageTimes[ stage ] = std::max( stageTimes[ stage ], 0.0 ) + elapsedTime;
+}
+
+//------------------------------------------------------------------------------
+// Generation was cancelled by the caller (see GenerateSurface)
+static bool IsCancelled( const std::atomic< bool >* cancelled )
+{
+  return cancelled != NULL && *cancelled;
+}
+
+//------------------------------------------------------------------------------
+class vtkSlicerMarkupsToModelClosedSurfaceGeneration::vtkInternal
+{
+public:
+  vtkInternal()
+  {
+    this->ConvexHull = vtkSmartPointer< vtkSlicerMarkupsToModelConvexHullGeneration >::New();
+    this->AlphaShape = vtkSmartPointer< vtkSlicerMarkupsToModelAlphaShapeGeneration >::New();
+    this->PointsToTriangulate = vtkSmartPointer< vtkPolyData >::New();
+    this->SurfacePolyData = vtkSmartPointer< vtkPolyData >::New();
+    this->ConvexSurfacePolyData = vtkSmartPointer< vtkPolyData >::New();
+
+    this->ButterflySubdivisionFilter = vtkSmartPointer< vtkButterflySubdivisionFilter >::New();
+    this->ButterflySubdivisionFilter->SetInputData( this->SurfacePolyData );
+    this->ButterflySubdivisionFilter->SetNumberOfSubdivisions( 3 );
+
+    this->LinearSubdivisionFilter = vtkSmartPointer< vtkLinearSubdivisionFilter >::New();
+    this->LinearSubdivisionFilter->SetInputData( this->SurfacePolyData );
+
+    this->Normals = vtkSmartPointer< vtkPolyDataNormals >::New();
+    this->Normals->SetFeatureAngle( 100 ); // TODO: This needs some justification, or set as an input parameter
+
+    this->SurfacePointArrangement = POINT_ARRANGEMENT_LAST;
+  }
+
+  vtkSmartPointer< vtkSlicerMarkupsToModelConvexHullGeneration > ConvexHull;
+  vtkSmartPointer< vtkSlicerMarkupsToModelAlphaShapeGeneration > AlphaShape;
+
+  // Triangulated surface, input of the subdivision filters
+  vtkSmartPointer< vtkPolyData > PointsToTriangulate;
+  vtkSmartPointer< vtkPolyData > SurfacePolyData;
+  // Arrangement of the points that SurfacePolyData was generated from (POINT_ARRANGEMENT_LAST if there is no surface)
+  PointArrangement SurfacePointArrangement;
+  vtkSmartPointer< vtkPolyData > ConvexSurfacePolyData;
+  vtkSmartPointer< vtkButterflySubdivisionFilter > ButterflySubdivisionFilter;
+  vtkSmartPointer< vtkLinearSubdivisionFilter > LinearSubdivisionFilter;
+  vtkSmartPointer< vtkPolyDataNormals > Normals;
+};
+
 //------------------------------------------------------------------------------
 vtkStandardNewMacro( vtkSlicerMarkupsToModelClosedSurfaceGeneration );
 
 //------------------------------------------------------------------------------
 vtkSlicerMarkupsToModelClosedSurfaceGeneration::vtkSlicerMarkupsToModelClosedSurfaceGeneration()
 {
+  this->Internal = new vtkInternal;
 }
 
 //------------------------------------------------------------------------------
 vtkSlicerMarkupsToModelClosedSurfaceGeneration::~vtkSlicerMarkupsToModelClosedSurfaceGeneration()
 {
+  delete this->Internal;
 }
 
 //------------------------------------------------------------------------------
 bool vtkSlicerMarkupsToModelClosedSurfaceGeneration::GenerateClosedSurfaceModel(vtkPoints* inputPoints, vtkPolyData* outputPolyData,
-  double delaunayAlpha, bool smoothing, bool forceConvex)
+  double delaunayAlpha, bool smoothing, bool forceConvex, bool subdivision)
+{
+  vtkSmartPointer< vtkSlicerMarkupsToModelClosedSurfaceGeneration > generator = vtkSmartPointer< vtkSlicerMarkupsToModelClosedSurfaceGeneration >::New();
+  return generator->GenerateSurface(inputPoints, outputPolyData, delaunayAlpha, smoothing, forceConvex, subdivision);
+}
+
+//------------------------------------------------------------------------------
+bool vtkSlicerMarkupsToModelClosedSurfaceGeneration::GenerateSurface(vtkPoints* inputPoints, vtkPolyData* outputPolyData,
+  double delaunayAlpha, bool smoothing, bool forceConvex, bool subdivision, double* stageTimes/*=NULL*/,
+  const std::atomic< bool >* cancelled/*=NULL*/)
 {
   if (inputPoints == NULL)
   {
@@ -53,6 +132,9 @@ bool vtkSlicerMarkupsToModelClosedSurfaceGeneration::GenerateClosedSurfaceModel(
     return false;
   }
 
+  this->Internal->ConvexHull->Reset();
+  this->Internal->SurfacePointArrangement = POINT_ARRANGEMENT_LAST;
+
   int numberOfPoints = inputPoints->GetNumberOfPoints();
   if (numberOfPoints == 0)
   {
@@ -60,6 +142,171 @@ bool vtkSlicerMarkupsToModelClosedSurfaceGeneration::GenerateClosedSurfaceModel(
     return true;
   }
 
+  std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+  vtkPolyData* pointsToTriangulate = this->Internal->PointsToTriangulate;
+  PointArrangement pointArrangement = ComputePointsToTriangulate(inputPoints, pointsToTriangulate);
+  if (pointArrangement == POINT_ARRANGEMENT_LAST)
+  {
+    return false;
+  }
+
+  vtkPolyData* surfacePolyData = this->Internal->SurfacePolyData;
+  // With zero alpha the surface is the convex hull, which is computed directly.
+  // The hull is only kept for incremental updates if it is the hull of the input points (not extruded).
+  vtkSmartPointer< vtkSlicerMarkupsToModelConvexHullGeneration > hull = this->Internal->ConvexHull;
+  if (pointArrangement != POINT_ARRANGEMENT_NONPLANAR)
+  {
+    hull = vtkSmartPointer< vtkSlicerMarkupsToModelConvexHullGeneration >::New();
+  }
+  if (delaunayAlpha <= 0.0 && hull->Build(pointsToTriangulate->GetPoints()))
+  {
+    hull->GetPolyData(surfacePolyData);
+  }
+  else
+  {
+    // The tetrahedralization is kept, so if only the alpha value changes
+    // then the surface is extracted without triangulating the points again.
+    this->Internal->AlphaShape->Build(pointsToTriangulate->GetPoints());
+    this->Internal->AlphaShape->GetSurface(delaunayAlpha, surfacePolyData);
+  }
+  surfacePolyData->Modified();
+  this->Internal->SurfacePointArrangement = pointArrangement;
+  AddElapsedStageTime(stageTimes, vtkMRMLMarkupsToModelNode::TriangulationTimedStage, startTime);
+  if (IsCancelled(cancelled))
+  {
+    return false;
+  }
+
+  return this->GenerateSmoothSurface(outputPolyData, pointArrangement, smoothing, forceConvex, subdivision, stageTimes, cancelled);
+}
+
+//------------------------------------------------------------------------------
+double vtkSlicerMarkupsToModelClosedSurfaceGeneration::ComputeAutomaticDelaunayAlpha(vtkPoints* inputPoints)
+{
+  if (inputPoints == NULL || inputPoints->GetNumberOfPoints() == 0)
+  {
+    return 0.0;
+  }
+
+  vtkSmartPointer< vtkPolyData > pointsToTriangulate = vtkSmartPointer< vtkPolyData >::New();
+  if (ComputePointsToTriangulate(inputPoints, pointsToTriangulate) == POINT_ARRANGEMENT_LAST)
+  {
+    return 0.0;
+  }
+
+  this->Internal->AlphaShape->Build(pointsToTriangulate->GetPoints());
+  return this->Internal->AlphaShape->GetAutomaticAlpha();
+}
+
+//------------------------------------------------------------------------------
+vtkSlicerMarkupsToModelConvexHullGeneration* vtkSlicerMarkupsToModelClosedSurfaceGeneration::GetConvexHull()
+{
+  return this->Internal->ConvexHull;
+}
+
+//------------------------------------------------------------------------------
+bool vtkSlicerMarkupsToModelClosedSurfaceGeneration::GenerateSurfaceFromConvexHull(vtkPolyData* outputPolyData,
+  bool smoothing, bool forceConvex, bool subdivision, double* stageTimes/*=NULL*/)
+{
+  if (!this->Internal->ConvexHull->HasHull())
+  {
+    vtkGenericWarningMacro("Convex hull is not available. No model generated.");
+    return false;
+  }
+
+  if (outputPolyData == NULL)
+  {
+    vtkGenericWarningMacro("Output poly data is null. No model generated.");
+    return false;
+  }
+
+  std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+  this->Internal->ConvexHull->GetPolyData(this->Internal->SurfacePolyData);
+  this->Internal->SurfacePolyData->Modified();
+  this->Internal->SurfacePointArrangement = POINT_ARRANGEMENT_NONPLANAR;
+  AddElapsedStageTime(stageTimes, vtkMRMLMarkupsToModelNode::TriangulationTimedStage, startTime);
+  return this->GenerateSmoothSurface(outputPolyData, POINT_ARRANGEMENT_NONPLANAR, smoothing, forceConvex, subdivision, stageTimes);
+}
+
+//------------------------------------------------------------------------------
+bool vtkSlicerMarkupsToModelClosedSurfaceGeneration::GenerateSurfaceFromTriangulation(vtkPolyData* outputPolyData,
+  bool smoothing, bool forceConvex, bool subdivision, double* stageTimes/*=NULL*/)
+{
+  if (this->Internal->SurfacePointArrangement == POINT_ARRANGEMENT_LAST)
+  {
+    return false;
+  }
+
+  if (outputPolyData == NULL)
+  {
+    vtkGenericWarningMacro("Output poly data is null. No model generated.");
+    return false;
+  }
+
+  // The surface is not modified, so the subdivision filters only execute again if they were not used for the previous surface
+  return this->GenerateSmoothSurface(outputPolyData, this->Internal->SurfacePointArrangement, smoothing, forceConvex, subdivision, stageTimes);
+}
+
+//------------------------------------------------------------------------------
+bool vtkSlicerMarkupsToModelClosedSurfaceGeneration::GenerateSmoothSurface(vtkPolyData* outputPolyData,
+  PointArrangement pointArrangement, bool smoothing, bool forceConvex, bool subdivision, double* stageTimes,
+  const std::atomic< bool >* cancelled/*=NULL*/)
+{
+  // The filters are connected to the surface poly data once, only the input of the normal filter is switched.
+  // Filters that are not affected by the last modification of the surface are not executed again.
+  // Subdivision filters are updated explicitly (instead of by the normal filter), so that the stages can be timed separately.
+  std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+  vtkPolyDataNormals* normals = this->Internal->Normals;
+  if (!subdivision)
+  {
+    normals->SetInputData(this->Internal->SurfacePolyData);
+  }
+  else if (smoothing && pointArrangement == POINT_ARRANGEMENT_NONPLANAR)
+  {
+    vtkButterflySubdivisionFilter* subdivisionFilter = this->Internal->ButterflySubdivisionFilter;
+    subdivisionFilter->Update();
+    if (forceConvex)
+    {
+      vtkPolyData* convexHullPolyData = this->Internal->ConvexSurfacePolyData;
+      if (!vtkSlicerMarkupsToModelConvexHullGeneration::GenerateConvexHullModel(subdivisionFilter->GetOutput()->GetPoints(), convexHullPolyData))
+      {
+        vtkGenericWarningMacro("Failed to compute convex hull of the subdivided surface. The surface may not be convex.");
+        convexHullPolyData->ShallowCopy(subdivisionFilter->GetOutput());
+      }
+      convexHullPolyData->Modified();
+      normals->SetInputData(convexHullPolyData);
+    }
+    else
+    {
+      normals->SetInputConnection(subdivisionFilter->GetOutputPort());
+    }
+  }
+  else
+  {
+    this->Internal->LinearSubdivisionFilter->Update();
+    normals->SetInputConnection(this->Internal->LinearSubdivisionFilter->GetOutputPort());
+  }
+  if (subdivision)
+  {
+    AddElapsedStageTime(stageTimes, vtkMRMLMarkupsToModelNode::SubdivisionTimedStage, startTime);
+  }
+  if (IsCancelled(cancelled))
+  {
+    return false;
+  }
+
+  startTime = std::chrono::steady_clock::now();
+  normals->Update();
+  outputPolyData->DeepCopy(normals->GetOutput());
+  AddElapsedStageTime(stageTimes, vtkMRMLMarkupsToModelNode::NormalsTimedStage, startTime);
+  return true;
+}
+
+//------------------------------------------------------------------------------
+vtkSlicerMarkupsToModelClosedSurfaceGeneration::PointArrangement vtkSlicerMarkupsToModelClosedSurfaceGeneration::ComputePointsToTriangulate(
+  vtkPoints* inputPoints, vtkPolyData* pointsToTriangulate)
+{
+  int numberOfPoints = inputPoints->GetNumberOfPoints();
   vtkSmartPointer< vtkCellArray > inputCellArray = vtkSmartPointer< vtkCellArray >::New();
   inputCellArray->InsertNextCell(numberOfPoints);
   for (int i = 0; i < numberOfPoints; i++)
@@ -71,20 +318,9 @@ bool vtkSlicerMarkupsToModelClosedSurfaceGeneration::GenerateClosedSurfaceModel(
   inputPolyData->SetLines(inputCellArray);
   inputPolyData->SetPoints(inputPoints);
 
-  vtkSmartPointer< vtkDelaunay3D > delaunay = vtkSmartPointer< vtkDelaunay3D >::New();
-  delaunay->SetAlpha(delaunayAlpha);
-  delaunay->AlphaTrisOff();
-  delaunay->AlphaLinesOff();
-  delaunay->AlphaVertsOff();
-
   vtkSmartPointer< vtkMatrix4x4 > boundingAxesToRasTransformMatrix = vtkSmartPointer< vtkMatrix4x4 >::New();
-  ComputeTransformMatrixFromBoundingAxes(inputPoints, boundingAxesToRasTransformMatrix);
-
-  vtkSmartPointer< vtkMatrix4x4 > rasToBoundingAxesTransformMatrix = vtkSmartPointer< vtkMatrix4x4 >::New();
-  vtkMatrix4x4::Invert(boundingAxesToRasTransformMatrix, rasToBoundingAxesTransformMatrix);
-
   double smallestBoundingExtentRanges[3] = { 0.0, 0.0, 0.0 }; // temporary values
-  ComputeTransformedExtentRanges(inputPoints, rasToBoundingAxesTransformMatrix, smallestBoundingExtentRanges);
+  ComputeBoundingAxes(inputPoints, boundingAxesToRasTransformMatrix, smallestBoundingExtentRanges);
 
   PointArrangement pointArrangement = ComputePointArrangement(smallestBoundingExtentRanges);
 
@@ -109,7 +345,7 @@ bool vtkSlicerMarkupsToModelClosedSurfaceGeneration::GenerateClosedSurfaceModel(
       glyph->SetInputData(inputPolyData);
       glyph->Update();
 
-      delaunay->SetInputConnection(glyph->GetOutputPort());
+      pointsToTriangulate->ShallowCopy(glyph->GetOutput());
 
       break;
     }
@@ -132,7 +368,7 @@ bool vtkSlicerMarkupsToModelClosedSurfaceGeneration::GenerateClosedSurfaceModel(
       glyph->SetInputData(inputPolyData);
       glyph->Update();
 
-      delaunay->SetInputConnection(glyph->GetOutputPort());
+      pointsToTriangulate->ShallowCopy(glyph->GetOutput());
 
       break;
     }
@@ -157,74 +393,84 @@ bool vtkSlicerMarkupsToModelClosedSurfaceGeneration::GenerateClosedSurfaceModel(
       glyph->SetInputData(inputPolyData);
       glyph->Update();
 
-      delaunay->SetInputConnection(glyph->GetOutputPort());
+      pointsToTriangulate->ShallowCopy(glyph->GetOutput());
 
       break;
     }
     case POINT_ARRANGEMENT_NONPLANAR:
     {
-      delaunay->SetInputData(inputPolyData);
+      pointsToTriangulate->ShallowCopy(inputPolyData);
       break;
     }
     default: // unsupported or invalid
     {
       vtkGenericWarningMacro("Unsupported pointArrangementType detected: " << pointArrangement << ". Aborting closed surface generation.");
-      return false;
+      return POINT_ARRANGEMENT_LAST;
     }
   }
 
-  vtkSmartPointer< vtkDataSetSurfaceFilter > surfaceFilter = vtkSmartPointer< vtkDataSetSurfaceFilter >::New();
-  surfaceFilter->SetInputConnection(delaunay->GetOutputPort());
-  surfaceFilter->Update();
+  return pointArrangement;
+}
 
-  vtkSmartPointer<vtkPolyDataNormals> normals = vtkSmartPointer<vtkPolyDataNormals>::New();
-  normals->SetFeatureAngle(100); // TODO: This needs some justification, or set as an input parameter
+//------------------------------------------------------------------------------
+// Accumulate the sum and the sum of outer products of the point coordinates.
+// Coordinates are taken relative to the first point, which avoids loss of precision
+// when the points are far from the origin (covariance does not depend on the shift).
+template< class T >
+static void AccumulatePointMoments(const T* coordinates, vtkIdType numberOfPoints, double sum[3], double sumOfProducts[3][3])
+{
+  const double origin[3] = { static_cast< double >(coordinates[0]), static_cast< double >(coordinates[1]), static_cast< double >(coordinates[2]) };
+  double sxx = 0.0, sxy = 0.0, sxz = 0.0, syy = 0.0, syz = 0.0, szz = 0.0;
+  double sx = 0.0, sy = 0.0, sz = 0.0;
+  for (vtkIdType i = 0; i < numberOfPoints; i++)
+  {
+    const double x = coordinates[3 * i] - origin[0];
+    const double y = coordinates[3 * i + 1] - origin[1];
+    const double z = coordinates[3 * i + 2] - origin[2];
+    sx += x; sy += y; sz += z;
+    sxx += x * x; sxy += x * y; sxz += x * z;
+    syy += y * y; syz += y * z; szz += z * z;
+  }
+  sum[0] = sx; sum[1] = sy; sum[2] = sz;
+  sumOfProducts[0][0] = sxx; sumOfProducts[0][1] = sxy; sumOfProducts[0][2] = sxz;
+  sumOfProducts[1][0] = sxy; sumOfProducts[1][1] = syy; sumOfProducts[1][2] = syz;
+  sumOfProducts[2][0] = sxz; sumOfProducts[2][1] = syz; sumOfProducts[2][2] = szz;
+}
 
-  if (smoothing && pointArrangement == POINT_ARRANGEMENT_NONPLANAR)
+//------------------------------------------------------------------------------
+// Compute the range of the point coordinates projected onto the (orthonormal) axes.
+template< class T >
+static void ComputeProjectedExtentRanges(const T* coordinates, vtkIdType numberOfPoints, const double axes[3][3], double outputExtentRanges[3])
+{
+  double minimum[3] = { VTK_DOUBLE_MAX, VTK_DOUBLE_MAX, VTK_DOUBLE_MAX };
+  double maximum[3] = { -VTK_DOUBLE_MAX, -VTK_DOUBLE_MAX, -VTK_DOUBLE_MAX };
+  for (vtkIdType i = 0; i < numberOfPoints; i++)
   {
-    vtkSmartPointer< vtkButterflySubdivisionFilter > subdivisionFilter = vtkSmartPointer< vtkButterflySubdivisionFilter >::New();
-    subdivisionFilter->SetInputConnection(surfaceFilter->GetOutputPort());
-    subdivisionFilter->SetNumberOfSubdivisions(3);
-    subdivisionFilter->Update();
-    if (forceConvex)
+    const double x = coordinates[3 * i];
+    const double y = coordinates[3 * i + 1];
+    const double z = coordinates[3 * i + 2];
+    for (int axisIndex = 0; axisIndex < 3; axisIndex++)
     {
-      vtkSmartPointer< vtkDelaunay3D > convexHull = vtkSmartPointer< vtkDelaunay3D >::New();
-      convexHull->SetInputConnection(subdivisionFilter->GetOutputPort());
-      convexHull->Update();
-      vtkSmartPointer< vtkDataSetSurfaceFilter > surfaceFilter = vtkSmartPointer< vtkDataSetSurfaceFilter >::New();
-      surfaceFilter->SetInputData(convexHull->GetOutput());
-      surfaceFilter->Update();
-      normals->SetInputConnection(surfaceFilter->GetOutputPort());
-    }
-    else
-    {
-      normals->SetInputConnection(subdivisionFilter->GetOutputPort());
+      const double projection = x * axes[axisIndex][0] + y * axes[axisIndex][1] + z * axes[axisIndex][2];
+      minimum[axisIndex] = std::min(minimum[axisIndex], projection);
+      maximum[axisIndex] = std::max(maximum[axisIndex], projection);
     }
   }
-  else
+  for (int axisIndex = 0; axisIndex < 3; axisIndex++)
   {
-    vtkNew<vtkLinearSubdivisionFilter> linearSubdivision;
-    linearSubdivision->SetInputConnection(surfaceFilter->GetOutputPort());
-    normals->SetInputConnection(linearSubdivision->GetOutputPort());
+    outputExtentRanges[axisIndex] = maximum[axisIndex] - minimum[axisIndex];
   }
-  normals->Update();
-
-  outputPolyData->DeepCopy(normals->GetOutput());
-  return true;
 }
 
 //------------------------------------------------------------------------------
 // Compute the principal axes of the point cloud. The x axis represents the axis
 // with maximum variation, and the z axis has minimum variation.
-// This function is currently implemented using the vtkOBBTree object.
-// There are two limitations with this approach:
-// 1. vtkOBBTree may have a performance impact
-// 2. The axes returned are based on variation of coordinates, not the range
-//    (so the return result is not necessarily intuitive, variation != length).
-// Neither of these limitations will prevent the overall logic from functioning
-// correctly, but it is worth keeping in mind, and worth changing should a need
-// arise
-void vtkSlicerMarkupsToModelClosedSurfaceGeneration::ComputeTransformMatrixFromBoundingAxes(vtkPoints* points, vtkMatrix4x4* boundingAxesToRasTransformMatrix)
+// The axes are the eigenvectors of the covariance matrix of the points (same as the axes of vtkOBBTree::ComputeOBB),
+// computed directly from the point coordinates, in one pass for the covariance and one pass for the extents.
+// Note that the axes are based on variation of coordinates, not the range
+// (so the return result is not necessarily intuitive, variation != length).
+void vtkSlicerMarkupsToModelClosedSurfaceGeneration::ComputeBoundingAxes(vtkPoints* points, vtkMatrix4x4* boundingAxesToRasTransformMatrix,
+  double outputExtentRanges[3])
 {
   if (points == NULL)
   {
@@ -238,52 +484,102 @@ void vtkSlicerMarkupsToModelClosedSurfaceGeneration::ComputeTransformMatrixFromB
     return;
   }
 
+  if (outputExtentRanges == NULL)
+  {
+    vtkGenericWarningMacro("outputExtentRanges is null. Cannot compute best fit planes.");
+    return;
+  }
+
   // the output matrix should start as identity, so no translation etc.
   boundingAxesToRasTransformMatrix->Identity();
+  outputExtentRanges[0] = outputExtentRanges[1] = outputExtentRanges[2] = 0.0;
 
-  // Compute the plane using the smallest bounding box that can have arbitrary axes
-  vtkSmartPointer<vtkOBBTree> obbTree = vtkSmartPointer<vtkOBBTree>::New();
-  double cornerOBBOrigin[3] = { 0.0, 0.0, 0.0 }; // unused
-  double variationMaximumOBBAxis[3] = { 0.0, 0.0, 0.0 };
-  double variationMediumOBBAxis[3] = { 0.0, 0.0, 0.0 };
-  double variationMinimumOBBAxis[3] = { 0.0, 0.0, 0.0 };
-  double relativeAxisSizes[3] = { 0.0, 0.0, 0.0 }; // unused, the values represented herein are unclear
-  obbTree->ComputeOBB(points, cornerOBBOrigin, variationMaximumOBBAxis, variationMediumOBBAxis, variationMinimumOBBAxis, relativeAxisSizes);
+  vtkIdType numberOfPoints = points->GetNumberOfPoints();
+  if (numberOfPoints == 0)
+  {
+    return;
+  }
 
-  // now to store the desired results in the appropriate axis of the output matrix.
-  // must check each axis to make sure it was actually computed (non-zero)
-  // do the maxmimum variation axis
-  if (vtkMath::Norm(variationMaximumOBBAxis) < COMPARE_TO_ZERO_TOLERANCE)
+  // Work on the point coordinate buffer directly (points are almost always stored as float or double)
+  std::vector< double > convertedCoordinates;
+  const double* doubleCoordinates = NULL;
+  const float* floatCoordinates = NULL;
+  if (points->GetDataType() == VTK_DOUBLE)
+  {
+    doubleCoordinates = static_cast< const double* >(points->GetVoidPointer(0));
+  }
+  else if (points->GetDataType() == VTK_FLOAT)
+  {
+    floatCoordinates = static_cast< const float* >(points->GetVoidPointer(0));
+  }
+  else
+  {
+    convertedCoordinates.resize(3 * numberOfPoints);
+    for (vtkIdType i = 0; i < numberOfPoints; i++)
+    {
+      points->GetPoint(i, &convertedCoordinates[3 * i]);
+    }
+    doubleCoordinates = &convertedCoordinates[0];
+  }
+
+  double sum[3] = { 0.0, 0.0, 0.0 };
+  double sumOfProducts[3][3] = { { 0.0, 0.0, 0.0 }, { 0.0, 0.0, 0.0 }, { 0.0, 0.0, 0.0 } };
+  if (floatCoordinates != NULL)
+  {
+    AccumulatePointMoments(floatCoordinates, numberOfPoints, sum, sumOfProducts);
+  }
+  else
+  {
+    AccumulatePointMoments(doubleCoordinates, numberOfPoints, sum, sumOfProducts);
+  }
+
+  double covariance[3][3] = { { 0.0, 0.0, 0.0 }, { 0.0, 0.0, 0.0 }, { 0.0, 0.0, 0.0 } };
+  for (int row = 0; row < 3; row++)
+  {
+    for (int column = 0; column < 3; column++)
+    {
+      covariance[row][column] = (sumOfProducts[row][column] - sum[row] * sum[column] / numberOfPoints) / numberOfPoints;
+    }
+  }
+
+  // Eigenvalues are sorted in decreasing order, eigenvectors are stored in the columns
+  double* covarianceRows[3] = { covariance[0], covariance[1], covariance[2] };
+  double eigenvalues[3] = { 0.0, 0.0, 0.0 };
+  double eigenvectors[3][3] = { { 0.0, 0.0, 0.0 }, { 0.0, 0.0, 0.0 }, { 0.0, 0.0, 0.0 } };
+  double* eigenvectorRows[3] = { eigenvectors[0], eigenvectors[1], eigenvectors[2] };
+  vtkMath::Jacobi(covarianceRows, eigenvalues, eigenvectorRows);
+
+  double axes[3][3] = { { 0.0, 0.0, 0.0 }, { 0.0, 0.0, 0.0 }, { 0.0, 0.0, 0.0 } };
+  for (int axisIndex = 0; axisIndex < 3; axisIndex++)
+  {
+    for (int component = 0; component < 3; component++)
+    {
+      axes[axisIndex][component] = eigenvectors[component][axisIndex];
+    }
+  }
+  if (eigenvalues[0] < COMPARE_TO_ZERO_TOLERANCE * COMPARE_TO_ZERO_TOLERANCE)
   {
     // there is no variation in the points whatsoever.
     // i.e. all points are in a single position.
     // return arbitrary orthonormal axes (the standard axes will do).
-    boundingAxesToRasTransformMatrix->Identity();
     return;
   }
-  vtkMath::Normalize(variationMaximumOBBAxis);
-  SetNthColumnInMatrix(boundingAxesToRasTransformMatrix, 0, variationMaximumOBBAxis);
+  // the eigenvectors are orthonormal, make sure that they form a right-handed coordinate system
+  vtkMath::Cross(axes[0], axes[1], axes[2]);
 
-  // do the medium variation axis
-  if (vtkMath::Norm(variationMediumOBBAxis) < COMPARE_TO_ZERO_TOLERANCE)
+  for (int axisIndex = 0; axisIndex < 3; axisIndex++)
   {
-    // the points are colinear along only the maximum axis
-    // any two perpendicular orthonormal vectors will do for the remaining axes.
-    double thetaAngle = 0.0; // this can be arbitrary
-    vtkMath::Perpendiculars(variationMaximumOBBAxis, variationMediumOBBAxis, variationMinimumOBBAxis, thetaAngle);
+    SetNthColumnInMatrix(boundingAxesToRasTransformMatrix, axisIndex, axes[axisIndex]);
   }
-  vtkMath::Normalize(variationMediumOBBAxis);
-  SetNthColumnInMatrix(boundingAxesToRasTransformMatrix, 1, variationMediumOBBAxis);
 
-  // do the minimum variation axis
-  if (vtkMath::Norm(variationMinimumOBBAxis) < COMPARE_TO_ZERO_TOLERANCE)
+  if (floatCoordinates != NULL)
   {
-    // all points lie exactly on a plane.
-    // the remaining perpendicular vector found using cross product.
-    vtkMath::Cross(variationMaximumOBBAxis, variationMediumOBBAxis, variationMinimumOBBAxis);
+    ComputeProjectedExtentRanges(floatCoordinates, numberOfPoints, axes, outputExtentRanges);
+  }
+  else
+  {
+    ComputeProjectedExtentRanges(doubleCoordinates, numberOfPoints, axes, outputExtentRanges);
   }
-  vtkMath::Normalize(variationMinimumOBBAxis);
-  SetNthColumnInMatrix(boundingAxesToRasTransformMatrix, 2, variationMinimumOBBAxis);
 }
 
 //------------------------------------------------------------------------------
@@ -339,54 +635,6 @@ vtkSlicerMarkupsToModelClosedSurfaceGeneration::PointArrangement vtkSlicerMarkup
   return POINT_ARRANGEMENT_NONPLANAR;
 }
 
-//------------------------------------------------------------------------------
-void vtkSlicerMarkupsToModelClosedSurfaceGeneration::ComputeTransformedExtentRanges(vtkPoints* points, vtkMatrix4x4* transformMatrix, double outputExtentRanges[3])
-{
-  if (points == NULL)
-  {
-    vtkGenericWarningMacro("points is null. Aborting output extent computation.");
-    return;
-  }
-
-  if (transformMatrix == NULL)
-  {
-    vtkGenericWarningMacro("transformMatrix is null. Aborting output extent computation.");
-    return;
-  }
-
-  if (outputExtentRanges == NULL)
-  {
-    vtkGenericWarningMacro("outputExtentRanges is null. Aborting output extent computation.");
-    return;
-  }
-
-  vtkSmartPointer< vtkTransform > transform = vtkSmartPointer< vtkTransform >::New();
-  transform->SetMatrix(transformMatrix);
-  transform->Update();
-
-  // can't transform points directly, so need to store in a container
-  vtkSmartPointer< vtkPolyData > polyDataWithPoints = vtkSmartPointer< vtkPolyData >::New();
-  polyDataWithPoints->SetPoints(points);
-
-  vtkSmartPointer< vtkTransformFilter > transformFilter = vtkSmartPointer< vtkTransformFilter >::New();
-  transformFilter->SetTransform(transform);
-  transformFilter->SetInputData(polyDataWithPoints);
-  transformFilter->Update();
-
-  // the extent can be extracted from the output points object (poly data bounds does not work)
-  vtkPoints* transformedPoints = transformFilter->GetPolyDataOutput()->GetPoints();
-  transformedPoints->ComputeBounds();
-  double* extents = transformedPoints->GetBounds(); // { xmin, xmax, ymin, ymax, zmin, zmax }
-
-  for (int i = 0; i < 3; i++)
-  {
-    double axisIMin = extents[2 * i];
-    double axisIMax = extents[2 * i + 1];
-    double axisIRange = axisIMax - axisIMin;
-    outputExtentRanges[i] = axisIRange;
-  }
-}
-
 //------------------------------------------------------------------------------
 double vtkSlicerMarkupsToModelClosedSurfaceGeneration::ComputeSurfaceExtrusionAmount(const double extents[3])
 {
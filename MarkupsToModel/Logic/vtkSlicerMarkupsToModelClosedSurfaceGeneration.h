@@ -10,6 +10,11 @@
 
 #include "vtkSlicerMarkupsToModelModuleLogicExport.h"
 
+// STD includes
+#include <atomic>
+
+class vtkSlicerMarkupsToModelConvexHullGeneration;
+
 class VTK_SLICER_MARKUPSTOMODEL_MODULE_LOGIC_EXPORT vtkSlicerMarkupsToModelClosedSurfaceGeneration : public vtkObject
 {
   public:
@@ -27,19 +32,61 @@ class VTK_SLICER_MARKUPSTOMODEL_MODULE_LOGIC_EXPORT vtkSlicerMarkupsToModelClose
       POINT_ARRANGEMENT_LAST // do not set to this type, insert valid types above this line
     };
 
-    // Generates the closed surface from the points using vtkDelaunay3D.
-    static bool GenerateClosedSurfaceModel( vtkPoints* points, vtkPolyData* outputPolyData, double delaunayAlpha, bool smoothing, bool forceConvex );
+    // Generates the closed surface from the points using vtkDelaunay3D (or directly as the convex hull if delaunayAlpha is 0).
+    // If subdivision is disabled then the triangulated surface is returned without smoothing or subdivision
+    // (useful for quick previews).
+    // A temporary generator is used, see GenerateSurface for reusing the generator between updates.
+    static bool GenerateClosedSurfaceModel( vtkPoints* points, vtkPolyData* outputPolyData, double delaunayAlpha, bool smoothing, bool forceConvex,
+      bool subdivision = true );
+
+    // Same as GenerateClosedSurfaceModel, but the filters and intermediate results are kept in this generator,
+    // so that repeated updates (e.g., of the same parameter node) reuse them:
+    // - if the surface is generated from the convex hull of the input points then the hull is kept
+    //   (see GetConvexHull), so that it can be updated incrementally later,
+    // - the Delaunay tetrahedralization is kept and reused if the points did not change since the previous call
+    //   (e.g., when only delaunayAlpha is changed),
+    // - subdivision and normal computation filters stay connected.
+    // If stageTimes is specified then the durations of the triangulation, subdivision, and normal computation
+    // are added to it (indexed by vtkMRMLMarkupsToModelNode::TimedStage, negative for stages that were not performed yet).
+    // If cancelled is specified and becomes true (e.g., on another thread) then generation stops before the next stage
+    // and false is returned.
+    bool GenerateSurface( vtkPoints* points, vtkPolyData* outputPolyData, double delaunayAlpha, bool smoothing, bool forceConvex,
+      bool subdivision = true, double* stageTimes = NULL, const std::atomic< bool >* cancelled = NULL );
+
+    // Generates the closed surface from the convex hull that was kept by GenerateSurface and updated since then.
+    bool GenerateSurfaceFromConvexHull( vtkPolyData* outputPolyData, bool smoothing, bool forceConvex, bool subdivision = true,
+      double* stageTimes = NULL );
+
+    // Generates the closed surface from the triangulated surface of the last GenerateSurface or GenerateSurfaceFromConvexHull call.
+    // Only subdivision and normal computation are performed, which is sufficient if only smoothing, forceConvex,
+    // or subdivision changed. Returns false if there is no triangulated surface.
+    bool GenerateSurfaceFromTriangulation( vtkPolyData* outputPolyData, bool smoothing, bool forceConvex, bool subdivision = true,
+      double* stageTimes = NULL );
+
+    // Get the smallest Delaunay alpha value for which the closed surface is a single piece that contains all the points.
+    // Returns 0 if it cannot be computed. The tetrahedralization is kept for the next GenerateSurface call.
+    double ComputeAutomaticDelaunayAlpha( vtkPoints* points );
+
+    // Convex hull of the input points of the last GenerateSurface call. Empty if the surface was not generated from the convex hull.
+    vtkSlicerMarkupsToModelConvexHullGeneration* GetConvexHull();
 
   protected:
     vtkSlicerMarkupsToModelClosedSurfaceGeneration();
     ~vtkSlicerMarkupsToModelClosedSurfaceGeneration();
 
   private:
-    // Compute the best fit plane through the points, as well as the major and minor axes which describe variation in points.
-    static void ComputeTransformMatrixFromBoundingAxes( vtkPoints* points, vtkMatrix4x4* transformFromBoundingAxes );
+    // Get the points that the surface is triangulated from. Points that are on a plane, line, or at a single position
+    // are extruded to give them some volume. Returns the arrangement of the input points (POINT_ARRANGEMENT_LAST on error).
+    static PointArrangement ComputePointsToTriangulate( vtkPoints* inputPoints, vtkPolyData* pointsToTriangulate );
 
-    // Compute the range of points along the specified axes (total lengths along which points appear)
-    static void ComputeTransformedExtentRanges( vtkPoints* points, vtkMatrix4x4* transformMatrix, double outputExtentRanges[ 3 ] );
+    // Subdivide and smooth the triangulated surface stored in the generator (if enabled) and compute normals.
+    // Returns false if cancelled before computing the normals.
+    bool GenerateSmoothSurface( vtkPolyData* outputPolyData, PointArrangement pointArrangement, bool smoothing, bool forceConvex, bool subdivision,
+      double* stageTimes, const std::atomic< bool >* cancelled = NULL );
+
+    // Compute the best fit plane through the points, as well as the major and minor axes which describe variation in points,
+    // and the range of points along these axes (total lengths along which points appear).
+    static void ComputeBoundingAxes( vtkPoints* points, vtkMatrix4x4* transformFromBoundingAxes, double outputExtentRanges[ 3 ] );
 
     // Compute the amount to extrude surfaces when closed surface is linear or planar.
     static double ComputeSurfaceExtrusionAmount( const double extents[ 3 ] );
@@ -53,6 +100,9 @@ class VTK_SLICER_MARKUPSTOMODEL_MODULE_LOGIC_EXPORT vtkSlicerMarkupsToModelClose
     static void SetNthColumnInMatrix( vtkMatrix4x4* matrix, int n, const double axis[ 3 ] );
     static void GetNthColumnInMatrix( vtkMatrix4x4* matrix, int n, double outputAxis[ 3 ] );
 
+    class vtkInternal;
+    vtkInternal* Internal;
+
     // not used
     vtkSlicerMarkupsToModelClosedSurfaceGeneration ( const vtkSlicerMarkupsToModelClosedSurfaceGeneration& ) =delete;
     void operator= ( const vtkSlicerMarkupsToModelClosedSurfaceGeneration& ) =delete;
@@ -0,0 +1,666 @@
+#include "vtkSlicerMarkupsToModelConvexHullGeneration.h"
+
+#include <vtkCellArray.h>
+#include <vtkMath.h>
+#include <vtkObjectFactory.h>
+#include <vtkSmartPointer.h>
+
+// STD includes
+#include <algorithm>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+//------------------------------------------------------------------------------
+// constants within this file
+// Points closer than this to a face plane (relative to the size of the point set) are considered to be on the face.
+static const double HULL_DISTANCE_RELATIVE_TOLERANCE = 1.0e-10;
+static const double HULL_DISTANCE_MINIMUM_TOLERANCE = 1.0e-12;
+
+//------------------------------------------------------------------------------
+// Hash for directed edges (pairs of point indices)
+struct vtkHullEdgeHash
+{
+  size_t operator()( const std::pair< vtkIdType, vtkIdType >& edge ) const
+  {
+    return std::hash< vtkIdType >()( edge.first ) ^ ( std::hash< vtkIdType >()( edge.second ) * 0x9e3779b97f4a7c15ULL );
+  }
+};
+
+//------------------------------------------------------------------------------
+class vtkSlicerMarkupsToModelConvexHullGeneration::vtkInternal
+{
+public:
+  struct Face
+  {
+    vtkIdType PointIds[ 3 ];
+    double Normal[ 3 ];
+    double Offset;
+    std::vector< vtkIdType > OutsidePointIds; // points that are above this face and not assigned to any other face
+    bool Deleted;
+    unsigned int VisitStamp;
+    bool Visible;
+  };
+
+  vtkInternal()
+  : NumberOfDeletedFaces( 0 )
+  , Tolerance( HULL_DISTANCE_MINIMUM_TOLERANCE )
+  , CurrentVisitStamp( 0 )
+  {
+  }
+
+  // Compute the hull of the points. Returns false if the points do not span a volume.
+  bool Build( vtkPoints* points );
+
+  // Remove the hull and all the points.
+  void Reset();
+
+  // Add an input point to the hull. Returns true if the hull changed.
+  // If the hull topology is inconsistent then the hull is removed (and true is returned).
+  bool InsertPoint( vtkIdType pointId );
+
+  // Write the hull vertices and triangles into the poly data.
+  void GetPolyData( vtkPolyData* outputPolyData );
+
+  const double* GetPoint( vtkIdType pointId ) const
+  {
+    return &this->Coordinates[ 3 * pointId ];
+  }
+
+  // Index of the face that the point is the farthest above, or -1 if the point is not above any face.
+  int FindVisibleFace( const double* point ) const;
+
+  // Remove deleted faces from the face list.
+  void CompactFaces();
+
+  double GetDistanceFromFace( const Face& face, const double* point ) const
+  {
+    return vtkMath::Dot( face.Normal, point ) - face.Offset;
+  }
+
+  bool InitializeSimplex();
+  int AddFace( vtkIdType pointId0, vtkIdType pointId1, vtkIdType pointId2 );
+  void DeleteFace( int faceIndex );
+
+  // Add a point that is outside of the hull. visibleFaceIndex is a face that is visible from the point.
+  // The faces visible from the point are replaced by a cone of new faces. Outside points of the removed faces
+  // are reassigned to the new faces and the new faces that have outside points are added to the pending face list.
+  // Returns false if a face has no neighbor across one of its edges (the hull is not a closed surface anymore).
+  bool AddPoint( vtkIdType eyePointId, int visibleFaceIndex );
+
+  // Assign each point to the first face in the list that it is above. Points that are not above any face are discarded.
+  void AssignOutsidePoints( const std::vector< vtkIdType >& pointIds, const std::vector< int >& faceIndices );
+
+  std::vector< double > Coordinates; // x, y, z of each input point
+  std::vector< Face > Faces;
+  std::unordered_map< std::pair< vtkIdType, vtkIdType >, int, vtkHullEdgeHash > EdgeToFace; // directed edge -> face index
+  std::vector< int > PendingFaceIndices; // faces that may have outside points
+  std::vector< int > NumberOfFacesAtPoint; // number of hull faces that each point is a vertex of
+  int NumberOfDeletedFaces;
+  double Tolerance;
+  unsigned int CurrentVisitStamp;
+};
+
+//------------------------------------------------------------------------------
+bool vtkSlicerMarkupsToModelConvexHullGeneration::vtkInternal::Build( vtkPoints* points )
+{
+  this->Reset();
+
+  vtkIdType numberOfPoints = points->GetNumberOfPoints();
+  if ( numberOfPoints < 4 )
+  {
+    return false;
+  }
+  this->Coordinates.resize( 3 * numberOfPoints );
+  for ( vtkIdType pointIndex = 0; pointIndex < numberOfPoints; pointIndex++ )
+  {
+    points->GetPoint( pointIndex, &this->Coordinates[ 3 * pointIndex ] );
+  }
+  this->NumberOfFacesAtPoint.resize( numberOfPoints, 0 );
+
+  if ( !this->InitializeSimplex() )
+  {
+    this->Reset();
+    return false;
+  }
+
+  while ( !this->PendingFaceIndices.empty() )
+  {
+    int faceIndex = this->PendingFaceIndices.back();
+    this->PendingFaceIndices.pop_back();
+    Face& face = this->Faces[ faceIndex ];
+    if ( face.Deleted || face.OutsidePointIds.empty() )
+    {
+      continue;
+    }
+    // the farthest point is certainly a hull vertex
+    vtkIdType eyePointId = face.OutsidePointIds[ 0 ];
+    double eyeDistance = this->GetDistanceFromFace( face, this->GetPoint( eyePointId ) );
+    for ( size_t i = 1; i < face.OutsidePointIds.size(); i++ )
+    {
+      double distance = this->GetDistanceFromFace( face, this->GetPoint( face.OutsidePointIds[ i ] ) );
+      if ( distance > eyeDistance )
+      {
+        eyeDistance = distance;
+        eyePointId = face.OutsidePointIds[ i ];
+      }
+    }
+    if ( !this->AddPoint( eyePointId, faceIndex ) )
+    {
+      vtkGenericWarningMacro( "Convex hull topology is inconsistent. No convex hull generated." );
+      this->Reset();
+      return false;
+    }
+  }
+  this->CompactFaces();
+  return true;
+}
+
+//------------------------------------------------------------------------------
+void vtkSlicerMarkupsToModelConvexHullGeneration::vtkInternal::Reset()
+{
+  this->Coordinates.clear();
+  this->Faces.clear();
+  this->EdgeToFace.clear();
+  this->PendingFaceIndices.clear();
+  this->NumberOfFacesAtPoint.clear();
+  this->NumberOfDeletedFaces = 0;
+}
+
+//------------------------------------------------------------------------------
+bool vtkSlicerMarkupsToModelConvexHullGeneration::vtkInternal::InsertPoint( vtkIdType pointId )
+{
+  int visibleFaceIndex = this->FindVisibleFace( this->GetPoint( pointId ) );
+  if ( visibleFaceIndex < 0 )
+  {
+    // inside the hull or on its surface
+    return false;
+  }
+  if ( !this->AddPoint( pointId, visibleFaceIndex ) )
+  {
+    vtkGenericWarningMacro( "Convex hull topology is inconsistent. The convex hull is removed." );
+    this->Reset();
+    return true;
+  }
+  // deleted faces are only removed from time to time, to keep insertion cheap
+  if ( this->NumberOfDeletedFaces > static_cast< int >( this->Faces.size() ) / 2 )
+  {
+    this->CompactFaces();
+  }
+  return true;
+}
+
+//------------------------------------------------------------------------------
+int vtkSlicerMarkupsToModelConvexHullGeneration::vtkInternal::FindVisibleFace( const double* point ) const
+{
+  int visibleFaceIndex = -1;
+  double maximumDistance = this->Tolerance;
+  for ( int faceIndex = 0; faceIndex < static_cast< int >( this->Faces.size() ); faceIndex++ )
+  {
+    const Face& face = this->Faces[ faceIndex ];
+    if ( face.Deleted )
+    {
+      continue;
+    }
+    double distance = this->GetDistanceFromFace( face, point );
+    if ( distance > maximumDistance )
+    {
+      maximumDistance = distance;
+      visibleFaceIndex = faceIndex;
+    }
+  }
+  return visibleFaceIndex;
+}
+
+//------------------------------------------------------------------------------
+void vtkSlicerMarkupsToModelConvexHullGeneration::vtkInternal::CompactFaces()
+{
+  std::vector< Face > faces;
+  faces.reserve( this->Faces.size() - this->NumberOfDeletedFaces );
+  this->EdgeToFace.clear();
+  for ( std::vector< Face >::iterator faceIt = this->Faces.begin(); faceIt != this->Faces.end(); ++faceIt )
+  {
+    if ( faceIt->Deleted )
+    {
+      continue;
+    }
+    int faceIndex = static_cast< int >( faces.size() );
+    faces.push_back( *faceIt );
+    for ( int i = 0; i < 3; i++ )
+    {
+      this->EdgeToFace[ std::make_pair( faceIt->PointIds[ i ], faceIt->PointIds[ ( i + 1 ) % 3 ] ) ] = faceIndex;
+    }
+  }
+  this->Faces.swap( faces );
+  this->PendingFaceIndices.clear();
+  this->NumberOfDeletedFaces = 0;
+}
+
+//------------------------------------------------------------------------------
+bool vtkSlicerMarkupsToModelConvexHullGeneration::vtkInternal::InitializeSimplex()
+{
+  vtkIdType numberOfPoints = static_cast< vtkIdType >( this->Coordinates.size() / 3 );
+
+  // extreme points along the coordinate axes
+  vtkIdType extremePointIds[ 6 ] = { 0, 0, 0, 0, 0, 0 };
+  for ( vtkIdType pointId = 1; pointId < numberOfPoints; pointId++ )
+  {
+    const double* point = this->GetPoint( pointId );
+    for ( int axis = 0; axis < 3; axis++ )
+    {
+      if ( point[ axis ] < this->GetPoint( extremePointIds[ 2 * axis ] )[ axis ] )
+      {
+        extremePointIds[ 2 * axis ] = pointId;
+      }
+      if ( point[ axis ] > this->GetPoint( extremePointIds[ 2 * axis + 1 ] )[ axis ] )
+      {
+        extremePointIds[ 2 * axis + 1 ] = pointId;
+      }
+    }
+  }
+
+  // the two most distant extreme points
+  vtkIdType simplexPointIds[ 4 ] = { 0, 0, 0, 0 };
+  double maximumDistance2 = -1.0;
+  for ( int i = 0; i < 6; i++ )
+  {
+    for ( int j = i + 1; j < 6; j++ )
+    {
+      double distance2 = vtkMath::Distance2BetweenPoints( this->GetPoint( extremePointIds[ i ] ), this->GetPoint( extremePointIds[ j ] ) );
+      if ( distance2 > maximumDistance2 )
+      {
+        maximumDistance2 = distance2;
+        simplexPointIds[ 0 ] = extremePointIds[ i ];
+        simplexPointIds[ 1 ] = extremePointIds[ j ];
+      }
+    }
+  }
+  double size = sqrt( maximumDistance2 );
+  this->Tolerance = std::max( HULL_DISTANCE_MINIMUM_TOLERANCE, HULL_DISTANCE_RELATIVE_TOLERANCE * size );
+  if ( size <= this->Tolerance )
+  {
+    // all points are at the same position
+    return false;
+  }
+
+  // the point farthest from the line
+  const double* point0 = this->GetPoint( simplexPointIds[ 0 ] );
+  double lineDirection[ 3 ] = { 0.0, 0.0, 0.0 };
+  vtkMath::Subtract( this->GetPoint( simplexPointIds[ 1 ] ), point0, lineDirection );
+  vtkMath::Normalize( lineDirection );
+  double maximumLineDistance = 0.0;
+  for ( vtkIdType pointId = 0; pointId < numberOfPoints; pointId++ )
+  {
+    double offset[ 3 ] = { 0.0, 0.0, 0.0 };
+    vtkMath::Subtract( this->GetPoint( pointId ), point0, offset );
+    double perpendicular[ 3 ] = { 0.0, 0.0, 0.0 };
+    vtkMath::Cross( offset, lineDirection, perpendicular );
+    double lineDistance = vtkMath::Norm( perpendicular );
+    if ( lineDistance > maximumLineDistance )
+    {
+      maximumLineDistance = lineDistance;
+      simplexPointIds[ 2 ] = pointId;
+    }
+  }
+  if ( maximumLineDistance <= this->Tolerance )
+  {
+    // all points are on a line
+    return false;
+  }
+
+  // the point farthest from the plane
+  double planeNormal[ 3 ] = { 0.0, 0.0, 0.0 };
+  double planeVector[ 3 ] = { 0.0, 0.0, 0.0 };
+  vtkMath::Subtract( this->GetPoint( simplexPointIds[ 2 ] ), point0, planeVector );
+  vtkMath::Cross( lineDirection, planeVector, planeNormal );
+  vtkMath::Normalize( planeNormal );
+  double maximumPlaneDistance = 0.0;
+  for ( vtkIdType pointId = 0; pointId < numberOfPoints; pointId++ )
+  {
+    double offset[ 3 ] = { 0.0, 0.0, 0.0 };
+    vtkMath::Subtract( this->GetPoint( pointId ), point0, offset );
+    double planeDistance = vtkMath::Dot( offset, planeNormal );
+    if ( fabs( planeDistance ) > fabs( maximumPlaneDistance ) )
+    {
+      maximumPlaneDistance = planeDistance;
+      simplexPointIds[ 3 ] = pointId;
+    }
+  }
+  if ( fabs( maximumPlaneDistance ) <= this->Tolerance )
+  {
+    // all points are on a plane
+    return false;
+  }
+
+  // face (0,1,2) must point away from point 3
+  if ( maximumPlaneDistance > 0.0 )
+  {
+    std::swap( simplexPointIds[ 1 ], simplexPointIds[ 2 ] );
+  }
+  std::vector< int > faceIndices;
+  faceIndices.push_back( this->AddFace( simplexPointIds[ 0 ], simplexPointIds[ 1 ], simplexPointIds[ 2 ] ) );
+  faceIndices.push_back( this->AddFace( simplexPointIds[ 0 ], simplexPointIds[ 3 ], simplexPointIds[ 1 ] ) );
+  faceIndices.push_back( this->AddFace( simplexPointIds[ 1 ], simplexPointIds[ 3 ], simplexPointIds[ 2 ] ) );
+  faceIndices.push_back( this->AddFace( simplexPointIds[ 2 ], simplexPointIds[ 3 ], simplexPointIds[ 0 ] ) );
+
+  std::vector< vtkIdType > remainingPointIds;
+  remainingPointIds.reserve( numberOfPoints );
+  for ( vtkIdType pointId = 0; pointId < numberOfPoints; pointId++ )
+  {
+    if ( pointId != simplexPointIds[ 0 ] && pointId != simplexPointIds[ 1 ]
+      && pointId != simplexPointIds[ 2 ] && pointId != simplexPointIds[ 3 ] )
+    {
+      remainingPointIds.push_back( pointId );
+    }
+  }
+  this->AssignOutsidePoints( remainingPointIds, faceIndices );
+  return true;
+}
+
+//------------------------------------------------------------------------------
+int vtkSlicerMarkupsToModelConvexHullGeneration::vtkInternal::AddFace( vtkIdType pointId0, vtkIdType pointId1, vtkIdType pointId2 )
+{
+  Face face;
+  face.PointIds[ 0 ] = pointId0;
+  face.PointIds[ 1 ] = pointId1;
+  face.PointIds[ 2 ] = pointId2;
+  face.Deleted = false;
+  face.VisitStamp = 0;
+  face.Visible = false;
+
+  const double* point0 = this->GetPoint( pointId0 );
+  double edge1[ 3 ] = { 0.0, 0.0, 0.0 };
+  double edge2[ 3 ] = { 0.0, 0.0, 0.0 };
+  vtkMath::Subtract( this->GetPoint( pointId1 ), point0, edge1 );
+  vtkMath::Subtract( this->GetPoint( pointId2 ), point0, edge2 );
+  vtkMath::Cross( edge1, edge2, face.Normal );
+  vtkMath::Normalize( face.Normal ); // a degenerate face gets zero normal, so no point will ever be above it
+  face.Offset = vtkMath::Dot( face.Normal, point0 );
+
+  int faceIndex = static_cast< int >( this->Faces.size() );
+  this->Faces.push_back( face );
+  for ( int i = 0; i < 3; i++ )
+  {
+    this->EdgeToFace[ std::make_pair( face.PointIds[ i ], face.PointIds[ ( i + 1 ) % 3 ] ) ] = faceIndex;
+    this->NumberOfFacesAtPoint[ face.PointIds[ i ] ]++;
+  }
+  return faceIndex;
+}
+
+//------------------------------------------------------------------------------
+void vtkSlicerMarkupsToModelConvexHullGeneration::vtkInternal::DeleteFace( int faceIndex )
+{
+  Face& face = this->Faces[ faceIndex ];
+  for ( int i = 0; i < 3; i++ )
+  {
+    std::unordered_map< std::pair< vtkIdType, vtkIdType >, int, vtkHullEdgeHash >::iterator edgeIt =
+      this->EdgeToFace.find( std::make_pair( face.PointIds[ i ], face.PointIds[ ( i + 1 ) % 3 ] ) );
+    if ( edgeIt != this->EdgeToFace.end() && edgeIt->second == faceIndex )
+    {
+      this->EdgeToFace.erase( edgeIt );
+    }
+    this->NumberOfFacesAtPoint[ face.PointIds[ i ] ]--;
+  }
+  face.Deleted = true;
+  this->NumberOfDeletedFaces++;
+  face.OutsidePointIds.clear();
+  face.OutsidePointIds.shrink_to_fit();
+}
+
+//------------------------------------------------------------------------------
+bool vtkSlicerMarkupsToModelConvexHullGeneration::vtkInternal::AddPoint( vtkIdType eyePointId, int visibleFaceIndex )
+{
+  const double* eyePoint = this->GetPoint( eyePointId );
+  this->CurrentVisitStamp++;
+
+  // Find all faces visible from the eye point (they form a connected region) and the horizon edges around them
+  std::vector< int > visibleFaceIndices;
+  std::vector< std::pair< vtkIdType, vtkIdType > > horizonEdges;
+  std::vector< int > faceIndicesToVisit;
+  this->Faces[ visibleFaceIndex ].VisitStamp = this->CurrentVisitStamp;
+  this->Faces[ visibleFaceIndex ].Visible = true;
+  faceIndicesToVisit.push_back( visibleFaceIndex );
+  while ( !faceIndicesToVisit.empty() )
+  {
+    int faceIndex = faceIndicesToVisit.back();
+    faceIndicesToVisit.pop_back();
+    visibleFaceIndices.push_back( faceIndex );
+    for ( int i = 0; i < 3; i++ )
+    {
+      vtkIdType edgeStartPointId = this->Faces[ faceIndex ].PointIds[ i ];
+      vtkIdType edgeEndPointId = this->Faces[ faceIndex ].PointIds[ ( i + 1 ) % 3 ];
+      std::unordered_map< std::pair< vtkIdType, vtkIdType >, int, vtkHullEdgeHash >::const_iterator neighborIt =
+        this->EdgeToFace.find( std::make_pair( edgeEndPointId, edgeStartPointId ) );
+      if ( neighborIt == this->EdgeToFace.end() )
+      {
+        return false;
+      }
+      int neighborFaceIndex = neighborIt->second;
+      Face& neighborFace = this->Faces[ neighborFaceIndex ];
+      if ( neighborFace.VisitStamp != this->CurrentVisitStamp )
+      {
+        neighborFace.VisitStamp = this->CurrentVisitStamp;
+        neighborFace.Visible = ( this->GetDistanceFromFace( neighborFace, eyePoint ) > this->Tolerance );
+        if ( neighborFace.Visible )
+        {
+          faceIndicesToVisit.push_back( neighborFaceIndex );
+        }
+      }
+      if ( !neighborFace.Visible )
+      {
+        horizonEdges.push_back( std::make_pair( edgeStartPointId, edgeEndPointId ) );
+      }
+    }
+  }
+
+  // Remove visible faces, keep their outside points for reassignment
+  std::vector< vtkIdType > orphanPointIds;
+  for ( std::vector< int >::iterator faceIndexIt = visibleFaceIndices.begin(); faceIndexIt != visibleFaceIndices.end(); ++faceIndexIt )
+  {
+    Face& face = this->Faces[ *faceIndexIt ];
+    for ( std::vector< vtkIdType >::iterator pointIdIt = face.OutsidePointIds.begin(); pointIdIt != face.OutsidePointIds.end(); ++pointIdIt )
+    {
+      if ( *pointIdIt != eyePointId )
+      {
+        orphanPointIds.push_back( *pointIdIt );
+      }
+    }
+    this->DeleteFace( *faceIndexIt );
+  }
+
+  // Connect the horizon to the eye point. The new faces keep the orientation of the removed faces.
+  std::vector< int > newFaceIndices;
+  newFaceIndices.reserve( horizonEdges.size() );
+  for ( std::vector< std::pair< vtkIdType, vtkIdType > >::iterator edgeIt = horizonEdges.begin(); edgeIt != horizonEdges.end(); ++edgeIt )
+  {
+    newFaceIndices.push_back( this->AddFace( edgeIt->first, edgeIt->second, eyePointId ) );
+  }
+  this->AssignOutsidePoints( orphanPointIds, newFaceIndices );
+  return true;
+}
+
+//------------------------------------------------------------------------------
+void vtkSlicerMarkupsToModelConvexHullGeneration::vtkInternal::AssignOutsidePoints( const std::vector< vtkIdType >& pointIds, const std::vector< int >& faceIndices )
+{
+  for ( std::vector< vtkIdType >::const_iterator pointIdIt = pointIds.begin(); pointIdIt != pointIds.end(); ++pointIdIt )
+  {
+    const double* point = this->GetPoint( *pointIdIt );
+    for ( std::vector< int >::const_iterator faceIndexIt = faceIndices.begin(); faceIndexIt != faceIndices.end(); ++faceIndexIt )
+    {
+      Face& face = this->Faces[ *faceIndexIt ];
+      if ( this->GetDistanceFromFace( face, point ) > this->Tolerance )
+      {
+        face.OutsidePointIds.push_back( *pointIdIt );
+        break;
+      }
+    }
+  }
+  for ( std::vector< int >::const_iterator faceIndexIt = faceIndices.begin(); faceIndexIt != faceIndices.end(); ++faceIndexIt )
+  {
+    if ( !this->Faces[ *faceIndexIt ].OutsidePointIds.empty() )
+    {
+      this->PendingFaceIndices.push_back( *faceIndexIt );
+    }
+  }
+}
+
+//------------------------------------------------------------------------------
+void vtkSlicerMarkupsToModelConvexHullGeneration::vtkInternal::GetPolyData( vtkPolyData* outputPolyData )
+{
+  vtkIdType numberOfInputPoints = static_cast< vtkIdType >( this->Coordinates.size() / 3 );
+  std::vector< vtkIdType > outputPointIds( numberOfInputPoints, -1 );
+  vtkSmartPointer< vtkPoints > hullPoints = vtkSmartPointer< vtkPoints >::New();
+  vtkSmartPointer< vtkCellArray > hullPolys = vtkSmartPointer< vtkCellArray >::New();
+  for ( std::vector< Face >::iterator faceIt = this->Faces.begin(); faceIt != this->Faces.end(); ++faceIt )
+  {
+    if ( faceIt->Deleted )
+    {
+      continue;
+    }
+    vtkIdType trianglePointIds[ 3 ] = { 0, 0, 0 };
+    for ( int i = 0; i < 3; i++ )
+    {
+      vtkIdType inputPointId = faceIt->PointIds[ i ];
+      if ( outputPointIds[ inputPointId ] < 0 )
+      {
+        outputPointIds[ inputPointId ] = hullPoints->InsertNextPoint( this->GetPoint( inputPointId ) );
+      }
+      trianglePointIds[ i ] = outputPointIds[ inputPointId ];
+    }
+    hullPolys->InsertNextCell( 3, trianglePointIds );
+  }
+  outputPolyData->Initialize();
+  outputPolyData->SetPoints( hullPoints );
+  outputPolyData->SetPolys( hullPolys );
+}
+
+//------------------------------------------------------------------------------
+vtkStandardNewMacro( vtkSlicerMarkupsToModelConvexHullGeneration );
+
+//------------------------------------------------------------------------------
+vtkSlicerMarkupsToModelConvexHullGeneration::vtkSlicerMarkupsToModelConvexHullGeneration()
+{
+  this->Internal = new vtkInternal;
+}
+
+//------------------------------------------------------------------------------
+vtkSlicerMarkupsToModelConvexHullGeneration::~vtkSlicerMarkupsToModelConvexHullGeneration()
+{
+  delete this->Internal;
+}
+
+//------------------------------------------------------------------------------
+bool vtkSlicerMarkupsToModelConvexHullGeneration::GenerateConvexHullModel( vtkPoints* points, vtkPolyData* outputPolyData )
+{
+  if ( points == NULL )
+  {
+    vtkGenericWarningMacro( "Input points are null. No convex hull generated." );
+    return false;
+  }
+
+  if ( outputPolyData == NULL )
+  {
+    vtkGenericWarningMacro( "Output poly data is null. No convex hull generated." );
+    return false;
+  }
+
+  vtkInternal hull;
+  if ( !hull.Build( points ) )
+  {
+    return false;
+  }
+  hull.GetPolyData( outputPolyData );
+  return true;
+}
+
+//------------------------------------------------------------------------------
+bool vtkSlicerMarkupsToModelConvexHullGeneration::Build( vtkPoints* points )
+{
+  if ( points == NULL )
+  {
+    vtkGenericWarningMacro( "Input points are null. No convex hull generated." );
+    this->Internal->Reset();
+    return false;
+  }
+  return this->Internal->Build( points );
+}
+
+//------------------------------------------------------------------------------
+void vtkSlicerMarkupsToModelConvexHullGeneration::Reset()
+{
+  this->Internal->Reset();
+}
+
+//------------------------------------------------------------------------------
+bool vtkSlicerMarkupsToModelConvexHullGeneration::HasHull()
+{
+  return !this->Internal->Faces.empty();
+}
+
+//------------------------------------------------------------------------------
+vtkIdType vtkSlicerMarkupsToModelConvexHullGeneration::GetNumberOfPoints()
+{
+  return static_cast< vtkIdType >( this->Internal->Coordinates.size() / 3 );
+}
+
+//------------------------------------------------------------------------------
+bool vtkSlicerMarkupsToModelConvexHullGeneration::IsHullVertex( vtkIdType pointId )
+{
+  if ( pointId < 0 || pointId >= this->GetNumberOfPoints() )
+  {
+    return false;
+  }
+  return this->Internal->NumberOfFacesAtPoint[ pointId ] > 0;
+}
+
+//------------------------------------------------------------------------------
+bool vtkSlicerMarkupsToModelConvexHullGeneration::InsertPoint( const double point[ 3 ] )
+{
+  if ( !this->HasHull() )
+  {
+    vtkGenericWarningMacro( "Convex hull is not computed. Cannot insert point." );
+    return false;
+  }
+  vtkIdType pointId = this->GetNumberOfPoints();
+  this->Internal->Coordinates.insert( this->Internal->Coordinates.end(), point, point + 3 );
+  this->Internal->NumberOfFacesAtPoint.push_back( 0 );
+  return this->Internal->InsertPoint( pointId );
+}
+
+//------------------------------------------------------------------------------
+bool vtkSlicerMarkupsToModelConvexHullGeneration::SetPoint( vtkIdType pointId, const double point[ 3 ], bool& hullModified )
+{
+  hullModified = false;
+  if ( !this->HasHull() || pointId < 0 || pointId >= this->GetNumberOfPoints() )
+  {
+    return false;
+  }
+  if ( this->IsHullVertex( pointId ) )
+  {
+    // the hull may shrink, which cannot be computed from the current hull
+    return false;
+  }
+  // the point did not contribute to the hull, so it only matters if it moved outside
+  std::copy( point, point + 3, this->Internal->Coordinates.begin() + 3 * pointId );
+  hullModified = this->Internal->InsertPoint( pointId );
+  return this->HasHull();
+}
+
+//------------------------------------------------------------------------------
+void vtkSlicerMarkupsToModelConvexHullGeneration::GetPolyData( vtkPolyData* outputPolyData )
+{
+  if ( outputPolyData == NULL )
+  {
+    vtkGenericWarningMacro( "Output poly data is null. No convex hull generated." );
+    return;
+  }
+  this->Internal->GetPolyData( outputPolyData );
+}
+
+//------------------------------------------------------------------------------
+void vtkSlicerMarkupsToModelConvexHullGeneration::PrintSelf( ostream &os, vtkIndent indent )
+{
+  Superclass::PrintSelf( os, indent );
+  os << indent << "NumberOfPoints: " << this->GetNumberOfPoints() << std::endl;
+  os << indent << "NumberOfFaces: " << this->Internal->Faces.size() - this->Internal->NumberOfDeletedFaces << std::endl;
+}
@@ -0,0 +1,73 @@
+#ifndef __vtkSlicerMarkupsToModelConvexHullGeneration_h
+#define __vtkSlicerMarkupsToModelConvexHullGeneration_h
+
+// vtk includes
+#include <vtkObject.h>
+#include <vtkPoints.h>
+#include <vtkPolyData.h>
+
+#include "vtkSlicerMarkupsToModelModuleLogicExport.h"
+
+// Computes the convex hull of a point set directly, using the quickhull algorithm
+// (Barber et al., "The quickhull algorithm for convex hulls", ACM TOMS 1996).
+//
+// This is much faster than computing a full Delaunay tetrahedralization and extracting its surface.
+// The output contains only the hull vertices and outward oriented triangles.
+//
+// An instance keeps the hull of its points, so that the hull can be updated when points are added or moved.
+// Points that are not hull vertices can be moved freely: if they stay inside then the hull does not change.
+class VTK_SLICER_MARKUPSTOMODEL_MODULE_LOGIC_EXPORT vtkSlicerMarkupsToModelConvexHullGeneration : public vtkObject
+{
+  public:
+    // standard vtk object methods
+    vtkTypeMacro( vtkSlicerMarkupsToModelConvexHullGeneration, vtkObject );
+    void PrintSelf( ostream& os, vtkIndent indent ) override;
+    static vtkSlicerMarkupsToModelConvexHullGeneration *New();
+
+    // Generate the triangulated convex hull of the points. Any previous content of outputPolyData is replaced.
+    // Returns false if the points do not span a volume (all points are on a plane, line, or at a single position),
+    // in this case the output is not modified.
+    static bool GenerateConvexHullModel( vtkPoints* points, vtkPolyData* outputPolyData );
+
+    // Compute the convex hull of the points and keep it for incremental updates.
+    // Returns false if the points do not span a volume, in this case the hull is empty.
+    bool Build( vtkPoints* points );
+
+    // Remove the hull and all points.
+    void Reset();
+
+    // Returns true if the hull has been computed.
+    bool HasHull();
+
+    // Number of points that the hull was computed from (including the inserted points).
+    vtkIdType GetNumberOfPoints();
+
+    // Returns true if the point is a vertex of the hull.
+    bool IsHullVertex( vtkIdType pointId );
+
+    // Add a point (its index is the previous number of points).
+    // Returns true if the hull changed, i.e. the point is outside of the hull.
+    // If the hull could not be updated then it is removed (HasHull returns false) and Build must be called.
+    bool InsertPoint( const double point[ 3 ] );
+
+    // Move a point. hullModified is set to true if the hull changed.
+    // Returns false if the hull cannot be updated incrementally (the point is a hull vertex or the update failed), then Build must be called.
+    bool SetPoint( vtkIdType pointId, const double point[ 3 ], bool& hullModified );
+
+    // Write the hull vertices and triangles into the poly data. Any previous content of outputPolyData is replaced.
+    void GetPolyData( vtkPolyData* outputPolyData );
+
+  protected:
+    vtkSlicerMarkupsToModelConvexHullGeneration();
+    ~vtkSlicerMarkupsToModelConvexHullGeneration();
+
+  private:
+    class vtkInternal;
+    vtkInternal* Internal;
+
+    // not used
+    vtkSlicerMarkupsToModelConvexHullGeneration ( const vtkSlicerMarkupsToModelConvexHullGeneration& ) =delete;
+    void operator= ( const vtkSlicerMarkupsToModelConvexHullGeneration& ) =delete;
+};
+
+#endif
@@ -18,10 +18,14 @@
 // MarkupsToModel Logic includes
 #include "vtkSlicerMarkupsToModelLogic.h"
 #include "vtkSlicerMarkupsToModelClosedSurfaceGeneration.h"
+#include "vtkSlicerMarkupsToModelConvexHullGeneration.h"
+#include "vtkSlicerMarkupsToModelMeshCache.h"
+#include "vtkSlicerMarkupsToModelTubeGeneration.h"
 #include "vtkCurveGenerator.h"
 
 // MRML includes
 #include "vtkMRMLMarkupsNode.h"
+#include "vtkMRMLMarkupsToModelTracer.h"
 #include "vtkMRMLModelNode.h"
 #include "vtkMRMLSelectionNode.h"
 #include <vtkMRMLModelDisplayNode.h>
@@ -30,7 +34,6 @@
 
 // VTK includes
 #include <vtkCellArray.h>
-#include <vtkCleanPolyData.h>
 #include <vtkCollection.h>
 #include <vtkCollectionIterator.h>
 #include <vtkDoubleArray.h>
@@ -39,301 +42,2360 @@
 #include <vtkNew.h>
 #include <vtkObjectFactory.h>
 #include <vtkPoints.h>
+#include <vtkLine.h>
+#include <vtkSMPTools.h>
 #include <vtkSphereSource.h>
-#include <vtkTubeFilter.h>
+#include <vtkTimerLog.h>
+#include <vtkWeakPointer.h>
 
 // STD includes
+#include <algorithm>
+#include <atomic>
 #include <cassert>
+#include <chrono>
 #include <cmath>
+#include <condition_variable>
+#include <deque>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
 #include <vector>
 #include <set>
 
-//----------------------------------------------------------------------------
-vtkStandardNewMacro(vtkSlicerMarkupsToModelLogic);
+// Curve points of an incremental update may differ from a full update by at most this distance
+static const double INCREMENTAL_CURVE_UPDATE_TOLERANCE_MM = 0.001;
 
 //----------------------------------------------------------------------------
-vtkSlicerMarkupsToModelLogic::vtkSlicerMarkupsToModelLogic()
+// The output model of the parameter node is shown in any view
+static bool IsOutputModelVisible( vtkMRMLMarkupsToModelNode* moduleNode )
 {
-  this->CurveGenerator = vtkSmartPointer< vtkCurveGenerator >::New();
+  vtkMRMLModelNode* outputModelNode = moduleNode->GetOutputModelNode();
+  if ( outputModelNode == NULL )
+  {
+    return false;
+  }
+  for ( int displayNodeIndex = 0; displayNodeIndex < outputModelNode->GetNumberOfDisplayNodes(); displayNodeIndex++ )
+  {
+    vtkMRMLDisplayNode* displayNode = outputModelNode->GetNthDisplayNode( displayNodeIndex );
+    if ( displayNode != NULL && displayNode->GetVisibility() )
+    {
+      return true;
+    }
+  }
+  return false;
 }
 
 //----------------------------------------------------------------------------
-vtkSlicerMarkupsToModelLogic::~vtkSlicerMarkupsToModelLogic()
+// Output is generated at reduced quality while the user is interacting, if level of detail is enabled
+static bool IsReducedLevelOfDetail( vtkMRMLMarkupsToModelNode* moduleNode )
 {
+  return moduleNode->GetInteracting() && moduleNode->GetInteractionLevelOfDetail();
 }
 
 //----------------------------------------------------------------------------
-void vtkSlicerMarkupsToModelLogic::PrintSelf(ostream& os, vtkIndent indent)
+// Generation was cancelled by the caller (see vtkSlicerMarkupsToModelLogic::GenerateOutputModel)
+static bool IsCancelled( const std::atomic< bool >* cancelled )
 {
-  this->Superclass::PrintSelf(os, indent);
+  return cancelled != NULL && *cancelled;
 }
 
-//---------------------------------------------------------------------------
-void vtkSlicerMarkupsToModelLogic::SetMRMLSceneInternal(vtkMRMLScene * newScene)
+//----------------------------------------------------------------------------
+// Mark all stages of an output update as not performed (see vtkMRMLMarkupsToModelNode::AddStageTimes)
+static void InitializeStageTimes( double* stageTimes )
 {
-  vtkNew<vtkIntArray> events;
-  events->InsertNextValue(vtkMRMLScene::NodeAddedEvent);
-  events->InsertNextValue(vtkMRMLScene::NodeRemovedEvent);
-  events->InsertNextValue(vtkMRMLScene::StartBatchProcessEvent);
-  events->InsertNextValue(vtkMRMLScene::EndBatchProcessEvent);
-  events->InsertNextValue(vtkMRMLScene::StartImportEvent);
-  events->InsertNextValue(vtkMRMLScene::EndImportEvent);
-  this->SetAndObserveMRMLSceneEventsInternal(newScene, events.GetPointer());
+  std::fill( stageTimes, stageTimes + vtkMRMLMarkupsToModelNode::TimedStage_Last, -1.0 );
 }
 
-//-----------------------------------------------------------------------------
-void vtkSlicerMarkupsToModelLogic::RegisterNodes()
+//----------------------------------------------------------------------------
+// Measures the duration of a stage of an output update with a high resolution clock,
+// and adds it to the stage times (if specified) when stopped or when it goes out of scope.
+// The stage is also recorded as a span if tracing is enabled (see vtkMRMLMarkupsToModelTracer).
+class StageTimer
 {
-  if (!this->GetMRMLScene())
+public:
+  StageTimer( double* stageTimes, int stage )
+    : StageTimes( stageTimes )
+    , Stage( stage )
+    , StartTime( std::chrono::steady_clock::now() )
+    , TraceStartTime( -1.0 )
   {
-    vtkWarningMacro("MRML scene not yet created");
-    return;
+    if ( vtkMRMLMarkupsToModelTracer::IsTracing() )
+    {
+      this->TraceStartTime = vtkMRMLMarkupsToModelTracer::GetInstance()->GetTime();
+    }
+  }
+  ~StageTimer()
+  {
+    this->Stop();
+  }
+  void Stop()
+  {
+    if ( this->TraceStartTime >= 0.0 )
+    {
+      vtkMRMLMarkupsToModelTracer::GetInstance()->AddSpan(
+        vtkMRMLMarkupsToModelNode::GetTimedStageAsString( this->Stage ), "stage", this->TraceStartTime );
+      this->TraceStartTime = -1.0;
+    }
+    if ( this->StageTimes == NULL )
+    {
+      return;
+    }
+    double elapsedTime = std::chrono::duration< double >( std::chrono::steady_clock::now() - this->StartTime ).count();
+    // a stage may be performed more than once in an update
+    this->StageTimes[ this->Stage ] = std::max( this->StageTimes[ this->Stage ], 0.0 ) + elapsedTime;
+    this->StageTimes = NULL;
   }
 
-  this->GetMRMLScene()->RegisterNodeClass(vtkSmartPointer< vtkMRMLMarkupsToModelNode >::New());
+private:
+  double* StageTimes;
+  int Stage;
+  std::chrono::steady_clock::time_point StartTime;
+  double TraceStartTime; // negative if the stage is not traced
+};
+
+//----------------------------------------------------------------------------
+// Records the stage times of an output update in the parameter node and counts the update when the update is finished
+// (goes out of scope), unless the update is continued on a worker thread
+class StageTimesRecorder
+{
+public:
+  StageTimesRecorder( vtkMRMLMarkupsToModelNode* moduleNode, double* stageTimes, vtkTypeUInt64* numberOfPerformedUpdates )
+    : ModuleNode( moduleNode )
+    , StageTimes( stageTimes )
+    , NumberOfPerformedUpdates( numberOfPerformedUpdates )
+    , Enabled( true )
+  {
+    InitializeStageTimes( stageTimes );
+  }
+  ~StageTimesRecorder()
+  {
+    if ( this->Enabled )
+    {
+      this->ModuleNode->AddStageTimes( this->StageTimes );
+      ( *this->NumberOfPerformedUpdates )++;
+    }
+  }
+  void Disable()
+  {
+    this->Enabled = false;
+  }
+
+private:
+  vtkMRMLMarkupsToModelNode* ModuleNode;
+  double* StageTimes;
+  vtkTypeUInt64* NumberOfPerformedUpdates;
+  bool Enabled;
+};
+
+//----------------------------------------------------------------------------
+// Curve model resolution for the current level of detail
+static void GetCurveResolution( vtkMRMLMarkupsToModelNode* moduleNode,
+  int& tubeNumberOfSides, int& tubeSegmentsBetweenControlPoints, int& maximumSamplesPerSegment )
+{
+  tubeNumberOfSides = moduleNode->GetTubeNumberOfSides();
+  tubeSegmentsBetweenControlPoints = moduleNode->GetTubeSegmentsBetweenControlPoints();
+  maximumSamplesPerSegment = moduleNode->GetMaximumSamplesPerSegment();
+  if ( IsReducedLevelOfDetail( moduleNode ) )
+  {
+    tubeNumberOfSides = std::min( tubeNumberOfSides, moduleNode->GetInteractionTubeNumberOfSides() );
+    tubeSegmentsBetweenControlPoints = std::min( tubeSegmentsBetweenControlPoints, moduleNode->GetInteractionTubeSegmentsBetweenControlPoints() );
+    maximumSamplesPerSegment = std::min( maximumSamplesPerSegment, moduleNode->GetInteractionTubeSegmentsBetweenControlPoints() );
+  }
 }
 
-//---------------------------------------------------------------------------
-void vtkSlicerMarkupsToModelLogic::UpdateFromMRMLScene()
+//----------------------------------------------------------------------------
+// Returns true if the two point lists contain exactly the same points in the same order
+static bool HaveSamePoints( vtkPoints* points1, vtkPoints* points2 )
 {
-  assert(this->GetMRMLScene() != 0);
+  vtkIdType numberOfPoints = points1->GetNumberOfPoints();
+  if ( numberOfPoints != points2->GetNumberOfPoints() )
+  {
+    return false;
+  }
+  for ( vtkIdType pointIndex = 0; pointIndex < numberOfPoints; pointIndex++ )
+  {
+    double point1[ 3 ] = { 0.0, 0.0, 0.0 };
+    double point2[ 3 ] = { 0.0, 0.0, 0.0 };
+    points1->GetPoint( pointIndex, point1 );
+    points2->GetPoint( pointIndex, point2 );
+    if ( point1[ 0 ] != point2[ 0 ] || point1[ 1 ] != point2[ 1 ] || point1[ 2 ] != point2[ 2 ] )
+    {
+      return false;
+    }
+  }
+  return true;
 }
 
-//---------------------------------------------------------------------------
-void vtkSlicerMarkupsToModelLogic::OnMRMLSceneEndImport()
+//----------------------------------------------------------------------------
+// Hash of the point coordinates (64-bit FNV-1a), for detecting if the input points changed
+static vtkTypeUInt64 ComputePointsFingerprint( vtkPoints* points )
 {
-  vtkSmartPointer<vtkCollection> markupsToModelNodes = vtkSmartPointer<vtkCollection>::Take(
-    this->GetMRMLScene()->GetNodesByClass("vtkMRMLMarkupsToModelNode"));
-  vtkNew<vtkCollectionIterator> markupsToModelNodeIt;
-  markupsToModelNodeIt->SetCollection(markupsToModelNodes);
-  for (markupsToModelNodeIt->InitTraversal(); !markupsToModelNodeIt->IsDoneWithTraversal(); markupsToModelNodeIt->GoToNextItem())
+  vtkTypeUInt64 fingerprint = 14695981039346656037ULL;
+  vtkIdType numberOfPoints = points->GetNumberOfPoints();
+  const unsigned char* numberOfPointsBytes = reinterpret_cast< const unsigned char* >( &numberOfPoints );
+  for ( size_t byteIndex = 0; byteIndex < sizeof( numberOfPoints ); byteIndex++ )
   {
-    vtkMRMLMarkupsToModelNode* markupsToModelNode = vtkMRMLMarkupsToModelNode::SafeDownCast(markupsToModelNodeIt->GetCurrentObject());
-    if (markupsToModelNode != NULL)
+    fingerprint = ( fingerprint ^ numberOfPointsBytes[ byteIndex ] ) * 1099511628211ULL;
+  }
+  for ( vtkIdType pointIndex = 0; pointIndex < numberOfPoints; pointIndex++ )
+  {
+    double point[ 3 ] = { 0.0, 0.0, 0.0 };
+    points->GetPoint( pointIndex, point );
+    const unsigned char* pointBytes = reinterpret_cast< const unsigned char* >( point );
+    for ( size_t byteIndex = 0; byteIndex < sizeof( point ); byteIndex++ )
     {
-      this->UpdateOutputModel(markupsToModelNode);
+      fingerprint = ( fingerprint ^ pointBytes[ byteIndex ] ) * 1099511628211ULL;
     }
   }
+  return fingerprint;
 }
 
-//---------------------------------------------------------------------------
-void vtkSlicerMarkupsToModelLogic::OnMRMLSceneStartImport()
+//----------------------------------------------------------------------------
+// Index of the duplicate point grid cell that contains the coordinate. Clamped to a range that
+// cannot overflow when neighbor cell indices are computed (coordinates are not finite or the cells are too small).
+static const double MAXIMUM_GRID_CELL_INDEX = 1.0e18;
+static long long GetGridCellIndex( double coordinate, double cellSize )
 {
+  double index = std::floor( coordinate / cellSize );
+  if ( !( index > -MAXIMUM_GRID_CELL_INDEX ) )
+  {
+    // also if the index is NaN
+    return static_cast< long long >( -MAXIMUM_GRID_CELL_INDEX );
+  }
+  return static_cast< long long >( std::min( index, MAXIMUM_GRID_CELL_INDEX ) );
 }
 
-//---------------------------------------------------------------------------
-void vtkSlicerMarkupsToModelLogic::OnMRMLSceneNodeAdded(vtkMRMLNode* node)
+//----------------------------------------------------------------------------
+// Uniform grid used for finding duplicate points. Only non-empty cells are stored, in an open addressing hash table.
+// Each cell stores the index of the first point of a linked list of the points in the cell.
+// Most searched cells are empty, this is detected from a compact bitmap of cell index hashes
+// (that fits in the cache), so the table itself is accessed only if the cell may exist.
+class DuplicatePointGrid
 {
-  if (node == NULL || this->GetMRMLScene() == NULL)
+public:
+  struct Cell
   {
-    vtkWarningMacro("OnMRMLSceneNodeAdded: Invalid MRML scene or node");
-    return;
+    long long Index[ 3 ];
+    vtkIdType FirstPointId; // -1 if the cell is empty
+  };
+
+  DuplicatePointGrid( vtkIdType maximumNumberOfCells )
+  {
+    size_t capacity = 64;
+    while ( capacity < 2 * static_cast< size_t >( maximumNumberOfCells ) )
+    {
+      capacity *= 2;
+    }
+    Cell emptyCell = { { 0, 0, 0 }, -1 };
+    this->Cells.assign( capacity, emptyCell );
+    this->UsedHashBits.assign( capacity / 8, 0 ); // 8 bits for each table slot
+    this->Mask = capacity - 1;
+    this->HashBitMask = 8 * capacity - 1;
   }
 
-  vtkMRMLMarkupsToModelNode* markupsToModelNode = vtkMRMLMarkupsToModelNode::SafeDownCast(node);
-  if (markupsToModelNode)
+  // Returns the first point in the cell with the given index, -1 if the cell is empty
+  vtkIdType GetFirstPointId( const long long index[ 3 ] )
   {
-    vtkDebugMacro("OnMRMLSceneNodeAdded: Module node added.");
-    vtkUnObserveMRMLNodeMacro(markupsToModelNode); // Remove previous observers.
-    vtkNew<vtkIntArray> events;
-    events->InsertNextValue(vtkCommand::ModifiedEvent);
-    events->InsertNextValue(vtkMRMLMarkupsToModelNode::MarkupsPositionModifiedEvent);
-    vtkObserveMRMLNodeEventsMacro(markupsToModelNode, events.GetPointer());
+    size_t hashBit = this->GetHashBit( index );
+    if ( ( this->UsedHashBits[ hashBit / 64 ] & ( 1ULL << ( hashBit % 64 ) ) ) == 0 )
+    {
+      return -1;
+    }
+    return this->GetCell( index ).FirstPointId;
   }
-}
 
-//---------------------------------------------------------------------------
-void vtkSlicerMarkupsToModelLogic::OnMRMLSceneNodeRemoved(vtkMRMLNode* node)
+  // Add a point to the cell with the given index. nextPointId is set to the previous first point of the cell.
+  void AddPoint( const long long index[ 3 ], vtkIdType pointId, vtkIdType& nextPointId )
+  {
+    Cell& cell = this->GetCell( index );
+    if ( cell.FirstPointId < 0 )
+    {
+      cell.Index[ 0 ] = index[ 0 ];
+      cell.Index[ 1 ] = index[ 1 ];
+      cell.Index[ 2 ] = index[ 2 ];
+      size_t hashBit = this->GetHashBit( index );
+      this->UsedHashBits[ hashBit / 64 ] |= ( 1ULL << ( hashBit % 64 ) );
+    }
+    nextPointId = cell.FirstPointId;
+    cell.FirstPointId = pointId;
+  }
+
+private:
+  static unsigned long long GetHash( const long long index[ 3 ] )
+  {
+    // large primes, as in Teschner et al., "Optimized Spatial Hashing for Collision Detection of Deformable Objects"
+    // (computed in unsigned arithmetic, which wraps around instead of overflowing)
+    unsigned long long hash = static_cast< unsigned long long >( index[ 0 ] ) * 73856093ULL
+      ^ static_cast< unsigned long long >( index[ 1 ] ) * 19349663ULL ^ static_cast< unsigned long long >( index[ 2 ] ) * 83492791ULL;
+    hash *= 0x9E3779B97F4A7C15ULL;
+    return hash ^ ( hash >> 32 );
+  }
+
+  size_t GetSlot( const long long index[ 3 ] ) const
+  {
+    return static_cast< size_t >( GetHash( index ) ) & this->Mask;
+  }
+
+  size_t GetHashBit( const long long index[ 3 ] ) const
+  {
+    // use different hash bits than for the slot, so that collisions in the table are not collisions in the bitmap
+    return static_cast< size_t >( GetHash( index ) >> 24 ) & this->HashBitMask;
+  }
+
+  // Returns the cell with the given index, or the empty cell where it can be inserted
+  Cell& GetCell( const long long index[ 3 ] )
+  {
+    size_t slot = this->GetSlot( index );
+    while ( this->Cells[ slot ].FirstPointId >= 0
+      && ( this->Cells[ slot ].Index[ 0 ] != index[ 0 ] || this->Cells[ slot ].Index[ 1 ] != index[ 1 ] || this->Cells[ slot ].Index[ 2 ] != index[ 2 ] ) )
+    {
+      slot = ( slot + 1 ) & this->Mask;
+    }
+    return this->Cells[ slot ];
+  }
+
+  std::vector< Cell > Cells;
+  std::vector< unsigned long long > UsedHashBits; // bit is set if a cell with an index that hashes to the bit has been added
+  size_t Mask;
+  size_t HashBitMask;
+};
+
+//----------------------------------------------------------------------------
+// Curve generated by the last update of a parameter node, kept so that
+// points appended at the end of the curve can be processed incrementally.
+struct CurveUpdateState
 {
-  if (node == NULL || this->GetMRMLScene() == NULL)
+  vtkSmartPointer< vtkPoints > ControlPoints;
+  vtkSmartPointer< vtkPoints > CurvePoints;
+  vtkWeakPointer< vtkPolyData > OutputPolyData;
+  double OutputCurveLength;
+
+  // Parameters used for generating the curve
+  bool CleanMarkups;
+  double DuplicatePointTolerance;
+  int CurveType;
+  int TubeSegmentsBetweenControlPoints;
+  int CurveSamplingMode;
+  bool TubeLoop;
+  bool TubeCapping;
+  double TubeRadius;
+  int TubeNumberOfSides;
+  bool KochanekEndsCopyNearestDerivatives;
+  double KochanekBias;
+  double KochanekContinuity;
+  double KochanekTension;
+
+  CurveUpdateState()
   {
-    vtkWarningMacro("OnMRMLSceneNodeRemoved: Invalid MRML scene or node");
-    return;
+    this->OutputCurveLength = 0.0;
+    this->CleanMarkups = true;
+    this->DuplicatePointTolerance = 0.0;
+    this->CurveType = vtkMRMLMarkupsToModelNode::Linear;
+    this->TubeSegmentsBetweenControlPoints = 0;
+    this->CurveSamplingMode = vtkMRMLMarkupsToModelNode::UniformSampling;
+    this->TubeLoop = false;
+    this->TubeCapping = true;
+    this->TubeRadius = 0.0;
+    this->TubeNumberOfSides = 0;
+    this->KochanekEndsCopyNearestDerivatives = false;
+    this->KochanekBias = 0.0;
+    this->KochanekContinuity = 0.0;
+    this->KochanekTension = 0.0;
   }
 
-  if (node->IsA("vtkSlicerMarkupsToModelNode"))
+  void SetParameters( vtkMRMLMarkupsToModelNode* moduleNode )
   {
-    vtkDebugMacro("OnMRMLSceneNodeRemoved");
-    vtkUnObserveMRMLNodeMacro(node);
+    this->CleanMarkups = moduleNode->GetCleanMarkups();
+    this->DuplicatePointTolerance = moduleNode->GetDuplicatePointTolerance();
+    this->CurveType = moduleNode->GetCurveType();
+    int unusedMaximumSamplesPerSegment = 0;
+    GetCurveResolution( moduleNode, this->TubeNumberOfSides, this->TubeSegmentsBetweenControlPoints, unusedMaximumSamplesPerSegment );
+    this->CurveSamplingMode = moduleNode->GetCurveSamplingMode();
+    this->TubeLoop = moduleNode->GetTubeLoop();
+    this->TubeCapping = moduleNode->GetTubeCapping();
+    this->TubeRadius = moduleNode->GetTubeRadius();
+    this->KochanekEndsCopyNearestDerivatives = moduleNode->GetKochanekEndsCopyNearestDerivatives();
+    this->KochanekBias = moduleNode->GetKochanekBias();
+    this->KochanekContinuity = moduleNode->GetKochanekContinuity();
+    this->KochanekTension = moduleNode->GetKochanekTension();
   }
-}
 
-//------------------------------------------------------------------------------
-void vtkSlicerMarkupsToModelLogic::UpdateSelectionNode(vtkMRMLMarkupsToModelNode* markupsToModelModuleNode)
+  bool HasSameParameters( vtkMRMLMarkupsToModelNode* moduleNode )
+  {
+    int tubeNumberOfSides = 0;
+    int tubeSegmentsBetweenControlPoints = 0;
+    int unusedMaximumSamplesPerSegment = 0;
+    GetCurveResolution( moduleNode, tubeNumberOfSides, tubeSegmentsBetweenControlPoints, unusedMaximumSamplesPerSegment );
+    return this->CleanMarkups == moduleNode->GetCleanMarkups()
+      && this->DuplicatePointTolerance == moduleNode->GetDuplicatePointTolerance()
+      && this->CurveType == moduleNode->GetCurveType()
+      && this->TubeSegmentsBetweenControlPoints == tubeSegmentsBetweenControlPoints
+      && this->TubeNumberOfSides == tubeNumberOfSides
+      && this->CurveSamplingMode == moduleNode->GetCurveSamplingMode()
+      && this->TubeLoop == moduleNode->GetTubeLoop()
+      && this->TubeCapping == moduleNode->GetTubeCapping()
+      && this->TubeRadius == moduleNode->GetTubeRadius()
+      && this->KochanekEndsCopyNearestDerivatives == moduleNode->GetKochanekEndsCopyNearestDerivatives()
+      && this->KochanekBias == moduleNode->GetKochanekBias()
+      && this->KochanekContinuity == moduleNode->GetKochanekContinuity()
+      && this->KochanekTension == moduleNode->GetKochanekTension();
+  }
+};
+
+//----------------------------------------------------------------------------
+// Control points and parameters that the closed surface of a parameter node was last generated from,
+// kept so that added or moved points can be processed incrementally
+// (using the convex hull kept in the closed surface generator of the node).
+struct ClosedSurfaceUpdateState
 {
-  if (!markupsToModelModuleNode)
+  vtkSmartPointer< vtkPoints > ControlPoints;
+  vtkWeakPointer< vtkPolyData > OutputPolyData;
+
+  // Parameters used for generating the surface
+  bool CleanMarkups;
+  double DuplicatePointTolerance;
+  double DelaunayAlpha;
+  bool ButterflySubdivision;
+  bool ForceConvex;
+  bool Subdivision;
+
+  ClosedSurfaceUpdateState()
   {
-    // No markups selected
-    return;
+    this->CleanMarkups = true;
+    this->DuplicatePointTolerance = 0.0;
+    this->DelaunayAlpha = 0.0;
+    this->ButterflySubdivision = true;
+    this->ForceConvex = false;
+    this->Subdivision = true;
   }
-  vtkMRMLNode* inputNode = markupsToModelModuleNode->GetInputNode();
-  vtkMRMLMarkupsNode* markupsNode = vtkMRMLMarkupsNode::SafeDownCast( inputNode );
-  if (!markupsNode)
+
+  void SetParameters( vtkMRMLMarkupsToModelNode* moduleNode )
   {
-    // No markups selected
-    return;
+    this->CleanMarkups = moduleNode->GetCleanMarkups();
+    this->DuplicatePointTolerance = moduleNode->GetDuplicatePointTolerance();
+    this->DelaunayAlpha = moduleNode->GetDelaunayAlpha();
+    this->ButterflySubdivision = moduleNode->GetButterflySubdivision();
+    this->ForceConvex = moduleNode->GetConvexHull();
+    this->Subdivision = !IsReducedLevelOfDetail( moduleNode );
   }
-  if (!this->GetMRMLScene())
+
+  bool HasSameParameters( vtkMRMLMarkupsToModelNode* moduleNode )
   {
-    vtkErrorMacro("UpdateSelectionNode: no scene defined!");
-    return;
+    return this->CleanMarkups == moduleNode->GetCleanMarkups()
+      && this->DuplicatePointTolerance == moduleNode->GetDuplicatePointTolerance()
+      && this->DelaunayAlpha == moduleNode->GetDelaunayAlpha()
+      && this->ButterflySubdivision == moduleNode->GetButterflySubdivision()
+      && this->ForceConvex == moduleNode->GetConvexHull()
+      && this->Subdivision == !IsReducedLevelOfDetail( moduleNode );
   }
+};
 
-  // try the application logic first
-  vtkMRMLApplicationLogic *mrmlAppLogic = this->GetMRMLApplicationLogic();
-  vtkMRMLSelectionNode *selectionNode = NULL;
-  if (mrmlAppLogic)
+//----------------------------------------------------------------------------
+// Number of curve segments on each side of a modified control point that are affected by the modification
+// and number of additional control points needed on each side for evaluating those segments correctly.
+// Cardinal spline is global, but the effect of a control point decreases quickly (by about 4x per segment);
+// the incremental result is always checked against the previous curve, so a too small window only means a full update.
+// Returns false if the curve cannot be evaluated locally.
+static bool GetCurveSegmentSupport( int curveType, int& numberOfAffectedSegments, int& numberOfContextPoints )
+{
+  switch ( curveType )
   {
-    selectionNode = mrmlAppLogic->GetSelectionNode();
+    case vtkMRMLMarkupsToModelNode::Linear: numberOfAffectedSegments = 1; numberOfContextPoints = 1; return true;
+    case vtkMRMLMarkupsToModelNode::KochanekSpline: numberOfAffectedSegments = 2; numberOfContextPoints = 2; return true;
+    case vtkMRMLMarkupsToModelNode::CardinalSpline: numberOfAffectedSegments = 8; numberOfContextPoints = 8; return true;
+    default:
+      // polynomial fit depends on all the points
+      return false;
   }
-  else
+}
+
+//----------------------------------------------------------------------------
+// Model that was generated recently for a parameter node, see vtkSlicerMarkupsToModelLogic::MaximumNumberOfRecentOutputs
+struct RecentOutput
+{
+  std::string Key; // see vtkSlicerMarkupsToModelMeshCache::ComputeKey
+  vtkSmartPointer< vtkPolyData > PolyData; // private copy, never modified
+  double OutputCurveLength;
+
+  RecentOutput()
+    : OutputCurveLength( 0.0 )
   {
-    // try a default string
-    selectionNode = vtkMRMLSelectionNode::SafeDownCast(this->GetMRMLScene()->GetNodeByID("vtkMRMLSelectionNodeSingleton"));
   }
-  if (!selectionNode)
+};
+
+//----------------------------------------------------------------------------
+// Generators of a parameter node. They are kept between updates, so that the filters are not recreated
+// and intermediate results (e.g., tetrahedralization) can be reused.
+struct ModelPipeline
+{
+  vtkSmartPointer< vtkSlicerMarkupsToModelClosedSurfaceGeneration > ClosedSurfaceGenerator;
+  vtkSmartPointer< vtkCurveGenerator > CurveGenerator;
+
+  // Results of the stages before vtkMRMLMarkupsToModelNode::ModelStage in the last update,
+  // so that if only parameters of the model stage change then the earlier stages are not performed again.
+  // The triangulated surface is kept in the closed surface generator.
+  bool HasStageResults;
+  vtkTimeStamp StageResultsTime;
+  vtkSmartPointer< vtkPoints > ControlPoints; // cleaned input points
+  vtkSmartPointer< vtkPoints > CurvePoints; // sampled curve points that the tube is generated from
+  double OutputCurveLength;
+
+  // Time of the last update of the output (in seconds), for limiting the update rate during interaction
+  double LastUpdateTime;
+
+  // Fingerprint of the input points of the last update (see ComputePointsFingerprint),
+  // so that updates are skipped if the input was modified without moving the points (e.g., a point was selected)
+  bool HasInputFingerprint;
+  vtkTypeUInt64 InputFingerprint;
+
+  // Durations of the stages of the update in progress (see vtkMRMLMarkupsToModelNode::TimedStage)
+  double StageTimes[ vtkMRMLMarkupsToModelNode::TimedStage_Last ];
+
+  // Recently generated models, most recently used first
+  std::list< RecentOutput > RecentOutputs;
+  // The output poly data shares its arrays with a recent output, so it must not be modified in place:
+  // new poly data is created for the next update instead
+  bool OutputShared;
+  // Poly data that was last assigned to the output model by the logic. Only this one is modified in place,
+  // other poly data of the output model (e.g., of a model that was selected as output) may be used elsewhere.
+  vtkWeakPointer< vtkPolyData > OutputPolyData;
+
+  ModelPipeline()
   {
-    vtkErrorMacro("UpdateSelectionNode: selection node is not available");
-    return;
+    this->ClosedSurfaceGenerator = vtkSmartPointer< vtkSlicerMarkupsToModelClosedSurfaceGeneration >::New();
+    this->CurveGenerator = vtkSmartPointer< vtkCurveGenerator >::New();
+    this->HasStageResults = false;
+    this->ControlPoints = vtkSmartPointer< vtkPoints >::New();
+    this->CurvePoints = vtkSmartPointer< vtkPoints >::New();
+    this->OutputCurveLength = 0.0;
+    this->LastUpdateTime = 0.0;
+    this->HasInputFingerprint = false;
+    this->InputFingerprint = 0;
+    this->OutputShared = false;
+    InitializeStageTimes( this->StageTimes );
   }
 
-  const char *activeID = markupsNode ? markupsNode->GetID() : NULL;
-  if (!activeID)
+  // Poly data of the output model if the model can be written into it in place, new poly data otherwise
+  vtkSmartPointer< vtkPolyData > GetReusableOutputPolyData( vtkMRMLModelNode* outputModelNode )
   {
-    return;
+    if ( outputModelNode == NULL || this->OutputShared || this->OutputPolyData == NULL
+      || outputModelNode->GetPolyData() != this->OutputPolyData )
+    {
+      return vtkSmartPointer< vtkPolyData >::New();
+    }
+    return outputModelNode->GetPolyData();
   }
+};
 
-  const char *selectionNodeActivePlaceNodeID = selectionNode->GetActivePlaceNodeID();
-  if (selectionNodeActivePlaceNodeID != NULL && activeID != NULL && !strcmp(selectionNodeActivePlaceNodeID, activeID))
+//----------------------------------------------------------------------------
+// Output model generation of a parameter node on a worker thread. The job only accesses its own data:
+// a copy of the parameter node and control points, and its own generators and output poly data.
+struct ModelUpdateJob
+{
+  vtkSmartPointer< vtkMRMLMarkupsToModelNode > Parameters;
+  vtkSmartPointer< vtkPoints > ControlPoints;
+  vtkSmartPointer< vtkPolyData > OutputPolyData;
+  ModelPipeline Pipeline;
+  std::string CacheKey; // the result is stored in the recent outputs and the mesh cache with this key (if not empty)
+  bool Success;
+  // Set by the main thread if the result is not needed anymore, the job then stops before its next stage
+  std::atomic< bool > Cancelled;
+  // Set by the worker thread when the results can be accessed by the main thread
+  std::atomic< bool > Finished;
+
+  ModelUpdateJob()
+    : Success( false )
+    , Cancelled( false )
+    , Finished( false )
   {
-    // no change
-    return;
   }
+};
 
-  selectionNode->SetReferenceActivePlaceNodeID(activeID);
+//----------------------------------------------------------------------------
+static void RunModelUpdateJob( std::shared_ptr< ModelUpdateJob > job )
+{
+  MARKUPSTOMODEL_TRACE_SCOPE( "RunModelUpdateJob", "generation" );
+  if ( !job->Cancelled )
+  {
+    job->Success = vtkSlicerMarkupsToModelLogic::GenerateOutputModel( job->Parameters, job->ControlPoints, job->OutputPolyData,
+      job->Pipeline.ClosedSurfaceGenerator, job->Pipeline.CurveGenerator, job->Pipeline.CurvePoints, job->Pipeline.OutputCurveLength,
+      job->Pipeline.StageTimes, &job->Cancelled );
+  }
+  job->Finished = true;
 }
 
-//------------------------------------------------------------------------------
-void vtkSlicerMarkupsToModelLogic::UpdateOutputModel(vtkMRMLMarkupsToModelNode* markupsToModelModuleNode)
+//----------------------------------------------------------------------------
+// Runs the background update jobs of the logic one after the other on a single thread that is owned by the logic.
+// The thread is started when the first job is added and joined when the worker is deleted (jobs that did not start
+// yet are cancelled, the running job stops before its next stage).
+class ModelUpdateWorker
 {
-  if ( markupsToModelModuleNode == NULL )
+public:
+  ModelUpdateWorker()
+    : Stopping( false )
   {
-    vtkErrorMacro( "No markupsToModelModuleNode provided to UpdateOutputModel. No operation performed." );
-    return;
   }
 
-  vtkMRMLNode* inputNode = markupsToModelModuleNode->GetInputNode();
-  if (inputNode == NULL)
+  ~ModelUpdateWorker()
+  {
+    {
+      std::lock_guard< std::mutex > lock( this->Mutex );
+      this->Stopping = true;
+      for ( std::deque< std::shared_ptr< ModelUpdateJob > >::iterator jobIt = this->Jobs.begin(); jobIt != this->Jobs.end(); ++jobIt )
+      {
+        ( *jobIt )->Cancelled = true;
+      }
+    }
+    this->JobAdded.notify_all();
+    if ( this->Thread.joinable() )
+    {
+      this->Thread.join();
+    }
+  }
+
+  void AddJob( std::shared_ptr< ModelUpdateJob > job )
+  {
+    {
+      std::lock_guard< std::mutex > lock( this->Mutex );
+      this->Jobs.push_back( job );
+      if ( !this->Thread.joinable() )
+      {
+        this->Thread = std::thread( &ModelUpdateWorker::Run, this );
+      }
+    }
+    this->JobAdded.notify_one();
+  }
+
+private:
+  void Run()
+  {
+    while ( true )
+    {
+      std::shared_ptr< ModelUpdateJob > job;
+      {
+        std::unique_lock< std::mutex > lock( this->Mutex );
+        while ( !this->Stopping && this->Jobs.empty() )
+        {
+          this->JobAdded.wait( lock );
+        }
+        if ( this->Stopping )
+        {
+          return;
+        }
+        job = this->Jobs.front();
+        this->Jobs.pop_front();
+      }
+      RunModelUpdateJob( job );
+    }
+  }
+
+  std::thread Thread;
+  std::mutex Mutex;
+  std::condition_variable JobAdded;
+  std::deque< std::shared_ptr< ModelUpdateJob > > Jobs;
+  bool Stopping;
+};
+
+//----------------------------------------------------------------------------
+// Background updates of a parameter node. At most one job runs for a node at a time, and only the latest request
+// is queued: if more updates are requested while a job is running then the earlier queued job is dropped.
+struct AsynchronousUpdateState
+{
+  std::shared_ptr< ModelUpdateJob > RunningJob;
+  std::shared_ptr< ModelUpdateJob > QueuedJob;
+  int Status;
+
+  AsynchronousUpdateState()
+    : Status( vtkSlicerMarkupsToModelLogic::AsynchronousUpdateIdle )
+  {
+  }
+};
+
+//----------------------------------------------------------------------------
+// Output model generation of a parameter node, as part of updating multiple nodes in parallel
+struct ModelGenerationTask
+{
+  vtkMRMLMarkupsToModelNode* ModuleNode;
+  vtkSmartPointer< vtkPoints > ControlPoints;
+  vtkSmartPointer< vtkPolyData > OutputPolyData;
+  ModelPipeline* Pipeline;
+  std::string CacheKey; // the result is stored in the recent outputs and the mesh cache with this key (if not empty)
+  bool Success;
+
+  ModelGenerationTask()
+    : ModuleNode( NULL )
+    , Pipeline( NULL )
+    , Success( false )
+  {
+  }
+};
+
+//----------------------------------------------------------------------------
+// Functor for vtkSMPTools, generates the output models of a range of tasks.
+// Each task has its own generators and output, and the parameter nodes are only read.
+class vtkModelGenerationWorker
+{
+public:
+  ModelGenerationTask* Tasks;
+
+  void operator()( vtkIdType beginTaskIndex, vtkIdType endTaskIndex ) const
+  {
+    for ( vtkIdType taskIndex = beginTaskIndex; taskIndex < endTaskIndex; taskIndex++ )
+    {
+      MARKUPSTOMODEL_TRACE_SCOPE( "GenerateOutputModel", "generation" );
+      ModelGenerationTask& task = this->Tasks[ taskIndex ];
+      task.Success = vtkSlicerMarkupsToModelLogic::GenerateOutputModel( task.ModuleNode, task.ControlPoints, task.OutputPolyData,
+        task.Pipeline->ClosedSurfaceGenerator, task.Pipeline->CurveGenerator, task.Pipeline->CurvePoints, task.Pipeline->OutputCurveLength,
+        task.Pipeline->StageTimes );
+    }
+  }
+};
+
+//----------------------------------------------------------------------------
+class vtkSlicerMarkupsToModelLogic::vtkInternal
+{
+public:
+  std::map< vtkMRMLMarkupsToModelNode*, CurveUpdateState > CurveUpdateStates;
+  std::map< vtkMRMLMarkupsToModelNode*, ClosedSurfaceUpdateState > ClosedSurfaceUpdateStates;
+  std::map< vtkMRMLMarkupsToModelNode*, ModelPipeline > Pipelines;
+
+  // Parameter nodes that were modified during interaction but their output is not updated yet.
+  // The value is the index of the modified markup point (-1 if more points or the parameters were modified).
+  std::map< vtkMRMLMarkupsToModelNode*, int > PendingUpdates;
+
+  std::map< vtkMRMLMarkupsToModelNode*, AsynchronousUpdateState > AsynchronousUpdates;
+
+  // Deleted with the logic, which waits for the running job to stop
+  ModelUpdateWorker Worker;
+
+  // Parameter nodes whose output was not generated at scene load because it is hidden
+  // (see vtkMRMLMarkupsToModelNode::DeferHiddenOutputUpdate)
+  std::set< vtkMRMLMarkupsToModelNode* > DeferredUpdates;
+
+  vtkSmartPointer< vtkSlicerMarkupsToModelMeshCache > MeshCache;
+
+  // Separate generator for evaluating parts of the curve, so that
+  // the state of the main curve generator is not affected.
+  vtkSmartPointer< vtkCurveGenerator > LocalCurveGenerator;
+
+  // Re-evaluate curve segments [firstSegmentIndex, endSegmentIndex) from the new control points
+  // and replace them in the curve stored in the state. The curve before and after the range is kept,
+  // so the number of curve points may only change if the range extends to the end of the curve.
+  // The range of curve points that changed is returned in firstModifiedCurvePointIndex and lastModifiedCurvePointIndex.
+  // Returns false (and leaves the state unchanged) if the re-evaluated segments do not connect to the rest of the curve.
+  bool ReplaceCurveSegments( CurveUpdateState& state, vtkMRMLMarkupsToModelNode* moduleNode, vtkPoints* controlPoints,
+    vtkIdType firstSegmentIndex, vtkIdType endSegmentIndex,
+    vtkIdType& firstModifiedCurvePointIndex, vtkIdType& lastModifiedCurvePointIndex );
+
+  // Re-evaluate a polynomial curve and copy the curve points that changed into the state.
+  // The polynomial fit cannot be evaluated from a subset of the control points (the parameters are normalized
+  // over the whole curve), but with moving least squares fitting only the curve points within the sample width
+  // of the modified control point change, so only those are updated.
+  bool UpdatePolynomialCurvePoints( CurveUpdateState& state, vtkMRMLMarkupsToModelNode* moduleNode, vtkPoints* controlPoints,
+    vtkIdType& firstModifiedCurvePointIndex, vtkIdType& lastModifiedCurvePointIndex );
+
+  // Parameter and output of the state can be used for an incremental update of the curve model of the node.
+  bool CanUpdateIncrementally( CurveUpdateState& state, vtkMRMLMarkupsToModelNode* moduleNode );
+
+  // Copy the curve of the state after an incremental update into the pipeline of the node, so that later changes
+  // of model stage parameters (e.g., tube radius) do not require evaluating the curve again.
+  void StoreCurveStageResults( vtkMRMLMarkupsToModelNode* moduleNode, CurveUpdateState& state );
+};
+
+//----------------------------------------------------------------------------
+void vtkSlicerMarkupsToModelLogic::vtkInternal::StoreCurveStageResults( vtkMRMLMarkupsToModelNode* moduleNode, CurveUpdateState& state )
+{
+  ModelPipeline& pipeline = this->Pipelines[ moduleNode ];
+  pipeline.ControlPoints->DeepCopy( state.ControlPoints );
+  pipeline.CurvePoints->DeepCopy( state.CurvePoints );
+  pipeline.OutputCurveLength = state.OutputCurveLength;
+  pipeline.StageResultsTime.Modified();
+  pipeline.HasStageResults = true;
+}
+
+//----------------------------------------------------------------------------
+bool vtkSlicerMarkupsToModelLogic::vtkInternal::CanUpdateIncrementally( CurveUpdateState& state, vtkMRMLMarkupsToModelNode* moduleNode )
+{
+  vtkMRMLModelNode* outputModelNode = moduleNode->GetOutputModelNode();
+  return state.HasSameParameters( moduleNode )
+    && state.OutputPolyData != NULL && outputModelNode != NULL && outputModelNode->GetPolyData() == state.OutputPolyData
+    && !state.TubeLoop && state.TubeRadius > 0.0 && state.TubeSegmentsBetweenControlPoints >= 1
+    && state.CurveSamplingMode == vtkMRMLMarkupsToModelNode::UniformSampling
+    && state.CurvePoints->GetNumberOfPoints() == ( state.ControlPoints->GetNumberOfPoints() - 1 ) * state.TubeSegmentsBetweenControlPoints + 1;
+}
+
+//----------------------------------------------------------------------------
+bool vtkSlicerMarkupsToModelLogic::vtkInternal::UpdatePolynomialCurvePoints( CurveUpdateState& state, vtkMRMLMarkupsToModelNode* moduleNode,
+  vtkPoints* controlPoints, vtkIdType& firstModifiedCurvePointIndex, vtkIdType& lastModifiedCurvePointIndex )
+{
+  this->LocalCurveGenerator->SetInputPoints( controlPoints );
+  this->LocalCurveGenerator->SetNumberOfPointsPerInterpolatingSegment( state.TubeSegmentsBetweenControlPoints );
+  this->LocalCurveGenerator->SetCurveIsClosed( false );
+  vtkSlicerMarkupsToModelLogic::SetCurveGeneratorParameters( this->LocalCurveGenerator, state.CurveType,
+    moduleNode->GetPolynomialOrder(), moduleNode->GetPointParameterType(),
+    state.KochanekEndsCopyNearestDerivatives, state.KochanekBias, state.KochanekContinuity, state.KochanekTension,
+    moduleNode->GetPolynomialFitType(), moduleNode->GetPolynomialSampleWidth(), moduleNode->GetPolynomialWeightType() );
+  this->LocalCurveGenerator->Update();
+  vtkPoints* curvePoints = this->LocalCurveGenerator->GetOutputPoints();
+  vtkIdType numberOfCurvePoints = state.CurvePoints->GetNumberOfPoints();
+  if ( curvePoints == NULL || curvePoints->GetNumberOfPoints() != numberOfCurvePoints )
+  {
+    return false;
+  }
+
+  firstModifiedCurvePointIndex = numberOfCurvePoints;
+  lastModifiedCurvePointIndex = -1;
+  for ( vtkIdType curvePointIndex = 0; curvePointIndex < numberOfCurvePoints; curvePointIndex++ )
+  {
+    double previousCurvePoint[ 3 ] = { 0.0, 0.0, 0.0 };
+    double curvePoint[ 3 ] = { 0.0, 0.0, 0.0 };
+    state.CurvePoints->GetPoint( curvePointIndex, previousCurvePoint );
+    curvePoints->GetPoint( curvePointIndex, curvePoint );
+    if ( previousCurvePoint[ 0 ] != curvePoint[ 0 ] || previousCurvePoint[ 1 ] != curvePoint[ 1 ] || previousCurvePoint[ 2 ] != curvePoint[ 2 ] )
+    {
+      firstModifiedCurvePointIndex = std::min( firstModifiedCurvePointIndex, curvePointIndex );
+      lastModifiedCurvePointIndex = curvePointIndex;
+      state.CurvePoints->SetPoint( curvePointIndex, curvePoint );
+    }
+  }
+  state.CurvePoints->Modified();
+  state.OutputCurveLength = this->LocalCurveGenerator->GetOutputCurveLength();
+  return true;
+}
+
+//----------------------------------------------------------------------------
+bool vtkSlicerMarkupsToModelLogic::vtkInternal::ReplaceCurveSegments( CurveUpdateState& state, vtkMRMLMarkupsToModelNode* moduleNode,
+  vtkPoints* controlPoints, vtkIdType firstSegmentIndex, vtkIdType endSegmentIndex,
+  vtkIdType& firstModifiedCurvePointIndex, vtkIdType& lastModifiedCurvePointIndex )
+{
+  int numberOfAffectedSegments = 0;
+  int numberOfContextPoints = 0;
+  if ( !GetCurveSegmentSupport( state.CurveType, numberOfAffectedSegments, numberOfContextPoints ) )
+  {
+    return false;
+  }
+
+  vtkIdType numberOfControlPoints = controlPoints->GetNumberOfPoints();
+  vtkIdType numberOfSegments = numberOfControlPoints - 1;
+  vtkIdType pointsPerSegment = state.TubeSegmentsBetweenControlPoints;
+  vtkIdType numberOfCurvePoints = numberOfSegments * pointsPerSegment + 1;
+  vtkIdType previousNumberOfCurvePoints = state.CurvePoints->GetNumberOfPoints();
+  // curve points after the replaced range are shifted by this amount
+  vtkIdType curvePointShift = numberOfCurvePoints - previousNumberOfCurvePoints;
+  if ( firstSegmentIndex < 0 || endSegmentIndex > numberOfSegments || firstSegmentIndex >= endSegmentIndex
+    || ( curvePointShift != 0 && endSegmentIndex != numberOfSegments ) )
+  {
+    return false;
+  }
+
+  // Evaluate the range from the nearby control points
+  vtkIdType firstLocalControlPointIndex = std::max< vtkIdType >( firstSegmentIndex - numberOfContextPoints, 0 );
+  vtkIdType lastLocalControlPointIndex = std::min< vtkIdType >( endSegmentIndex + numberOfContextPoints, numberOfControlPoints - 1 );
+  vtkSmartPointer< vtkPoints > localControlPoints = vtkSmartPointer< vtkPoints >::New();
+  localControlPoints->SetNumberOfPoints( lastLocalControlPointIndex - firstLocalControlPointIndex + 1 );
+  for ( vtkIdType pointIndex = firstLocalControlPointIndex; pointIndex <= lastLocalControlPointIndex; pointIndex++ )
+  {
+    localControlPoints->SetPoint( pointIndex - firstLocalControlPointIndex, controlPoints->GetPoint( pointIndex ) );
+  }
+  this->LocalCurveGenerator->SetInputPoints( localControlPoints );
+  this->LocalCurveGenerator->SetNumberOfPointsPerInterpolatingSegment( pointsPerSegment );
+  this->LocalCurveGenerator->SetCurveIsClosed( false );
+  vtkSlicerMarkupsToModelLogic::SetCurveGeneratorParameters( this->LocalCurveGenerator, state.CurveType,
+    moduleNode->GetPolynomialOrder(), moduleNode->GetPointParameterType(),
+    state.KochanekEndsCopyNearestDerivatives, state.KochanekBias, state.KochanekContinuity, state.KochanekTension,
+    moduleNode->GetPolynomialFitType(), moduleNode->GetPolynomialSampleWidth(), moduleNode->GetPolynomialWeightType() );
+  this->LocalCurveGenerator->Update();
+  vtkPoints* localCurvePoints = this->LocalCurveGenerator->GetOutputPoints();
+  if ( localCurvePoints == NULL
+    || localCurvePoints->GetNumberOfPoints() != ( lastLocalControlPointIndex - firstLocalControlPointIndex ) * pointsPerSegment + 1 )
+  {
+    return false;
+  }
+  vtkIdType localCurvePointOffset = firstLocalControlPointIndex * pointsPerSegment;
+
+  // The segments just before and after the range must be the same in the previous curve and in the local curve,
+  // otherwise the range does not connect smoothly to the rest of the curve.
+  vtkIdType firstReplacedCurvePointIndex = firstSegmentIndex * pointsPerSegment;
+  vtkIdType endReplacedCurvePointIndex = endSegmentIndex * pointsPerSegment;
+  std::vector< std::pair< vtkIdType, vtkIdType > > seamRanges; // [first, last] curve point indices
+  if ( firstSegmentIndex > 0 )
+  {
+    seamRanges.push_back( std::make_pair( firstReplacedCurvePointIndex - pointsPerSegment, firstReplacedCurvePointIndex ) );
+  }
+  if ( endSegmentIndex < numberOfSegments )
+  {
+    seamRanges.push_back( std::make_pair( endReplacedCurvePointIndex, endReplacedCurvePointIndex + pointsPerSegment ) );
+  }
+  for ( size_t seamIndex = 0; seamIndex < seamRanges.size(); seamIndex++ )
+  {
+    for ( vtkIdType curvePointIndex = seamRanges[ seamIndex ].first; curvePointIndex <= seamRanges[ seamIndex ].second; curvePointIndex++ )
+    {
+      double previousCurvePoint[ 3 ] = { 0.0, 0.0, 0.0 };
+      double localCurvePoint[ 3 ] = { 0.0, 0.0, 0.0 };
+      state.CurvePoints->GetPoint( curvePointIndex, previousCurvePoint );
+      localCurvePoints->GetPoint( curvePointIndex - localCurvePointOffset, localCurvePoint );
+      if ( vtkMath::Distance2BetweenPoints( previousCurvePoint, localCurvePoint )
+        > INCREMENTAL_CURVE_UPDATE_TOLERANCE_MM * INCREMENTAL_CURVE_UPDATE_TOLERANCE_MM )
+      {
+        return false;
+      }
+    }
+  }
+
+  // Replace the range. Points at the seams are kept from the previous curve.
+  double outputCurveLength = state.OutputCurveLength;
+  double previousCurvePoint[ 3 ] = { 0.0, 0.0, 0.0 };
+  double curvePoint[ 3 ] = { 0.0, 0.0, 0.0 };
+  vtkIdType previousEndReplacedCurvePointIndex = std::min( endReplacedCurvePointIndex - curvePointShift, previousNumberOfCurvePoints - 1 );
+  state.CurvePoints->GetPoint( firstReplacedCurvePointIndex, previousCurvePoint );
+  for ( vtkIdType curvePointIndex = firstReplacedCurvePointIndex + 1; curvePointIndex <= previousEndReplacedCurvePointIndex; curvePointIndex++ )
+  {
+    state.CurvePoints->GetPoint( curvePointIndex, curvePoint );
+    outputCurveLength -= sqrt( vtkMath::Distance2BetweenPoints( previousCurvePoint, curvePoint ) );
+    previousCurvePoint[ 0 ] = curvePoint[ 0 ];
+    previousCurvePoint[ 1 ] = curvePoint[ 1 ];
+    previousCurvePoint[ 2 ] = curvePoint[ 2 ];
+  }
+  if ( curvePointShift != 0 )
+  {
+    // SetNumberOfValues preserves existing values (unlike SetNumberOfTuples)
+    state.CurvePoints->GetData()->SetNumberOfValues( 3 * numberOfCurvePoints );
+  }
+  firstModifiedCurvePointIndex = firstReplacedCurvePointIndex + 1;
+  lastModifiedCurvePointIndex = ( endSegmentIndex == numberOfSegments ? numberOfCurvePoints - 1 : endReplacedCurvePointIndex - 1 );
+  state.CurvePoints->GetPoint( firstReplacedCurvePointIndex, previousCurvePoint );
+  for ( vtkIdType curvePointIndex = firstModifiedCurvePointIndex; curvePointIndex <= endReplacedCurvePointIndex; curvePointIndex++ )
+  {
+    if ( curvePointIndex <= lastModifiedCurvePointIndex )
+    {
+      localCurvePoints->GetPoint( curvePointIndex - localCurvePointOffset, curvePoint );
+      state.CurvePoints->SetPoint( curvePointIndex, curvePoint );
+    }
+    else
+    {
+      state.CurvePoints->GetPoint( curvePointIndex, curvePoint );
+    }
+    outputCurveLength += sqrt( vtkMath::Distance2BetweenPoints( previousCurvePoint, curvePoint ) );
+    previousCurvePoint[ 0 ] = curvePoint[ 0 ];
+    previousCurvePoint[ 1 ] = curvePoint[ 1 ];
+    previousCurvePoint[ 2 ] = curvePoint[ 2 ];
+  }
+  state.CurvePoints->Modified();
+  state.OutputCurveLength = outputCurveLength;
+  return true;
+}
+
+//----------------------------------------------------------------------------
+vtkStandardNewMacro(vtkSlicerMarkupsToModelLogic);
+
+//----------------------------------------------------------------------------
+vtkSlicerMarkupsToModelLogic::vtkSlicerMarkupsToModelLogic()
+{
+  this->MinimumInteractionUpdateInterval = 1.0 / 30.0;
+  this->NumberOfUpdateRequests = 0;
+  this->NumberOfMergedUpdateRequests = 0;
+  this->NumberOfSkippedUpdateRequests = 0;
+  this->NumberOfPerformedUpdates = 0;
+  this->MaximumNumberOfRecentOutputs = 0;
+  this->Internal = new vtkInternal;
+  this->Internal->LocalCurveGenerator = vtkSmartPointer< vtkCurveGenerator >::New();
+  this->Internal->MeshCache = vtkSmartPointer< vtkSlicerMarkupsToModelMeshCache >::New();
+}
+
+//----------------------------------------------------------------------------
+vtkSlicerMarkupsToModelLogic::~vtkSlicerMarkupsToModelLogic()
+{
+  // running jobs keep their own data, they just need to stop (the worker thread is joined when the internal data is deleted)
+  for (std::map< vtkMRMLMarkupsToModelNode*, AsynchronousUpdateState >::iterator updateIt = this->Internal->AsynchronousUpdates.begin();
+    updateIt != this->Internal->AsynchronousUpdates.end(); ++updateIt)
+  {
+    if (updateIt->second.RunningJob)
+    {
+      updateIt->second.RunningJob->Cancelled = true;
+    }
+  }
+  delete this->Internal;
+}
+
+//----------------------------------------------------------------------------
+void vtkSlicerMarkupsToModelLogic::PrintSelf(ostream& os, vtkIndent indent)
+{
+  this->Superclass::PrintSelf(os, indent);
+  os << indent << "MinimumInteractionUpdateInterval: " << this->MinimumInteractionUpdateInterval << std::endl;
+  os << indent << "NumberOfUpdateRequests: " << this->NumberOfUpdateRequests << std::endl;
+  os << indent << "NumberOfMergedUpdateRequests: " << this->NumberOfMergedUpdateRequests << std::endl;
+  os << indent << "NumberOfSkippedUpdateRequests: " << this->NumberOfSkippedUpdateRequests << std::endl;
+  os << indent << "NumberOfPerformedUpdates: " << this->NumberOfPerformedUpdates << std::endl;
+  os << indent << "NumberOfPendingUpdates: " << this->Internal->PendingUpdates.size() << std::endl;
+  os << indent << "NumberOfAsynchronousUpdates: " << this->Internal->AsynchronousUpdates.size() << std::endl;
+  os << indent << "MaximumNumberOfRecentOutputs: " << this->MaximumNumberOfRecentOutputs << std::endl;
+  os << indent << "MeshCache:" << std::endl;
+  this->Internal->MeshCache->PrintSelf(os, indent.GetNextIndent());
+}
+
+//---------------------------------------------------------------------------
+void vtkSlicerMarkupsToModelLogic::SetMRMLSceneInternal(vtkMRMLScene * newScene)
+{
+  vtkNew<vtkIntArray> events;
+  events->InsertNextValue(vtkMRMLScene::NodeAddedEvent);
+  events->InsertNextValue(vtkMRMLScene::NodeRemovedEvent);
+  events->InsertNextValue(vtkMRMLScene::StartBatchProcessEvent);
+  events->InsertNextValue(vtkMRMLScene::EndBatchProcessEvent);
+  events->InsertNextValue(vtkMRMLScene::StartImportEvent);
+  events->InsertNextValue(vtkMRMLScene::EndImportEvent);
+  this->SetAndObserveMRMLSceneEventsInternal(newScene, events.GetPointer());
+}
+
+//-----------------------------------------------------------------------------
+void vtkSlicerMarkupsToModelLogic::RegisterNodes()
+{
+  if (!this->GetMRMLScene())
+  {
+    vtkWarningMacro("MRML scene not yet created");
+    return;
+  }
+
+  this->GetMRMLScene()->RegisterNodeClass(vtkSmartPointer< vtkMRMLMarkupsToModelNode >::New());
+}
+
+//---------------------------------------------------------------------------
+void vtkSlicerMarkupsToModelLogic::UpdateFromMRMLScene()
+{
+  assert(this->GetMRMLScene() != 0);
+}
+
+//---------------------------------------------------------------------------
+void vtkSlicerMarkupsToModelLogic::OnMRMLSceneEndImport()
+{
+  vtkSmartPointer<vtkCollection> markupsToModelNodes = vtkSmartPointer<vtkCollection>::Take(
+    this->GetMRMLScene()->GetNodesByClass("vtkMRMLMarkupsToModelNode"));
+  // hidden outputs are generated when they are shown, if requested
+  vtkNew<vtkCollection> visibleMarkupsToModelNodes;
+  vtkNew<vtkCollectionIterator> markupsToModelNodeIt;
+  markupsToModelNodeIt->SetCollection(markupsToModelNodes);
+  for (markupsToModelNodeIt->InitTraversal(); !markupsToModelNodeIt->IsDoneWithTraversal(); markupsToModelNodeIt->GoToNextItem())
+  {
+    vtkMRMLMarkupsToModelNode* markupsToModelNode = vtkMRMLMarkupsToModelNode::SafeDownCast(markupsToModelNodeIt->GetCurrentObject());
+    if (markupsToModelNode == NULL)
+    {
+      continue;
+    }
+    if (markupsToModelNode->GetDeferHiddenOutputUpdate() && !IsOutputModelVisible(markupsToModelNode))
+    {
+      this->Internal->DeferredUpdates.insert(markupsToModelNode);
+      continue;
+    }
+    visibleMarkupsToModelNodes->AddItem(markupsToModelNode);
+  }
+  this->UpdateOutputModels(visibleMarkupsToModelNodes.GetPointer());
+}
+
+//---------------------------------------------------------------------------
+void vtkSlicerMarkupsToModelLogic::OnMRMLSceneStartImport()
+{
+}
+
+//---------------------------------------------------------------------------
+void vtkSlicerMarkupsToModelLogic::OnMRMLSceneNodeAdded(vtkMRMLNode* node)
+{
+  if (node == NULL || this->GetMRMLScene() == NULL)
+  {
+    vtkWarningMacro("OnMRMLSceneNodeAdded: Invalid MRML scene or node");
+    return;
+  }
+
+  vtkMRMLMarkupsToModelNode* markupsToModelNode = vtkMRMLMarkupsToModelNode::SafeDownCast(node);
+  if (markupsToModelNode)
+  {
+    vtkDebugMacro("OnMRMLSceneNodeAdded: Module node added.");
+    vtkUnObserveMRMLNodeMacro(markupsToModelNode); // Remove previous observers.
+    vtkNew<vtkIntArray> events;
+    events->InsertNextValue(vtkCommand::ModifiedEvent);
+    events->InsertNextValue(vtkMRMLMarkupsToModelNode::MarkupsPositionModifiedEvent);
+    events->InsertNextValue(vtkMRMLMarkupsToModelNode::OutputModelDisplayModifiedEvent);
+    vtkObserveMRMLNodeEventsMacro(markupsToModelNode, events.GetPointer());
+  }
+}
+
+//---------------------------------------------------------------------------
+void vtkSlicerMarkupsToModelLogic::OnMRMLSceneNodeRemoved(vtkMRMLNode* node)
+{
+  if (node == NULL || this->GetMRMLScene() == NULL)
+  {
+    vtkWarningMacro("OnMRMLSceneNodeRemoved: Invalid MRML scene or node");
+    return;
+  }
+
+  vtkMRMLMarkupsToModelNode* markupsToModelNode = vtkMRMLMarkupsToModelNode::SafeDownCast(node);
+  if (markupsToModelNode)
+  {
+    vtkDebugMacro("OnMRMLSceneNodeRemoved");
+    vtkUnObserveMRMLNodeMacro(markupsToModelNode);
+    this->Internal->CurveUpdateStates.erase(markupsToModelNode);
+    this->Internal->ClosedSurfaceUpdateStates.erase(markupsToModelNode);
+    this->Internal->Pipelines.erase(markupsToModelNode);
+    this->Internal->PendingUpdates.erase(markupsToModelNode);
+    this->CancelAsynchronousUpdate(markupsToModelNode);
+    this->Internal->DeferredUpdates.erase(markupsToModelNode);
+  }
+}
+
+//------------------------------------------------------------------------------
+void vtkSlicerMarkupsToModelLogic::UpdateSelectionNode(vtkMRMLMarkupsToModelNode* markupsToModelModuleNode)
+{
+  if (!markupsToModelModuleNode)
+  {
+    // No markups selected
+    return;
+  }
+  vtkMRMLNode* inputNode = markupsToModelModuleNode->GetInputNode();
+  vtkMRMLMarkupsNode* markupsNode = vtkMRMLMarkupsNode::SafeDownCast( inputNode );
+  if (!markupsNode)
+  {
+    // No markups selected
+    return;
+  }
+  if (!this->GetMRMLScene())
+  {
+    vtkErrorMacro("UpdateSelectionNode: no scene defined!");
+    return;
+  }
+
+  // try the application logic first
+  vtkMRMLApplicationLogic *mrmlAppLogic = this->GetMRMLApplicationLogic();
+  vtkMRMLSelectionNode *selectionNode = NULL;
+  if (mrmlAppLogic)
+  {
+    selectionNode = mrmlAppLogic->GetSelectionNode();
+  }
+  else
+  {
+    // try a default string
+    selectionNode = vtkMRMLSelectionNode::SafeDownCast(this->GetMRMLScene()->GetNodeByID("vtkMRMLSelectionNodeSingleton"));
+  }
+  if (!selectionNode)
+  {
+    vtkErrorMacro("UpdateSelectionNode: selection node is not available");
+    return;
+  }
+
+  const char *activeID = markupsNode ? markupsNode->GetID() : NULL;
+  if (!activeID)
+  {
+    return;
+  }
+
+  const char *selectionNodeActivePlaceNodeID = selectionNode->GetActivePlaceNodeID();
+  if (selectionNodeActivePlaceNodeID != NULL && activeID != NULL && !strcmp(selectionNodeActivePlaceNodeID, activeID))
+  {
+    // no change
+    return;
+  }
+
+  selectionNode->SetReferenceActivePlaceNodeID(activeID);
+}
+
+//------------------------------------------------------------------------------
+void vtkSlicerMarkupsToModelLogic::UpdateOutputModel(vtkMRMLMarkupsToModelNode* markupsToModelModuleNode, int modifiedMarkupPointIndex/*=-1*/)
+{
+  this->UpdateOutputModelFromPoints( markupsToModelModuleNode, modifiedMarkupPointIndex, NULL, 0.0 );
+}
+
+//------------------------------------------------------------------------------
+void vtkSlicerMarkupsToModelLogic::UpdateOutputModelFromPoints(vtkMRMLMarkupsToModelNode* markupsToModelModuleNode, int modifiedMarkupPointIndex,
+  vtkPoints* inputControlPoints, double inputExtractionTime)
+{
+  MARKUPSTOMODEL_TRACE_SCOPE("Logic::UpdateOutputModel", "logic");
+  if ( markupsToModelModuleNode == NULL )
+  {
+    vtkErrorMacro( "No markupsToModelModuleNode provided to UpdateOutputModel. No operation performed." );
+    return;
+  }
+  // the output is updated with the latest state, so pending updates of the node are not needed anymore
+  this->Internal->PendingUpdates.erase( markupsToModelModuleNode );
+  this->Internal->DeferredUpdates.erase( markupsToModelModuleNode );
+
+  // std::map creates the generators at the first update of the node
+  ModelPipeline& pipeline = this->Internal->Pipelines[ markupsToModelModuleNode ];
+  StageTimesRecorder stageTimesRecorder( markupsToModelModuleNode, pipeline.StageTimes, &this->NumberOfPerformedUpdates );
+
+  vtkSmartPointer< vtkPoints > controlPoints = inputControlPoints;
+  if ( controlPoints != NULL )
+  {
+    pipeline.StageTimes[ vtkMRMLMarkupsToModelNode::MarkupsToPointsTimedStage ] = inputExtractionTime;
+  }
+  else
+  {
+    controlPoints = vtkSmartPointer< vtkPoints >::New();
+    if ( !this->GetInputControlPoints( markupsToModelModuleNode, controlPoints, pipeline.StageTimes ) )
+    {
+      return;
+    }
+  }
+  this->SetInputFingerprint( markupsToModelModuleNode, controlPoints );
+
+  // The output would be replaced by the result of the running background update, so incremental updates of the
+  // current output would be lost. The latest state is generated after the running update instead,
+  // or now if background updates were disabled (then the running update is outdated).
+  std::map< vtkMRMLMarkupsToModelNode*, AsynchronousUpdateState >::iterator asynchronousUpdateIt =
+    this->Internal->AsynchronousUpdates.find( markupsToModelModuleNode );
+  if ( asynchronousUpdateIt != this->Internal->AsynchronousUpdates.end() && asynchronousUpdateIt->second.RunningJob )
+  {
+    if ( markupsToModelModuleNode->GetAsynchronousUpdate() )
+    {
+      this->StartAsynchronousUpdate( markupsToModelModuleNode, controlPoints,
+        this->ComputeOutputModelKey( markupsToModelModuleNode, controlPoints ) );
+      // the stage times are recorded when the job is finished
+      stageTimesRecorder.Disable();
+      return;
+    }
+    this->CancelAsynchronousUpdate( markupsToModelModuleNode );
+  }
+
+  // Points moved or appended at the end of a curve, or added to or moved within a convex surface,
+  // can be processed without regenerating the whole model
+  int modelType = markupsToModelModuleNode->GetModelType();
+  if ( modelType == vtkMRMLMarkupsToModelNode::ClosedSurface
+    && this->UpdateClosedSurfaceModelIncrementally( markupsToModelModuleNode, controlPoints ) )
+  {
+    return;
+  }
+  if ( modelType == vtkMRMLMarkupsToModelNode::Curve )
+  {
+    if ( modifiedMarkupPointIndex >= 0
+      && this->UpdateOutputCurveModelLocally( markupsToModelModuleNode, controlPoints, modifiedMarkupPointIndex ) )
+    {
+      return;
+    }
+    if ( this->AppendToOutputCurveModel( markupsToModelModuleNode, controlPoints ) )
+    {
+      return;
+    }
+  }
+  // Models that were generated earlier with the same input and parameters are reused: recent models of the node
+  // (e.g., when a parameter is switched back) or models in the mesh cache (e.g., from a previous session)
+  std::string cacheKey = this->ComputeOutputModelKey( markupsToModelModuleNode, controlPoints );
+  if ( this->LoadOutputModelFromCache( markupsToModelModuleNode, cacheKey ) )
+  {
+    return;
+  }
+
+  // If only parameters of the model stage changed (e.g., tube radius or surface smoothing)
+  // then the curve points or triangulated surface of the previous update are used
+  if ( this->UpdateOutputModelStage( markupsToModelModuleNode, controlPoints ) )
+  {
+    return;
+  }
+
+  if ( markupsToModelModuleNode->GetAsynchronousUpdate() )
+  {
+    this->StartAsynchronousUpdate( markupsToModelModuleNode, controlPoints, cacheKey );
+    stageTimesRecorder.Disable();
+    return;
+  }
+
+  // Create the model from the points.
+  // Curve models are written into the existing output mesh, so that if the topology of the tube
+  // is unchanged (e.g., while a point is dragged) then only the point coordinates are updated.
+  vtkSmartPointer< vtkPolyData > outputPolyData;
+  if ( modelType == vtkMRMLMarkupsToModelNode::Curve )
+  {
+    outputPolyData = pipeline.GetReusableOutputPolyData( markupsToModelModuleNode->GetOutputModelNode() );
+  }
+  else
+  {
+    outputPolyData = vtkSmartPointer< vtkPolyData >::New();
+  }
+  pipeline.StageResultsTime.Modified();
+  bool success = vtkSlicerMarkupsToModelLogic::GenerateOutputModel( markupsToModelModuleNode, controlPoints, outputPolyData,
+    pipeline.ClosedSurfaceGenerator, pipeline.CurveGenerator, pipeline.CurvePoints, pipeline.OutputCurveLength, pipeline.StageTimes );
+  if ( success )
+  {
+    this->StoreOutputModelInCache( markupsToModelModuleNode, cacheKey, outputPolyData, pipeline.OutputCurveLength );
+  }
+  this->FinishOutputModelUpdate( markupsToModelModuleNode, markupsToModelModuleNode, controlPoints, outputPolyData, success );
+}
+
+//------------------------------------------------------------------------------
+std::string vtkSlicerMarkupsToModelLogic::ComputeOutputModelKey( vtkMRMLMarkupsToModelNode* markupsToModelModuleNode, vtkPoints* controlPoints )
+{
+  if ( this->MaximumNumberOfRecentOutputs == 0 && !this->Internal->MeshCache->IsEnabled() )
+  {
+    return std::string();
+  }
+  // models generated during interaction are not kept: the input changes at every update,
+  // and the key does not contain the interaction parameters of reduced quality models
+  if ( markupsToModelModuleNode->GetInteracting() )
+  {
+    return std::string();
+  }
+
+  // the model does not depend on duplicate points, so the key is computed from the cleaned points
+  vtkSmartPointer< vtkPoints > cleanedControlPoints = controlPoints;
+  if ( markupsToModelModuleNode->GetCleanMarkups() )
+  {
+    cleanedControlPoints = vtkSmartPointer< vtkPoints >::New();
+    cleanedControlPoints->DeepCopy( controlPoints );
+    vtkSlicerMarkupsToModelLogic::RemoveDuplicatePoints( cleanedControlPoints, markupsToModelModuleNode->GetDuplicatePointTolerance() );
+  }
+  return vtkSlicerMarkupsToModelMeshCache::ComputeKey( markupsToModelModuleNode, cleanedControlPoints );
+}
+
+//------------------------------------------------------------------------------
+// Add the model to the front of the recent outputs and remove the least recently used models above the maximum number
+static void AddRecentOutput( std::list< RecentOutput >& recentOutputs, const RecentOutput& recentOutput, int maximumNumberOfRecentOutputs )
+{
+  for ( std::list< RecentOutput >::iterator recentOutputIt = recentOutputs.begin(); recentOutputIt != recentOutputs.end(); ++recentOutputIt )
+  {
+    if ( recentOutputIt->Key == recentOutput.Key )
+    {
+      recentOutputs.erase( recentOutputIt );
+      break;
+    }
+  }
+  recentOutputs.push_front( recentOutput );
+  while ( static_cast< int >( recentOutputs.size() ) > maximumNumberOfRecentOutputs )
+  {
+    recentOutputs.pop_back();
+  }
+}
+
+//------------------------------------------------------------------------------
+bool vtkSlicerMarkupsToModelLogic::LoadOutputModelFromCache( vtkMRMLMarkupsToModelNode* markupsToModelModuleNode, const std::string& cacheKey )
+{
+  if ( cacheKey.empty() )
+  {
+    return false;
+  }
+
+  ModelPipeline& pipeline = this->Internal->Pipelines[ markupsToModelModuleNode ];
+  RecentOutput cachedOutput;
+  std::list< RecentOutput >::iterator recentOutputIt = pipeline.RecentOutputs.begin();
+  while ( recentOutputIt != pipeline.RecentOutputs.end() && recentOutputIt->Key != cacheKey )
+  {
+    ++recentOutputIt;
+  }
+  if ( recentOutputIt != pipeline.RecentOutputs.end() && this->MaximumNumberOfRecentOutputs > 0 )
+  {
+    cachedOutput = *recentOutputIt;
+    pipeline.RecentOutputs.splice( pipeline.RecentOutputs.begin(), pipeline.RecentOutputs, recentOutputIt );
+  }
+  else
+  {
+    cachedOutput.Key = cacheKey;
+    cachedOutput.PolyData = vtkSmartPointer< vtkPolyData >::New();
+    if ( !this->Internal->MeshCache->IsEnabled()
+      || !this->Internal->MeshCache->Load( cacheKey, cachedOutput.PolyData, cachedOutput.OutputCurveLength ) )
+    {
+      return false;
+    }
+    if ( this->MaximumNumberOfRecentOutputs > 0 )
+    {
+      AddRecentOutput( pipeline.RecentOutputs, cachedOutput, this->MaximumNumberOfRecentOutputs );
+    }
+  }
+
+  vtkSmartPointer< vtkPolyData > outputPolyData = cachedOutput.PolyData;
+  pipeline.OutputShared = false;
+  if ( this->MaximumNumberOfRecentOutputs > 0 )
+  {
+    // only the arrays are shared with the recent output, the output can be assigned other arrays without affecting it
+    outputPolyData = vtkSmartPointer< vtkPolyData >::New();
+    outputPolyData->ShallowCopy( cachedOutput.PolyData );
+    pipeline.OutputShared = true;
+  }
+
+  // intermediate results of the generators are not available for the loaded model, so the next update is a full update
+  this->Internal->CurveUpdateStates.erase( markupsToModelModuleNode );
+  this->Internal->ClosedSurfaceUpdateStates.erase( markupsToModelModuleNode );
+  pipeline.HasStageResults = false;
+  if ( markupsToModelModuleNode->GetModelType() == vtkMRMLMarkupsToModelNode::Curve )
+  {
+    markupsToModelModuleNode->SetOutputCurveLength( cachedOutput.OutputCurveLength );
+  }
+  this->AssignPolyDataToOutput( markupsToModelModuleNode, outputPolyData );
+  return true;
+}
+
+//------------------------------------------------------------------------------
+void vtkSlicerMarkupsToModelLogic::StoreOutputModelInCache( vtkMRMLMarkupsToModelNode* markupsToModelModuleNode, const std::string& cacheKey,
+  vtkPolyData* outputPolyData, double outputCurveLength )
+{
+  if ( cacheKey.empty() )
+  {
+    return;
+  }
+  if ( this->MaximumNumberOfRecentOutputs > 0 )
+  {
+    // the output may be modified in place by later updates, so a copy is kept
+    RecentOutput recentOutput;
+    recentOutput.Key = cacheKey;
+    recentOutput.PolyData = vtkSmartPointer< vtkPolyData >::New();
+    recentOutput.PolyData->DeepCopy( outputPolyData );
+    recentOutput.OutputCurveLength = outputCurveLength;
+    AddRecentOutput( this->Internal->Pipelines[ markupsToModelModuleNode ].RecentOutputs, recentOutput, this->MaximumNumberOfRecentOutputs );
+  }
+  if ( this->Internal->MeshCache->IsEnabled() )
+  {
+    this->Internal->MeshCache->Store( cacheKey, outputPolyData, outputCurveLength );
+  }
+}
+
+//------------------------------------------------------------------------------
+vtkSlicerMarkupsToModelMeshCache* vtkSlicerMarkupsToModelLogic::GetMeshCache()
+{
+  return this->Internal->MeshCache;
+}
+
+//------------------------------------------------------------------------------
+void vtkSlicerMarkupsToModelLogic::UpdateOutputModels( vtkCollection* markupsToModelModuleNodes )
+{
+  MARKUPSTOMODEL_TRACE_SCOPE( "Logic::UpdateOutputModels", "logic" );
+  if ( markupsToModelModuleNodes == NULL )
+  {
+    vtkErrorMacro( "No parameter nodes provided to UpdateOutputModels. No operation performed." );
+    return;
+  }
+
+  // Input points and generators are collected on the main thread, so that the parallel tasks
+  // only read the parameter nodes and write their own generators and output
+  std::vector< ModelGenerationTask > tasks;
+  vtkNew<vtkCollectionIterator> markupsToModelNodeIt;
+  markupsToModelNodeIt->SetCollection( markupsToModelModuleNodes );
+  for ( markupsToModelNodeIt->InitTraversal(); !markupsToModelNodeIt->IsDoneWithTraversal(); markupsToModelNodeIt->GoToNextItem() )
+  {
+    vtkMRMLMarkupsToModelNode* markupsToModelModuleNode = vtkMRMLMarkupsToModelNode::SafeDownCast( markupsToModelNodeIt->GetCurrentObject() );
+    if ( markupsToModelModuleNode == NULL )
+    {
+      continue;
+    }
+    this->Internal->PendingUpdates.erase( markupsToModelModuleNode );
+    this->Internal->DeferredUpdates.erase( markupsToModelModuleNode );
+    this->CancelAsynchronousUpdate( markupsToModelModuleNode );
+    ModelGenerationTask task;
+    task.ModuleNode = markupsToModelModuleNode;
+    // std::map creates the generators at the first update of the node, pointers to elements stay valid
+    task.Pipeline = &this->Internal->Pipelines[ markupsToModelModuleNode ];
+    InitializeStageTimes( task.Pipeline->StageTimes );
+    task.ControlPoints = vtkSmartPointer< vtkPoints >::New();
+    if ( !this->GetInputControlPoints( markupsToModelModuleNode, task.ControlPoints, task.Pipeline->StageTimes ) )
+    {
+      continue;
+    }
+    this->SetInputFingerprint( markupsToModelModuleNode, task.ControlPoints );
+    task.CacheKey = this->ComputeOutputModelKey( markupsToModelModuleNode, task.ControlPoints );
+    if ( this->LoadOutputModelFromCache( markupsToModelModuleNode, task.CacheKey ) )
+    {
+      markupsToModelModuleNode->AddStageTimes( task.Pipeline->StageTimes );
+      this->NumberOfPerformedUpdates++;
+      continue;
+    }
+    task.OutputPolyData = vtkSmartPointer< vtkPolyData >::New();
+    task.Pipeline->StageResultsTime.Modified();
+    tasks.push_back( task );
+  }
+  if ( tasks.empty() )
+  {
+    return;
+  }
+
+  vtkModelGenerationWorker worker;
+  worker.Tasks = &tasks[ 0 ];
+  vtkSMPTools::For( 0, static_cast< vtkIdType >( tasks.size() ), 1, worker );
+
+  // Assigning the output invokes events, so it is done on the main thread
+  for ( std::vector< ModelGenerationTask >::iterator taskIt = tasks.begin(); taskIt != tasks.end(); ++taskIt )
+  {
+    if ( taskIt->Success )
+    {
+      this->StoreOutputModelInCache( taskIt->ModuleNode, taskIt->CacheKey, taskIt->OutputPolyData, taskIt->Pipeline->OutputCurveLength );
+    }
+    this->FinishOutputModelUpdate( taskIt->ModuleNode, taskIt->ModuleNode, taskIt->ControlPoints, taskIt->OutputPolyData, taskIt->Success );
+    taskIt->ModuleNode->AddStageTimes( taskIt->Pipeline->StageTimes );
+    this->NumberOfPerformedUpdates++;
+  }
+}
+
+//------------------------------------------------------------------------------
+bool vtkSlicerMarkupsToModelLogic::GetInputControlPoints( vtkMRMLMarkupsToModelNode* markupsToModelModuleNode, vtkPoints* controlPoints,
+  double* stageTimes/*=NULL*/ )
+{
+  vtkMRMLNode* inputNode = markupsToModelModuleNode->GetInputNode();
+  if (inputNode == NULL)
+  {
+    return false;
+  }
+
+  if (markupsToModelModuleNode->GetOutputModelNode() == NULL)
+  {
+    vtkErrorMacro("No output model node provided to UpdateOutputModel. No operation performed.");
+    return false;
+  }
+
+  // extract the input points from the MRML node, according to its type
+  StageTimer timer( stageTimes, vtkMRMLMarkupsToModelNode::MarkupsToPointsTimedStage );
+  vtkMRMLMarkupsNode* inputMarkupsNode = vtkMRMLMarkupsNode::SafeDownCast( inputNode );
+  vtkMRMLModelNode* inputModelNode = vtkMRMLModelNode::SafeDownCast( inputNode );
+  if ( inputMarkupsNode != NULL )
+  {
+    vtkSlicerMarkupsToModelLogic::MarkupsToPoints( inputMarkupsNode, controlPoints );
+  }
+  else if ( inputModelNode != NULL )
+  {
+    vtkSlicerMarkupsToModelLogic::ModelToPoints( inputModelNode, controlPoints );
+  }
+  else
+  {
+    vtkErrorMacro( "Input node type is not supported. No operation performed." );
+    return false;
+  }
+  return true;
+}
+
+//------------------------------------------------------------------------------
+bool vtkSlicerMarkupsToModelLogic::GenerateOutputModel( vtkMRMLMarkupsToModelNode* markupsToModelModuleNode,
+  vtkPoints* controlPoints, vtkPolyData* outputPolyData,
+  vtkSlicerMarkupsToModelClosedSurfaceGeneration* closedSurfaceGenerator, vtkCurveGenerator* curveGenerator,
+  vtkPoints* outputCurvePoints, double& outputCurveLength, double* stageTimes/*=NULL*/,
+  const std::atomic< bool >* cancelled/*=NULL*/ )
+{
+  outputCurveLength = 0.0;
+  if ( IsCancelled( cancelled ) )
+  {
+    return false;
+  }
+  bool cleanMarkups = markupsToModelModuleNode->GetCleanMarkups();
+  double duplicatePointTolerance = markupsToModelModuleNode->GetDuplicatePointTolerance();
+  switch ( markupsToModelModuleNode->GetModelType() )
+  {
+    case vtkMRMLMarkupsToModelNode::ClosedSurface:
+    {
+      double delaunayAlpha = markupsToModelModuleNode->GetDelaunayAlpha();
+      bool smoothing = markupsToModelModuleNode->GetButterflySubdivision();
+      bool forceConvex = markupsToModelModuleNode->GetConvexHull();
+      // subdivision is the most expensive step, it is skipped while the user is interacting
+      bool subdivision = !IsReducedLevelOfDetail( markupsToModelModuleNode );
+      return vtkSlicerMarkupsToModelLogic::UpdateClosedSurfaceModel( controlPoints, outputPolyData, smoothing, forceConvex, delaunayAlpha, cleanMarkups, subdivision,
+        closedSurfaceGenerator, duplicatePointTolerance, stageTimes, cancelled );
+    }
+    case vtkMRMLMarkupsToModelNode::Curve:
+    {
+      int tubeSegmentsBetweenControlPoints = 0;
+      int tubeNumberOfSides = 0;
+      int maximumSamplesPerSegment = 0;
+      GetCurveResolution( markupsToModelModuleNode, tubeNumberOfSides, tubeSegmentsBetweenControlPoints, maximumSamplesPerSegment );
+      bool tubeLoop = markupsToModelModuleNode->GetTubeLoop();
+      bool tubeCapping = markupsToModelModuleNode->GetTubeCapping();
+      double tubeRadius = markupsToModelModuleNode->GetTubeRadius();
+      int curveType = markupsToModelModuleNode->GetCurveType();
+      int polynomialOrder = markupsToModelModuleNode->GetPolynomialOrder();
+      int pointParameterType = markupsToModelModuleNode->GetPointParameterType();
+      bool kochanekEndsCopyNearestDerivatives = markupsToModelModuleNode->GetKochanekEndsCopyNearestDerivatives();
+      double kochanekBias = markupsToModelModuleNode->GetKochanekBias();
+      double kochanekContinuity = markupsToModelModuleNode->GetKochanekContinuity();
+      double kochanekTension = markupsToModelModuleNode->GetKochanekTension();
+      int polynomialFitType = markupsToModelModuleNode->GetPolynomialFitType();
+      double polynomialSampleWidth = markupsToModelModuleNode->GetPolynomialSampleWidth();
+      int polynomialWeightType = markupsToModelModuleNode->GetPolynomialWeightType();
+      int curveSamplingMode = markupsToModelModuleNode->GetCurveSamplingMode();
+      double samplingAngleTolerance = markupsToModelModuleNode->GetSamplingAngleTolerance();
+      double samplingChordTolerance = markupsToModelModuleNode->GetSamplingChordTolerance();
+      int minimumSamplesPerSegment = std::min( markupsToModelModuleNode->GetMinimumSamplesPerSegment(), maximumSamplesPerSegment );
+      bool success = vtkSlicerMarkupsToModelLogic::UpdateOutputCurveModel( controlPoints, outputPolyData, curveType, tubeLoop, tubeRadius, tubeNumberOfSides, tubeSegmentsBetweenControlPoints, cleanMarkups, polynomialOrder, pointParameterType, kochanekEndsCopyNearestDerivatives, kochanekBias, kochanekContinuity, kochanekTension, curveGenerator, polynomialFitType, polynomialSampleWidth, polynomialWeightType, tubeCapping,
+        curveSamplingMode, samplingAngleTolerance, samplingChordTolerance, minimumSamplesPerSegment, maximumSamplesPerSegment, duplicatePointTolerance,
+        outputCurvePoints, stageTimes, cancelled );
+      if ( success && controlPoints->GetNumberOfPoints() > 1 )
+      {
+        outputCurveLength = curveGenerator->GetOutputCurveLength();
+      }
+      return success;
+    }
+  }
+  return false;
+}
+
+//------------------------------------------------------------------------------
+void vtkSlicerMarkupsToModelLogic::FinishOutputModelUpdate( vtkMRMLMarkupsToModelNode* markupsToModelModuleNode,
+  vtkMRMLMarkupsToModelNode* parameterNode, vtkPoints* controlPoints, vtkPolyData* outputPolyData, bool success )
+{
+  ModelPipeline& pipeline = this->Internal->Pipelines[ markupsToModelModuleNode ];
+  int modelType = parameterNode->GetModelType();
+  switch ( modelType )
+  {
+    case vtkMRMLMarkupsToModelNode::ClosedSurface:
+    {
+      if ( success )
+      {
+        // incremental updates are only possible if the surface is the convex hull of the points (checked when updating)
+        ClosedSurfaceUpdateState& state = this->Internal->ClosedSurfaceUpdateStates[ markupsToModelModuleNode ];
+        if ( state.ControlPoints == NULL )
+        {
+          state.ControlPoints = vtkSmartPointer< vtkPoints >::New();
+        }
+        state.SetParameters( parameterNode );
+        state.ControlPoints->DeepCopy( controlPoints );
+        state.OutputPolyData = outputPolyData;
+      }
+      else
+      {
+        this->Internal->ClosedSurfaceUpdateStates.erase( markupsToModelModuleNode );
+      }
+      break;
+    }
+    case vtkMRMLMarkupsToModelNode::Curve:
+    {
+      if ( success && controlPoints->GetNumberOfPoints() > 1 )
+      {
+        markupsToModelModuleNode->SetOutputCurveLength( pipeline.OutputCurveLength );
+        if ( parameterNode->GetCurveSamplingMode() == vtkMRMLMarkupsToModelNode::UniformSampling )
+        {
+          this->StoreCurveUpdateState( markupsToModelModuleNode, controlPoints, pipeline.CurveGenerator->GetOutputPoints(),
+            outputPolyData, pipeline.OutputCurveLength, parameterNode );
+        }
+        else
+        {
+          // incremental updates rely on uniform sampling
+          this->Internal->CurveUpdateStates.erase( markupsToModelModuleNode );
+        }
+      }
+      else
+      {
+        markupsToModelModuleNode->SetOutputCurveLength( 0.0 );
+        this->Internal->CurveUpdateStates.erase( markupsToModelModuleNode );
+      }
+      break;
+    }
+  }
+  if ( modelType != vtkMRMLMarkupsToModelNode::Curve )
+  {
+    this->Internal->CurveUpdateStates.erase( markupsToModelModuleNode );
+  }
+  if ( modelType != vtkMRMLMarkupsToModelNode::ClosedSurface )
+  {
+    this->Internal->ClosedSurfaceUpdateStates.erase( markupsToModelModuleNode );
+  }
+  pipeline.OutputShared = false;
+  if ( success )
+  {
+    // control points were cleaned in place
+    pipeline.ControlPoints->DeepCopy( controlPoints );
+    pipeline.HasStageResults = true;
+  }
+  else
+  {
+    pipeline.HasStageResults = false;
+    // do not leave a partially updated mesh in the output
+    outputPolyData->Initialize();
+  }
+
+  this->AssignPolyDataToOutput( markupsToModelModuleNode, outputPolyData );
+}
+
+//------------------------------------------------------------------------------
+bool vtkSlicerMarkupsToModelLogic::UpdateOutputModelStage( vtkMRMLMarkupsToModelNode* markupsToModelModuleNode, vtkPoints* controlPoints )
+{
+  std::map< vtkMRMLMarkupsToModelNode*, ModelPipeline >::iterator pipelineIt = this->Internal->Pipelines.find( markupsToModelModuleNode );
+  if ( pipelineIt == this->Internal->Pipelines.end() || !pipelineIt->second.HasStageResults )
+  {
+    return false;
+  }
+  ModelPipeline& pipeline = pipelineIt->second;
+  if ( markupsToModelModuleNode->GetFirstModifiedPipelineStage( pipeline.StageResultsTime.GetMTime() ) < vtkMRMLMarkupsToModelNode::ModelStage )
+  {
+    return false;
+  }
+
+  if ( markupsToModelModuleNode->GetCleanMarkups() )
+  {
+    StageTimer timer( pipeline.StageTimes, vtkMRMLMarkupsToModelNode::RemoveDuplicatePointsTimedStage );
+    vtkSlicerMarkupsToModelLogic::RemoveDuplicatePoints( controlPoints, markupsToModelModuleNode->GetDuplicatePointTolerance() );
+  }
+  if ( !HaveSamePoints( controlPoints, pipeline.ControlPoints ) )
+  {
+    return false;
+  }
+
+  vtkSmartPointer< vtkPolyData > outputPolyData;
+  switch ( markupsToModelModuleNode->GetModelType() )
+  {
+    case vtkMRMLMarkupsToModelNode::ClosedSurface:
+    {
+      outputPolyData = vtkSmartPointer< vtkPolyData >::New();
+      bool smoothing = markupsToModelModuleNode->GetButterflySubdivision();
+      bool forceConvex = markupsToModelModuleNode->GetConvexHull();
+      bool subdivision = !IsReducedLevelOfDetail( markupsToModelModuleNode );
+      if ( !pipeline.ClosedSurfaceGenerator->GenerateSurfaceFromTriangulation( outputPolyData, smoothing, forceConvex, subdivision,
+        pipeline.StageTimes ) )
+      {
+        return false;
+      }
+      std::map< vtkMRMLMarkupsToModelNode*, ClosedSurfaceUpdateState >::iterator stateIt =
+        this->Internal->ClosedSurfaceUpdateStates.find( markupsToModelModuleNode );
+      if ( stateIt != this->Internal->ClosedSurfaceUpdateStates.end() )
+      {
+        stateIt->second.SetParameters( markupsToModelModuleNode );
+        stateIt->second.OutputPolyData = outputPolyData.GetPointer();
+      }
+      break;
+    }
+    case vtkMRMLMarkupsToModelNode::Curve:
+    {
+      if ( pipeline.CurvePoints->GetNumberOfPoints() < 2 )
+      {
+        // sphere or empty output, cheap to generate from the control points
+        return false;
+      }
+      outputPolyData = pipeline.GetReusableOutputPolyData( markupsToModelModuleNode->GetOutputModelNode() );
+      int tubeNumberOfSides = 0;
+      int unusedTubeSegmentsBetweenControlPoints = 0;
+      int unusedMaximumSamplesPerSegment = 0;
+      GetCurveResolution( markupsToModelModuleNode, tubeNumberOfSides, unusedTubeSegmentsBetweenControlPoints, unusedMaximumSamplesPerSegment );
+      {
+        StageTimer timer( pipeline.StageTimes, vtkMRMLMarkupsToModelNode::TubeGenerationTimedStage );
+        vtkSlicerMarkupsToModelLogic::GenerateTubeModel( pipeline.CurvePoints, outputPolyData,
+          markupsToModelModuleNode->GetTubeRadius(), tubeNumberOfSides, markupsToModelModuleNode->GetTubeCapping() );
+      }
+      markupsToModelModuleNode->SetOutputCurveLength( pipeline.OutputCurveLength );
+      if ( markupsToModelModuleNode->GetCurveSamplingMode() == vtkMRMLMarkupsToModelNode::UniformSampling )
+      {
+        this->StoreCurveUpdateState( markupsToModelModuleNode, pipeline.ControlPoints, pipeline.CurvePoints,
+          outputPolyData, pipeline.OutputCurveLength );
+      }
+      break;
+    }
+    default:
+      return false;
+  }
+
+  pipeline.StageResultsTime.Modified();
+  pipeline.OutputShared = false;
+  this->AssignPolyDataToOutput( markupsToModelModuleNode, outputPolyData );
+  return true;
+}
+
+//------------------------------------------------------------------------------
+void vtkSlicerMarkupsToModelLogic::StoreCurveUpdateState( vtkMRMLMarkupsToModelNode* markupsToModelModuleNode,
+  vtkPoints* controlPoints, vtkPoints* curvePoints, vtkPolyData* outputPolyData, double outputCurveLength,
+  vtkMRMLMarkupsToModelNode* parameterNode/*=NULL*/ )
+{
+  if ( curvePoints == NULL )
+  {
+    this->Internal->CurveUpdateStates.erase( markupsToModelModuleNode );
+    return;
+  }
+  CurveUpdateState& state = this->Internal->CurveUpdateStates[ markupsToModelModuleNode ];
+  state.SetParameters( parameterNode != NULL ? parameterNode : markupsToModelModuleNode );
+  if ( state.ControlPoints == NULL )
+  {
+    state.ControlPoints = vtkSmartPointer< vtkPoints >::New();
+    state.CurvePoints = vtkSmartPointer< vtkPoints >::New();
+  }
+  state.ControlPoints->DeepCopy( controlPoints );
+  state.CurvePoints->DeepCopy( curvePoints );
+  state.OutputPolyData = outputPolyData;
+  state.OutputCurveLength = outputCurveLength;
+}
+
+//------------------------------------------------------------------------------
+bool vtkSlicerMarkupsToModelLogic::AppendToOutputCurveModel( vtkMRMLMarkupsToModelNode* markupsToModelModuleNode, vtkPoints* controlPoints )
+{
+  std::map< vtkMRMLMarkupsToModelNode*, CurveUpdateState >::iterator stateIt = this->Internal->CurveUpdateStates.find( markupsToModelModuleNode );
+  if ( stateIt == this->Internal->CurveUpdateStates.end() )
+  {
+    return false;
+  }
+  CurveUpdateState& state = stateIt->second;
+  double* stageTimes = this->Internal->Pipelines[ markupsToModelModuleNode ].StageTimes;
+  int numberOfAffectedSegments = 0;
+  int numberOfContextPoints = 0;
+  if ( !this->Internal->CanUpdateIncrementally( state, markupsToModelModuleNode )
+    || !GetCurveSegmentSupport( state.CurveType, numberOfAffectedSegments, numberOfContextPoints ) )
+  {
+    return false;
+  }
+
+  if ( state.CleanMarkups )
+  {
+    StageTimer timer( stageTimes, vtkMRMLMarkupsToModelNode::RemoveDuplicatePointsTimedStage );
+    vtkSlicerMarkupsToModelLogic::RemoveDuplicatePoints( controlPoints, state.DuplicatePointTolerance );
+  }
+  vtkIdType numberOfControlPoints = controlPoints->GetNumberOfPoints();
+  vtkIdType previousNumberOfControlPoints = state.ControlPoints->GetNumberOfPoints();
+  if ( numberOfControlPoints != previousNumberOfControlPoints + 1 )
+  {
+    return false;
+  }
+  // 2 points are always connected by a line, so a spline can only be extended from 3 points
+  vtkIdType minimumPreviousNumberOfControlPoints = ( state.CurveType == vtkMRMLMarkupsToModelNode::Linear ? 2 : 3 );
+  if ( previousNumberOfControlPoints < minimumPreviousNumberOfControlPoints )
+  {
+    return false;
+  }
+  for ( vtkIdType pointIndex = 0; pointIndex < previousNumberOfControlPoints; pointIndex++ )
+  {
+    double point[ 3 ] = { 0.0, 0.0, 0.0 };
+    double previousPoint[ 3 ] = { 0.0, 0.0, 0.0 };
+    controlPoints->GetPoint( pointIndex, point );
+    state.ControlPoints->GetPoint( pointIndex, previousPoint );
+    if ( point[ 0 ] != previousPoint[ 0 ] || point[ 1 ] != previousPoint[ 1 ] || point[ 2 ] != previousPoint[ 2 ] )
+    {
+      // not an append
+      return false;
+    }
+  }
+
+  vtkIdType numberOfSegments = numberOfControlPoints - 1;
+  vtkIdType firstModifiedCurvePointIndex = 0;
+  vtkIdType lastModifiedCurvePointIndex = 0;
+  StageTimer curveTimer( stageTimes, vtkMRMLMarkupsToModelNode::CurveGenerationTimedStage );
+  if ( !this->Internal->ReplaceCurveSegments( state, markupsToModelModuleNode, controlPoints,
+    std::max< vtkIdType >( numberOfSegments - numberOfAffectedSegments, 0 ), numberOfSegments,
+    firstModifiedCurvePointIndex, lastModifiedCurvePointIndex ) )
+  {
+    return false;
+  }
+  curveTimer.Stop();
+  StageTimer tubeTimer( stageTimes, vtkMRMLMarkupsToModelNode::TubeGenerationTimedStage );
+  bool tubeUpdated = vtkSlicerMarkupsToModelTubeGeneration::UpdateTubeModel( state.CurvePoints, firstModifiedCurvePointIndex, state.OutputPolyData,
+    state.TubeRadius, state.TubeNumberOfSides, state.TubeCapping );
+  tubeTimer.Stop();
+  if ( !tubeUpdated )
+  {
+    // the curve points have already been modified, so the state is not usable anymore
+    this->Internal->CurveUpdateStates.erase( stateIt );
+    return false;
+  }
+
+  state.ControlPoints->InsertNextPoint( controlPoints->GetPoint( numberOfControlPoints - 1 ) );
+  markupsToModelModuleNode->SetOutputCurveLength( state.OutputCurveLength );
+  this->Internal->StoreCurveStageResults( markupsToModelModuleNode, state );
+  return true;
+}
+
+//------------------------------------------------------------------------------
+bool vtkSlicerMarkupsToModelLogic::UpdateOutputCurveModelLocally( vtkMRMLMarkupsToModelNode* markupsToModelModuleNode,
+  vtkPoints* controlPoints, int modifiedControlPointIndex )
+{
+  std::map< vtkMRMLMarkupsToModelNode*, CurveUpdateState >::iterator stateIt = this->Internal->CurveUpdateStates.find( markupsToModelModuleNode );
+  if ( stateIt == this->Internal->CurveUpdateStates.end() )
+  {
+    return false;
+  }
+  CurveUpdateState& state = stateIt->second;
+  double* stageTimes = this->Internal->Pipelines[ markupsToModelModuleNode ].StageTimes;
+  if ( !this->Internal->CanUpdateIncrementally( state, markupsToModelModuleNode ) )
+  {
+    return false;
+  }
+
+  // The index refers to the markups, so it is only valid for the control points if no duplicates were removed
+  // (now or in the previous update).
+  vtkIdType numberOfControlPoints = controlPoints->GetNumberOfPoints();
+  if ( numberOfControlPoints != state.ControlPoints->GetNumberOfPoints()
+    || modifiedControlPointIndex < 0 || modifiedControlPointIndex >= numberOfControlPoints )
+  {
+    return false;
+  }
+  if ( state.CleanMarkups )
+  {
+    StageTimer timer( stageTimes, vtkMRMLMarkupsToModelNode::RemoveDuplicatePointsTimedStage );
+    if ( vtkSlicerMarkupsToModelLogic::RemoveDuplicatePoints( controlPoints, state.DuplicatePointTolerance ) > 0 )
+    {
+      return false;
+    }
+  }
+  // 2 points are always connected by a line, regardless of the curve type
+  vtkIdType minimumNumberOfControlPoints = ( state.CurveType == vtkMRMLMarkupsToModelNode::Linear ? 2 : 3 );
+  if ( numberOfControlPoints < minimumNumberOfControlPoints )
+  {
+    return false;
+  }
+
+  vtkIdType firstModifiedCurvePointIndex = 0;
+  vtkIdType lastModifiedCurvePointIndex = 0;
+  int numberOfAffectedSegments = 0;
+  int numberOfContextPoints = 0;
+  StageTimer curveTimer( stageTimes, vtkMRMLMarkupsToModelNode::CurveGenerationTimedStage );
+  if ( GetCurveSegmentSupport( state.CurveType, numberOfAffectedSegments, numberOfContextPoints ) )
+  {
+    vtkIdType numberOfSegments = numberOfControlPoints - 1;
+    if ( !this->Internal->ReplaceCurveSegments( state, markupsToModelModuleNode, controlPoints,
+      std::max< vtkIdType >( modifiedControlPointIndex - numberOfAffectedSegments, 0 ),
+      std::min< vtkIdType >( modifiedControlPointIndex + numberOfAffectedSegments, numberOfSegments ),
+      firstModifiedCurvePointIndex, lastModifiedCurvePointIndex ) )
+    {
+      return false;
+    }
+  }
+  else if ( !this->Internal->UpdatePolynomialCurvePoints( state, markupsToModelModuleNode, controlPoints,
+    firstModifiedCurvePointIndex, lastModifiedCurvePointIndex ) )
+  {
+    return false;
+  }
+
+  curveTimer.Stop();
+  StageTimer tubeTimer( stageTimes, vtkMRMLMarkupsToModelNode::TubeGenerationTimedStage );
+  bool tubeUpdated = vtkSlicerMarkupsToModelTubeGeneration::UpdateTubeModelRange( state.CurvePoints,
+    firstModifiedCurvePointIndex, lastModifiedCurvePointIndex,
+    state.OutputPolyData, state.TubeRadius, state.TubeNumberOfSides, state.TubeCapping );
+  tubeTimer.Stop();
+  if ( !tubeUpdated )
+  {
+    // the curve points have already been modified, so the state is not usable anymore
+    this->Internal->CurveUpdateStates.erase( stateIt );
+    return false;
+  }
+
+  state.ControlPoints->SetPoint( modifiedControlPointIndex, controlPoints->GetPoint( modifiedControlPointIndex ) );
+  markupsToModelModuleNode->SetOutputCurveLength( state.OutputCurveLength );
+  this->Internal->StoreCurveStageResults( markupsToModelModuleNode, state );
+  return true;
+}
+
+//------------------------------------------------------------------------------
+bool vtkSlicerMarkupsToModelLogic::UpdateClosedSurfaceModelIncrementally( vtkMRMLMarkupsToModelNode* markupsToModelModuleNode,
+  vtkPoints* controlPoints )
+{
+  std::map< vtkMRMLMarkupsToModelNode*, ClosedSurfaceUpdateState >::iterator stateIt =
+    this->Internal->ClosedSurfaceUpdateStates.find( markupsToModelModuleNode );
+  if ( stateIt == this->Internal->ClosedSurfaceUpdateStates.end() )
+  {
+    return false;
+  }
+  ClosedSurfaceUpdateState& state = stateIt->second;
+  vtkMRMLModelNode* outputModelNode = markupsToModelModuleNode->GetOutputModelNode();
+  ModelPipeline& pipeline = this->Internal->Pipelines[ markupsToModelModuleNode ];
+  vtkSlicerMarkupsToModelClosedSurfaceGeneration* closedSurfaceGenerator = pipeline.ClosedSurfaceGenerator;
+  vtkSlicerMarkupsToModelConvexHullGeneration* convexHull = closedSurfaceGenerator->GetConvexHull();
+  if ( !state.HasSameParameters( markupsToModelModuleNode )
+    || state.OutputPolyData == NULL || outputModelNode == NULL || outputModelNode->GetPolyData() != state.OutputPolyData
+    || !convexHull->HasHull() )
+  {
+    return false;
+  }
+
+  if ( state.CleanMarkups )
+  {
+    StageTimer timer( pipeline.StageTimes, vtkMRMLMarkupsToModelNode::RemoveDuplicatePointsTimedStage );
+    vtkSlicerMarkupsToModelLogic::RemoveDuplicatePoints( controlPoints, state.DuplicatePointTolerance );
+  }
+  vtkIdType numberOfControlPoints = controlPoints->GetNumberOfPoints();
+  vtkIdType previousNumberOfControlPoints = state.ControlPoints->GetNumberOfPoints();
+  if ( numberOfControlPoints != previousNumberOfControlPoints && numberOfControlPoints != previousNumberOfControlPoints + 1 )
+  {
+    return false;
+  }
+  // Find the point that was moved (if any). Only a single point may be modified.
+  vtkIdType modifiedControlPointIndex = -1;
+  for ( vtkIdType pointIndex = 0; pointIndex < previousNumberOfControlPoints; pointIndex++ )
+  {
+    double point[ 3 ] = { 0.0, 0.0, 0.0 };
+    double previousPoint[ 3 ] = { 0.0, 0.0, 0.0 };
+    controlPoints->GetPoint( pointIndex, point );
+    state.ControlPoints->GetPoint( pointIndex, previousPoint );
+    if ( point[ 0 ] != previousPoint[ 0 ] || point[ 1 ] != previousPoint[ 1 ] || point[ 2 ] != previousPoint[ 2 ] )
+    {
+      if ( modifiedControlPointIndex >= 0 || numberOfControlPoints != previousNumberOfControlPoints )
+      {
+        return false;
+      }
+      modifiedControlPointIndex = pointIndex;
+    }
+  }
+
+  // The triangulated surface in the generator is updated with the hull, so the stage results are now for the new points
+  pipeline.HasStageResults = false;
+
+  StageTimer hullTimer( pipeline.StageTimes, vtkMRMLMarkupsToModelNode::TriangulationTimedStage );
+  bool hullModified = false;
+  if ( numberOfControlPoints == previousNumberOfControlPoints + 1 )
+  {
+    double addedPoint[ 3 ] = { 0.0, 0.0, 0.0 };
+    controlPoints->GetPoint( numberOfControlPoints - 1, addedPoint );
+    hullModified = convexHull->InsertPoint( addedPoint );
+    if ( !convexHull->HasHull() )
+    {
+      return false;
+    }
+    state.ControlPoints->InsertNextPoint( addedPoint );
+  }
+  else if ( modifiedControlPointIndex >= 0 )
+  {
+    double modifiedPoint[ 3 ] = { 0.0, 0.0, 0.0 };
+    controlPoints->GetPoint( modifiedControlPointIndex, modifiedPoint );
+    if ( !convexHull->SetPoint( modifiedControlPointIndex, modifiedPoint, hullModified ) )
+    {
+      // a hull vertex was moved, the hull must be recomputed
+      return false;
+    }
+    state.ControlPoints->SetPoint( modifiedControlPointIndex, modifiedPoint );
+  }
+
+  hullTimer.Stop();
+
+  if ( hullModified
+    && !closedSurfaceGenerator->GenerateSurfaceFromConvexHull( state.OutputPolyData, state.ButterflySubdivision, state.ForceConvex, state.Subdivision,
+      pipeline.StageTimes ) )
+  {
+    this->Internal->ClosedSurfaceUpdateStates.erase( stateIt );
+    return false;
+  }
+  // if the point is inside the surface then the output does not change
+  pipeline.ControlPoints->DeepCopy( state.ControlPoints );
+  pipeline.HasStageResults = true;
+  return true;
+}
+
+//------------------------------------------------------------------------------
+void vtkSlicerMarkupsToModelLogic::ProcessMRMLNodesEvents(vtkObject* caller, unsigned long event, void* callData )
+{
+  MARKUPSTOMODEL_TRACE_SCOPE("Logic::ProcessMRMLNodesEvents", "logic");
+  vtkMRMLNode* callerNode = vtkMRMLNode::SafeDownCast(caller);
+  if (callerNode == NULL)
+  {
+    return;
+  }
+
+  vtkMRMLMarkupsToModelNode* markupsToModelModuleNode = vtkMRMLMarkupsToModelNode::SafeDownCast(callerNode);
+  if (markupsToModelModuleNode == NULL)
+  {
+    return;
+  }
+
+  if (this->GetMRMLScene() &&
+    (this->GetMRMLScene()->IsImporting() ||
+    this->GetMRMLScene()->IsRestoring() ||
+    this->GetMRMLScene()->IsClosing()))
+  {
+    return;
+  }
+
+  if (event == vtkMRMLMarkupsToModelNode::OutputModelDisplayModifiedEvent)
+  {
+    // the output of the scene was not generated yet, as it was hidden
+    if (this->Internal->DeferredUpdates.count(markupsToModelModuleNode) > 0 && IsOutputModelVisible(markupsToModelModuleNode))
+    {
+      this->UpdateOutputModel(markupsToModelModuleNode);
+    }
+    return;
+  }
+
+  if (!markupsToModelModuleNode->GetAutoUpdateOutput())
+  {
+    return;
+  }
+
+  // Markups nodes are also modified by changes that do not affect the output (e.g., selection, label, or lock of points).
+  // Parameter changes are reported by ModifiedEvent, so they are always processed.
+  // The input points are extracted once, both for checking whether they changed and for updating the output.
+  if (event == vtkMRMLMarkupsToModelNode::MarkupsPositionModifiedEvent)
+  {
+    vtkSmartPointer< vtkPoints > inputControlPoints = vtkSmartPointer< vtkPoints >::New();
+    double stageTimes[vtkMRMLMarkupsToModelNode::TimedStage_Last];
+    InitializeStageTimes(stageTimes);
+    if (!this->GetInputControlPoints(markupsToModelModuleNode, inputControlPoints, stageTimes))
+    {
+      // the update reports the missing input
+      inputControlPoints = NULL;
+    }
+    else if (!this->HasInputPointsChanged(markupsToModelModuleNode, inputControlPoints))
+    {
+      this->NumberOfSkippedUpdateRequests++;
+      return;
+    }
+    int modifiedMarkupPointIndex = (callData != NULL ? *(reinterpret_cast<int*>(callData)) : -1);
+    this->RequestOutputModelUpdate(markupsToModelModuleNode, modifiedMarkupPointIndex,
+      inputControlPoints, stageTimes[vtkMRMLMarkupsToModelNode::MarkupsToPointsTimedStage]);
+  }
+  else if (event == vtkCommand::ModifiedEvent)
+  {
+    this->RequestOutputModelUpdate(markupsToModelModuleNode);
+  }
+}
+
+//------------------------------------------------------------------------------
+void vtkSlicerMarkupsToModelLogic::SetInputFingerprint(vtkMRMLMarkupsToModelNode* markupsToModelModuleNode, vtkPoints* controlPoints)
+{
+  ModelPipeline& pipeline = this->Internal->Pipelines[markupsToModelModuleNode];
+  pipeline.InputFingerprint = ComputePointsFingerprint(controlPoints);
+  pipeline.HasInputFingerprint = true;
+}
+
+//------------------------------------------------------------------------------
+bool vtkSlicerMarkupsToModelLogic::HasInputPointsChanged(vtkMRMLMarkupsToModelNode* markupsToModelModuleNode, vtkPoints* controlPoints)
+{
+  std::map< vtkMRMLMarkupsToModelNode*, ModelPipeline >::iterator pipelineIt = this->Internal->Pipelines.find(markupsToModelModuleNode);
+  if (pipelineIt == this->Internal->Pipelines.end() || !pipelineIt->second.HasInputFingerprint)
+  {
+    return true;
+  }
+  return ComputePointsFingerprint(controlPoints) != pipelineIt->second.InputFingerprint;
+}
+
+//------------------------------------------------------------------------------
+void vtkSlicerMarkupsToModelLogic::RequestOutputModelUpdate(vtkMRMLMarkupsToModelNode* markupsToModelModuleNode, int modifiedMarkupPointIndex/*=-1*/,
+  vtkPoints* inputControlPoints/*=NULL*/, double inputExtractionTime/*=0.0*/)
+{
+  MARKUPSTOMODEL_TRACE_SCOPE("Logic::RequestOutputModelUpdate", "logic");
+  this->NumberOfUpdateRequests++;
+
+  // Merge with the pending update of the node. Only a single point index can be kept,
+  // so if the requests are for different points (or not for a single point) then the whole model is updated.
+  std::map< vtkMRMLMarkupsToModelNode*, int >::iterator pendingUpdateIt = this->Internal->PendingUpdates.find(markupsToModelModuleNode);
+  if (pendingUpdateIt != this->Internal->PendingUpdates.end())
+  {
+    if (pendingUpdateIt->second != modifiedMarkupPointIndex)
+    {
+      modifiedMarkupPointIndex = -1;
+    }
+    this->Internal->PendingUpdates.erase(pendingUpdateIt);
+    this->NumberOfMergedUpdateRequests++;
+  }
+
+  // While the user is interacting, the output is not updated more often than the minimum interval.
+  // At the end of the interaction the node is modified (Interacting is cleared), so the latest state is always shown.
+  double currentTime = vtkTimerLog::GetUniversalTime();
+  ModelPipeline& pipeline = this->Internal->Pipelines[markupsToModelModuleNode];
+  if (markupsToModelModuleNode->GetInteracting() && this->MinimumInteractionUpdateInterval > 0.0
+    && currentTime - pipeline.LastUpdateTime < this->MinimumInteractionUpdateInterval)
+  {
+    this->Internal->PendingUpdates[markupsToModelModuleNode] = modifiedMarkupPointIndex;
+    this->InvokeEvent(PendingUpdateAddedEvent, markupsToModelModuleNode);
+    return;
+  }
+
+  pipeline.LastUpdateTime = currentTime;
+  this->UpdateOutputModelFromPoints(markupsToModelModuleNode, modifiedMarkupPointIndex, inputControlPoints, inputExtractionTime);
+}
+
+//------------------------------------------------------------------------------
+void vtkSlicerMarkupsToModelLogic::ProcessPendingUpdates(bool force/*=false*/)
+{
+  MARKUPSTOMODEL_TRACE_SCOPE("Logic::ProcessPendingUpdates", "logic");
+  this->ProcessAsynchronousUpdates();
+  if (this->Internal->PendingUpdates.empty())
+  {
+    return;
+  }
+
+  // Collect the updates first, as updating the output may add or remove pending updates
+  double currentTime = vtkTimerLog::GetUniversalTime();
+  std::vector< std::pair< vtkMRMLMarkupsToModelNode*, int > > dueUpdates;
+  for (std::map< vtkMRMLMarkupsToModelNode*, int >::iterator pendingUpdateIt = this->Internal->PendingUpdates.begin();
+    pendingUpdateIt != this->Internal->PendingUpdates.end(); ++pendingUpdateIt)
+  {
+    ModelPipeline& pipeline = this->Internal->Pipelines[pendingUpdateIt->first];
+    if (force || currentTime - pipeline.LastUpdateTime >= this->MinimumInteractionUpdateInterval)
+    {
+      dueUpdates.push_back(*pendingUpdateIt);
+    }
+  }
+
+  for (std::vector< std::pair< vtkMRMLMarkupsToModelNode*, int > >::iterator dueUpdateIt = dueUpdates.begin();
+    dueUpdateIt != dueUpdates.end(); ++dueUpdateIt)
+  {
+    vtkMRMLMarkupsToModelNode* markupsToModelModuleNode = dueUpdateIt->first;
+    if (this->Internal->PendingUpdates.erase(markupsToModelModuleNode) == 0)
+    {
+      // already updated or removed from the scene
+      continue;
+    }
+    if (!markupsToModelModuleNode->GetAutoUpdateOutput())
+    {
+      continue;
+    }
+    this->Internal->Pipelines[markupsToModelModuleNode].LastUpdateTime = currentTime;
+    this->UpdateOutputModel(markupsToModelModuleNode, dueUpdateIt->second);
+  }
+}
+
+//------------------------------------------------------------------------------
+bool vtkSlicerMarkupsToModelLogic::IsOutputModelUpdateDeferred(vtkMRMLMarkupsToModelNode* markupsToModelModuleNode)
+{
+  return this->Internal->DeferredUpdates.count(markupsToModelModuleNode) > 0;
+}
+
+//------------------------------------------------------------------------------
+bool vtkSlicerMarkupsToModelLogic::HasPendingUpdates()
+{
+  if (!this->Internal->PendingUpdates.empty())
+  {
+    return true;
+  }
+  for (std::map< vtkMRMLMarkupsToModelNode*, AsynchronousUpdateState >::iterator updateIt = this->Internal->AsynchronousUpdates.begin();
+    updateIt != this->Internal->AsynchronousUpdates.end(); ++updateIt)
+  {
+    if (updateIt->second.RunningJob)
+    {
+      return true;
+    }
+  }
+  return false;
+}
+
+//------------------------------------------------------------------------------
+void vtkSlicerMarkupsToModelLogic::StartAsynchronousUpdate(vtkMRMLMarkupsToModelNode* markupsToModelModuleNode, vtkPoints* controlPoints,
+  const std::string& cacheKey/*=""*/)
+{
+  std::shared_ptr< ModelUpdateJob > job = std::make_shared< ModelUpdateJob >();
+  job->CacheKey = cacheKey;
+  // The worker thread must not access the parameter node, as it may be modified or deleted in the meantime
+  job->Parameters = vtkSmartPointer< vtkMRMLMarkupsToModelNode >::New();
+  job->Parameters->Copy(markupsToModelModuleNode);
+  job->Parameters->SetInteracting(markupsToModelModuleNode->GetInteracting()); // not copied, but affects the level of detail
+  job->ControlPoints = vtkSmartPointer< vtkPoints >::New();
+  job->ControlPoints->DeepCopy(controlPoints);
+  job->OutputPolyData = vtkSmartPointer< vtkPolyData >::New();
+  // parameters that are modified after this point are newer than the results
+  job->Pipeline.StageResultsTime.Modified();
+  // the job continues the update, the stage times are recorded when its result is assigned to the output
+  ModelPipeline& pipeline = this->Internal->Pipelines[markupsToModelModuleNode];
+  std::copy(pipeline.StageTimes, pipeline.StageTimes + vtkMRMLMarkupsToModelNode::TimedStage_Last, job->Pipeline.StageTimes);
+
+  AsynchronousUpdateState& update = this->Internal->AsynchronousUpdates[markupsToModelModuleNode];
+  if (update.RunningJob)
   {
+    // The running job is outdated. It stops before its next stage, and the new job is started
+    // when it has finished (and its result is discarded).
+    update.RunningJob->Cancelled = true;
+    update.QueuedJob = job;
+    this->SetAsynchronousUpdateStatus(markupsToModelModuleNode, AsynchronousUpdatePending);
+    this->InvokeEvent(PendingUpdateAddedEvent, markupsToModelModuleNode);
     return;
   }
+  update.RunningJob = job;
+  this->Internal->Worker.AddJob(job);
+  this->SetAsynchronousUpdateStatus(markupsToModelModuleNode, AsynchronousUpdateRunning);
+  this->InvokeEvent(PendingUpdateAddedEvent, markupsToModelModuleNode);
+}
 
-  if (markupsToModelModuleNode->GetOutputModelNode() == NULL)
+//------------------------------------------------------------------------------
+void vtkSlicerMarkupsToModelLogic::CancelAsynchronousUpdate(vtkMRMLMarkupsToModelNode* markupsToModelModuleNode)
+{
+  std::map< vtkMRMLMarkupsToModelNode*, AsynchronousUpdateState >::iterator updateIt = this->Internal->AsynchronousUpdates.find(markupsToModelModuleNode);
+  if (updateIt == this->Internal->AsynchronousUpdates.end())
   {
-    vtkErrorMacro("No output model node provided to UpdateOutputModel. No operation performed.");
     return;
   }
-
-  // extract the input points from the MRML node, according to its type
-  vtkSmartPointer< vtkPoints > controlPoints = vtkSmartPointer< vtkPoints >::New();
-  vtkMRMLMarkupsNode* inputMarkupsNode = vtkMRMLMarkupsNode::SafeDownCast( inputNode );
-  vtkMRMLModelNode* inputModelNode = vtkMRMLModelNode::SafeDownCast( inputNode );
-  if ( inputMarkupsNode != NULL )
+  if (updateIt->second.RunningJob)
   {
-    vtkSlicerMarkupsToModelLogic::MarkupsToPoints( inputMarkupsNode, controlPoints );
+    updateIt->second.RunningJob->Cancelled = true;
   }
-  else if ( inputModelNode != NULL )
+  bool statusModified = (updateIt->second.Status != AsynchronousUpdateIdle);
+  this->Internal->AsynchronousUpdates.erase(updateIt);
+  if (statusModified)
   {
-    vtkSlicerMarkupsToModelLogic::ModelToPoints( inputModelNode, controlPoints );
+    this->InvokeEvent(AsynchronousUpdateStatusModifiedEvent, markupsToModelModuleNode);
   }
-  else
+}
+
+//------------------------------------------------------------------------------
+void vtkSlicerMarkupsToModelLogic::ProcessAsynchronousUpdates()
+{
+  MARKUPSTOMODEL_TRACE_SCOPE("Logic::ProcessAsynchronousUpdates", "logic");
+  // Collect the finished jobs first, as assigning the output may start or cancel updates
+  std::vector< vtkMRMLMarkupsToModelNode* > finishedUpdateNodes;
+  for (std::map< vtkMRMLMarkupsToModelNode*, AsynchronousUpdateState >::iterator updateIt = this->Internal->AsynchronousUpdates.begin();
+    updateIt != this->Internal->AsynchronousUpdates.end(); ++updateIt)
   {
-    vtkErrorMacro( "Input node type is not supported. No operation performed." );
-    return;
+    if (updateIt->second.RunningJob && updateIt->second.RunningJob->Finished)
+    {
+      finishedUpdateNodes.push_back(updateIt->first);
+    }
   }
 
-  // Create the model from the points
-  vtkSmartPointer< vtkPolyData > outputPolyData = vtkSmartPointer< vtkPolyData >::New();
-  bool cleanMarkups = markupsToModelModuleNode->GetCleanMarkups();
-  bool success = false;
-  int modelType = markupsToModelModuleNode->GetModelType();
-  switch ( modelType )
+  for (std::vector< vtkMRMLMarkupsToModelNode* >::iterator nodeIt = finishedUpdateNodes.begin(); nodeIt != finishedUpdateNodes.end(); ++nodeIt)
   {
-    case vtkMRMLMarkupsToModelNode::ClosedSurface:
+    vtkMRMLMarkupsToModelNode* markupsToModelModuleNode = *nodeIt;
+    std::map< vtkMRMLMarkupsToModelNode*, AsynchronousUpdateState >::iterator updateIt = this->Internal->AsynchronousUpdates.find(markupsToModelModuleNode);
+    if (updateIt == this->Internal->AsynchronousUpdates.end() || !updateIt->second.RunningJob || !updateIt->second.RunningJob->Finished)
     {
-      double delaunayAlpha = markupsToModelModuleNode->GetDelaunayAlpha();
-      bool smoothing = markupsToModelModuleNode->GetButterflySubdivision();
-      bool forceConvex = markupsToModelModuleNode->GetConvexHull();
-      success = vtkSlicerMarkupsToModelLogic::UpdateClosedSurfaceModel( controlPoints, outputPolyData, smoothing, forceConvex, delaunayAlpha, cleanMarkups );
-      break;
+      // cancelled or removed from the scene while other outputs were assigned
+      continue;
     }
-    case vtkMRMLMarkupsToModelNode::Curve:
+    std::shared_ptr< ModelUpdateJob > job = updateIt->second.RunningJob;
+    updateIt->second.RunningJob = updateIt->second.QueuedJob;
+    updateIt->second.QueuedJob.reset();
+    if (updateIt->second.RunningJob)
     {
-      if ( this->CurveGenerator == NULL )
-      {
-        vtkErrorMacro( "Curve generator is null. No operation performed." );
-        return;
-      }
-      int tubeSegmentsBetweenControlPoints = markupsToModelModuleNode->GetTubeSegmentsBetweenControlPoints();
-      bool tubeLoop = markupsToModelModuleNode->GetTubeLoop();
-      bool tubeCapping = markupsToModelModuleNode->GetTubeCapping();
-      double tubeRadius = markupsToModelModuleNode->GetTubeRadius();
-      int tubeNumberOfSides = markupsToModelModuleNode->GetTubeNumberOfSides();
-      int curveType = markupsToModelModuleNode->GetCurveType();
-      int polynomialOrder = markupsToModelModuleNode->GetPolynomialOrder();
-      int pointParameterType = markupsToModelModuleNode->GetPointParameterType();
-      bool kochanekEndsCopyNearestDerivatives = markupsToModelModuleNode->GetKochanekEndsCopyNearestDerivatives();
-      double kochanekBias = markupsToModelModuleNode->GetKochanekBias();
-      double kochanekContinuity = markupsToModelModuleNode->GetKochanekContinuity();
-      double kochanekTension = markupsToModelModuleNode->GetKochanekTension();
-      int polynomialFitType = markupsToModelModuleNode->GetPolynomialFitType();
-      double polynomialSampleWidth = markupsToModelModuleNode->GetPolynomialSampleWidth();
-      int polynomialWeightType = markupsToModelModuleNode->GetPolynomialWeightType();
-      success = vtkSlicerMarkupsToModelLogic::UpdateOutputCurveModel( controlPoints, outputPolyData, curveType, tubeLoop, tubeRadius, tubeNumberOfSides, tubeSegmentsBetweenControlPoints, cleanMarkups, polynomialOrder, pointParameterType, kochanekEndsCopyNearestDerivatives, kochanekBias, kochanekContinuity, kochanekTension, this->CurveGenerator, polynomialFitType, polynomialSampleWidth, polynomialWeightType, tubeCapping );
-      if ( success && controlPoints->GetNumberOfPoints() > 1 )
-      {
-        double outputCurveLength = this->CurveGenerator->GetOutputCurveLength();
-        markupsToModelModuleNode->SetOutputCurveLength( outputCurveLength );
-      }
-      else
-      {
-        markupsToModelModuleNode->SetOutputCurveLength( 0.0 );
-      }
-      break;
+      this->Internal->Worker.AddJob(updateIt->second.RunningJob);
+      this->SetAsynchronousUpdateStatus(markupsToModelModuleNode, AsynchronousUpdateRunning);
+    }
+    else
+    {
+      this->SetAsynchronousUpdateStatus(markupsToModelModuleNode, AsynchronousUpdateDone);
+    }
+    if (job->Cancelled || markupsToModelModuleNode->GetOutputModelNode() == NULL)
+    {
+      continue;
     }
-  }
 
-  vtkSlicerMarkupsToModelLogic::AssignPolyDataToOutput( markupsToModelModuleNode, outputPolyData );
+    // The generators of the job become the generators of the node, so that the intermediate results
+    // (e.g., convex hull for incremental updates) match the output
+    ModelPipeline& pipeline = this->Internal->Pipelines[markupsToModelModuleNode];
+    pipeline.ClosedSurfaceGenerator = job->Pipeline.ClosedSurfaceGenerator;
+    pipeline.CurveGenerator = job->Pipeline.CurveGenerator;
+    pipeline.CurvePoints = job->Pipeline.CurvePoints;
+    pipeline.OutputCurveLength = job->Pipeline.OutputCurveLength;
+    pipeline.StageResultsTime = job->Pipeline.StageResultsTime;
+    std::copy(job->Pipeline.StageTimes, job->Pipeline.StageTimes + vtkMRMLMarkupsToModelNode::TimedStage_Last, pipeline.StageTimes);
+    if (job->Success)
+    {
+      this->StoreOutputModelInCache(markupsToModelModuleNode, job->CacheKey, job->OutputPolyData, job->Pipeline.OutputCurveLength);
+    }
+    this->FinishOutputModelUpdate(markupsToModelModuleNode, job->Parameters, job->ControlPoints, job->OutputPolyData, job->Success);
+    markupsToModelModuleNode->AddStageTimes(pipeline.StageTimes);
+    this->NumberOfPerformedUpdates++;
+  }
 }
 
 //------------------------------------------------------------------------------
-void vtkSlicerMarkupsToModelLogic::ProcessMRMLNodesEvents(vtkObject* caller, unsigned long event, void* vtkNotUsed( callData ) )
+int vtkSlicerMarkupsToModelLogic::GetAsynchronousUpdateStatus(vtkMRMLMarkupsToModelNode* markupsToModelModuleNode)
 {
-  vtkMRMLNode* callerNode = vtkMRMLNode::SafeDownCast(caller);
-  if (callerNode == NULL)
+  std::map< vtkMRMLMarkupsToModelNode*, AsynchronousUpdateState >::iterator updateIt = this->Internal->AsynchronousUpdates.find(markupsToModelModuleNode);
+  if (updateIt == this->Internal->AsynchronousUpdates.end())
   {
-    return;
+    return AsynchronousUpdateIdle;
   }
+  return updateIt->second.Status;
+}
 
-  vtkMRMLMarkupsToModelNode* markupsToModelModuleNode = vtkMRMLMarkupsToModelNode::SafeDownCast(callerNode);
-  if (markupsToModelModuleNode == NULL || !markupsToModelModuleNode->GetAutoUpdateOutput())
+//------------------------------------------------------------------------------
+void vtkSlicerMarkupsToModelLogic::SetAsynchronousUpdateStatus(vtkMRMLMarkupsToModelNode* markupsToModelModuleNode, int status)
+{
+  AsynchronousUpdateState& update = this->Internal->AsynchronousUpdates[markupsToModelModuleNode];
+  if (update.Status == status)
   {
     return;
   }
+  update.Status = status;
+  this->InvokeEvent(AsynchronousUpdateStatusModifiedEvent, markupsToModelModuleNode);
+}
 
-  if (this->GetMRMLScene() &&
-    (this->GetMRMLScene()->IsImporting() ||
-    this->GetMRMLScene()->IsRestoring() ||
-    this->GetMRMLScene()->IsClosing()))
+//------------------------------------------------------------------------------
+const char* vtkSlicerMarkupsToModelLogic::GetAsynchronousUpdateStatusAsString(int status)
+{
+  switch (status)
   {
-    return;
+    case AsynchronousUpdateIdle: return "Idle";
+    case AsynchronousUpdatePending: return "Pending";
+    case AsynchronousUpdateRunning: return "Running";
+    case AsynchronousUpdateDone: return "Done";
+    default:
+      vtkGenericWarningMacro("Unknown asynchronous update status: " << status);
+      return "";
   }
+}
 
-  if (event == vtkMRMLMarkupsToModelNode::MarkupsPositionModifiedEvent
-    || event == vtkCommand::ModifiedEvent)
-  {
-    this->UpdateOutputModel(markupsToModelModuleNode);
-  }
+//------------------------------------------------------------------------------
+void vtkSlicerMarkupsToModelLogic::ResetUpdateRequestCounters()
+{
+  this->NumberOfUpdateRequests = 0;
+  this->NumberOfMergedUpdateRequests = 0;
+  this->NumberOfSkippedUpdateRequests = 0;
+  this->NumberOfPerformedUpdates = 0;
 }
 
 //------------------------------------------------------------------------------
@@ -401,7 +2463,10 @@ bool vtkSlicerMarkupsToModelLogic::UpdateOutputCurveModel( vtkPoints* controlPoi
   bool cleanMarkups, int polynomialOrder, int pointParameterType,
   bool kochanekEndsCopyNearestDerivatives, double kochanekBias, double kochanekContinuity, double kochanekTension,
   vtkCurveGenerator* curveGenerator,
-  int polynomialFitType, double polynomialSampleWidth, int polynomialWeightType, bool tubeCapping )
+  int polynomialFitType, double polynomialSampleWidth, int polynomialWeightType, bool tubeCapping,
+  int curveSamplingMode, double samplingAngleTolerance, double samplingChordTolerance,
+  int minimumSamplesPerSegment, int maximumSamplesPerSegment, double duplicatePointTolerance, vtkPoints* outputCurvePoints,
+  double* stageTimes/*=NULL*/, const std::atomic< bool >* cancelled/*=NULL*/ )
 {
   if ( controlPoints == NULL )
   {
@@ -418,18 +2483,30 @@ bool vtkSlicerMarkupsToModelLogic::UpdateOutputCurveModel( vtkPoints* controlPoi
   // get rid of duplicate points
   if ( cleanMarkups )
   {
-    vtkSlicerMarkupsToModelLogic::RemoveDuplicatePoints( controlPoints );
+    StageTimer timer( stageTimes, vtkMRMLMarkupsToModelNode::RemoveDuplicatePointsTimedStage );
+    vtkSlicerMarkupsToModelLogic::RemoveDuplicatePoints( controlPoints, duplicatePointTolerance );
+  }
+  if ( IsCancelled( cancelled ) )
+  {
+    return false;
+  }
+
+  if ( outputCurvePoints != NULL )
+  {
+    outputCurvePoints->Reset();
   }
 
   // check a few special cases before handling the different types of curve
   if ( controlPoints->GetNumberOfPoints() <= 0 )
   {
-    // don't need to do anything for 0 points
+    // empty output for 0 points
+    outputPolyData->Initialize();
     return true;
   }
 
   if ( controlPoints->GetNumberOfPoints() == 1 )
   {
+    StageTimer timer( stageTimes, vtkMRMLMarkupsToModelNode::TubeGenerationTimedStage );
     vtkSlicerMarkupsToModelLogic::GenerateSphereModel( controlPoints->GetPoint( 0 ), outputPolyData, tubeRadius, tubeNumberOfSides );
     return true;
   }
@@ -440,10 +2517,19 @@ bool vtkSlicerMarkupsToModelLogic::UpdateOutputCurveModel( vtkPoints* controlPoi
     temporaryCurveGenerator = vtkSmartPointer< vtkCurveGenerator >::New();
     curveGenerator = temporaryCurveGenerator;
   }
+  // In adaptive mode the curve is evaluated at the maximum sampling rate and then only the necessary samples are kept
+  bool adaptiveSampling = ( curveSamplingMode == vtkMRMLMarkupsToModelNode::AdaptiveSampling );
+  int pointsPerSegment = adaptiveSampling ? maximumSamplesPerSegment : tubeSegmentsBetweenControlPoints;
   curveGenerator->SetInputPoints( controlPoints );
-  curveGenerator->SetNumberOfPointsPerInterpolatingSegment( tubeSegmentsBetweenControlPoints );
+  curveGenerator->SetNumberOfPointsPerInterpolatingSegment( pointsPerSegment );
   vtkPoints* curvePoints = NULL; // temporary value
+  vtkSmartPointer< vtkPoints > adaptiveCurvePoints;
+  if ( adaptiveSampling )
+  {
+    adaptiveCurvePoints = vtkSmartPointer< vtkPoints >::New();
+  }
 
+  StageTimer curveTimer( stageTimes, vtkMRMLMarkupsToModelNode::CurveGenerationTimedStage );
   // special case
   if ( controlPoints->GetNumberOfPoints() == 2 )
   {
@@ -451,26 +2537,84 @@ bool vtkSlicerMarkupsToModelLogic::UpdateOutputCurveModel( vtkPoints* controlPoi
     curveGenerator->SetCurveTypeToLinearSpline();
     curveGenerator->Update();
     curvePoints = curveGenerator->GetOutputPoints();
+    if ( adaptiveSampling )
+    {
+      vtkSlicerMarkupsToModelLogic::SelectAdaptiveCurvePoints( curvePoints, pointsPerSegment,
+        samplingAngleTolerance, samplingChordTolerance, minimumSamplesPerSegment, adaptiveCurvePoints );
+      curvePoints = adaptiveCurvePoints;
+    }
+    if ( outputCurvePoints != NULL )
+    {
+      outputCurvePoints->DeepCopy( curvePoints );
+    }
+    curveTimer.Stop();
+    if ( IsCancelled( cancelled ) )
+    {
+      return false;
+    }
+    StageTimer tubeTimer( stageTimes, vtkMRMLMarkupsToModelNode::TubeGenerationTimedStage );
     vtkSlicerMarkupsToModelLogic::GenerateTubeModel( curvePoints, outputPolyData, tubeRadius, tubeNumberOfSides, tubeCapping );
     return true;
   }
 
   curveGenerator->SetCurveIsClosed( tubeLoop );
+  if ( !vtkSlicerMarkupsToModelLogic::SetCurveGeneratorParameters( curveGenerator, curveType, polynomialOrder, pointParameterType,
+    kochanekEndsCopyNearestDerivatives, kochanekBias, kochanekContinuity, kochanekTension,
+    polynomialFitType, polynomialSampleWidth, polynomialWeightType ) )
+  {
+    vtkGenericWarningMacro( "Unknown curve type. Aborting." );
+    return false;
+  }
+  curveGenerator->Update();
+  curvePoints = curveGenerator->GetOutputPoints();
+
+  if ( curvePoints == NULL )
+  {
+    vtkGenericWarningMacro( "No curve points generated. No model can be generated." );
+    return false;
+  }
+
+  if ( adaptiveSampling )
+  {
+    vtkSlicerMarkupsToModelLogic::SelectAdaptiveCurvePoints( curvePoints, pointsPerSegment,
+      samplingAngleTolerance, samplingChordTolerance, minimumSamplesPerSegment, adaptiveCurvePoints );
+    curvePoints = adaptiveCurvePoints;
+  }
+
+  if ( tubeLoop && curveType != vtkMRMLMarkupsToModelNode::Polynomial ) // looping not supported for polynomials
+  {
+    vtkSlicerMarkupsToModelLogic::MakeLoopContinuous( curvePoints );
+  }
+  if ( outputCurvePoints != NULL )
+  {
+    outputCurvePoints->DeepCopy( curvePoints );
+  }
+  curveTimer.Stop();
+  if ( IsCancelled( cancelled ) )
+  {
+    return false;
+  }
+  StageTimer tubeTimer( stageTimes, vtkMRMLMarkupsToModelNode::TubeGenerationTimedStage );
+  vtkSlicerMarkupsToModelLogic::GenerateTubeModel( curvePoints, outputPolyData, tubeRadius, tubeNumberOfSides, tubeCapping );
+  return true;
+}
+
+//------------------------------------------------------------------------------
+bool vtkSlicerMarkupsToModelLogic::SetCurveGeneratorParameters( vtkCurveGenerator* curveGenerator, int curveType,
+  int polynomialOrder, int pointParameterType,
+  bool kochanekEndsCopyNearestDerivatives, double kochanekBias, double kochanekContinuity, double kochanekTension,
+  int polynomialFitType, double polynomialSampleWidth, int polynomialWeightType )
+{
   switch ( curveType )
   {
-    // Generates a polynomial curve model.
     case vtkMRMLMarkupsToModelNode::Linear:
     {
       curveGenerator->SetCurveTypeToLinearSpline();
-      curveGenerator->Update();
-      curvePoints = curveGenerator->GetOutputPoints();
       break;
     }
     case vtkMRMLMarkupsToModelNode::CardinalSpline:
     {
       curveGenerator->SetCurveTypeToCardinalSpline();
-      curveGenerator->Update();
-      curvePoints = curveGenerator->GetOutputPoints();
       break;
     }
     case vtkMRMLMarkupsToModelNode::KochanekSpline:
@@ -480,8 +2624,6 @@ bool vtkSlicerMarkupsToModelLogic::UpdateOutputCurveModel( vtkPoints* controlPoi
       curveGenerator->SetKochanekContinuity( kochanekContinuity );
       curveGenerator->SetKochanekTension( kochanekTension );
       curveGenerator->SetKochanekEndsCopyNearestDerivatives( kochanekEndsCopyNearestDerivatives );
-      curveGenerator->Update();
-      curvePoints = curveGenerator->GetOutputPoints();
       break;
     }
     case vtkMRMLMarkupsToModelNode::Polynomial:
@@ -553,29 +2695,15 @@ bool vtkSlicerMarkupsToModelLogic::UpdateOutputCurveModel( vtkPoints* controlPoi
           break;
         }
       }
-      curveGenerator->Update();
-      curvePoints = curveGenerator->GetOutputPoints();
       break;
     }
     default:
     {
-      vtkGenericWarningMacro( "Unknown curve type. Aborting." );
       return false;
     }
   }
-
-  if ( curvePoints == NULL )
-  {
-    vtkGenericWarningMacro( "No curve points generated. No model can be generated." );
-    return false;
-  }
-
-  if ( tubeLoop && curveType != vtkMRMLMarkupsToModelNode::Polynomial ) // looping not supported for polynomials
-  {
-    vtkSlicerMarkupsToModelLogic::MakeLoopContinuous( curvePoints );
-  }
-  vtkSlicerMarkupsToModelLogic::GenerateTubeModel( curvePoints, outputPolyData, tubeRadius, tubeNumberOfSides, tubeCapping );
   return true;
+
 }
 
 //------------------------------------------------------------------------------
@@ -611,7 +2739,9 @@ bool vtkSlicerMarkupsToModelLogic::UpdateClosedSurfaceModel(
 //------------------------------------------------------------------------------
 bool vtkSlicerMarkupsToModelLogic::UpdateClosedSurfaceModel(
   vtkPoints* controlPoints, vtkPolyData* outputPolyData,
-  bool smoothing, bool forceConvex, double delaunayAlpha, bool cleanMarkups )
+  bool smoothing, bool forceConvex, double delaunayAlpha, bool cleanMarkups, bool subdivision,
+  vtkSlicerMarkupsToModelClosedSurfaceGeneration* closedSurfaceGenerator, double duplicatePointTolerance, double* stageTimes/*=NULL*/,
+  const std::atomic< bool >* cancelled/*=NULL*/ )
 {
   if ( controlPoints == NULL )
   {
@@ -628,11 +2758,59 @@ bool vtkSlicerMarkupsToModelLogic::UpdateClosedSurfaceModel(
   // get rid of duplicate points
   if ( cleanMarkups )
   {
-    vtkSlicerMarkupsToModelLogic::RemoveDuplicatePoints( controlPoints );
+    StageTimer timer( stageTimes, vtkMRMLMarkupsToModelNode::RemoveDuplicatePointsTimedStage );
+    vtkSlicerMarkupsToModelLogic::RemoveDuplicatePoints( controlPoints, duplicatePointTolerance );
+  }
+  if ( IsCancelled( cancelled ) )
+  {
+    return false;
+  }
+
+  vtkSmartPointer< vtkSlicerMarkupsToModelClosedSurfaceGeneration > temporaryClosedSurfaceGenerator = NULL; // needed in case closedSurfaceGenerator is null
+  if ( closedSurfaceGenerator == NULL )
+  {
+    temporaryClosedSurfaceGenerator = vtkSmartPointer< vtkSlicerMarkupsToModelClosedSurfaceGeneration >::New();
+    closedSurfaceGenerator = temporaryClosedSurfaceGenerator;
   }
 
-  vtkSlicerMarkupsToModelClosedSurfaceGeneration::GenerateClosedSurfaceModel( controlPoints, outputPolyData, delaunayAlpha, smoothing, forceConvex );
-  return true;
+  closedSurfaceGenerator->GenerateSurface( controlPoints, outputPolyData, delaunayAlpha, smoothing, forceConvex, subdivision,
+    stageTimes, cancelled );
+  return !IsCancelled( cancelled );
+}
+
+//------------------------------------------------------------------------------
+double vtkSlicerMarkupsToModelLogic::ComputeAutomaticDelaunayAlpha( vtkMRMLMarkupsToModelNode* markupsToModelModuleNode )
+{
+  if ( markupsToModelModuleNode == NULL )
+  {
+    vtkErrorMacro( "No markupsToModelModuleNode provided to ComputeAutomaticDelaunayAlpha. No operation performed." );
+    return 0.0;
+  }
+
+  vtkSmartPointer< vtkPoints > controlPoints = vtkSmartPointer< vtkPoints >::New();
+  vtkMRMLNode* inputNode = markupsToModelModuleNode->GetInputNode();
+  vtkMRMLMarkupsNode* inputMarkupsNode = vtkMRMLMarkupsNode::SafeDownCast( inputNode );
+  vtkMRMLModelNode* inputModelNode = vtkMRMLModelNode::SafeDownCast( inputNode );
+  if ( inputMarkupsNode != NULL )
+  {
+    vtkSlicerMarkupsToModelLogic::MarkupsToPoints( inputMarkupsNode, controlPoints );
+  }
+  else if ( inputModelNode != NULL )
+  {
+    vtkSlicerMarkupsToModelLogic::ModelToPoints( inputModelNode, controlPoints );
+  }
+  else
+  {
+    return 0.0;
+  }
+  if ( markupsToModelModuleNode->GetCleanMarkups() )
+  {
+    vtkSlicerMarkupsToModelLogic::RemoveDuplicatePoints( controlPoints, markupsToModelModuleNode->GetDuplicatePointTolerance() );
+  }
+
+  // Use the closed surface generator of the node, so that the surface can be
+  // generated for the returned alpha value without triangulating the points again.
+  return this->Internal->Pipelines[ markupsToModelModuleNode ].ClosedSurfaceGenerator->ComputeAutomaticDelaunayAlpha( controlPoints );
 }
 
 //------------------------------------------------------------------------------
@@ -689,17 +2867,107 @@ void vtkSlicerMarkupsToModelLogic::MarkupsToPoints( vtkMRMLMarkupsNode* inputMar
 }
 
 //------------------------------------------------------------------------------
-void vtkSlicerMarkupsToModelLogic::RemoveDuplicatePoints( vtkPoints* points )
+vtkIdType vtkSlicerMarkupsToModelLogic::RemoveDuplicatePoints( vtkPoints* points, double tolerance )
 {
-  vtkSmartPointer< vtkPolyData > polyData = vtkSmartPointer< vtkPolyData >::New();
-  polyData->Initialize();
-  polyData->SetPoints( points );
+  if ( points == NULL )
+  {
+    vtkGenericWarningMacro( "Points object is null. No duplicate points removed." );
+    return 0;
+  }
+  vtkIdType numberOfPoints = points->GetNumberOfPoints();
+  if ( numberOfPoints < 2 )
+  {
+    return 0;
+  }
+
+  // Points are hashed into a uniform grid. Cell size is four times the tolerance, so the points closer than the tolerance
+  // to a point are in at most 2x2x2 cells, and on average only 1.5^3 cells have to be searched.
+  double cellSize = ( tolerance > 0.0 ? 4.0 * tolerance : 1.0 ); // with zero tolerance only identical points are merged
+  // If the tolerance is tiny compared to the coordinates then larger cells are used, so that cell indices stay in range
+  // (more points are compared in a cell, but the result is the same)
+  double bounds[ 6 ] = { 0.0, 0.0, 0.0, 0.0, 0.0, 0.0 };
+  points->GetBounds( bounds );
+  double maximumAbsoluteCoordinate = 0.0;
+  for ( int i = 0; i < 6; i++ )
+  {
+    maximumAbsoluteCoordinate = std::max( maximumAbsoluteCoordinate, fabs( bounds[ i ] ) );
+  }
+  if ( vtkMath::IsFinite( maximumAbsoluteCoordinate ) )
+  {
+    cellSize = std::max( cellSize, 2.0 * maximumAbsoluteCoordinate / MAXIMUM_GRID_CELL_INDEX );
+  }
+  const double tolerance2 = tolerance * tolerance;
+  DuplicatePointGrid grid( numberOfPoints );
+  std::vector< vtkIdType > nextPointInCell( numberOfPoints, -1 );
+
+  vtkIdType numberOfKeptPoints = 0;
+  for ( vtkIdType pointIndex = 0; pointIndex < numberOfPoints; pointIndex++ )
+  {
+    double point[ 3 ] = { 0.0, 0.0, 0.0 };
+    points->GetPoint( pointIndex, point );
+    long long cellIndex[ 3 ] = { 0, 0, 0 };
+    long long searchOffset[ 3 ] = { 0, 0, 0 }; // direction of the neighbor cell that is within tolerance (if any)
+    for ( int i = 0; i < 3; i++ )
+    {
+      cellIndex[ i ] = GetGridCellIndex( point[ i ], cellSize );
+      if ( GetGridCellIndex( point[ i ] - tolerance, cellSize ) < cellIndex[ i ] )
+      {
+        searchOffset[ i ] = -1;
+      }
+      else if ( GetGridCellIndex( point[ i ] + tolerance, cellSize ) > cellIndex[ i ] )
+      {
+        searchOffset[ i ] = 1;
+      }
+    }
+
+    bool duplicate = false;
+    for ( int neighborIndex = 0; neighborIndex < 8 && !duplicate; neighborIndex++ )
+    {
+      if ( ( ( neighborIndex & 1 ) && searchOffset[ 0 ] == 0 )
+        || ( ( neighborIndex & 2 ) && searchOffset[ 1 ] == 0 )
+        || ( ( neighborIndex & 4 ) && searchOffset[ 2 ] == 0 ) )
+      {
+        continue;
+      }
+      long long neighborCellIndex[ 3 ] =
+      {
+        cellIndex[ 0 ] + ( ( neighborIndex & 1 ) ? searchOffset[ 0 ] : 0 ),
+        cellIndex[ 1 ] + ( ( neighborIndex & 2 ) ? searchOffset[ 1 ] : 0 ),
+        cellIndex[ 2 ] + ( ( neighborIndex & 4 ) ? searchOffset[ 2 ] : 0 )
+      };
+      for ( vtkIdType keptPointIndex = grid.GetFirstPointId( neighborCellIndex ); keptPointIndex >= 0; keptPointIndex = nextPointInCell[ keptPointIndex ] )
+      {
+        double keptPoint[ 3 ] = { 0.0, 0.0, 0.0 };
+        points->GetPoint( keptPointIndex, keptPoint );
+        if ( vtkMath::Distance2BetweenPoints( point, keptPoint ) <= tolerance2 )
+        {
+          duplicate = true;
+          break;
+        }
+      }
+    }
+    if ( duplicate )
+    {
+      continue;
+    }
+
+    // Kept points are moved to the front, in their original order. A point is never
+    // overwritten before it is read, as numberOfKeptPoints <= pointIndex.
+    if ( numberOfKeptPoints != pointIndex )
+    {
+      points->SetPoint( numberOfKeptPoints, point );
+    }
+    grid.AddPoint( cellIndex, numberOfKeptPoints, nextPointInCell[ numberOfKeptPoints ] );
+    numberOfKeptPoints++;
+  }
 
-  vtkSmartPointer< vtkCleanPolyData > cleanPointPolyData = vtkSmartPointer< vtkCleanPolyData >::New();
-  cleanPointPolyData->SetInputData( polyData );
-  const double CLEAN_POLYDATA_TOLERANCE_MM = 0.01;
-  cleanPointPolyData->SetTolerance( CLEAN_POLYDATA_TOLERANCE_MM );
-  cleanPointPolyData->Update();
+  vtkIdType numberOfRemovedPoints = numberOfPoints - numberOfKeptPoints;
+  if ( numberOfRemovedPoints > 0 )
+  {
+    points->SetNumberOfPoints( numberOfKeptPoints );
+    points->Modified();
+  }
+  return numberOfRemovedPoints;
 }
 
 //------------------------------------------------------------------------------
@@ -742,6 +3010,12 @@ void vtkSlicerMarkupsToModelLogic::GenerateTubeModel( vtkPoints* pointsToConnect
     return;
   }
 
+  if ( tubeRadius > 0.0 )
+  {
+    vtkSlicerMarkupsToModelTubeGeneration::GenerateTubeModel( pointsToConnect, outputTubePolyData, tubeRadius, tubeNumberOfSides, tubeCapping );
+    return;
+  }
+
   int numPoints = pointsToConnect->GetNumberOfPoints();
 
   vtkSmartPointer< vtkCellArray > lineCellArray = vtkSmartPointer< vtkCellArray >::New();
@@ -755,33 +3029,24 @@ void vtkSlicerMarkupsToModelLogic::GenerateTubeModel( vtkPoints* pointsToConnect
   linePolyData->Initialize();
   linePolyData->SetPoints( pointsToConnect );
   linePolyData->SetLines( lineCellArray );
-
-  if (tubeRadius > 0.0)
-  {
-    vtkSmartPointer< vtkTubeFilter > tubeSegmentFilter = vtkSmartPointer< vtkTubeFilter >::New();
-    tubeSegmentFilter->SetInputData( linePolyData );
-    tubeSegmentFilter->SetRadius( tubeRadius );
-    tubeSegmentFilter->SetNumberOfSides( tubeNumberOfSides );
-    tubeSegmentFilter->SetCapping(tubeCapping);
-    tubeSegmentFilter->Update();
-    outputTubePolyData->DeepCopy( tubeSegmentFilter->GetOutput() );
-  }
-  else
-  {
-    outputTubePolyData->DeepCopy( linePolyData );
-  }
+  outputTubePolyData->DeepCopy( linePolyData );
 }
 
 //------------------------------------------------------------------------------
 void vtkSlicerMarkupsToModelLogic::AssignPolyDataToOutput( vtkMRMLMarkupsToModelNode* markupsToModelModuleNode, vtkPolyData* outputPolyData )
 {
+  StageTimer timer( this->Internal->Pipelines[ markupsToModelModuleNode ].StageTimes, vtkMRMLMarkupsToModelNode::AssignOutputTimedStage );
   vtkMRMLModelNode* outputModelNode = markupsToModelModuleNode->GetOutputModelNode();
   if ( outputModelNode == NULL )
   {
     vtkGenericWarningMacro( "Output model node is not specified. No operation performed." );
     return;
   }
-  outputModelNode->SetAndObservePolyData( outputPolyData );
+  if ( outputModelNode->GetPolyData() != outputPolyData )
+  {
+    outputModelNode->SetAndObservePolyData( outputPolyData );
+  }
+  this->Internal->Pipelines[ markupsToModelModuleNode ].OutputPolyData = outputPolyData;
 
   // Attach a display node if needed
   vtkMRMLModelDisplayNode* displayNode = vtkMRMLModelDisplayNode::SafeDownCast( outputModelNode->GetDisplayNode() );
@@ -794,6 +3059,92 @@ void vtkSlicerMarkupsToModelLogic::AssignPolyDataToOutput( vtkMRMLMarkupsToModel
   }
 }
 
+//------------------------------------------------------------------------------
+void vtkSlicerMarkupsToModelLogic::SelectAdaptiveCurvePoints( vtkPoints* densePoints, int densePointsPerSegment,
+  double angleToleranceDeg, double chordToleranceMm, int minimumPointsPerSegment, vtkPoints* outputPoints )
+{
+  outputPoints->Initialize();
+  vtkIdType numberOfDensePoints = densePoints->GetNumberOfPoints();
+  if ( numberOfDensePoints < 3 )
+  {
+    outputPoints->DeepCopy( densePoints );
+    return;
+  }
+
+  // If the points are not uniformly sampled per segment (e.g., polynomial fit) then the whole curve is processed as one segment
+  vtkIdType pointsPerSegment = densePointsPerSegment;
+  if ( pointsPerSegment < 1 || ( numberOfDensePoints - 1 ) % pointsPerSegment != 0 )
+  {
+    pointsPerSegment = numberOfDensePoints - 1;
+  }
+  vtkIdType numberOfSegments = ( numberOfDensePoints - 1 ) / pointsPerSegment;
+  minimumPointsPerSegment = std::max( 1, std::min< int >( minimumPointsPerSegment, pointsPerSegment ) );
+  double cosAngleTolerance = cos( vtkMath::RadiansFromDegrees( angleToleranceDeg ) );
+
+  // direction of each dense step, for measuring the change of curve direction
+  std::vector< double > stepDirections( 3 * ( numberOfDensePoints - 1 ) );
+  std::vector< bool > stepDirectionValid( numberOfDensePoints - 1 );
+  for ( vtkIdType stepIndex = 0; stepIndex < numberOfDensePoints - 1; stepIndex++ )
+  {
+    double stepStart[ 3 ] = { 0.0, 0.0, 0.0 };
+    double stepEnd[ 3 ] = { 0.0, 0.0, 0.0 };
+    densePoints->GetPoint( stepIndex, stepStart );
+    densePoints->GetPoint( stepIndex + 1, stepEnd );
+    double* stepDirection = &stepDirections[ 3 * stepIndex ];
+    vtkMath::Subtract( stepEnd, stepStart, stepDirection );
+    stepDirectionValid[ stepIndex ] = ( vtkMath::Normalize( stepDirection ) > 0.0 );
+  }
+
+  outputPoints->Allocate( numberOfDensePoints );
+  outputPoints->InsertNextPoint( densePoints->GetPoint( 0 ) );
+  for ( vtkIdType segmentIndex = 0; segmentIndex < numberOfSegments; segmentIndex++ )
+  {
+    vtkIdType segmentStartIndex = segmentIndex * pointsPerSegment;
+    for ( int partIndex = 0; partIndex < minimumPointsPerSegment; partIndex++ )
+    {
+      // the segment is divided into the minimum number of parts, each part is simplified separately
+      vtkIdType partStartIndex = segmentStartIndex + ( partIndex * pointsPerSegment ) / minimumPointsPerSegment;
+      vtkIdType partEndIndex = segmentStartIndex + ( ( partIndex + 1 ) * pointsPerSegment ) / minimumPointsPerSegment;
+      vtkIdType lastSelectedIndex = partStartIndex;
+      for ( vtkIdType candidateIndex = partStartIndex + 1; candidateIndex < partEndIndex; candidateIndex++ )
+      {
+        // check if the curve between the last selected point and the point after the candidate
+        // can be replaced by a straight line; if not then the candidate has to be kept
+        vtkIdType nextIndex = candidateIndex + 1;
+        bool withinTolerance = true;
+        if ( stepDirectionValid[ lastSelectedIndex ] && stepDirectionValid[ candidateIndex ]
+          && vtkMath::Dot( &stepDirections[ 3 * lastSelectedIndex ], &stepDirections[ 3 * candidateIndex ] ) < cosAngleTolerance )
+        {
+          withinTolerance = false;
+        }
+        double chordStart[ 3 ] = { 0.0, 0.0, 0.0 };
+        double chordEnd[ 3 ] = { 0.0, 0.0, 0.0 };
+        densePoints->GetPoint( lastSelectedIndex, chordStart );
+        densePoints->GetPoint( nextIndex, chordEnd );
+        for ( vtkIdType innerIndex = lastSelectedIndex + 1; withinTolerance && innerIndex < nextIndex; innerIndex++ )
+        {
+          double innerPoint[ 3 ] = { 0.0, 0.0, 0.0 };
+          densePoints->GetPoint( innerIndex, innerPoint );
+          double parametricCoordinate = 0.0;
+          double closestPoint[ 3 ] = { 0.0, 0.0, 0.0 };
+          if ( vtkLine::DistanceToLine( innerPoint, chordStart, chordEnd, parametricCoordinate, closestPoint )
+            > chordToleranceMm * chordToleranceMm )
+          {
+            withinTolerance = false;
+          }
+        }
+        if ( !withinTolerance )
+        {
+          outputPoints->InsertNextPoint( densePoints->GetPoint( candidateIndex ) );
+          lastSelectedIndex = candidateIndex;
+        }
+      }
+      outputPoints->InsertNextPoint( densePoints->GetPoint( partEndIndex ) );
+    }
+  }
+  outputPoints->Squeeze();
+}
+
 //------------------------------------------------------------------------------
 void vtkSlicerMarkupsToModelLogic::MakeLoopContinuous( vtkPoints* curvePoints )
 {
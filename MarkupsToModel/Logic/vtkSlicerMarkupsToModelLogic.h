@@ -39,15 +39,20 @@ limitations under the License.
 #include "vtkMRMLMarkupsToModelNode.h"
 
 // STD includes
+#include <atomic>
 #include <cstdlib>
+#include <string>
 
 #include "vtkSlicerMarkupsToModelModuleLogicExport.h"
 
+class vtkCollection;
 class vtkMRMLMarkupsNode;
 class vtkMRMLMarkupsToModelNode;
 class vtkMRMLModelNode;
 class vtkPolyData;
 class vtkCurveGenerator;
+class vtkSlicerMarkupsToModelClosedSurfaceGeneration;
+class vtkSlicerMarkupsToModelMeshCache;
 
 /// \ingroup Slicer_QtModules_ExtensionTemplate
 class VTK_SLICER_MARKUPSTOMODEL_MODULE_LOGIC_EXPORT vtkSlicerMarkupsToModelLogic :
@@ -56,6 +61,25 @@ class VTK_SLICER_MARKUPSTOMODEL_MODULE_LOGIC_EXPORT vtkSlicerMarkupsToModelLogic
 public:
   static vtkSlicerMarkupsToModelLogic *New();
   vtkTypeMacro(vtkSlicerMarkupsToModelLogic, vtkSlicerModuleLogic);
+
+  enum Events
+  {
+    // Invoked when the background update status of a parameter node changes, the parameter node is passed as call data
+    AsynchronousUpdateStatusModifiedEvent = vtkCommand::UserEvent + 779,
+    // Invoked when an output update is postponed or started in the background, so ProcessPendingUpdates
+    // must be called until HasPendingUpdates returns false. The parameter node is passed as call data.
+    PendingUpdateAddedEvent
+  };
+
+  enum AsynchronousUpdateStatus
+  {
+    AsynchronousUpdateIdle = 0, // no background update was started
+    AsynchronousUpdatePending, // a background update is waiting for an outdated update to finish
+    AsynchronousUpdateRunning, // a background update is in progress
+    AsynchronousUpdateDone, // the result of the last background update was assigned to the output model
+    AsynchronousUpdateStatus_Last // insert valid types above this line
+  };
+
   void PrintSelf(ostream& os, vtkIndent indent) override;
   vtkSlicerMarkupsLogic* MarkupsLogic;
   void ProcessMRMLNodesEvents( vtkObject* caller, unsigned long event, void* callData ) override;
@@ -63,15 +87,85 @@ public:
   // Updates the mouse selection type to create markups or to navigate the scene.
   void UpdateSelectionNode( vtkMRMLMarkupsToModelNode* markupsToModelModuleNode );
 
-  // Updates closed surface or curve output model from markups
-  void UpdateOutputModel( vtkMRMLMarkupsToModelNode* moduleNode );
+  // Updates closed surface or curve output model from markups.
+  // If only a single markup point was modified then its index can be specified in modifiedMarkupPointIndex,
+  // this allows updating only the affected part of a curve model.
+  void UpdateOutputModel( vtkMRMLMarkupsToModelNode* moduleNode, int modifiedMarkupPointIndex = -1 );
+
+  // Updates the output models of all parameter nodes in the collection (e.g., after scene import).
+  // The models are generated in parallel, only assigning them to the output nodes is done sequentially.
+  void UpdateOutputModels( vtkCollection* moduleNodes );
+
+  // Returns true if the output model of the parameter node was not generated at scene load because it is hidden
+  // (see vtkMRMLMarkupsToModelNode::DeferHiddenOutputUpdate). Call UpdateOutputModel before accessing the output.
+  bool IsOutputModelUpdateDeferred( vtkMRMLMarkupsToModelNode* moduleNode );
+
+  // Minimum time between output updates of a parameter node while the user is interacting (in seconds).
+  // Modifications that arrive sooner after the last update are merged, and the output is updated once with the latest state
+  // by ProcessPendingUpdates or when the interaction ends. If 0 then the output is updated after each modification.
+  vtkGetMacro( MinimumInteractionUpdateInterval, double );
+  vtkSetClampMacro( MinimumInteractionUpdateInterval, double, 0.0, VTK_DOUBLE_MAX );
+
+  // Update the output of parameter nodes that were modified during interaction but not updated yet,
+  // if the minimum update interval has elapsed since their last update (or if force is true).
+  // Needs to be called periodically while there are pending updates (the module calls it from a timer
+  // that is started by PendingUpdateAddedEvent).
+  void ProcessPendingUpdates( bool force = false );
+  bool HasPendingUpdates();
+
+  // Number of output update requests (modifications of parameter nodes or their input) and
+  // number of requests that were merged with a later request instead of updating the output separately.
+  // Modifications of the input that did not change the point positions (e.g., selection or label of a point)
+  // are not requests, they are counted in the number of skipped update requests.
+  vtkGetMacro( NumberOfUpdateRequests, vtkTypeUInt64 );
+  vtkGetMacro( NumberOfMergedUpdateRequests, vtkTypeUInt64 );
+  vtkGetMacro( NumberOfSkippedUpdateRequests, vtkTypeUInt64 );
+  // Number of output updates that were performed (background updates when their result is assigned to the output),
+  // regardless of whether the output mesh changed.
+  vtkGetMacro( NumberOfPerformedUpdates, vtkTypeUInt64 );
+  void ResetUpdateRequestCounters();
+
+  // Cache of generated models on disk. Disabled by default, enabled by setting its cache directory.
+  vtkSlicerMarkupsToModelMeshCache* GetMeshCache();
+
+  // Number of recently generated models that are kept in memory for each parameter node, so that if the input and
+  // parameters change back to a recent state (e.g., a parameter is switched on and off) then the model is not generated again.
+  // The output shares the mesh with the kept model until it is updated. Each kept model is a copy of the output,
+  // so memory use grows with the mesh size and the number of parameter nodes. 0 (default) disables keeping models.
+  vtkGetMacro( MaximumNumberOfRecentOutputs, int );
+  vtkSetClampMacro( MaximumNumberOfRecentOutputs, int, 0, VTK_INT_MAX );
+
+  // Status of the background update of the parameter node (see vtkMRMLMarkupsToModelNode::AsynchronousUpdate).
+  int GetAsynchronousUpdateStatus( vtkMRMLMarkupsToModelNode* moduleNode );
+  static const char* GetAsynchronousUpdateStatusAsString( int status );
+
+  // Generate the output model of the parameter node from the control points, without using or modifying the
+  // update state kept for the node. Only parameters are read from the node, so this can run on a worker thread
+  // on a copy of the parameter node, if generators that are not used elsewhere are provided.
+  // Curve points and curve length are stored in outputCurvePoints (if specified) and outputCurveLength.
+  // If stageTimes is specified then the durations of the performed stages are added to it
+  // (indexed by vtkMRMLMarkupsToModelNode::TimedStage, negative for stages that were not performed yet).
+  // If cancelled is specified and becomes true (e.g., set by the main thread) then generation stops before
+  // the next stage (points, curve, tube or triangulation, subdivision, normals) and false is returned.
+  static bool GenerateOutputModel( vtkMRMLMarkupsToModelNode* moduleNode, vtkPoints* controlPoints, vtkPolyData* outputPolyData,
+    vtkSlicerMarkupsToModelClosedSurfaceGeneration* closedSurfaceGenerator, vtkCurveGenerator* curveGenerator,
+    vtkPoints* outputCurvePoints, double& outputCurveLength, double* stageTimes = NULL,
+    const std::atomic< bool >* cancelled = NULL );
 
   // lower-level access to functionality for making a closed surface model
   static bool UpdateClosedSurfaceModel( vtkMRMLMarkupsNode* markupsNode, vtkMRMLModelNode* modelNode,
       bool smoothing = true, bool forceConvex = false, double delaunayAlpha = 0.0, bool cleanMarkups = true );
 
+  // If closedSurfaceGenerator is specified then its filters and intermediate results (convex hull, tetrahedralization)
+  // are reused and kept for the next update (see vtkSlicerMarkupsToModelClosedSurfaceGeneration::GenerateSurface).
   static bool UpdateClosedSurfaceModel( vtkPoints* controlPoints, vtkPolyData* polyData,
-    bool smoothing = true, bool forceConvex = false, double delaunayAlpha = 0.0, bool cleanMarkups = true );
+    bool smoothing = true, bool forceConvex = false, double delaunayAlpha = 0.0, bool cleanMarkups = true,
+    bool subdivision = true, vtkSlicerMarkupsToModelClosedSurfaceGeneration* closedSurfaceGenerator = NULL,
+    double duplicatePointTolerance = 0.01, double* stageTimes = NULL, const std::atomic< bool >* cancelled = NULL );
+
+  // Get the smallest Delaunay alpha value for which the closed surface generated from the input points
+  // is a single piece that contains all the points. Returns 0 if it cannot be computed.
+  double ComputeAutomaticDelaunayAlpha( vtkMRMLMarkupsToModelNode* moduleNode );
 
   // Lower-level access to functionality for making a curve model.
   // If tubeRadius<=0.0 then a line will be created instead of a tube.
@@ -84,6 +178,9 @@ public:
       int polynomialWeightType = vtkMRMLMarkupsToModelNode::Rectangular,
       bool tubeCap = true);
 
+  // If outputCurvePoints is specified then the sampled curve points that the tube is generated from are copied into it.
+  // Durations of the stages are added to stageTimes, if specified, and generation stops if cancelled becomes true
+  // (see GenerateOutputModel).
   static bool UpdateOutputCurveModel( vtkPoints* controlPoints, vtkPolyData* polyData,
       int curveType = vtkMRMLMarkupsToModelNode::Linear,
       bool tubeLoop = false, double tubeRadius = 1.0, int tubeNumberOfSides = 8, int tubeSegmentsBetweenControlPoints = 5,
@@ -93,7 +190,12 @@ public:
       vtkCurveGenerator* curveGenerator = NULL,
       int polynomialFitType = vtkMRMLMarkupsToModelNode::GlobalLeastSquares, double polynomialSampleWidth = 0.5,
       int polynomialWeightType = vtkMRMLMarkupsToModelNode::Rectangular,
-      bool tubeCap = true);
+      bool tubeCap = true,
+      int curveSamplingMode = vtkMRMLMarkupsToModelNode::UniformSampling,
+      double samplingAngleTolerance = 5.0, double samplingChordTolerance = 0.1,
+      int minimumSamplesPerSegment = 1, int maximumSamplesPerSegment = 20,
+      double duplicatePointTolerance = 0.01, vtkPoints* outputCurvePoints = NULL, double* stageTimes = NULL,
+      const std::atomic< bool >* cancelled = NULL);
 
   // Get the points store in a vtkMRMLMarkupsNode
   static void MarkupsToPoints( vtkMRMLMarkupsNode* markupsNode, vtkPoints* outputPoints );
@@ -101,8 +203,10 @@ public:
   // Get the points store in a vtkMRMLModelNode
   static void ModelToPoints( vtkMRMLModelNode* modelNode, vtkPoints* outputPoints );
 
-  // Remove duplicate points from a vtkPoints object
-  static void RemoveDuplicatePoints( vtkPoints* points );
+  // Remove duplicate points from a vtkPoints object, in place.
+  // A point is removed if it is not farther than tolerance (in mm) from a previous point; the order of the remaining points is kept.
+  // Returns the number of removed points.
+  static vtkIdType RemoveDuplicatePoints( vtkPoints* points, double tolerance = 0.01 );
 
   // DEPRECATED - Sets the input node to be processed
   void SetMarkupsNode( vtkMRMLMarkupsNode* newMarkups, vtkMRMLMarkupsToModelNode* moduleNode );
@@ -122,7 +226,102 @@ protected:
   virtual void OnMRMLSceneNodeRemoved(vtkMRMLNode* node) override;
 
 private:
-  vtkSmartPointer< vtkCurveGenerator > CurveGenerator;
+  // Update the output model of the parameter node now, or later if it was updated recently during interaction.
+  // If the input points were already extracted then they are passed in inputControlPoints, with the duration of
+  // the extraction in inputExtractionTime, so that they are not extracted again (they are only used if the update is not postponed).
+  void RequestOutputModelUpdate( vtkMRMLMarkupsToModelNode* moduleNode, int modifiedMarkupPointIndex = -1,
+    vtkPoints* inputControlPoints = NULL, double inputExtractionTime = 0.0 );
+
+  // Same as UpdateOutputModel, but the input points are taken from inputControlPoints if specified
+  // (see RequestOutputModelUpdate). The points may be modified.
+  void UpdateOutputModelFromPoints( vtkMRMLMarkupsToModelNode* moduleNode, int modifiedMarkupPointIndex,
+    vtkPoints* inputControlPoints, double inputExtractionTime );
+
+  // Get the input points of the parameter node. Returns false if the input or output node is missing or not supported.
+  // The duration is added to stageTimes, if specified.
+  bool GetInputControlPoints( vtkMRMLMarkupsToModelNode* moduleNode, vtkPoints* controlPoints, double* stageTimes = NULL );
+
+  // Remember the input points that the output of the parameter node is updated from.
+  void SetInputFingerprint( vtkMRMLMarkupsToModelNode* moduleNode, vtkPoints* controlPoints );
+  // Returns false if the input points of the parameter node (extracted by GetInputControlPoints)
+  // are the same as at the last update.
+  bool HasInputPointsChanged( vtkMRMLMarkupsToModelNode* moduleNode, vtkPoints* controlPoints );
+
+  // Get the key of the model generated from the points with the parameters of the node in the recent outputs and the mesh cache.
+  // Returns empty string if the model must not be cached.
+  std::string ComputeOutputModelKey( vtkMRMLMarkupsToModelNode* moduleNode, vtkPoints* controlPoints );
+
+  // Assign the model that was generated earlier from the same points and parameters to the output,
+  // from the recent outputs of the node or from the mesh cache. Returns false if the model is not found.
+  bool LoadOutputModelFromCache( vtkMRMLMarkupsToModelNode* moduleNode, const std::string& cacheKey );
+
+  // Keep the generated model in the recent outputs of the node and store it in the mesh cache (if enabled).
+  void StoreOutputModelInCache( vtkMRMLMarkupsToModelNode* moduleNode, const std::string& cacheKey,
+    vtkPolyData* outputPolyData, double outputCurveLength );
+
+  // Generate the output model of the parameter node from the control points on a worker thread.
+  // If an update of the node is already running then it is cancelled and the new update starts when it has finished.
+  // The result is stored in the recent outputs and the mesh cache with cacheKey, if specified.
+  void StartAsynchronousUpdate( vtkMRMLMarkupsToModelNode* moduleNode, vtkPoints* controlPoints, const std::string& cacheKey = "" );
+
+  // Cancel the running and queued background updates of the parameter node.
+  void CancelAsynchronousUpdate( vtkMRMLMarkupsToModelNode* moduleNode );
+
+  // Assign the results of finished background updates to the output models and start queued updates.
+  void ProcessAsynchronousUpdates();
+
+  void SetAsynchronousUpdateStatus( vtkMRMLMarkupsToModelNode* moduleNode, int status );
+
+  // Store the update state of the model that has just been generated for the parameter node
+  // (for later incremental updates) and assign the model to the output.
+  // parameterNode contains the parameters the model was generated with.
+  void FinishOutputModelUpdate( vtkMRMLMarkupsToModelNode* moduleNode, vtkMRMLMarkupsToModelNode* parameterNode,
+    vtkPoints* controlPoints, vtkPolyData* outputPolyData, bool success );
+
+  double MinimumInteractionUpdateInterval;
+  vtkTypeUInt64 NumberOfUpdateRequests;
+  vtkTypeUInt64 NumberOfMergedUpdateRequests;
+  vtkTypeUInt64 NumberOfSkippedUpdateRequests;
+  vtkTypeUInt64 NumberOfPerformedUpdates;
+  int MaximumNumberOfRecentOutputs;
+
+  class vtkInternal;
+  vtkInternal* Internal;
+
+  // Update the curve model of the parameter node after control points were appended at the end of the curve.
+  // Only the last segments of the curve (within the support of the spline) are re-evaluated
+  // and only the corresponding tube rings are regenerated.
+  // Returns false if the incremental update is not possible, in this case a full update is needed.
+  bool AppendToOutputCurveModel( vtkMRMLMarkupsToModelNode* moduleNode, vtkPoints* controlPoints );
+
+  // Update the curve model of the parameter node after a single control point was moved.
+  // Only the curve segments affected by the control point are re-evaluated
+  // and only the corresponding tube rings are regenerated.
+  // Returns false if the incremental update is not possible, in this case a full update is needed.
+  bool UpdateOutputCurveModelLocally( vtkMRMLMarkupsToModelNode* moduleNode, vtkPoints* controlPoints, int modifiedControlPointIndex );
+
+  // Update the closed surface model of the parameter node after a single control point was added or moved.
+  // If the surface is generated from the convex hull of the points then the hull is updated incrementally,
+  // and the model is only regenerated if the hull changed (points added or moved inside the hull are ignored).
+  // Returns false if the incremental update is not possible, in this case a full update is needed.
+  bool UpdateClosedSurfaceModelIncrementally( vtkMRMLMarkupsToModelNode* moduleNode, vtkPoints* controlPoints );
+
+  // Update the model of the parameter node from the results of the earlier pipeline stages of the last update
+  // (sampled curve points or triangulated surface), if only parameters of the model stage changed since then
+  // (see vtkMRMLMarkupsToModelNode::PipelineStage).
+  // Returns false if the input points or parameters of earlier stages changed, in this case a full update is needed.
+  bool UpdateOutputModelStage( vtkMRMLMarkupsToModelNode* moduleNode, vtkPoints* controlPoints );
+
+  // Store the curve that has just been generated for the parameter node, for use in later incremental updates.
+  void StoreCurveUpdateState( vtkMRMLMarkupsToModelNode* moduleNode, vtkPoints* controlPoints, vtkPoints* curvePoints,
+    vtkPolyData* outputPolyData, double outputCurveLength, vtkMRMLMarkupsToModelNode* parameterNode = NULL );
+
+  // Set curve type and fitting parameters in the curve generator.
+  // Returns false if the curve type is not recognized.
+  static bool SetCurveGeneratorParameters( vtkCurveGenerator* curveGenerator, int curveType,
+    int polynomialOrder, int pointParameterType,
+    bool kochanekEndsCopyNearestDerivatives, double kochanekBias, double kochanekContinuity, double kochanekTension,
+    int polynomialFitType, double polynomialSampleWidth, int polynomialWeightType );
 
   // Generate a sphere at the point specified. Special case to be called when only one point is input.
   //   point - center of the sphere
@@ -133,17 +332,25 @@ private:
 
   // Generate a tube that passes through the points specified.
   //   points - the points that the tube passes through
-  //   outputTubePolyData - the tube mesh will be stored in this poly data.
+  //   outputTubePolyData - the tube mesh will be stored in this poly data (see vtkSlicerMarkupsToModelTubeGeneration for the layout).
   //   tubeRadius - the radius of the tube in outputTubePolyData.
   //   tubeNumberOfSides - The resolution for tube tesselation (higher = smoother).
   static void GenerateTubeModel( vtkPoints* points, vtkPolyData* outputTubePolyData, double tubeRadius, int tubeNumberOfSides, bool tubeCapping=true );
 
+  // Select a subset of densely sampled curve points so that the curve direction changes by at most angleToleranceDeg
+  // and the curve deviates by at most chordToleranceMm from the line between consecutive selected points.
+  //   densePoints - curve points, densePointsPerSegment points in each segment between control points
+  //   minimumPointsPerSegment - each segment is divided into at least this many parts
+  //   outputPoints - the selected points, including the first and last points and the control point positions
+  static void SelectAdaptiveCurvePoints( vtkPoints* densePoints, int densePointsPerSegment,
+    double angleToleranceDeg, double chordToleranceMm, int minimumPointsPerSegment, vtkPoints* outputPoints );
+
   // If looped, the first and last segment of the curve must be exactly parallel.
   // Otherwise the curve will have two caps that don't line up and the curve will
   // not appear continuous.
   static void MakeLoopContinuous( vtkPoints* curvePoints );
 
-  static void AssignPolyDataToOutput( vtkMRMLMarkupsToModelNode* moduleNode, vtkPolyData* polyData );
+  void AssignPolyDataToOutput( vtkMRMLMarkupsToModelNode* moduleNode, vtkPolyData* polyData );
 
   vtkSlicerMarkupsToModelLogic(const vtkSlicerMarkupsToModelLogic&); // Not implemented
   void operator=(const vtkSlicerMarkupsToModelLogic&); // Not implemented
@@ -0,0 +1,817 @@
+#include "vtkSlicerMarkupsToModelMeshCache.h"
+
+// MRML includes
+#include "vtkMRMLMarkupsToModelNode.h"
+
+// VTK includes
+#include <vtkCellArray.h>
+#include <vtkCellData.h>
+#include <vtkDataArray.h>
+#include <vtkObjectFactory.h>
+#include <vtkPointData.h>
+#include <vtkSmartPointer.h>
+#include <vtksys/Directory.hxx>
+#include <vtksys/SystemTools.hxx>
+
+// STD includes
+#include <algorithm>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <fstream>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+//------------------------------------------------------------------------------
+// constants within this file
+static const char* CACHE_FILE_EXTENSION = ".mtmmesh";
+static const char CACHE_FILE_MAGIC[ 4 ] = { 'M', 'T', 'M', 'C' };
+// Increase if the file format or the generated models change, so that outdated models are not used
+static const vtkTypeUInt32 CACHE_FILE_VERSION = 2;
+static const vtkTypeUInt64 DEFAULT_MAXIMUM_CACHE_SIZE_BYTES = 512 * 1024 * 1024;
+
+//------------------------------------------------------------------------------
+// 64-bit FNV-1a hash
+class vtkMeshCacheKeyHash
+{
+public:
+  vtkMeshCacheKeyHash()
+  : Value( 14695981039346656037ULL )
+  {
+  }
+
+  void Add( const void* data, size_t size )
+  {
+    const unsigned char* bytes = static_cast< const unsigned char* >( data );
+    for ( size_t byteIndex = 0; byteIndex < size; byteIndex++ )
+    {
+      this->Value ^= bytes[ byteIndex ];
+      this->Value *= 1099511628211ULL;
+    }
+  }
+
+  void AddInt( vtkTypeInt64 value ) { this->Add( &value, sizeof( value ) ); }
+  void AddDouble( double value ) { this->Add( &value, sizeof( value ) ); }
+
+  vtkTypeUInt64 Value;
+};
+
+//------------------------------------------------------------------------------
+template< class T > static void WriteValue( std::ostream& stream, T value )
+{
+  stream.write( reinterpret_cast< const char* >( &value ), sizeof( T ) );
+}
+
+//------------------------------------------------------------------------------
+template< class T > static bool ReadValue( std::istream& stream, T& value )
+{
+  stream.read( reinterpret_cast< char* >( &value ), sizeof( T ) );
+  return !stream.fail();
+}
+
+//------------------------------------------------------------------------------
+// Write type, size, name, and the contents of the array as they are in memory.
+// attributeType is the attribute that the array is assigned to (vtkDataSetAttributes::AttributeTypes), -1 if none.
+static void WriteArray( std::ostream& stream, vtkDataArray* array, int attributeType )
+{
+  const char* name = array->GetName();
+  vtkTypeUInt32 nameLength = ( name != NULL ) ? static_cast< vtkTypeUInt32 >( strlen( name ) ) : 0;
+  WriteValue< vtkTypeInt32 >( stream, array->GetDataType() );
+  WriteValue< vtkTypeInt32 >( stream, array->GetNumberOfComponents() );
+  WriteValue< vtkTypeInt64 >( stream, array->GetNumberOfTuples() );
+  WriteValue< vtkTypeInt32 >( stream, attributeType );
+  WriteValue< vtkTypeUInt32 >( stream, nameLength );
+  stream.write( name, nameLength );
+  vtkTypeInt64 numberOfBytes = array->GetNumberOfTuples() * array->GetNumberOfComponents() * array->GetDataTypeSize();
+  if ( numberOfBytes > 0 )
+  {
+    stream.write( static_cast< const char* >( array->GetVoidPointer( 0 ) ), numberOfBytes );
+  }
+}
+
+//------------------------------------------------------------------------------
+// Number of bytes between the current read position and the end of a stream of streamSize bytes
+static vtkTypeInt64 GetRemainingBytes( std::istream& stream, vtkTypeInt64 streamSize )
+{
+  std::streamoff position = stream.tellg();
+  if ( position < 0 || position > streamSize )
+  {
+    return 0;
+  }
+  return streamSize - position;
+}
+
+//------------------------------------------------------------------------------
+// Read an array written by WriteArray from a stream of streamSize bytes.
+// Returns NULL if the array cannot be read, or if the stored size exceeds the rest of the stream (e.g., corrupt file),
+// so that no memory is allocated for arrays that cannot be read.
+static vtkSmartPointer< vtkDataArray > ReadArray( std::istream& stream, vtkTypeInt64 streamSize, int& attributeType )
+{
+  vtkTypeInt32 dataType = 0;
+  vtkTypeInt32 numberOfComponents = 0;
+  vtkTypeInt64 numberOfTuples = 0;
+  vtkTypeInt32 storedAttributeType = -1;
+  vtkTypeUInt32 nameLength = 0;
+  if ( !ReadValue( stream, dataType ) || !ReadValue( stream, numberOfComponents ) || !ReadValue( stream, numberOfTuples )
+    || !ReadValue( stream, storedAttributeType ) || !ReadValue( stream, nameLength )
+    || numberOfComponents < 1 || numberOfTuples < 0 || nameLength > GetRemainingBytes( stream, streamSize ) )
+  {
+    return NULL;
+  }
+  std::string name( nameLength, '\0' );
+  if ( nameLength > 0 && !stream.read( &name[ 0 ], nameLength ) )
+  {
+    return NULL;
+  }
+  vtkSmartPointer< vtkDataArray > array = vtkSmartPointer< vtkDataArray >::Take( vtkDataArray::CreateDataArray( dataType ) );
+  if ( array == NULL )
+  {
+    return NULL;
+  }
+  vtkTypeInt64 dataTypeSize = array->GetDataTypeSize();
+  if ( dataTypeSize <= 0
+    || numberOfTuples > GetRemainingBytes( stream, streamSize ) / ( static_cast< vtkTypeInt64 >( numberOfComponents ) * dataTypeSize ) )
+  {
+    return NULL;
+  }
+  array->SetNumberOfComponents( numberOfComponents );
+  array->SetNumberOfTuples( numberOfTuples );
+  if ( !name.empty() )
+  {
+    array->SetName( name.c_str() );
+  }
+  vtkTypeInt64 numberOfBytes = numberOfTuples * numberOfComponents * dataTypeSize;
+  if ( numberOfBytes > 0 && !stream.read( static_cast< char* >( array->GetVoidPointer( 0 ) ), numberOfBytes ) )
+  {
+    return NULL;
+  }
+  attributeType = storedAttributeType;
+  return array;
+}
+
+//------------------------------------------------------------------------------
+static void WriteAttributes( std::ostream& stream, vtkDataSetAttributes* attributes )
+{
+  std::vector< int > arrayIndices;
+  for ( int arrayIndex = 0; arrayIndex < attributes->GetNumberOfArrays(); arrayIndex++ )
+  {
+    // only numeric arrays are stored
+    if ( attributes->GetArray( arrayIndex ) != NULL )
+    {
+      arrayIndices.push_back( arrayIndex );
+    }
+  }
+  WriteValue< vtkTypeUInt32 >( stream, static_cast< vtkTypeUInt32 >( arrayIndices.size() ) );
+  for ( std::vector< int >::iterator arrayIndexIt = arrayIndices.begin(); arrayIndexIt != arrayIndices.end(); ++arrayIndexIt )
+  {
+    WriteArray( stream, attributes->GetArray( *arrayIndexIt ), attributes->IsArrayAnAttribute( *arrayIndexIt ) );
+  }
+}
+
+//------------------------------------------------------------------------------
+static bool ReadAttributes( std::istream& stream, vtkTypeInt64 streamSize, vtkDataSetAttributes* attributes )
+{
+  vtkTypeUInt32 numberOfArrays = 0;
+  if ( !ReadValue( stream, numberOfArrays ) )
+  {
+    return false;
+  }
+  for ( vtkTypeUInt32 arrayIndex = 0; arrayIndex < numberOfArrays; arrayIndex++ )
+  {
+    int attributeType = -1;
+    vtkSmartPointer< vtkDataArray > array = ReadArray( stream, streamSize, attributeType );
+    if ( array == NULL )
+    {
+      return false;
+    }
+    int addedArrayIndex = attributes->AddArray( array );
+    if ( attributeType >= 0 && attributeType < vtkDataSetAttributes::NUM_ATTRIBUTES )
+    {
+      attributes->SetActiveAttribute( addedArrayIndex, attributeType );
+    }
+  }
+  return true;
+}
+
+//------------------------------------------------------------------------------
+static void WriteCells( std::ostream& stream, vtkCellArray* cells )
+{
+  WriteArray( stream, cells->GetOffsetsArray(), -1 );
+  WriteArray( stream, cells->GetConnectivityArray(), -1 );
+}
+
+//------------------------------------------------------------------------------
+// Read cells written by WriteCells. Returns NULL if the cells are not valid for a model of numberOfPoints points
+// (offsets must start at 0, must not decrease, and must end at the connectivity size; point ids must be in range),
+// so that a corrupt file cannot make later filters read out of bounds.
+static vtkSmartPointer< vtkCellArray > ReadCells( std::istream& stream, vtkTypeInt64 streamSize, vtkIdType numberOfPoints )
+{
+  int attributeType = -1;
+  vtkSmartPointer< vtkDataArray > offsets = ReadArray( stream, streamSize, attributeType );
+  vtkSmartPointer< vtkDataArray > connectivity = ReadArray( stream, streamSize, attributeType );
+  if ( offsets == NULL || connectivity == NULL
+    || offsets->GetNumberOfComponents() != 1 || connectivity->GetNumberOfComponents() != 1 )
+  {
+    return NULL;
+  }
+  vtkIdType numberOfOffsets = offsets->GetNumberOfTuples();
+  vtkIdType connectivitySize = connectivity->GetNumberOfTuples();
+  if ( numberOfOffsets == 0 ? connectivitySize != 0
+    : ( offsets->GetComponent( 0, 0 ) != 0 || offsets->GetComponent( numberOfOffsets - 1, 0 ) != connectivitySize ) )
+  {
+    return NULL;
+  }
+  for ( vtkIdType offsetIndex = 1; offsetIndex < numberOfOffsets; offsetIndex++ )
+  {
+    if ( offsets->GetComponent( offsetIndex, 0 ) < offsets->GetComponent( offsetIndex - 1, 0 ) )
+    {
+      return NULL;
+    }
+  }
+  for ( vtkIdType connectivityIndex = 0; connectivityIndex < connectivitySize; connectivityIndex++ )
+  {
+    double pointId = connectivity->GetComponent( connectivityIndex, 0 );
+    if ( pointId < 0 || pointId >= numberOfPoints )
+    {
+      return NULL;
+    }
+  }
+  vtkSmartPointer< vtkCellArray > cells = vtkSmartPointer< vtkCellArray >::New();
+  if ( !cells->SetData( offsets, connectivity ) )
+  {
+    return NULL;
+  }
+  return cells;
+}
+
+//------------------------------------------------------------------------------
+// Write the model into a cache file. The file is written under a temporary name and renamed when complete,
+// so that incomplete files are never read. The key is stored as well, so that a file is only used for its own key.
+static bool WriteCacheFile( const std::string& filePath, const std::string& key, vtkPolyData* polyData, double outputCurveLength )
+{
+  std::string temporaryFilePath = filePath + ".tmp";
+  std::ofstream stream( temporaryFilePath.c_str(), std::ios::out | std::ios::binary | std::ios::trunc );
+  if ( !stream )
+  {
+    return false;
+  }
+  stream.write( CACHE_FILE_MAGIC, sizeof( CACHE_FILE_MAGIC ) );
+  WriteValue< vtkTypeUInt32 >( stream, CACHE_FILE_VERSION );
+  WriteValue< vtkTypeUInt32 >( stream, static_cast< vtkTypeUInt32 >( key.size() ) );
+  stream.write( key.c_str(), key.size() );
+  WriteValue< double >( stream, outputCurveLength );
+  WriteArray( stream, polyData->GetPoints()->GetData(), -1 );
+  WriteCells( stream, polyData->GetVerts() );
+  WriteCells( stream, polyData->GetLines() );
+  WriteCells( stream, polyData->GetPolys() );
+  WriteCells( stream, polyData->GetStrips() );
+  WriteAttributes( stream, polyData->GetPointData() );
+  WriteAttributes( stream, polyData->GetCellData() );
+  stream.close();
+  if ( stream.fail() || !vtksys::SystemTools::RenameFile( temporaryFilePath, filePath ) )
+  {
+    vtksys::SystemTools::RemoveFile( temporaryFilePath );
+    return false;
+  }
+  return true;
+}
+
+//------------------------------------------------------------------------------
+class vtkSlicerMarkupsToModelMeshCache::vtkInternal
+{
+public:
+  struct Entry
+  {
+    vtkTypeUInt64 Size;
+    vtkTypeUInt64 LastAccess; // higher value means more recent use
+  };
+
+  // Model that is stored but its file is not written yet
+  struct PendingWrite
+  {
+    vtkSmartPointer< vtkPolyData > PolyData;
+    double OutputCurveLength;
+  };
+
+  vtkInternal()
+  : CacheSize( 0 )
+  , AccessCounter( 0 )
+  , MaximumCacheSize( DEFAULT_MAXIMUM_CACHE_SIZE_BYTES )
+  , Writing( false )
+  , StopWriter( false )
+  {
+  }
+
+  ~vtkInternal()
+  {
+    // files that are still queued are written before the thread exits
+    {
+      std::lock_guard< std::mutex > lock( this->Mutex );
+      this->StopWriter = true;
+    }
+    this->WriteQueued.notify_all();
+    if ( this->WriterThread.joinable() )
+    {
+      this->WriterThread.join();
+    }
+  }
+
+  std::string GetFilePath( const std::string& key ) const
+  {
+    return this->Directory + "/" + key + CACHE_FILE_EXTENSION;
+  }
+
+  // Find the cache files in the directory. Order of use is taken from the file modification times.
+  void ScanDirectory();
+
+  // Mark the entry as the most recently used.
+  void Touch( const std::string& key );
+
+  void AddEntry( const std::string& key, vtkTypeUInt64 size );
+  void RemoveEntry( const std::string& key );
+
+  // Remove least recently used files until the total size is within the limit.
+  void RemoveLeastRecentlyUsed( vtkTypeUInt64 maximumCacheSize );
+
+  // Queue writing the model into the cache file of the key on the writer thread (the model must not be modified later).
+  void QueueWrite( const std::string& key, vtkPolyData* polyData, double outputCurveLength );
+
+  // Wait until all queued files are written.
+  void WaitForWrites();
+
+  // Main function of the writer thread
+  void WriteQueuedFiles();
+
+  // Entries, cache size, and pending writes are accessed by the main thread and the writer thread
+  std::mutex Mutex;
+
+  std::string Directory; // only modified when no files are written
+  std::map< std::string, Entry > Entries;
+  vtkTypeUInt64 CacheSize;
+  vtkTypeUInt64 AccessCounter;
+  vtkTypeUInt64 MaximumCacheSize;
+
+  std::map< std::string, PendingWrite > PendingWrites;
+  std::deque< std::string > WriteQueue;
+  bool Writing; // the writer thread is writing a file that is already removed from the queue
+  bool StopWriter;
+  std::condition_variable WriteQueued;
+  std::condition_variable WritesFinished;
+  std::thread WriterThread;
+};
+
+//------------------------------------------------------------------------------
+void vtkSlicerMarkupsToModelMeshCache::vtkInternal::QueueWrite( const std::string& key, vtkPolyData* polyData, double outputCurveLength )
+{
+  {
+    std::lock_guard< std::mutex > lock( this->Mutex );
+    PendingWrite& pendingWrite = this->PendingWrites[ key ];
+    if ( pendingWrite.PolyData == NULL )
+    {
+      this->WriteQueue.push_back( key );
+    }
+    // if the key is already queued then only the latest model is written
+    pendingWrite.PolyData = polyData;
+    pendingWrite.OutputCurveLength = outputCurveLength;
+    if ( !this->WriterThread.joinable() )
+    {
+      this->WriterThread = std::thread( &vtkInternal::WriteQueuedFiles, this );
+    }
+  }
+  this->WriteQueued.notify_one();
+}
+
+//------------------------------------------------------------------------------
+void vtkSlicerMarkupsToModelMeshCache::vtkInternal::WaitForWrites()
+{
+  std::unique_lock< std::mutex > lock( this->Mutex );
+  while ( !this->WriteQueue.empty() || this->Writing )
+  {
+    this->WritesFinished.wait( lock );
+  }
+}
+
+//------------------------------------------------------------------------------
+void vtkSlicerMarkupsToModelMeshCache::vtkInternal::WriteQueuedFiles()
+{
+  std::unique_lock< std::mutex > lock( this->Mutex );
+  while ( true )
+  {
+    while ( !this->StopWriter && this->WriteQueue.empty() )
+    {
+      this->WriteQueued.wait( lock );
+    }
+    if ( this->WriteQueue.empty() )
+    {
+      return;
+    }
+    std::string key = this->WriteQueue.front();
+    this->WriteQueue.pop_front();
+    PendingWrite pendingWrite = this->PendingWrites[ key ];
+    std::string filePath = this->GetFilePath( key );
+    this->Writing = true;
+
+    lock.unlock();
+    bool written = WriteCacheFile( filePath, key, pendingWrite.PolyData, pendingWrite.OutputCurveLength );
+    if ( !written )
+    {
+      // not an error of the update that stored the model, so it is only reported
+      vtkGenericWarningMacro( "vtkSlicerMarkupsToModelMeshCache: Failed to write mesh cache file " << filePath );
+    }
+    vtkTypeUInt64 fileSize = written ? vtksys::SystemTools::FileLength( filePath ) : 0;
+    lock.lock();
+
+    std::map< std::string, PendingWrite >::iterator pendingWriteIt = this->PendingWrites.find( key );
+    if ( pendingWriteIt->second.PolyData == pendingWrite.PolyData )
+    {
+      this->PendingWrites.erase( pendingWriteIt );
+    }
+    else
+    {
+      // stored again while the file was written
+      this->WriteQueue.push_back( key );
+    }
+    if ( written )
+    {
+      this->AddEntry( key, fileSize );
+      this->RemoveLeastRecentlyUsed( this->MaximumCacheSize );
+    }
+    this->Writing = false;
+    this->WritesFinished.notify_all();
+  }
+}
+
+//------------------------------------------------------------------------------
+void vtkSlicerMarkupsToModelMeshCache::vtkInternal::ScanDirectory()
+{
+  this->Entries.clear();
+  this->CacheSize = 0;
+  this->AccessCounter = 0;
+  vtksys::Directory directory;
+  if ( !directory.Load( this->Directory ) )
+  {
+    return;
+  }
+  std::string extension = CACHE_FILE_EXTENSION;
+  std::vector< std::pair< long, std::string > > filesByModifiedTime;
+  for ( unsigned long fileIndex = 0; fileIndex < directory.GetNumberOfFiles(); fileIndex++ )
+  {
+    std::string fileName = directory.GetFile( fileIndex );
+    if ( fileName.size() <= extension.size() || fileName.compare( fileName.size() - extension.size(), extension.size(), extension ) != 0 )
+    {
+      continue;
+    }
+    std::string key = fileName.substr( 0, fileName.size() - extension.size() );
+    filesByModifiedTime.push_back( std::make_pair( vtksys::SystemTools::ModifiedTime( this->GetFilePath( key ) ), key ) );
+  }
+  std::sort( filesByModifiedTime.begin(), filesByModifiedTime.end() );
+  for ( std::vector< std::pair< long, std::string > >::iterator fileIt = filesByModifiedTime.begin(); fileIt != filesByModifiedTime.end(); ++fileIt )
+  {
+    this->AddEntry( fileIt->second, vtksys::SystemTools::FileLength( this->GetFilePath( fileIt->second ) ) );
+  }
+}
+
+//------------------------------------------------------------------------------
+void vtkSlicerMarkupsToModelMeshCache::vtkInternal::Touch( const std::string& key )
+{
+  std::map< std::string, Entry >::iterator entryIt = this->Entries.find( key );
+  if ( entryIt == this->Entries.end() )
+  {
+    return;
+  }
+  entryIt->second.LastAccess = ++this->AccessCounter;
+  // the order is restored from modification times in the next session
+  vtksys::SystemTools::Touch( this->GetFilePath( key ), false );
+}
+
+//------------------------------------------------------------------------------
+void vtkSlicerMarkupsToModelMeshCache::vtkInternal::AddEntry( const std::string& key, vtkTypeUInt64 size )
+{
+  this->RemoveEntry( key );
+  Entry entry;
+  entry.Size = size;
+  entry.LastAccess = ++this->AccessCounter;
+  this->Entries[ key ] = entry;
+  this->CacheSize += size;
+}
+
+//------------------------------------------------------------------------------
+void vtkSlicerMarkupsToModelMeshCache::vtkInternal::RemoveEntry( const std::string& key )
+{
+  std::map< std::string, Entry >::iterator entryIt = this->Entries.find( key );
+  if ( entryIt == this->Entries.end() )
+  {
+    return;
+  }
+  this->CacheSize -= entryIt->second.Size;
+  this->Entries.erase( entryIt );
+}
+
+//------------------------------------------------------------------------------
+void vtkSlicerMarkupsToModelMeshCache::vtkInternal::RemoveLeastRecentlyUsed( vtkTypeUInt64 maximumCacheSize )
+{
+  while ( this->CacheSize > maximumCacheSize && !this->Entries.empty() )
+  {
+    std::map< std::string, Entry >::iterator leastRecentlyUsedIt = this->Entries.begin();
+    for ( std::map< std::string, Entry >::iterator entryIt = this->Entries.begin(); entryIt != this->Entries.end(); ++entryIt )
+    {
+      if ( entryIt->second.LastAccess < leastRecentlyUsedIt->second.LastAccess )
+      {
+        leastRecentlyUsedIt = entryIt;
+      }
+    }
+    std::string key = leastRecentlyUsedIt->first;
+    vtksys::SystemTools::RemoveFile( this->GetFilePath( key ) );
+    this->RemoveEntry( key );
+  }
+}
+
+//------------------------------------------------------------------------------
+vtkStandardNewMacro( vtkSlicerMarkupsToModelMeshCache );
+
+//------------------------------------------------------------------------------
+vtkSlicerMarkupsToModelMeshCache::vtkSlicerMarkupsToModelMeshCache()
+{
+  this->MaximumCacheSize = DEFAULT_MAXIMUM_CACHE_SIZE_BYTES;
+  this->NumberOfHits = 0;
+  this->NumberOfMisses = 0;
+  this->Internal = new vtkInternal;
+}
+
+//------------------------------------------------------------------------------
+vtkSlicerMarkupsToModelMeshCache::~vtkSlicerMarkupsToModelMeshCache()
+{
+  delete this->Internal;
+}
+
+//------------------------------------------------------------------------------
+void vtkSlicerMarkupsToModelMeshCache::SetCacheDirectory( const char* directory )
+{
+  std::string newDirectory = ( directory != NULL ) ? directory : "";
+  if ( newDirectory == this->Internal->Directory )
+  {
+    return;
+  }
+  // queued files are written into the previous directory
+  this->Internal->WaitForWrites();
+  if ( !newDirectory.empty() && !vtksys::SystemTools::MakeDirectory( newDirectory ) )
+  {
+    vtkErrorMacro( "SetCacheDirectory: Failed to create cache directory " << newDirectory << ". Mesh cache is disabled." );
+    newDirectory.clear();
+  }
+  {
+    std::lock_guard< std::mutex > lock( this->Internal->Mutex );
+    this->Internal->Directory = newDirectory;
+    this->Internal->ScanDirectory();
+    this->Internal->RemoveLeastRecentlyUsed( this->MaximumCacheSize );
+  }
+  this->Modified();
+}
+
+//------------------------------------------------------------------------------
+const char* vtkSlicerMarkupsToModelMeshCache::GetCacheDirectory()
+{
+  return this->Internal->Directory.c_str();
+}
+
+//------------------------------------------------------------------------------
+bool vtkSlicerMarkupsToModelMeshCache::IsEnabled()
+{
+  return !this->Internal->Directory.empty();
+}
+
+//------------------------------------------------------------------------------
+void vtkSlicerMarkupsToModelMeshCache::SetMaximumCacheSize( vtkTypeUInt64 maximumCacheSize )
+{
+  if ( this->MaximumCacheSize == maximumCacheSize )
+  {
+    return;
+  }
+  this->MaximumCacheSize = maximumCacheSize;
+  {
+    std::lock_guard< std::mutex > lock( this->Internal->Mutex );
+    this->Internal->MaximumCacheSize = maximumCacheSize;
+    this->Internal->RemoveLeastRecentlyUsed( this->MaximumCacheSize );
+  }
+  this->Modified();
+}
+
+//------------------------------------------------------------------------------
+vtkTypeUInt64 vtkSlicerMarkupsToModelMeshCache::GetCacheSize()
+{
+  std::lock_guard< std::mutex > lock( this->Internal->Mutex );
+  return this->Internal->CacheSize;
+}
+
+//------------------------------------------------------------------------------
+int vtkSlicerMarkupsToModelMeshCache::GetNumberOfEntries()
+{
+  std::lock_guard< std::mutex > lock( this->Internal->Mutex );
+  return static_cast< int >( this->Internal->Entries.size() );
+}
+
+//------------------------------------------------------------------------------
+std::string vtkSlicerMarkupsToModelMeshCache::ComputeKey( vtkMRMLMarkupsToModelNode* parameterNode, vtkPoints* controlPoints )
+{
+  vtkMeshCacheKeyHash hash;
+  hash.AddInt( CACHE_FILE_VERSION );
+
+  vtkIdType numberOfPoints = ( controlPoints != NULL ) ? controlPoints->GetNumberOfPoints() : 0;
+  hash.AddInt( numberOfPoints );
+  for ( vtkIdType pointIndex = 0; pointIndex < numberOfPoints; pointIndex++ )
+  {
+    double point[ 3 ] = { 0.0, 0.0, 0.0 };
+    controlPoints->GetPoint( pointIndex, point );
+    hash.Add( point, sizeof( point ) );
+  }
+
+  int modelType = parameterNode->GetModelType();
+  hash.AddInt( modelType );
+  hash.AddInt( parameterNode->GetCleanMarkups() );
+  hash.AddDouble( parameterNode->GetDuplicatePointTolerance() );
+  if ( modelType == vtkMRMLMarkupsToModelNode::ClosedSurface )
+  {
+    hash.AddInt( parameterNode->GetButterflySubdivision() );
+    hash.AddDouble( parameterNode->GetDelaunayAlpha() );
+    hash.AddInt( parameterNode->GetConvexHull() );
+  }
+  else
+  {
+    hash.AddInt( parameterNode->GetCurveType() );
+    hash.AddInt( parameterNode->GetTubeLoop() );
+    hash.AddDouble( parameterNode->GetTubeRadius() );
+    hash.AddInt( parameterNode->GetTubeNumberOfSides() );
+    hash.AddInt( parameterNode->GetTubeSegmentsBetweenControlPoints() );
+    hash.AddInt( parameterNode->GetTubeCapping() );
+    hash.AddInt( parameterNode->GetPolynomialOrder() );
+    hash.AddInt( parameterNode->GetPointParameterType() );
+    hash.AddInt( parameterNode->GetPolynomialFitType() );
+    hash.AddDouble( parameterNode->GetPolynomialSampleWidth() );
+    hash.AddInt( parameterNode->GetPolynomialWeightType() );
+    hash.AddInt( parameterNode->GetKochanekEndsCopyNearestDerivatives() );
+    hash.AddDouble( parameterNode->GetKochanekBias() );
+    hash.AddDouble( parameterNode->GetKochanekContinuity() );
+    hash.AddDouble( parameterNode->GetKochanekTension() );
+    hash.AddInt( parameterNode->GetCurveSamplingMode() );
+    hash.AddDouble( parameterNode->GetSamplingAngleTolerance() );
+    hash.AddDouble( parameterNode->GetSamplingChordTolerance() );
+    hash.AddInt( parameterNode->GetMinimumSamplesPerSegment() );
+    hash.AddInt( parameterNode->GetMaximumSamplesPerSegment() );
+  }
+
+  static const char hexDigits[] = "0123456789abcdef";
+  std::string key( 16, '0' );
+  for ( int digitIndex = 15; digitIndex >= 0; digitIndex-- )
+  {
+    key[ digitIndex ] = hexDigits[ hash.Value & 0xf ];
+    hash.Value >>= 4;
+  }
+  return key;
+}
+
+//------------------------------------------------------------------------------
+bool vtkSlicerMarkupsToModelMeshCache::Load( const std::string& key, vtkPolyData* outputPolyData, double& outputCurveLength )
+{
+  if ( !this->IsEnabled() || outputPolyData == NULL )
+  {
+    this->NumberOfMisses++;
+    return false;
+  }
+  {
+    std::lock_guard< std::mutex > lock( this->Internal->Mutex );
+    std::map< std::string, vtkInternal::PendingWrite >::iterator pendingWriteIt = this->Internal->PendingWrites.find( key );
+    if ( pendingWriteIt != this->Internal->PendingWrites.end() )
+    {
+      // the file is not written yet, the model is copied as the writer thread may still read it
+      outputPolyData->DeepCopy( pendingWriteIt->second.PolyData );
+      outputCurveLength = pendingWriteIt->second.OutputCurveLength;
+      this->NumberOfHits++;
+      return true;
+    }
+    if ( this->Internal->Entries.find( key ) == this->Internal->Entries.end() )
+    {
+      this->NumberOfMisses++;
+      return false;
+    }
+  }
+
+  std::string filePath = this->Internal->GetFilePath( key );
+  vtkTypeInt64 fileSize = static_cast< vtkTypeInt64 >( vtksys::SystemTools::FileLength( filePath ) );
+  std::ifstream stream( filePath.c_str(), std::ios::in | std::ios::binary );
+  char magic[ 4 ] = { 0, 0, 0, 0 };
+  vtkTypeUInt32 version = 0;
+  vtkTypeUInt32 keyLength = 0;
+  std::string storedKey;
+  double curveLength = 0.0;
+  bool valid = stream.read( magic, sizeof( magic ) ) && std::equal( magic, magic + 4, CACHE_FILE_MAGIC )
+    && ReadValue( stream, version ) && version == CACHE_FILE_VERSION
+    && ReadValue( stream, keyLength ) && keyLength == key.size();
+  if ( valid )
+  {
+    storedKey.resize( keyLength );
+    valid = ( keyLength == 0 || stream.read( &storedKey[ 0 ], keyLength ) ) && storedKey == key
+      && ReadValue( stream, curveLength );
+  }
+
+  vtkSmartPointer< vtkPolyData > polyData = vtkSmartPointer< vtkPolyData >::New();
+  int attributeType = -1;
+  vtkSmartPointer< vtkDataArray > pointArray = valid ? ReadArray( stream, fileSize, attributeType ) : NULL;
+  valid = pointArray != NULL && pointArray->GetNumberOfComponents() == 3;
+  if ( valid )
+  {
+    vtkIdType numberOfPoints = pointArray->GetNumberOfTuples();
+    vtkSmartPointer< vtkCellArray > verts = ReadCells( stream, fileSize, numberOfPoints );
+    vtkSmartPointer< vtkCellArray > lines = ReadCells( stream, fileSize, numberOfPoints );
+    vtkSmartPointer< vtkCellArray > polys = ReadCells( stream, fileSize, numberOfPoints );
+    vtkSmartPointer< vtkCellArray > strips = ReadCells( stream, fileSize, numberOfPoints );
+    valid = verts != NULL && lines != NULL && polys != NULL && strips != NULL
+      && ReadAttributes( stream, fileSize, polyData->GetPointData() )
+      && ReadAttributes( stream, fileSize, polyData->GetCellData() );
+    if ( valid )
+    {
+      vtkSmartPointer< vtkPoints > points = vtkSmartPointer< vtkPoints >::New();
+      points->SetData( pointArray );
+      polyData->SetPoints( points );
+      polyData->SetVerts( verts );
+      polyData->SetLines( lines );
+      polyData->SetPolys( polys );
+      polyData->SetStrips( strips );
+    }
+  }
+  stream.close();
+
+  if ( !valid )
+  {
+    vtkWarningMacro( "Load: Failed to read mesh cache file " << filePath << ". The file is removed." );
+    vtksys::SystemTools::RemoveFile( filePath );
+    {
+      std::lock_guard< std::mutex > lock( this->Internal->Mutex );
+      this->Internal->RemoveEntry( key );
+    }
+    this->NumberOfMisses++;
+    return false;
+  }
+
+  outputPolyData->ShallowCopy( polyData );
+  outputCurveLength = curveLength;
+  {
+    std::lock_guard< std::mutex > lock( this->Internal->Mutex );
+    this->Internal->Touch( key );
+  }
+  this->NumberOfHits++;
+  return true;
+}
+
+//------------------------------------------------------------------------------
+bool vtkSlicerMarkupsToModelMeshCache::Store( const std::string& key, vtkPolyData* polyData, double outputCurveLength )
+{
+  if ( !this->IsEnabled() || polyData == NULL || polyData->GetPoints() == NULL )
+  {
+    return false;
+  }
+
+  // Writing the file takes longer than copying the model, so it is written on a background thread
+  // and the update that generated the model is not delayed by it. The model is copied, as the output
+  // may be modified in place by later updates.
+  vtkSmartPointer< vtkPolyData > polyDataCopy = vtkSmartPointer< vtkPolyData >::New();
+  polyDataCopy->DeepCopy( polyData );
+  this->Internal->QueueWrite( key, polyDataCopy, outputCurveLength );
+  return true;
+}
+
+//------------------------------------------------------------------------------
+void vtkSlicerMarkupsToModelMeshCache::Flush()
+{
+  this->Internal->WaitForWrites();
+}
+
+//------------------------------------------------------------------------------
+void vtkSlicerMarkupsToModelMeshCache::Clear()
+{
+  this->Internal->WaitForWrites();
+  std::lock_guard< std::mutex > lock( this->Internal->Mutex );
+  this->Internal->RemoveLeastRecentlyUsed( 0 );
+}
+
+//------------------------------------------------------------------------------
+void vtkSlicerMarkupsToModelMeshCache::ResetStatistics()
+{
+  this->NumberOfHits = 0;
+  this->NumberOfMisses = 0;
+}
+
+//------------------------------------------------------------------------------
+void vtkSlicerMarkupsToModelMeshCache::PrintSelf( ostream &os, vtkIndent indent )
+{
+  Superclass::PrintSelf( os, indent );
+  std::lock_guard< std::mutex > lock( this->Internal->Mutex );
+  os << indent << "CacheDirectory: " << this->Internal->Directory << std::endl;
+  os << indent << "MaximumCacheSize: " << this->MaximumCacheSize << std::endl;
+  os << indent << "CacheSize: " << this->Internal->CacheSize << std::endl;
+  os << indent << "NumberOfEntries: " << this->Internal->Entries.size() << std::endl;
+  os << indent << "NumberOfPendingWrites: " << this->Internal->PendingWrites.size() << std::endl;
+  os << indent << "NumberOfHits: " << this->NumberOfHits << std::endl;
+  os << indent << "NumberOfMisses: " << this->NumberOfMisses << std::endl;
+}
@@ -0,0 +1,86 @@
+#ifndef __vtkSlicerMarkupsToModelMeshCache_h
+#define __vtkSlicerMarkupsToModelMeshCache_h
+
+// vtk includes
+#include <vtkObject.h>
+#include <vtkPoints.h>
+#include <vtkPolyData.h>
+
+// STD includes
+#include <string>
+
+#include "vtkSlicerMarkupsToModelModuleLogicExport.h"
+
+class vtkMRMLMarkupsToModelNode;
+
+// Cache of generated output models in a local directory, keyed by a hash of the input points and the generation parameters
+// (see ComputeKey), so that identical models are not generated again (e.g., when the same scene is loaded again).
+//
+// Each model is stored in a separate file in a raw binary format (array contents are written as they are in memory),
+// so that loading only requires reading the arrays. Files are written on a background thread. When the total size of the files exceeds the maximum size
+// then the least recently used files are removed. Last use is kept in the file modification times between sessions.
+// The cache is disabled until a cache directory is set.
+class VTK_SLICER_MARKUPSTOMODEL_MODULE_LOGIC_EXPORT vtkSlicerMarkupsToModelMeshCache : public vtkObject
+{
+  public:
+    // standard vtk object methods
+    vtkTypeMacro( vtkSlicerMarkupsToModelMeshCache, vtkObject );
+    void PrintSelf( ostream& os, vtkIndent indent ) override;
+    static vtkSlicerMarkupsToModelMeshCache *New();
+
+    // Directory of the cache files. It is created if it does not exist, and files that are already in it are used.
+    // Set to NULL or empty string to disable the cache.
+    void SetCacheDirectory( const char* directory );
+    const char* GetCacheDirectory();
+    bool IsEnabled();
+
+    // Maximum total size of the cache files (in bytes). Least recently used files are removed if it is exceeded.
+    vtkGetMacro( MaximumCacheSize, vtkTypeUInt64 );
+    void SetMaximumCacheSize( vtkTypeUInt64 maximumCacheSize );
+
+    // Total size of the cache files (in bytes).
+    vtkTypeUInt64 GetCacheSize();
+    int GetNumberOfEntries();
+
+    // Compute the key of the model that is generated from the points with the parameters of the node.
+    // The points are expected to be cleaned already (see vtkSlicerMarkupsToModelLogic::RemoveDuplicatePoints).
+    // Parameters that only apply during interaction are not included, so models must not be cached while interacting.
+    static std::string ComputeKey( vtkMRMLMarkupsToModelNode* parameterNode, vtkPoints* controlPoints );
+
+    // Load the model stored with the key into outputPolyData. The curve length stored with the model is returned in outputCurveLength.
+    // Returns false if there is no model stored with the key (the file is removed if it cannot be read).
+    bool Load( const std::string& key, vtkPolyData* outputPolyData, double& outputCurveLength );
+
+    // Store the model with the key. The model is copied and its file is written on a background thread
+    // (the model can be loaded meanwhile). Returns false if the cache is disabled or the model has no points.
+    bool Store( const std::string& key, vtkPolyData* polyData, double outputCurveLength );
+
+    // Wait until the files of all stored models are written.
+    void Flush();
+
+    // Remove all cache files.
+    void Clear();
+
+    // Number of Load calls that found the model and that did not.
+    vtkGetMacro( NumberOfHits, vtkTypeUInt64 );
+    vtkGetMacro( NumberOfMisses, vtkTypeUInt64 );
+    void ResetStatistics();
+
+  protected:
+    vtkSlicerMarkupsToModelMeshCache();
+    ~vtkSlicerMarkupsToModelMeshCache();
+
+  private:
+    vtkTypeUInt64 MaximumCacheSize;
+    vtkTypeUInt64 NumberOfHits;
+    vtkTypeUInt64 NumberOfMisses;
+
+    class vtkInternal;
+    vtkInternal* Internal;
+
+    // not used
+    vtkSlicerMarkupsToModelMeshCache ( const vtkSlicerMarkupsToModelMeshCache& ) =delete;
+    void operator= ( const vtkSlicerMarkupsToModelMeshCache& ) =delete;
+};
+
+#endif
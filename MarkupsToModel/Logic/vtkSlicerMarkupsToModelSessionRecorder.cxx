@@ -0,0 +1,442 @@
+#include "vtkSlicerMarkupsToModelSessionRecorder.h"
+
+// MRML includes
+#include "vtkMRMLMarkupsNode.h"
+#include "vtkMRMLMarkupsToModelNode.h"
+
+// VTK includes
+#include <vtkCallbackCommand.h>
+#include <vtkObjectFactory.h>
+#include <vtkSmartPointer.h>
+#include <vtkWeakPointer.h>
+
+// STD includes
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <string>
+#include <vector>
+
+//------------------------------------------------------------------------------
+// constants within this file
+static const char* RECORDING_HEADER = "# MarkupsToModel session recording";
+
+//------------------------------------------------------------------------------
+class vtkSlicerMarkupsToModelSessionRecorder::vtkInternal
+{
+public:
+  vtkInternal()
+    : ParameterNodeObserverTag( 0 )
+  {
+  }
+
+  vtkWeakPointer< vtkMRMLMarkupsToModelNode > ParameterNode;
+  vtkWeakPointer< vtkMRMLMarkupsNode > MarkupsNode;
+  unsigned long ParameterNodeObserverTag;
+  std::vector< unsigned long > MarkupsNodeObserverTags;
+  vtkSmartPointer< vtkCallbackCommand > Callback;
+
+  std::chrono::steady_clock::time_point StartTime;
+  std::vector< std::string > Events; // lines of the recording
+  std::string LastParameters; // parameters in the last recorded parameters event
+  // Coordinates (x, y, z of each point) of the input points as of the last recorded event. Point modified events are
+  // also invoked by changes that do not move points (e.g., selection or label), these are not recorded.
+  std::vector< double > RecordedCoordinates;
+
+  // Start a line of the recording with the current time and the event type
+  void BeginEvent( std::ostringstream& line, const char* eventType )
+  {
+    double time = std::chrono::duration< double >( std::chrono::steady_clock::now() - this->StartTime ).count();
+    line << std::fixed << std::setprecision( 6 ) << time << " " << eventType;
+    // positions are written with full precision, so that the replayed points are the same
+    line << std::defaultfloat << std::setprecision( 17 );
+  }
+
+  void RecordParameters()
+  {
+    std::string parameters = vtkSlicerMarkupsToModelSessionRecorder::GetParametersAsString( this->ParameterNode );
+    if ( parameters == this->LastParameters )
+    {
+      return;
+    }
+    this->LastParameters = parameters;
+    std::ostringstream line;
+    this->BeginEvent( line, "parameters" );
+    line << " " << parameters;
+    this->Events.push_back( line.str() );
+  }
+
+  void GetCoordinates( std::vector< double >& coordinates )
+  {
+    int numberOfPoints = ( this->MarkupsNode != NULL ? this->MarkupsNode->GetNumberOfControlPoints() : 0 );
+    coordinates.resize( 3 * numberOfPoints );
+    for ( int pointIndex = 0; pointIndex < numberOfPoints; pointIndex++ )
+    {
+      this->MarkupsNode->GetNthControlPointPosition( pointIndex, &coordinates[ 3 * pointIndex ] );
+    }
+  }
+
+  void RecordPoints()
+  {
+    this->GetCoordinates( this->RecordedCoordinates );
+    std::ostringstream line;
+    this->BeginEvent( line, "points" );
+    line << " " << this->RecordedCoordinates.size() / 3;
+    for ( std::vector< double >::iterator coordinateIt = this->RecordedCoordinates.begin(); coordinateIt != this->RecordedCoordinates.end(); ++coordinateIt )
+    {
+      line << " " << *coordinateIt;
+    }
+    this->Events.push_back( line.str() );
+  }
+
+  // Record all points if any of them moved, or points were added or removed since the last recorded event
+  void RecordPointsIfMoved()
+  {
+    std::vector< double > coordinates;
+    this->GetCoordinates( coordinates );
+    if ( coordinates != this->RecordedCoordinates )
+    {
+      this->RecordPoints();
+    }
+  }
+
+  void RecordPointAdded( int pointIndex )
+  {
+    if ( pointIndex < 0 || pointIndex >= this->MarkupsNode->GetNumberOfControlPoints()
+      || 3 * static_cast< size_t >( pointIndex ) > this->RecordedCoordinates.size() )
+    {
+      this->RecordPoints();
+      return;
+    }
+    double position[ 3 ] = { 0.0, 0.0, 0.0 };
+    this->MarkupsNode->GetNthControlPointPosition( pointIndex, position );
+    this->RecordedCoordinates.insert( this->RecordedCoordinates.begin() + 3 * pointIndex, position, position + 3 );
+    this->RecordPoint( "add", pointIndex, position );
+  }
+
+  void RecordPointMoved( int pointIndex )
+  {
+    if ( pointIndex < 0 || pointIndex >= this->MarkupsNode->GetNumberOfControlPoints()
+      || this->RecordedCoordinates.size() != 3 * static_cast< size_t >( this->MarkupsNode->GetNumberOfControlPoints() ) )
+    {
+      this->RecordPointsIfMoved();
+      return;
+    }
+    double position[ 3 ] = { 0.0, 0.0, 0.0 };
+    this->MarkupsNode->GetNthControlPointPosition( pointIndex, position );
+    if ( std::equal( position, position + 3, this->RecordedCoordinates.begin() + 3 * pointIndex ) )
+    {
+      return;
+    }
+    std::copy( position, position + 3, this->RecordedCoordinates.begin() + 3 * pointIndex );
+    this->RecordPoint( "move", pointIndex, position );
+  }
+
+  void RecordPointRemoved( int pointIndex )
+  {
+    if ( pointIndex < 0 || 3 * static_cast< size_t >( pointIndex ) + 3 > this->RecordedCoordinates.size() )
+    {
+      this->RecordPoints();
+      return;
+    }
+    this->RecordedCoordinates.erase( this->RecordedCoordinates.begin() + 3 * pointIndex, this->RecordedCoordinates.begin() + 3 * pointIndex + 3 );
+    std::ostringstream index;
+    index << pointIndex;
+    this->RecordEvent( "remove", index.str().c_str() );
+  }
+
+  void RecordPoint( const char* eventType, int pointIndex, const double position[ 3 ] )
+  {
+    std::ostringstream line;
+    this->BeginEvent( line, eventType );
+    line << " " << pointIndex << " " << position[ 0 ] << " " << position[ 1 ] << " " << position[ 2 ];
+    this->Events.push_back( line.str() );
+  }
+
+  void RecordEvent( const char* eventType, const char* arguments = NULL )
+  {
+    std::ostringstream line;
+    this->BeginEvent( line, eventType );
+    if ( arguments != NULL )
+    {
+      line << " " << arguments;
+    }
+    this->Events.push_back( line.str() );
+  }
+
+  void ObserveMarkupsNode( vtkMRMLMarkupsNode* markupsNode )
+  {
+    if ( this->MarkupsNode != NULL )
+    {
+      for ( std::vector< unsigned long >::iterator tagIt = this->MarkupsNodeObserverTags.begin(); tagIt != this->MarkupsNodeObserverTags.end(); ++tagIt )
+      {
+        this->MarkupsNode->RemoveObserver( *tagIt );
+      }
+    }
+    this->MarkupsNodeObserverTags.clear();
+    this->MarkupsNode = markupsNode;
+    if ( markupsNode == NULL )
+    {
+      return;
+    }
+    const unsigned long markupsEvents[] =
+    {
+      vtkMRMLMarkupsNode::PointAddedEvent,
+      vtkMRMLMarkupsNode::PointRemovedEvent,
+      vtkMRMLMarkupsNode::PointModifiedEvent,
+      vtkMRMLMarkupsNode::PointPositionDefinedEvent,
+      vtkMRMLMarkupsNode::PointStartInteractionEvent,
+      vtkMRMLMarkupsNode::PointEndInteractionEvent
+    };
+    for ( size_t eventIndex = 0; eventIndex < sizeof( markupsEvents ) / sizeof( markupsEvents[ 0 ] ); eventIndex++ )
+    {
+      this->MarkupsNodeObserverTags.push_back( markupsNode->AddObserver( markupsEvents[ eventIndex ], this->Callback ) );
+    }
+  }
+};
+
+//------------------------------------------------------------------------------
+// Names of the attributes written by vtkMRMLNode::WriteXML that are not parameters of the output generation
+static bool IsParameterAttribute( const std::string& name )
+{
+  return name != "id" && name != "name" && name != "references" && name != "attributes";
+}
+
+//------------------------------------------------------------------------------
+vtkStandardNewMacro( vtkSlicerMarkupsToModelSessionRecorder );
+
+//------------------------------------------------------------------------------
+vtkSlicerMarkupsToModelSessionRecorder::vtkSlicerMarkupsToModelSessionRecorder()
+{
+  this->Internal = new vtkInternal;
+  this->Internal->Callback = vtkSmartPointer< vtkCallbackCommand >::New();
+  this->Internal->Callback->SetCallback( vtkSlicerMarkupsToModelSessionRecorder::OnNodeEvent );
+  this->Internal->Callback->SetClientData( this );
+}
+
+//------------------------------------------------------------------------------
+vtkSlicerMarkupsToModelSessionRecorder::~vtkSlicerMarkupsToModelSessionRecorder()
+{
+  this->StopRecording();
+  delete this->Internal;
+}
+
+//------------------------------------------------------------------------------
+bool vtkSlicerMarkupsToModelSessionRecorder::StartRecording( vtkMRMLMarkupsToModelNode* parameterNode )
+{
+  this->StopRecording();
+  if ( parameterNode == NULL )
+  {
+    vtkErrorMacro( "StartRecording: parameter node is not specified" );
+    return false;
+  }
+  vtkMRMLMarkupsNode* markupsNode = vtkMRMLMarkupsNode::SafeDownCast( parameterNode->GetInputNode() );
+  if ( markupsNode == NULL )
+  {
+    vtkErrorMacro( "StartRecording: input of the parameter node is not a markups node" );
+    return false;
+  }
+
+  this->Internal->Events.clear();
+  this->Internal->LastParameters.clear();
+  this->Internal->RecordedCoordinates.clear();
+  this->Internal->StartTime = std::chrono::steady_clock::now();
+  this->Internal->ParameterNode = parameterNode;
+  this->Internal->ParameterNodeObserverTag = parameterNode->AddObserver( vtkCommand::ModifiedEvent, this->Internal->Callback );
+  this->Internal->ObserveMarkupsNode( markupsNode );
+
+  this->Internal->RecordParameters();
+  this->Internal->RecordPoints();
+  this->Modified();
+  return true;
+}
+
+//------------------------------------------------------------------------------
+void vtkSlicerMarkupsToModelSessionRecorder::StopRecording()
+{
+  this->Internal->ObserveMarkupsNode( NULL );
+  if ( this->Internal->ParameterNode != NULL )
+  {
+    this->Internal->ParameterNode->RemoveObserver( this->Internal->ParameterNodeObserverTag );
+  }
+  this->Internal->ParameterNode = NULL;
+  this->Internal->ParameterNodeObserverTag = 0;
+}
+
+//------------------------------------------------------------------------------
+bool vtkSlicerMarkupsToModelSessionRecorder::IsRecording()
+{
+  return this->Internal->ParameterNode != NULL;
+}
+
+//------------------------------------------------------------------------------
+int vtkSlicerMarkupsToModelSessionRecorder::GetNumberOfEvents()
+{
+  return static_cast< int >( this->Internal->Events.size() );
+}
+
+//------------------------------------------------------------------------------
+bool vtkSlicerMarkupsToModelSessionRecorder::WriteRecording( const char* fileName )
+{
+  if ( fileName == NULL )
+  {
+    vtkErrorMacro( "WriteRecording: file name is not specified" );
+    return false;
+  }
+  std::ofstream file( fileName, std::ios::out | std::ios::trunc );
+  if ( !file )
+  {
+    vtkErrorMacro( "WriteRecording: cannot open file " << fileName );
+    return false;
+  }
+  file << RECORDING_HEADER << std::endl;
+  for ( std::vector< std::string >::iterator eventIt = this->Internal->Events.begin(); eventIt != this->Internal->Events.end(); ++eventIt )
+  {
+    file << *eventIt << std::endl;
+  }
+  return static_cast< bool >( file );
+}
+
+//------------------------------------------------------------------------------
+std::string vtkSlicerMarkupsToModelSessionRecorder::GetParametersAsString( vtkMRMLMarkupsToModelNode* parameterNode )
+{
+  if ( parameterNode == NULL )
+  {
+    return "";
+  }
+  std::ostringstream xml;
+  parameterNode->WriteXML( xml, 0 );
+
+  std::vector< std::pair< std::string, std::string > > attributes;
+  if ( !vtkSlicerMarkupsToModelSessionRecorder::ParseAttributes( xml.str(), attributes ) )
+  {
+    return "";
+  }
+  std::ostringstream parameters;
+  for ( std::vector< std::pair< std::string, std::string > >::iterator attributeIt = attributes.begin(); attributeIt != attributes.end(); ++attributeIt )
+  {
+    if ( !IsParameterAttribute( attributeIt->first ) )
+    {
+      continue;
+    }
+    parameters << ( parameters.tellp() > 0 ? " " : "" ) << attributeIt->first << "=\"" << attributeIt->second << "\"";
+  }
+  return parameters.str();
+}
+
+//------------------------------------------------------------------------------
+bool vtkSlicerMarkupsToModelSessionRecorder::SetParametersFromString( vtkMRMLMarkupsToModelNode* parameterNode, const std::string& parameters )
+{
+  if ( parameterNode == NULL )
+  {
+    return false;
+  }
+  std::vector< std::pair< std::string, std::string > > attributes;
+  if ( !vtkSlicerMarkupsToModelSessionRecorder::ParseAttributes( parameters, attributes ) )
+  {
+    return false;
+  }
+  std::vector< const char* > atts;
+  for ( std::vector< std::pair< std::string, std::string > >::iterator attributeIt = attributes.begin(); attributeIt != attributes.end(); ++attributeIt )
+  {
+    if ( !IsParameterAttribute( attributeIt->first ) )
+    {
+      continue;
+    }
+    atts.push_back( attributeIt->first.c_str() );
+    atts.push_back( attributeIt->second.c_str() );
+  }
+  atts.push_back( NULL );
+  parameterNode->ReadXMLAttributes( &atts[ 0 ] );
+  return true;
+}
+
+//------------------------------------------------------------------------------
+bool vtkSlicerMarkupsToModelSessionRecorder::ParseAttributes( const std::string& text, std::vector< std::pair< std::string, std::string > >& attributes )
+{
+  attributes.clear();
+  size_t position = 0;
+  while ( true )
+  {
+    size_t nameBegin = text.find_first_not_of( " \t\r\n", position );
+    if ( nameBegin == std::string::npos )
+    {
+      return true;
+    }
+    size_t separator = text.find( "=\"", nameBegin );
+    if ( separator == std::string::npos )
+    {
+      vtkGenericWarningMacro( "vtkSlicerMarkupsToModelSessionRecorder::ParseAttributes: invalid attribute in " << text );
+      return false;
+    }
+    size_t valueEnd = text.find( '"', separator + 2 );
+    if ( valueEnd == std::string::npos )
+    {
+      vtkGenericWarningMacro( "vtkSlicerMarkupsToModelSessionRecorder::ParseAttributes: unterminated attribute value in " << text );
+      return false;
+    }
+    attributes.push_back( std::make_pair( text.substr( nameBegin, separator - nameBegin ), text.substr( separator + 2, valueEnd - separator - 2 ) ) );
+    position = valueEnd + 1;
+  }
+}
+
+//------------------------------------------------------------------------------
+void vtkSlicerMarkupsToModelSessionRecorder::OnNodeEvent( vtkObject* caller, unsigned long event, void* clientData, void* callData )
+{
+  vtkSlicerMarkupsToModelSessionRecorder* self = reinterpret_cast< vtkSlicerMarkupsToModelSessionRecorder* >( clientData );
+  vtkInternal* internal = self->Internal;
+  if ( internal->ParameterNode == NULL )
+  {
+    return;
+  }
+
+  if ( caller == internal->ParameterNode.GetPointer() )
+  {
+    vtkMRMLMarkupsNode* markupsNode = vtkMRMLMarkupsNode::SafeDownCast( internal->ParameterNode->GetInputNode() );
+    if ( markupsNode != internal->MarkupsNode.GetPointer() )
+    {
+      internal->ObserveMarkupsNode( markupsNode );
+      internal->RecordPoints();
+    }
+    internal->RecordParameters();
+    return;
+  }
+
+  if ( caller != internal->MarkupsNode.GetPointer() )
+  {
+    return;
+  }
+  // call data is the index of the point, if a single point is affected
+  int pointIndex = ( callData != NULL ? *( reinterpret_cast< int* >( callData ) ) : -1 );
+  switch ( event )
+  {
+  case vtkMRMLMarkupsNode::PointAddedEvent:
+    internal->RecordPointAdded( pointIndex );
+    break;
+  case vtkMRMLMarkupsNode::PointModifiedEvent:
+  case vtkMRMLMarkupsNode::PointPositionDefinedEvent:
+    internal->RecordPointMoved( pointIndex );
+    break;
+  case vtkMRMLMarkupsNode::PointRemovedEvent:
+    internal->RecordPointRemoved( pointIndex );
+    break;
+  case vtkMRMLMarkupsNode::PointStartInteractionEvent:
+    internal->RecordEvent( "startInteraction" );
+    break;
+  case vtkMRMLMarkupsNode::PointEndInteractionEvent:
+    internal->RecordEvent( "endInteraction" );
+    break;
+  default:
+    break;
+  }
+}
+
+//------------------------------------------------------------------------------
+void vtkSlicerMarkupsToModelSessionRecorder::PrintSelf( ostream &os, vtkIndent indent )
+{
+  Superclass::PrintSelf( os, indent );
+  os << indent << "Recording: " << ( this->IsRecording() ? "true" : "false" ) << std::endl;
+  os << indent << "NumberOfEvents: " << this->GetNumberOfEvents() << std::endl;
+}
@@ -0,0 +1,81 @@
+#ifndef __vtkSlicerMarkupsToModelSessionRecorder_h
+#define __vtkSlicerMarkupsToModelSessionRecorder_h
+
+// vtk includes
+#include <vtkObject.h>
+
+// STD includes
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "vtkSlicerMarkupsToModelModuleLogicExport.h"
+
+class vtkMRMLMarkupsToModelNode;
+
+// Records the edits of the input markups of a parameter node (points added, moved and removed, start and end of
+// interaction) and the changes of its parameters during a session, with the time of each edit, so that the session can be
+// replayed later to measure update latency (see vtkSlicerMarkupsToModelSessionReplayer).
+//
+// Recordings are text files with one event per line: the time (in seconds since the start of the recording), the event type
+// and its arguments:
+//
+//   <time> parameters <XML attributes of the parameter node>
+//   <time> points <number of points> <x> <y> <z> ...
+//   <time> add <point index> <x> <y> <z>
+//   <time> move <point index> <x> <y> <z>
+//   <time> remove <point index>
+//   <time> startInteraction
+//   <time> endInteraction
+//
+// The first events are the parameters and the points when the recording is started. Edits that modify more than one point
+// are recorded as all points. Point modifications that do not change coordinates (e.g., selection, label or lock of points)
+// are not recorded. Only markups inputs are recorded. Record from the Python console:
+//
+//   recorder = slicer.vtkSlicerMarkupsToModelSessionRecorder()
+//   recorder.StartRecording(getNode('MarkupsToModel'))
+//   ... edit ...
+//   recorder.StopRecording()
+//   recorder.WriteRecording("/tmp/session.txt")
+class VTK_SLICER_MARKUPSTOMODEL_MODULE_LOGIC_EXPORT vtkSlicerMarkupsToModelSessionRecorder : public vtkObject
+{
+  public:
+    // standard vtk object methods
+    vtkTypeMacro( vtkSlicerMarkupsToModelSessionRecorder, vtkObject );
+    void PrintSelf( ostream& os, vtkIndent indent ) override;
+    static vtkSlicerMarkupsToModelSessionRecorder *New();
+
+    // Start recording the session of the parameter node. Events that were recorded earlier are removed.
+    // Returns false if the input of the parameter node is not a markups node.
+    bool StartRecording( vtkMRMLMarkupsToModelNode* parameterNode );
+    void StopRecording();
+    bool IsRecording();
+
+    int GetNumberOfEvents();
+
+    // Write the recorded events to a file. Returns false if the file cannot be written.
+    bool WriteRecording( const char* fileName );
+
+    // Parameters of the parameter node as XML attributes (name="value" pairs, separated by space), as in the recordings.
+    // Attributes that are not generation parameters (node ID, name, references and attributes) are not included.
+    static std::string GetParametersAsString( vtkMRMLMarkupsToModelNode* parameterNode );
+    // Set the parameters of the parameter node from the XML attributes. Returns false if the attributes cannot be parsed.
+    static bool SetParametersFromString( vtkMRMLMarkupsToModelNode* parameterNode, const std::string& parameters );
+
+  protected:
+    vtkSlicerMarkupsToModelSessionRecorder();
+    ~vtkSlicerMarkupsToModelSessionRecorder();
+
+  private:
+    static bool ParseAttributes( const std::string& text, std::vector< std::pair< std::string, std::string > >& attributes );
+    static void OnNodeEvent( vtkObject* caller, unsigned long event, void* clientData, void* callData );
+
+    class vtkInternal;
+    vtkInternal* Internal;
+
+    // not used
+    vtkSlicerMarkupsToModelSessionRecorder ( const vtkSlicerMarkupsToModelSessionRecorder& ) =delete;
+    void operator= ( const vtkSlicerMarkupsToModelSessionRecorder& ) =delete;
+};
+
+#endif
@@ -0,0 +1,558 @@
+#include "vtkSlicerMarkupsToModelSessionReplayer.h"
+#include "vtkSlicerMarkupsToModelLogic.h"
+#include "vtkSlicerMarkupsToModelSessionRecorder.h"
+
+// MRML includes
+#include "vtkMRMLMarkupsFiducialNode.h"
+#include "vtkMRMLMarkupsToModelNode.h"
+#include "vtkMRMLModelNode.h"
+#include <vtkMRMLScene.h>
+
+// VTK includes
+#include <vtkCallbackCommand.h>
+#include <vtkObjectFactory.h>
+#include <vtkSmartPointer.h>
+
+// STD includes
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+//------------------------------------------------------------------------------
+// constants within this file
+static const double PENDING_UPDATES_CHECK_INTERVAL_SEC = 0.01; // same as the interval of the module
+static const double FINISH_UPDATES_CHECK_INTERVAL_SEC = 0.001;
+
+enum ReplayEventType
+{
+  ParametersReplayEvent = 0,
+  PointsReplayEvent,
+  AddReplayEvent,
+  MoveReplayEvent,
+  RemoveReplayEvent,
+  StartInteractionReplayEvent,
+  EndInteractionReplayEvent,
+  ReplayEventType_Last
+};
+
+static const char* REPLAY_EVENT_TYPE_NAMES[ ReplayEventType_Last ] =
+{
+  "parameters", "points", "add", "move", "remove", "startInteraction", "endInteraction"
+};
+
+//------------------------------------------------------------------------------
+struct ReplayEvent
+{
+  double Time; // recorded time, in seconds
+  int Type;
+  int PointIndex;
+  std::vector< double > Coordinates;
+  std::string Parameters;
+};
+
+//------------------------------------------------------------------------------
+class vtkSlicerMarkupsToModelSessionReplayer::vtkInternal
+{
+public:
+  vtkInternal()
+    : OutputModified( false )
+    , LastNumberOfPerformedUpdates( 0 )
+  {
+  }
+
+  double GetElapsedTime()
+  {
+    return std::chrono::duration< double >( std::chrono::steady_clock::now() - this->StartTime ).count();
+  }
+
+  vtkSmartPointer< vtkSlicerMarkupsToModelLogic > Logic;
+  std::vector< ReplayEvent > Events;
+
+  // State of the replay
+  std::chrono::steady_clock::time_point StartTime;
+  bool OutputModified; // the output mesh was modified in the current step
+  vtkTypeUInt64 LastNumberOfPerformedUpdates; // number of updates performed by the logic until the current step
+  std::vector< size_t > UnresolvedEventIndices; // applied events that requested an update, in the order of the events
+  std::vector< double > AppliedTimes; // times when the events were applied, since the start of the replay
+  std::vector< bool > NoOpEvents; // events that did not request an output update
+  std::vector< bool > SkippedEvents; // no-op events that the logic skipped because the input points did not change
+  std::vector< bool > UnchangedOutputEvents; // events resolved by an update that did not modify the output mesh
+
+  // Results
+  std::vector< double > Latencies;
+  vtkTypeUInt64 NumberOfUpdateRequests;
+  vtkTypeUInt64 NumberOfMergedUpdateRequests;
+  vtkTypeUInt64 NumberOfSkippedUpdateRequests;
+};
+
+//------------------------------------------------------------------------------
+vtkStandardNewMacro( vtkSlicerMarkupsToModelSessionReplayer );
+
+//------------------------------------------------------------------------------
+vtkSlicerMarkupsToModelSessionReplayer::vtkSlicerMarkupsToModelSessionReplayer()
+  : Speed( 1.0 )
+  , NumberOfOutputUpdates( 0 )
+  , NumberOfCoalescedEvents( 0 )
+  , NumberOfDroppedEvents( 0 )
+  , NumberOfNoOpEvents( 0 )
+  , NumberOfUnchangedOutputEvents( 0 )
+  , ReplayDuration( 0.0 )
+{
+  this->Internal = new vtkInternal;
+  this->Internal->Logic = vtkSmartPointer< vtkSlicerMarkupsToModelLogic >::New();
+  this->Internal->NumberOfUpdateRequests = 0;
+  this->Internal->NumberOfMergedUpdateRequests = 0;
+  this->Internal->NumberOfSkippedUpdateRequests = 0;
+}
+
+//------------------------------------------------------------------------------
+vtkSlicerMarkupsToModelSessionReplayer::~vtkSlicerMarkupsToModelSessionReplayer()
+{
+  delete this->Internal;
+}
+
+//------------------------------------------------------------------------------
+vtkSlicerMarkupsToModelLogic* vtkSlicerMarkupsToModelSessionReplayer::GetLogic()
+{
+  return this->Internal->Logic;
+}
+
+//------------------------------------------------------------------------------
+bool vtkSlicerMarkupsToModelSessionReplayer::ReadRecording( const char* fileName )
+{
+  this->Internal->Events.clear();
+  if ( fileName == NULL )
+  {
+    vtkErrorMacro( "ReadRecording: file name is not specified" );
+    return false;
+  }
+  std::ifstream file( fileName );
+  if ( !file )
+  {
+    vtkErrorMacro( "ReadRecording: cannot open file " << fileName );
+    return false;
+  }
+
+  std::string line;
+  int lineNumber = 0;
+  while ( std::getline( file, line ) )
+  {
+    lineNumber++;
+    if ( line.empty() || line[ 0 ] == '#' )
+    {
+      continue;
+    }
+    std::istringstream lineStream( line );
+    ReplayEvent event;
+    std::string typeName;
+    lineStream >> event.Time >> typeName;
+    event.Type = std::find( REPLAY_EVENT_TYPE_NAMES, REPLAY_EVENT_TYPE_NAMES + ReplayEventType_Last, typeName ) - REPLAY_EVENT_TYPE_NAMES;
+    event.PointIndex = -1;
+    bool valid = !lineStream.fail() && event.Type != ReplayEventType_Last;
+    if ( valid && event.Type == ParametersReplayEvent )
+    {
+      std::getline( lineStream, event.Parameters );
+    }
+    else if ( valid && event.Type == PointsReplayEvent )
+    {
+      int numberOfPoints = 0;
+      lineStream >> numberOfPoints;
+      event.Coordinates.resize( 3 * std::max( numberOfPoints, 0 ) );
+      for ( std::vector< double >::iterator coordinateIt = event.Coordinates.begin(); coordinateIt != event.Coordinates.end(); ++coordinateIt )
+      {
+        lineStream >> *coordinateIt;
+      }
+      valid = !lineStream.fail() && numberOfPoints >= 0;
+    }
+    else if ( valid && ( event.Type == AddReplayEvent || event.Type == MoveReplayEvent ) )
+    {
+      event.Coordinates.resize( 3 );
+      lineStream >> event.PointIndex >> event.Coordinates[ 0 ] >> event.Coordinates[ 1 ] >> event.Coordinates[ 2 ];
+      valid = !lineStream.fail() && event.PointIndex >= 0;
+    }
+    else if ( valid && event.Type == RemoveReplayEvent )
+    {
+      lineStream >> event.PointIndex;
+      valid = !lineStream.fail() && event.PointIndex >= 0;
+    }
+    if ( !valid )
+    {
+      vtkErrorMacro( "ReadRecording: invalid event in line " << lineNumber << " of " << fileName << ": " << line );
+      this->Internal->Events.clear();
+      return false;
+    }
+    this->Internal->Events.push_back( event );
+  }
+  this->Modified();
+  return true;
+}
+
+//------------------------------------------------------------------------------
+int vtkSlicerMarkupsToModelSessionReplayer::GetNumberOfEvents()
+{
+  return static_cast< int >( this->Internal->Events.size() );
+}
+
+//------------------------------------------------------------------------------
+// Apply a recorded event to the input markups or parameter node. Returns false if the event does not match the input.
+static bool ApplyEvent( const ReplayEvent& event, vtkMRMLMarkupsToModelNode* parameterNode, vtkMRMLMarkupsNode* markupsNode )
+{
+  int numberOfPoints = markupsNode->GetNumberOfControlPoints();
+  double position[ 3 ] = { 0.0, 0.0, 0.0 };
+  if ( event.Coordinates.size() == 3 )
+  {
+    std::copy( event.Coordinates.begin(), event.Coordinates.end(), position );
+  }
+  switch ( event.Type )
+  {
+  case ParametersReplayEvent:
+    return vtkSlicerMarkupsToModelSessionRecorder::SetParametersFromString( parameterNode, event.Parameters );
+  case PointsReplayEvent:
+    {
+      int disabledModify = markupsNode->StartModify();
+      markupsNode->RemoveAllControlPoints();
+      for ( size_t coordinateIndex = 0; coordinateIndex + 2 < event.Coordinates.size(); coordinateIndex += 3 )
+      {
+        double point[ 3 ] = { event.Coordinates[ coordinateIndex ], event.Coordinates[ coordinateIndex + 1 ], event.Coordinates[ coordinateIndex + 2 ] };
+        markupsNode->AddControlPoint( point );
+      }
+      markupsNode->EndModify( disabledModify );
+      return true;
+    }
+  case AddReplayEvent:
+    if ( event.PointIndex > numberOfPoints )
+    {
+      return false;
+    }
+    if ( event.PointIndex == numberOfPoints )
+    {
+      markupsNode->AddControlPoint( position );
+      return true;
+    }
+    return markupsNode->InsertControlPoint( event.PointIndex, position );
+  case MoveReplayEvent:
+    if ( event.PointIndex >= numberOfPoints )
+    {
+      return false;
+    }
+    markupsNode->SetNthControlPointPosition( event.PointIndex, position[ 0 ], position[ 1 ], position[ 2 ] );
+    return true;
+  case RemoveReplayEvent:
+    if ( event.PointIndex >= numberOfPoints )
+    {
+      return false;
+    }
+    markupsNode->RemoveNthControlPoint( event.PointIndex );
+    return true;
+  case StartInteractionReplayEvent:
+    markupsNode->InvokeEvent( vtkMRMLMarkupsNode::PointStartInteractionEvent );
+    return true;
+  case EndInteractionReplayEvent:
+    markupsNode->InvokeEvent( vtkMRMLMarkupsNode::PointEndInteractionEvent );
+    return true;
+  default:
+    return false;
+  }
+}
+
+//------------------------------------------------------------------------------
+void vtkSlicerMarkupsToModelSessionReplayer::EndReplayStep()
+{
+  vtkInternal* internal = this->Internal;
+  double time = internal->GetElapsedTime();
+  bool outputModified = internal->OutputModified;
+  internal->OutputModified = false;
+  vtkTypeUInt64 numberOfPerformedUpdates = internal->Logic->GetNumberOfPerformedUpdates();
+  if ( numberOfPerformedUpdates == internal->LastNumberOfPerformedUpdates )
+  {
+    return;
+  }
+  this->NumberOfOutputUpdates += static_cast< int >( numberOfPerformedUpdates - internal->LastNumberOfPerformedUpdates );
+  internal->LastNumberOfPerformedUpdates = numberOfPerformedUpdates;
+  size_t numberOfResolvedEvents = internal->UnresolvedEventIndices.size();
+  if ( numberOfResolvedEvents > 1 )
+  {
+    this->NumberOfCoalescedEvents += static_cast< int >( numberOfResolvedEvents - 1 );
+  }
+  for ( std::vector< size_t >::iterator eventIndexIt = internal->UnresolvedEventIndices.begin(); eventIndexIt != internal->UnresolvedEventIndices.end(); ++eventIndexIt )
+  {
+    if ( outputModified )
+    {
+      internal->Latencies[ *eventIndexIt ] = time - internal->AppliedTimes[ *eventIndexIt ];
+    }
+    else
+    {
+      // the event was processed, but there is no output change that its latency could be measured by
+      internal->UnchangedOutputEvents[ *eventIndexIt ] = true;
+      this->NumberOfUnchangedOutputEvents++;
+    }
+  }
+  internal->UnresolvedEventIndices.clear();
+}
+
+//------------------------------------------------------------------------------
+bool vtkSlicerMarkupsToModelSessionReplayer::Replay()
+{
+  vtkInternal* internal = this->Internal;
+  if ( internal->Events.empty() )
+  {
+    vtkErrorMacro( "Replay: no recording is read" );
+    return false;
+  }
+  this->NumberOfOutputUpdates = 0;
+  this->NumberOfCoalescedEvents = 0;
+  this->NumberOfDroppedEvents = 0;
+  this->NumberOfNoOpEvents = 0;
+  this->NumberOfUnchangedOutputEvents = 0;
+  this->ReplayDuration = 0.0;
+  internal->AppliedTimes.clear();
+  internal->NoOpEvents.assign( internal->Events.size(), false );
+  internal->SkippedEvents.assign( internal->Events.size(), false );
+  internal->UnchangedOutputEvents.assign( internal->Events.size(), false );
+  internal->Latencies.assign( internal->Events.size(), -1.0 );
+  internal->UnresolvedEventIndices.clear();
+  internal->OutputModified = false;
+
+  vtkSmartPointer< vtkMRMLScene > scene = vtkSmartPointer< vtkMRMLScene >::New();
+  vtkSlicerMarkupsToModelLogic* logic = internal->Logic;
+  logic->SetMRMLScene( scene );
+  vtkSmartPointer< vtkMRMLMarkupsFiducialNode > markupsNode = vtkSmartPointer< vtkMRMLMarkupsFiducialNode >::New();
+  scene->AddNode( markupsNode );
+  vtkSmartPointer< vtkMRMLModelNode > modelNode = vtkSmartPointer< vtkMRMLModelNode >::New();
+  scene->AddNode( modelNode );
+  modelNode->CreateDefaultDisplayNodes();
+  vtkSmartPointer< vtkMRMLMarkupsToModelNode > parameterNode = vtkSmartPointer< vtkMRMLMarkupsToModelNode >::New();
+  scene->AddNode( parameterNode );
+  parameterNode->SetAndObserveInputNodeID( markupsNode->GetID() );
+  parameterNode->SetAndObserveOutputModelNodeID( modelNode->GetID() );
+
+  vtkSmartPointer< vtkCallbackCommand > outputModifiedCallback = vtkSmartPointer< vtkCallbackCommand >::New();
+  outputModifiedCallback->SetCallback( vtkSlicerMarkupsToModelSessionReplayer::OnOutputModified );
+  outputModifiedCallback->SetClientData( this );
+  unsigned long outputObserverTag = modelNode->AddObserver( vtkMRMLModelNode::MeshModifiedEvent, outputModifiedCallback );
+  logic->ResetUpdateRequestCounters();
+  internal->LastNumberOfPerformedUpdates = logic->GetNumberOfPerformedUpdates();
+
+  bool success = true;
+  internal->StartTime = std::chrono::steady_clock::now();
+  for ( std::vector< ReplayEvent >::iterator eventIt = internal->Events.begin(); eventIt != internal->Events.end(); ++eventIt )
+  {
+    // wait for the recorded time of the event, processing pending updates as the module does
+    while ( this->Speed > 0.0 )
+    {
+      double remainingTime = eventIt->Time / this->Speed - internal->GetElapsedTime();
+      if ( remainingTime <= 0.0 )
+      {
+        break;
+      }
+      std::this_thread::sleep_for( std::chrono::duration< double >( std::min( remainingTime, PENDING_UPDATES_CHECK_INTERVAL_SEC ) ) );
+      logic->ProcessPendingUpdates();
+      this->EndReplayStep();
+    }
+
+    vtkTypeUInt64 numberOfUpdateRequests = logic->GetNumberOfUpdateRequests();
+    vtkTypeUInt64 numberOfMergedUpdateRequests = logic->GetNumberOfMergedUpdateRequests();
+    vtkTypeUInt64 numberOfSkippedUpdateRequests = logic->GetNumberOfSkippedUpdateRequests();
+    size_t eventIndex = internal->AppliedTimes.size();
+    internal->AppliedTimes.push_back( internal->GetElapsedTime() );
+    internal->UnresolvedEventIndices.push_back( eventIndex );
+    if ( !ApplyEvent( *eventIt, parameterNode, markupsNode ) )
+    {
+      vtkErrorMacro( "Replay: " << REPLAY_EVENT_TYPE_NAMES[ eventIt->Type ] << " event at " << eventIt->Time
+        << "s cannot be applied to the input, replay is stopped" );
+      success = false;
+      break;
+    }
+    // Events that do not request an update (e.g., start of interaction, or points set to their current position that the
+    // logic skips) are not waiting for the output, so they are excluded from the latencies instead of being resolved by
+    // the next update.
+    bool updateRequested = logic->GetNumberOfUpdateRequests() != numberOfUpdateRequests
+      || logic->GetNumberOfMergedUpdateRequests() != numberOfMergedUpdateRequests;
+    if ( !updateRequested )
+    {
+      internal->UnresolvedEventIndices.pop_back();
+      internal->NoOpEvents[ eventIndex ] = true;
+      internal->SkippedEvents[ eventIndex ] = ( logic->GetNumberOfSkippedUpdateRequests() != numberOfSkippedUpdateRequests );
+      this->NumberOfNoOpEvents++;
+    }
+    this->EndReplayStep();
+
+    if ( this->Speed <= 0.0 )
+    {
+      logic->ProcessPendingUpdates();
+      this->EndReplayStep();
+    }
+  }
+
+  // finish the updates that were merged or that are running in the background
+  while ( true )
+  {
+    logic->ProcessPendingUpdates( true );
+    this->EndReplayStep();
+    int asynchronousUpdateStatus = logic->GetAsynchronousUpdateStatus( parameterNode );
+    if ( !logic->HasPendingUpdates()
+      && asynchronousUpdateStatus != vtkSlicerMarkupsToModelLogic::AsynchronousUpdatePending
+      && asynchronousUpdateStatus != vtkSlicerMarkupsToModelLogic::AsynchronousUpdateRunning )
+    {
+      break;
+    }
+    std::this_thread::sleep_for( std::chrono::duration< double >( FINISH_UPDATES_CHECK_INTERVAL_SEC ) );
+  }
+  this->ReplayDuration = internal->GetElapsedTime();
+  this->NumberOfDroppedEvents = static_cast< int >( internal->UnresolvedEventIndices.size() );
+
+  internal->NumberOfUpdateRequests = logic->GetNumberOfUpdateRequests();
+  internal->NumberOfMergedUpdateRequests = logic->GetNumberOfMergedUpdateRequests();
+  internal->NumberOfSkippedUpdateRequests = logic->GetNumberOfSkippedUpdateRequests();
+
+  modelNode->RemoveObserver( outputObserverTag );
+  logic->SetMRMLScene( NULL );
+  this->Modified();
+  return success;
+}
+
+//------------------------------------------------------------------------------
+void vtkSlicerMarkupsToModelSessionReplayer::OnOutputModified( vtkObject* vtkNotUsed( caller ), unsigned long vtkNotUsed( event ),
+  void* clientData, void* vtkNotUsed( callData ) )
+{
+  vtkSlicerMarkupsToModelSessionReplayer* self = reinterpret_cast< vtkSlicerMarkupsToModelSessionReplayer* >( clientData );
+  self->Internal->OutputModified = true;
+}
+
+//------------------------------------------------------------------------------
+double vtkSlicerMarkupsToModelSessionReplayer::GetEventLatency( int eventIndex )
+{
+  if ( eventIndex < 0 || eventIndex >= static_cast< int >( this->Internal->Latencies.size() ) )
+  {
+    vtkErrorMacro( "GetEventLatency: invalid event index " << eventIndex );
+    return -1.0;
+  }
+  return this->Internal->Latencies[ eventIndex ];
+}
+
+//------------------------------------------------------------------------------
+double vtkSlicerMarkupsToModelSessionReplayer::GetLatencyPercentile( double percentile )
+{
+  std::vector< double > latencies;
+  for ( std::vector< double >::iterator latencyIt = this->Internal->Latencies.begin(); latencyIt != this->Internal->Latencies.end(); ++latencyIt )
+  {
+    if ( *latencyIt >= 0.0 )
+    {
+      latencies.push_back( *latencyIt );
+    }
+  }
+  if ( latencies.empty() )
+  {
+    return 0.0;
+  }
+  std::sort( latencies.begin(), latencies.end() );
+  size_t rank = static_cast< size_t >( std::ceil( percentile / 100.0 * latencies.size() ) );
+  rank = std::min( std::max( rank, static_cast< size_t >( 1 ) ), latencies.size() );
+  return latencies[ rank - 1 ];
+}
+
+//------------------------------------------------------------------------------
+std::string vtkSlicerMarkupsToModelSessionReplayer::GetReportAsJSON()
+{
+  double totalLatency = 0.0;
+  int numberOfResolvedEvents = 0;
+  for ( std::vector< double >::iterator latencyIt = this->Internal->Latencies.begin(); latencyIt != this->Internal->Latencies.end(); ++latencyIt )
+  {
+    if ( *latencyIt >= 0.0 )
+    {
+      totalLatency += *latencyIt;
+      numberOfResolvedEvents++;
+    }
+  }
+
+  std::ostringstream os;
+  os << "{" << std::endl;
+  os << "  \"numberOfEvents\": " << this->Internal->Events.size() << "," << std::endl;
+  os << "  \"speed\": " << this->Speed << "," << std::endl;
+  os << "  \"replayDuration\": " << this->ReplayDuration << "," << std::endl;
+  os << "  \"numberOfOutputUpdates\": " << this->NumberOfOutputUpdates << "," << std::endl;
+  os << "  \"numberOfCoalescedEvents\": " << this->NumberOfCoalescedEvents << "," << std::endl;
+  os << "  \"numberOfDroppedEvents\": " << this->NumberOfDroppedEvents << "," << std::endl;
+  os << "  \"numberOfNoOpEvents\": " << this->NumberOfNoOpEvents << "," << std::endl;
+  os << "  \"numberOfUnchangedOutputEvents\": " << this->NumberOfUnchangedOutputEvents << "," << std::endl;
+  os << "  \"numberOfUpdateRequests\": " << this->Internal->NumberOfUpdateRequests << "," << std::endl;
+  os << "  \"numberOfMergedUpdateRequests\": " << this->Internal->NumberOfMergedUpdateRequests << "," << std::endl;
+  os << "  \"numberOfSkippedUpdateRequests\": " << this->Internal->NumberOfSkippedUpdateRequests << "," << std::endl;
+  // latencies in milliseconds
+  os << "  \"latencyMs\": {\"min\": " << this->GetLatencyPercentile( 0.0 ) * 1000.0
+    << ", \"mean\": " << ( numberOfResolvedEvents > 0 ? totalLatency / numberOfResolvedEvents : 0.0 ) * 1000.0
+    << ", \"p50\": " << this->GetLatencyPercentile( 50.0 ) * 1000.0 << ", \"p90\": " << this->GetLatencyPercentile( 90.0 ) * 1000.0
+    << ", \"p99\": " << this->GetLatencyPercentile( 99.0 ) * 1000.0 << ", \"max\": " << this->GetLatencyPercentile( 100.0 ) * 1000.0
+    << "}," << std::endl;
+  os << "  \"events\": [";
+  for ( size_t eventIndex = 0; eventIndex < this->Internal->Events.size(); eventIndex++ )
+  {
+    const ReplayEvent& event = this->Internal->Events[ eventIndex ];
+    os << ( eventIndex == 0 ? "" : "," ) << std::endl;
+    os << "    {\"time\": " << event.Time << ", \"type\": \"" << REPLAY_EVENT_TYPE_NAMES[ event.Type ] << "\"";
+    if ( event.PointIndex >= 0 )
+    {
+      os << ", \"pointIndex\": " << event.PointIndex;
+    }
+    if ( eventIndex < this->Internal->AppliedTimes.size() )
+    {
+      os << ", \"appliedTime\": " << this->Internal->AppliedTimes[ eventIndex ];
+    }
+    double latency = ( eventIndex < this->Internal->Latencies.size() ? this->Internal->Latencies[ eventIndex ] : -1.0 );
+    if ( latency >= 0.0 )
+    {
+      os << ", \"latencyMs\": " << latency * 1000.0;
+    }
+    else if ( eventIndex < this->Internal->NoOpEvents.size() && this->Internal->NoOpEvents[ eventIndex ] )
+    {
+      os << ", \"noOp\": true" << ( this->Internal->SkippedEvents[ eventIndex ] ? ", \"skipped\": true" : "" );
+    }
+    else if ( eventIndex < this->Internal->UnchangedOutputEvents.size() && this->Internal->UnchangedOutputEvents[ eventIndex ] )
+    {
+      os << ", \"unchangedOutput\": true";
+    }
+    else
+    {
+      os << ", \"dropped\": true";
+    }
+    os << "}";
+  }
+  os << std::endl << "  ]" << std::endl << "}" << std::endl;
+  return os.str();
+}
+
+//------------------------------------------------------------------------------
+bool vtkSlicerMarkupsToModelSessionReplayer::WriteReport( const char* fileName )
+{
+  if ( fileName == NULL )
+  {
+    vtkErrorMacro( "WriteReport: file name is not specified" );
+    return false;
+  }
+  std::ofstream file( fileName, std::ios::out | std::ios::trunc );
+  if ( !file )
+  {
+    vtkErrorMacro( "WriteReport: cannot open file " << fileName );
+    return false;
+  }
+  file << this->GetReportAsJSON();
+  return static_cast< bool >( file );
+}
+
+//------------------------------------------------------------------------------
+void vtkSlicerMarkupsToModelSessionReplayer::PrintSelf( ostream &os, vtkIndent indent )
+{
+  Superclass::PrintSelf( os, indent );
+  os << indent << "NumberOfEvents: " << this->GetNumberOfEvents() << std::endl;
+  os << indent << "Speed: " << this->Speed << std::endl;
+  os << indent << "NumberOfOutputUpdates: " << this->NumberOfOutputUpdates << std::endl;
+  os << indent << "NumberOfCoalescedEvents: " << this->NumberOfCoalescedEvents << std::endl;
+  os << indent << "NumberOfDroppedEvents: " << this->NumberOfDroppedEvents << std::endl;
+  os << indent << "NumberOfNoOpEvents: " << this->NumberOfNoOpEvents << std::endl;
+  os << indent << "NumberOfUnchangedOutputEvents: " << this->NumberOfUnchangedOutputEvents << std::endl;
+  os << indent << "ReplayDuration: " << this->ReplayDuration << std::endl;
+}
@@ -0,0 +1,96 @@
+#ifndef __vtkSlicerMarkupsToModelSessionReplayer_h
+#define __vtkSlicerMarkupsToModelSessionReplayer_h
+
+// vtk includes
+#include <vtkObject.h>
+
+// STD includes
+#include <string>
+
+#include "vtkSlicerMarkupsToModelModuleLogicExport.h"
+
+class vtkSlicerMarkupsToModelLogic;
+
+// Replays a session recorded by vtkSlicerMarkupsToModelSessionRecorder without GUI, and measures the end-to-end latency
+// of each recorded event: the time from applying the edit to the input markups (or the parameter change) until the output
+// model is updated. The events are applied to a new scene that the logic is attached to, and pending updates are processed
+// periodically as in the application.
+//
+// An output update resolves all the events that were applied before it and not resolved yet. Whether an update was
+// performed is decided by the update counters of the logic, not by the output mesh changing. Events that were resolved
+// by the same update as a later event are counted as coalesced, events after which no update was performed by the end
+// of the replay are counted as dropped. Events resolved by an update that did not modify the output mesh (e.g., the output
+// was already up to date) are counted as unchanged output events and excluded from the latencies.
+// Events that do not request an output update (e.g., start of interaction, or points set to their current position,
+// which the logic skips) are counted as no-op events and excluded from the latencies, based on the update request counters
+// of the logic before and after applying the event.
+// With asynchronous updates an event may be resolved by an update that was started before the event, if it finishes after
+// the event.
+class VTK_SLICER_MARKUPSTOMODEL_MODULE_LOGIC_EXPORT vtkSlicerMarkupsToModelSessionReplayer : public vtkObject
+{
+  public:
+    // standard vtk object methods
+    vtkTypeMacro( vtkSlicerMarkupsToModelSessionReplayer, vtkObject );
+    void PrintSelf( ostream& os, vtkIndent indent ) override;
+    static vtkSlicerMarkupsToModelSessionReplayer *New();
+
+    // Read the events of a recording. Returns false if the file cannot be read or it is not a valid recording.
+    bool ReadRecording( const char* fileName );
+    int GetNumberOfEvents();
+
+    // Replay speed relative to the recorded times (1 is the original speed).
+    // 0 replays at maximum speed: events are applied without waiting, pending updates are processed after each event.
+    vtkGetMacro( Speed, double );
+    vtkSetClampMacro( Speed, double, 0.0, VTK_DOUBLE_MAX );
+
+    // Logic that generates the outputs. It can be configured before replaying (e.g., minimum interaction update interval).
+    vtkSlicerMarkupsToModelLogic* GetLogic();
+
+    // Replay the recorded events and measure the latencies. Returns false if an event cannot be applied.
+    bool Replay();
+
+    // Results of the last replay.
+    // Latency of the event in seconds, negative if the event was dropped, it is a no-op event, or its update did not modify the output.
+    double GetEventLatency( int eventIndex );
+    // Nearest-rank percentile of the latencies of the events that have a latency.
+    double GetLatencyPercentile( double percentile );
+    vtkGetMacro( NumberOfOutputUpdates, int );
+    vtkGetMacro( NumberOfCoalescedEvents, int );
+    vtkGetMacro( NumberOfDroppedEvents, int );
+    vtkGetMacro( NumberOfNoOpEvents, int );
+    vtkGetMacro( NumberOfUnchangedOutputEvents, int );
+    // Time from the first event until all updates were finished, in seconds.
+    vtkGetMacro( ReplayDuration, double );
+
+    // Results of the last replay in JSON, including the latency of each event and the update request counters of the logic.
+    std::string GetReportAsJSON();
+    // Write the results to a file in JSON. Returns false if the file cannot be written.
+    bool WriteReport( const char* fileName );
+
+  protected:
+    vtkSlicerMarkupsToModelSessionReplayer();
+    ~vtkSlicerMarkupsToModelSessionReplayer();
+
+  private:
+    // Resolve the applied events that are not resolved yet, if the logic performed an output update in the step that ends now
+    // (applying an event or processing pending updates)
+    void EndReplayStep();
+    static void OnOutputModified( vtkObject* caller, unsigned long event, void* clientData, void* callData );
+
+    double Speed;
+    int NumberOfOutputUpdates;
+    int NumberOfCoalescedEvents;
+    int NumberOfDroppedEvents;
+    int NumberOfNoOpEvents;
+    int NumberOfUnchangedOutputEvents;
+    double ReplayDuration;
+
+    class vtkInternal;
+    vtkInternal* Internal;
+
+    // not used
+    vtkSlicerMarkupsToModelSessionReplayer ( const vtkSlicerMarkupsToModelSessionReplayer& ) =delete;
+    void operator= ( const vtkSlicerMarkupsToModelSessionReplayer& ) =delete;
+};
+
+#endif
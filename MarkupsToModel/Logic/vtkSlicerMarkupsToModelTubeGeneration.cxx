@@ -0,0 +1,635 @@
+#include "vtkSlicerMarkupsToModelTubeGeneration.h"
+
+#include <vtkCellArray.h>
+#include <vtkFloatArray.h>
+#include <vtkIdTypeArray.h>
+#include <vtkMath.h>
+#include <vtkObjectFactory.h>
+#include <vtkPointData.h>
+#include <vtkSMPTools.h>
+#include <vtkSmartPointer.h>
+
+// STD includes
+#include <algorithm>
+#include <vector>
+
+//------------------------------------------------------------------------------
+// constants within this file
+static const double COMPARE_TO_ZERO_TOLERANCE = 0.0001;
+static const int MINIMUM_TUBE_NUMBER_OF_SIDES = 3; // same limit as vtkTubeFilter
+static const char* TUBE_NORMALS_ARRAY_NAME = "TubeNormals";
+static const vtkIdType RINGS_PER_PARALLEL_TASK = 1000; // shorter curves are processed in a single thread
+
+//------------------------------------------------------------------------------
+vtkStandardNewMacro( vtkSlicerMarkupsToModelTubeGeneration );
+
+//------------------------------------------------------------------------------
+vtkSlicerMarkupsToModelTubeGeneration::vtkSlicerMarkupsToModelTubeGeneration()
+{
+}
+
+//------------------------------------------------------------------------------
+vtkSlicerMarkupsToModelTubeGeneration::~vtkSlicerMarkupsToModelTubeGeneration()
+{
+}
+
+//------------------------------------------------------------------------------
+// Direction of the curve at the given point: average of the adjacent segment directions.
+// Returns false if all adjacent segments have zero length.
+static bool ComputeCurveTangent( vtkPoints* curvePoints, vtkIdType pointIndex, double tangent[ 3 ] )
+{
+  tangent[ 0 ] = tangent[ 1 ] = tangent[ 2 ] = 0.0;
+  double currentPoint[ 3 ] = { 0.0, 0.0, 0.0 };
+  curvePoints->GetPoint( pointIndex, currentPoint );
+  if ( pointIndex > 0 )
+  {
+    double previousPoint[ 3 ] = { 0.0, 0.0, 0.0 };
+    curvePoints->GetPoint( pointIndex - 1, previousPoint );
+    double segmentDirection[ 3 ] = { 0.0, 0.0, 0.0 };
+    vtkMath::Subtract( currentPoint, previousPoint, segmentDirection );
+    if ( vtkMath::Normalize( segmentDirection ) > COMPARE_TO_ZERO_TOLERANCE )
+    {
+      vtkMath::Add( tangent, segmentDirection, tangent );
+    }
+  }
+  if ( pointIndex < curvePoints->GetNumberOfPoints() - 1 )
+  {
+    double nextPoint[ 3 ] = { 0.0, 0.0, 0.0 };
+    curvePoints->GetPoint( pointIndex + 1, nextPoint );
+    double segmentDirection[ 3 ] = { 0.0, 0.0, 0.0 };
+    vtkMath::Subtract( nextPoint, currentPoint, segmentDirection );
+    if ( vtkMath::Normalize( segmentDirection ) > COMPARE_TO_ZERO_TOLERANCE )
+    {
+      vtkMath::Add( tangent, segmentDirection, tangent );
+    }
+  }
+  return ( vtkMath::Normalize( tangent ) > COMPARE_TO_ZERO_TOLERANCE );
+}
+
+//------------------------------------------------------------------------------
+// Propagate the normal of the previous ring to the next ring using the double reflection method
+// (Wang et al., "Computation of rotation minimizing frames", ACM TOG 2008). The first reflection maps the
+// previous point onto the next one, the second one aligns the reflected tangent with the next tangent.
+static void PropagateNormal( const double previousPoint[ 3 ], const double previousTangent[ 3 ], const double previousNormal[ 3 ],
+  const double point[ 3 ], const double tangent[ 3 ], double normal[ 3 ] )
+{
+  double reflectedNormal[ 3 ] = { previousNormal[ 0 ], previousNormal[ 1 ], previousNormal[ 2 ] };
+  double reflectedTangent[ 3 ] = { previousTangent[ 0 ], previousTangent[ 1 ], previousTangent[ 2 ] };
+  double firstReflectionAxis[ 3 ] = { 0.0, 0.0, 0.0 };
+  vtkMath::Subtract( point, previousPoint, firstReflectionAxis );
+  double firstReflectionAxisLength2 = vtkMath::Dot( firstReflectionAxis, firstReflectionAxis );
+  if ( firstReflectionAxisLength2 > COMPARE_TO_ZERO_TOLERANCE * COMPARE_TO_ZERO_TOLERANCE )
+  {
+    double normalScale = 2.0 * vtkMath::Dot( firstReflectionAxis, reflectedNormal ) / firstReflectionAxisLength2;
+    double tangentScale = 2.0 * vtkMath::Dot( firstReflectionAxis, reflectedTangent ) / firstReflectionAxisLength2;
+    for ( int i = 0; i < 3; i++ )
+    {
+      reflectedNormal[ i ] -= normalScale * firstReflectionAxis[ i ];
+      reflectedTangent[ i ] -= tangentScale * firstReflectionAxis[ i ];
+    }
+  }
+  double secondReflectionAxis[ 3 ] = { 0.0, 0.0, 0.0 };
+  vtkMath::Subtract( tangent, reflectedTangent, secondReflectionAxis );
+  double secondReflectionAxisLength2 = vtkMath::Dot( secondReflectionAxis, secondReflectionAxis );
+  if ( secondReflectionAxisLength2 > COMPARE_TO_ZERO_TOLERANCE * COMPARE_TO_ZERO_TOLERANCE )
+  {
+    double normalScale = 2.0 * vtkMath::Dot( secondReflectionAxis, reflectedNormal ) / secondReflectionAxisLength2;
+    for ( int i = 0; i < 3; i++ )
+    {
+      reflectedNormal[ i ] -= normalScale * secondReflectionAxis[ i ];
+    }
+  }
+
+  // remove numerical drift, so that the frame stays orthonormal along long curves
+  double projection = vtkMath::Dot( reflectedNormal, tangent );
+  for ( int i = 0; i < 3; i++ )
+  {
+    normal[ i ] = reflectedNormal[ i ] - projection * tangent[ i ];
+  }
+  if ( vtkMath::Normalize( normal ) <= COMPARE_TO_ZERO_TOLERANCE )
+  {
+    double unusedAxis[ 3 ] = { 0.0, 0.0, 0.0 };
+    vtkMath::Perpendiculars( tangent, normal, unusedAxis, 0.0 );
+  }
+}
+
+//------------------------------------------------------------------------------
+// Compute rotation minimizing frames (tangent and normal) for rings [firstRingIndex, endRingIndex) in one pass.
+// If initialNormal is specified then it is the normal of ring firstRingIndex-1, otherwise the first normal is chosen arbitrarily.
+// Positions, tangents and normals are stored as 3-component tuples, starting with firstRingIndex.
+static void ComputeFrames( vtkPoints* curvePoints, vtkIdType firstRingIndex, vtkIdType endRingIndex, const double* initialNormal,
+  std::vector< double >& positions, std::vector< double >& tangents, std::vector< double >& normals )
+{
+  vtkIdType numberOfFrames = std::max< vtkIdType >( endRingIndex - firstRingIndex, 0 );
+  positions.resize( 3 * numberOfFrames );
+  tangents.resize( 3 * numberOfFrames );
+  normals.resize( 3 * numberOfFrames );
+
+  double previousPoint[ 3 ] = { 0.0, 0.0, 0.0 };
+  double previousTangent[ 3 ] = { 1.0, 0.0, 0.0 }; // used if the curve starts with coincident points
+  double previousNormal[ 3 ] = { 0.0, 0.0, 0.0 };
+  bool previousFrameValid = false;
+  if ( initialNormal != NULL && firstRingIndex > 0 )
+  {
+    curvePoints->GetPoint( firstRingIndex - 1, previousPoint );
+    if ( !ComputeCurveTangent( curvePoints, firstRingIndex - 1, previousTangent ) )
+    {
+      previousTangent[ 0 ] = 1.0;
+      previousTangent[ 1 ] = 0.0;
+      previousTangent[ 2 ] = 0.0;
+    }
+    previousNormal[ 0 ] = initialNormal[ 0 ];
+    previousNormal[ 1 ] = initialNormal[ 1 ];
+    previousNormal[ 2 ] = initialNormal[ 2 ];
+    previousFrameValid = ( vtkMath::Normalize( previousNormal ) > COMPARE_TO_ZERO_TOLERANCE );
+  }
+
+  for ( vtkIdType frameIndex = 0; frameIndex < numberOfFrames; frameIndex++ )
+  {
+    double* point = &positions[ 3 * frameIndex ];
+    double* tangent = &tangents[ 3 * frameIndex ];
+    double* normal = &normals[ 3 * frameIndex ];
+    curvePoints->GetPoint( firstRingIndex + frameIndex, point );
+    if ( !ComputeCurveTangent( curvePoints, firstRingIndex + frameIndex, tangent ) )
+    {
+      tangent[ 0 ] = previousTangent[ 0 ];
+      tangent[ 1 ] = previousTangent[ 1 ];
+      tangent[ 2 ] = previousTangent[ 2 ];
+    }
+    if ( previousFrameValid )
+    {
+      PropagateNormal( previousPoint, previousTangent, previousNormal, point, tangent, normal );
+    }
+    else
+    {
+      double unusedAxis[ 3 ] = { 0.0, 0.0, 0.0 };
+      vtkMath::Perpendiculars( tangent, normal, unusedAxis, 0.0 );
+    }
+    for ( int i = 0; i < 3; i++ )
+    {
+      previousPoint[ i ] = point[ i ];
+      previousTangent[ i ] = tangent[ i ];
+      previousNormal[ i ] = normal[ i ];
+    }
+    previousFrameValid = true;
+  }
+}
+
+//------------------------------------------------------------------------------
+// Writes ring vertices and normals from precomputed frames directly into the output arrays.
+// Rings are independent of each other, so ranges of rings can be processed in parallel.
+class vtkTubeRingWriter
+{
+public:
+  const double* Positions;
+  const double* Tangents;
+  const double* Normals;
+  vtkIdType FirstRingIndex;
+  vtkIdType RingPointOffset;
+  int NumberOfSides;
+  double Radius;
+  const double* SideCosines;
+  const double* SideSines;
+  float* TubePoints;
+  float* TubeNormals;
+
+  void operator()( vtkIdType beginRingIndex, vtkIdType endRingIndex ) const
+  {
+    for ( vtkIdType ringIndex = beginRingIndex; ringIndex < endRingIndex; ringIndex++ )
+    {
+      vtkIdType frameIndex = ringIndex - this->FirstRingIndex;
+      const double* point = this->Positions + 3 * frameIndex;
+      const double* tangent = this->Tangents + 3 * frameIndex;
+      const double* normal = this->Normals + 3 * frameIndex;
+      double binormal[ 3 ] = { 0.0, 0.0, 0.0 };
+      vtkMath::Cross( tangent, normal, binormal );
+      float* ringPoints = this->TubePoints + 3 * ( this->RingPointOffset + ringIndex * this->NumberOfSides );
+      float* ringNormals = this->TubeNormals + 3 * ( this->RingPointOffset + ringIndex * this->NumberOfSides );
+      for ( int sideIndex = 0; sideIndex < this->NumberOfSides; sideIndex++ )
+      {
+        for ( int i = 0; i < 3; i++ )
+        {
+          double radialDirection = this->SideCosines[ sideIndex ] * normal[ i ] + this->SideSines[ sideIndex ] * binormal[ i ];
+          ringPoints[ 3 * sideIndex + i ] = static_cast< float >( point[ i ] + this->Radius * radialDirection );
+          ringNormals[ 3 * sideIndex + i ] = static_cast< float >( radialDirection );
+        }
+      }
+    }
+  }
+};
+
+//------------------------------------------------------------------------------
+// Writes the connectivity of the side triangle strips directly into the cell array storage.
+class vtkTubeStripWriter
+{
+public:
+  vtkIdType FirstSegmentIndex;
+  vtkIdType RingPointOffset;
+  int NumberOfSides;
+  vtkIdType* Offsets;
+  vtkIdType* Connectivity;
+
+  void operator()( vtkIdType beginSegmentIndex, vtkIdType endSegmentIndex ) const
+  {
+    vtkIdType stripSize = 2 * ( this->NumberOfSides + 1 );
+    for ( vtkIdType segmentIndex = beginSegmentIndex; segmentIndex < endSegmentIndex; segmentIndex++ )
+    {
+      vtkIdType stripIndex = segmentIndex - this->FirstSegmentIndex;
+      this->Offsets[ stripIndex + 1 ] = ( stripIndex + 1 ) * stripSize;
+      vtkIdType* stripIds = this->Connectivity + stripIndex * stripSize;
+      vtkIdType segmentStartPointIndex = this->RingPointOffset + segmentIndex * this->NumberOfSides;
+      vtkIdType segmentEndPointIndex = segmentStartPointIndex + this->NumberOfSides;
+      for ( int sideIndex = 0; sideIndex <= this->NumberOfSides; sideIndex++ )
+      {
+        int wrappedSideIndex = sideIndex % this->NumberOfSides;
+        stripIds[ 2 * sideIndex ] = segmentEndPointIndex + wrappedSideIndex;
+        stripIds[ 2 * sideIndex + 1 ] = segmentStartPointIndex + wrappedSideIndex;
+      }
+    }
+  }
+};
+
+//------------------------------------------------------------------------------
+bool vtkSlicerMarkupsToModelTubeGeneration::GenerateTubeModel( vtkPoints* curvePoints, vtkPolyData* outputTubePolyData,
+  double tubeRadius, int tubeNumberOfSides, bool tubeCapping )
+{
+  if ( curvePoints == NULL )
+  {
+    vtkGenericWarningMacro( "Curve points are null. No model generated." );
+    return false;
+  }
+
+  if ( outputTubePolyData == NULL )
+  {
+    vtkGenericWarningMacro( "Output tube poly data is null. No model generated." );
+    return false;
+  }
+
+  if ( tubeNumberOfSides < MINIMUM_TUBE_NUMBER_OF_SIDES )
+  {
+    tubeNumberOfSides = MINIMUM_TUBE_NUMBER_OF_SIDES;
+  }
+
+  vtkIdType numberOfRings = curvePoints->GetNumberOfPoints();
+  if ( numberOfRings >= 2
+    && vtkSlicerMarkupsToModelTubeGeneration::GetNumberOfTubeRings( outputTubePolyData, tubeNumberOfSides, tubeCapping ) == numberOfRings )
+  {
+    // Same topology as the existing tube: keep the cells and only rewrite point coordinates and normals,
+    // so that no arrays are reallocated and connectivity does not have to be uploaded again for rendering.
+    vtkPoints* tubePoints = outputTubePolyData->GetPoints();
+    vtkDataArray* tubeNormals = outputTubePolyData->GetPointData()->GetNormals();
+    vtkSlicerMarkupsToModelTubeGeneration::ComputeRings( curvePoints, 0, numberOfRings, NULL, 0.0, tubePoints, tubeNormals,
+      tubeRadius, tubeNumberOfSides, tubeCapping );
+    tubePoints->Modified();
+    tubeNormals->Modified();
+    outputTubePolyData->Modified();
+    return true;
+  }
+
+  outputTubePolyData->Initialize();
+  if ( numberOfRings < 2 )
+  {
+    // a tube needs at least one segment, the output is empty
+    return true;
+  }
+
+  vtkIdType ringPointOffset = tubeCapping ? 2 * tubeNumberOfSides : 0;
+  vtkIdType numberOfTubePoints = ringPointOffset + numberOfRings * tubeNumberOfSides;
+
+  // all the arrays are allocated once and then filled directly
+  vtkSmartPointer< vtkPoints > tubePoints = vtkSmartPointer< vtkPoints >::New();
+  tubePoints->SetDataTypeToFloat();
+  tubePoints->SetNumberOfPoints( numberOfTubePoints );
+  vtkSmartPointer< vtkFloatArray > tubeNormals = vtkSmartPointer< vtkFloatArray >::New();
+  tubeNormals->SetName( TUBE_NORMALS_ARRAY_NAME );
+  tubeNormals->SetNumberOfComponents( 3 );
+  tubeNormals->SetNumberOfTuples( numberOfTubePoints );
+  vtkSlicerMarkupsToModelTubeGeneration::ComputeRings( curvePoints, 0, numberOfRings, NULL, 0.0, tubePoints, tubeNormals,
+    tubeRadius, tubeNumberOfSides, tubeCapping );
+
+  vtkSmartPointer< vtkCellArray > capPolys = vtkSmartPointer< vtkCellArray >::New();
+  if ( tubeCapping )
+  {
+    // start cap faces backward, so its points are listed in reverse order
+    std::vector< vtkIdType > capPointIds( tubeNumberOfSides );
+    for ( int sideIndex = 0; sideIndex < tubeNumberOfSides; sideIndex++ )
+    {
+      capPointIds[ sideIndex ] = tubeNumberOfSides - 1 - sideIndex;
+    }
+    capPolys->InsertNextCell( tubeNumberOfSides, &capPointIds[ 0 ] );
+    for ( int sideIndex = 0; sideIndex < tubeNumberOfSides; sideIndex++ )
+    {
+      capPointIds[ sideIndex ] = tubeNumberOfSides + sideIndex;
+    }
+    capPolys->InsertNextCell( tubeNumberOfSides, &capPointIds[ 0 ] );
+  }
+
+  vtkIdType numberOfSegments = numberOfRings - 1;
+  vtkSmartPointer< vtkIdTypeArray > stripOffsets = vtkSmartPointer< vtkIdTypeArray >::New();
+  stripOffsets->SetNumberOfValues( numberOfSegments + 1 );
+  stripOffsets->SetValue( 0, 0 );
+  vtkSmartPointer< vtkIdTypeArray > stripConnectivity = vtkSmartPointer< vtkIdTypeArray >::New();
+  stripConnectivity->SetNumberOfValues( numberOfSegments * 2 * ( tubeNumberOfSides + 1 ) );
+  vtkTubeStripWriter stripWriter;
+  stripWriter.FirstSegmentIndex = 0;
+  stripWriter.RingPointOffset = ringPointOffset;
+  stripWriter.NumberOfSides = tubeNumberOfSides;
+  stripWriter.Offsets = stripOffsets->GetPointer( 0 );
+  stripWriter.Connectivity = stripConnectivity->GetPointer( 0 );
+  vtkSMPTools::For( 0, numberOfSegments, RINGS_PER_PARALLEL_TASK, stripWriter );
+  vtkSmartPointer< vtkCellArray > sideStrips = vtkSmartPointer< vtkCellArray >::New();
+  sideStrips->SetData( stripOffsets, stripConnectivity );
+
+  outputTubePolyData->SetPoints( tubePoints );
+  outputTubePolyData->GetPointData()->SetNormals( tubeNormals );
+  outputTubePolyData->SetPolys( capPolys );
+  outputTubePolyData->SetStrips( sideStrips );
+  return true;
+}
+
+//------------------------------------------------------------------------------
+bool vtkSlicerMarkupsToModelTubeGeneration::UpdateTubeModel( vtkPoints* curvePoints, vtkIdType firstModifiedCurvePointIndex,
+  vtkPolyData* tubePolyData, double tubeRadius, int tubeNumberOfSides, bool tubeCapping )
+{
+  if ( curvePoints == NULL || tubePolyData == NULL )
+  {
+    return false;
+  }
+  if ( tubeNumberOfSides < MINIMUM_TUBE_NUMBER_OF_SIDES )
+  {
+    tubeNumberOfSides = MINIMUM_TUBE_NUMBER_OF_SIDES;
+  }
+
+  vtkIdType existingNumberOfRings = vtkSlicerMarkupsToModelTubeGeneration::GetNumberOfTubeRings( tubePolyData, tubeNumberOfSides, tubeCapping );
+  vtkIdType numberOfRings = curvePoints->GetNumberOfPoints();
+  if ( existingNumberOfRings < 2 || numberOfRings < existingNumberOfRings )
+  {
+    // removing rings would require removing cells, the tube has to be regenerated
+    return false;
+  }
+
+  // The direction of a ring depends on the neighboring curve points, so the ring before the first modified point changes too.
+  vtkIdType firstRingIndex = std::max< vtkIdType >( firstModifiedCurvePointIndex - 1, 0 );
+  firstRingIndex = std::min( firstRingIndex, existingNumberOfRings );
+
+  // The frame of the first updated ring continues from the previous ring,
+  // whose first vertex normal is the frame normal.
+  vtkIdType ringPointOffset = tubeCapping ? 2 * tubeNumberOfSides : 0;
+  vtkDataArray* tubeNormals = tubePolyData->GetPointData()->GetNormals();
+  double previousRingNormal[ 3 ] = { 0.0, 0.0, 0.0 };
+  double* initialNormal = NULL;
+  if ( firstRingIndex > 0 )
+  {
+    tubeNormals->GetTuple( ringPointOffset + ( firstRingIndex - 1 ) * tubeNumberOfSides, previousRingNormal );
+    initialNormal = previousRingNormal;
+  }
+
+  // SetNumberOfValues preserves existing values (unlike SetNumberOfTuples)
+  vtkIdType numberOfTubePoints = ringPointOffset + numberOfRings * tubeNumberOfSides;
+  vtkPoints* tubePoints = tubePolyData->GetPoints();
+  tubePoints->GetData()->SetNumberOfValues( 3 * numberOfTubePoints );
+  tubeNormals->SetNumberOfValues( 3 * numberOfTubePoints );
+  vtkSlicerMarkupsToModelTubeGeneration::ComputeRings( curvePoints, firstRingIndex, numberOfRings, initialNormal, 0.0,
+    tubePoints, tubeNormals, tubeRadius, tubeNumberOfSides, tubeCapping );
+
+  if ( numberOfRings > existingNumberOfRings )
+  {
+    vtkSlicerMarkupsToModelTubeGeneration::AppendStrips( tubePolyData->GetStrips(), existingNumberOfRings - 1, numberOfRings - 1,
+      tubeNumberOfSides, ringPointOffset );
+  }
+
+  tubePoints->Modified();
+  tubeNormals->Modified();
+  tubePolyData->Modified();
+  return true;
+}
+
+//------------------------------------------------------------------------------
+bool vtkSlicerMarkupsToModelTubeGeneration::UpdateTubeModelRange( vtkPoints* curvePoints,
+  vtkIdType firstModifiedCurvePointIndex, vtkIdType lastModifiedCurvePointIndex,
+  vtkPolyData* tubePolyData, double tubeRadius, int tubeNumberOfSides, bool tubeCapping )
+{
+  if ( curvePoints == NULL || tubePolyData == NULL )
+  {
+    return false;
+  }
+  if ( tubeNumberOfSides < MINIMUM_TUBE_NUMBER_OF_SIDES )
+  {
+    tubeNumberOfSides = MINIMUM_TUBE_NUMBER_OF_SIDES;
+  }
+
+  vtkIdType numberOfRings = curvePoints->GetNumberOfPoints();
+  if ( numberOfRings < 2
+    || vtkSlicerMarkupsToModelTubeGeneration::GetNumberOfTubeRings( tubePolyData, tubeNumberOfSides, tubeCapping ) != numberOfRings )
+  {
+    return false;
+  }
+  if ( firstModifiedCurvePointIndex > lastModifiedCurvePointIndex )
+  {
+    // nothing changed
+    return true;
+  }
+
+  // The tangent of a ring depends on the neighboring curve points, so the rings next to the modified range change too.
+  vtkIdType firstRingIndex = std::max< vtkIdType >( firstModifiedCurvePointIndex - 1, 0 );
+  vtkIdType endRingIndex = std::min< vtkIdType >( lastModifiedCurvePointIndex + 2, numberOfRings );
+
+  vtkIdType ringPointOffset = tubeCapping ? 2 * tubeNumberOfSides : 0;
+  vtkPoints* tubePoints = tubePolyData->GetPoints();
+  vtkDataArray* tubeNormals = tubePolyData->GetPointData()->GetNormals();
+  double initialNormal[ 3 ] = { 0.0, 0.0, 0.0 };
+  if ( firstRingIndex > 0 )
+  {
+    tubeNormals->GetTuple( ringPointOffset + ( firstRingIndex - 1 ) * tubeNumberOfSides, initialNormal );
+  }
+
+  // If there are unchanged rings after the range then the normal slid through the range generally does not
+  // match the normal of the next ring anymore. Measure the difference (rotation around the tangent)
+  // so that it can be spread along the recomputed rings instead of appearing as a sudden twist.
+  double twistAngle = 0.0;
+  if ( endRingIndex < numberOfRings )
+  {
+    std::vector< double > positions;
+    std::vector< double > tangents;
+    std::vector< double > normals;
+    ComputeFrames( curvePoints, firstRingIndex, endRingIndex + 1, firstRingIndex > 0 ? initialNormal : NULL, positions, tangents, normals );
+    const double* tangent = &tangents[ 3 * ( endRingIndex - firstRingIndex ) ];
+    const double* propagatedNormal = &normals[ 3 * ( endRingIndex - firstRingIndex ) ];
+    double existingNormal[ 3 ] = { 0.0, 0.0, 0.0 };
+    tubeNormals->GetTuple( ringPointOffset + endRingIndex * tubeNumberOfSides, existingNormal );
+    double normalsCross[ 3 ] = { 0.0, 0.0, 0.0 };
+    vtkMath::Cross( propagatedNormal, existingNormal, normalsCross );
+    twistAngle = atan2( vtkMath::Dot( normalsCross, tangent ), vtkMath::Dot( propagatedNormal, existingNormal ) );
+  }
+
+  vtkSlicerMarkupsToModelTubeGeneration::ComputeRings( curvePoints, firstRingIndex, endRingIndex,
+    firstRingIndex > 0 ? initialNormal : NULL, twistAngle, tubePoints, tubeNormals, tubeRadius, tubeNumberOfSides, tubeCapping );
+
+  tubePoints->Modified();
+  tubeNormals->Modified();
+  tubePolyData->Modified();
+  return true;
+}
+
+//------------------------------------------------------------------------------
+vtkIdType vtkSlicerMarkupsToModelTubeGeneration::GetNumberOfTubeRings( vtkPolyData* tubePolyData, int tubeNumberOfSides, bool tubeCapping )
+{
+  // rings are written directly into float arrays
+  if ( tubePolyData == NULL || tubePolyData->GetPoints() == NULL
+    || vtkFloatArray::SafeDownCast( tubePolyData->GetPoints()->GetData() ) == NULL
+    || vtkFloatArray::SafeDownCast( tubePolyData->GetPointData()->GetNormals() ) == NULL )
+  {
+    return -1;
+  }
+  if ( tubeNumberOfSides < MINIMUM_TUBE_NUMBER_OF_SIDES )
+  {
+    tubeNumberOfSides = MINIMUM_TUBE_NUMBER_OF_SIDES;
+  }
+
+  vtkIdType ringPointOffset = tubeCapping ? 2 * tubeNumberOfSides : 0;
+  vtkIdType numberOfRingPoints = tubePolyData->GetNumberOfPoints() - ringPointOffset;
+  if ( numberOfRingPoints < tubeNumberOfSides || numberOfRingPoints % tubeNumberOfSides != 0 )
+  {
+    return -1;
+  }
+  vtkIdType numberOfRings = numberOfRingPoints / tubeNumberOfSides;
+  vtkIdType expectedNumberOfCapPolys = tubeCapping ? 2 : 0;
+  if ( tubePolyData->GetNumberOfStrips() != numberOfRings - 1
+    || tubePolyData->GetNumberOfPolys() != expectedNumberOfCapPolys
+    || tubePolyData->GetNumberOfLines() != 0
+    || tubePolyData->GetPointData()->GetNormals()->GetNumberOfTuples() != tubePolyData->GetNumberOfPoints() )
+  {
+    return -1;
+  }
+  return numberOfRings;
+}
+
+//------------------------------------------------------------------------------
+void vtkSlicerMarkupsToModelTubeGeneration::ComputeRings( vtkPoints* curvePoints, vtkIdType firstRingIndex, vtkIdType endRingIndex,
+  const double* initialNormal, double twistAngle,
+  vtkPoints* tubePoints, vtkDataArray* tubeNormals, double tubeRadius, int tubeNumberOfSides, bool tubeCapping )
+{
+  vtkFloatArray* tubePointsArray = vtkFloatArray::SafeDownCast( tubePoints->GetData() );
+  vtkFloatArray* tubeNormalsArray = vtkFloatArray::SafeDownCast( tubeNormals );
+  if ( tubePointsArray == NULL || tubeNormalsArray == NULL )
+  {
+    vtkGenericWarningMacro( "Tube points and normals must be stored in float arrays. No rings generated." );
+    return;
+  }
+
+  vtkIdType numberOfRings = curvePoints->GetNumberOfPoints();
+  endRingIndex = std::min( endRingIndex, numberOfRings );
+  if ( endRingIndex <= firstRingIndex )
+  {
+    return;
+  }
+  vtkIdType ringPointOffset = tubeCapping ? 2 * tubeNumberOfSides : 0;
+
+  // Frames depend on each other, so they are computed in one sequential pass
+  std::vector< double > positions;
+  std::vector< double > tangents;
+  std::vector< double > normals;
+  ComputeFrames( curvePoints, firstRingIndex, endRingIndex, initialNormal, positions, tangents, normals );
+
+  // Rotate the rings around the curve by an increasing fraction of the twist angle
+  if ( twistAngle != 0.0 )
+  {
+    vtkIdType numberOfFrames = endRingIndex - firstRingIndex;
+    for ( vtkIdType frameIndex = 0; frameIndex < numberOfFrames; frameIndex++ )
+    {
+      double* tangent = &tangents[ 3 * frameIndex ];
+      double* normal = &normals[ 3 * frameIndex ];
+      double binormal[ 3 ] = { 0.0, 0.0, 0.0 };
+      vtkMath::Cross( tangent, normal, binormal );
+      double ringTwistAngle = twistAngle * ( frameIndex + 1 ) / ( numberOfFrames + 1 );
+      double cosTwist = cos( ringTwistAngle );
+      double sinTwist = sin( ringTwistAngle );
+      for ( int i = 0; i < 3; i++ )
+      {
+        normal[ i ] = cosTwist * normal[ i ] + sinTwist * binormal[ i ];
+      }
+    }
+  }
+
+  std::vector< double > sideCosines( tubeNumberOfSides );
+  std::vector< double > sideSines( tubeNumberOfSides );
+  for ( int sideIndex = 0; sideIndex < tubeNumberOfSides; sideIndex++ )
+  {
+    double sideAngle = 2.0 * vtkMath::Pi() * sideIndex / tubeNumberOfSides;
+    sideCosines[ sideIndex ] = cos( sideAngle );
+    sideSines[ sideIndex ] = sin( sideAngle );
+  }
+
+  vtkTubeRingWriter ringWriter;
+  ringWriter.Positions = &positions[ 0 ];
+  ringWriter.Tangents = &tangents[ 0 ];
+  ringWriter.Normals = &normals[ 0 ];
+  ringWriter.FirstRingIndex = firstRingIndex;
+  ringWriter.RingPointOffset = ringPointOffset;
+  ringWriter.NumberOfSides = tubeNumberOfSides;
+  ringWriter.Radius = tubeRadius;
+  ringWriter.SideCosines = &sideCosines[ 0 ];
+  ringWriter.SideSines = &sideSines[ 0 ];
+  ringWriter.TubePoints = tubePointsArray->GetPointer( 0 );
+  ringWriter.TubeNormals = tubeNormalsArray->GetPointer( 0 );
+  vtkSMPTools::For( firstRingIndex, endRingIndex, RINGS_PER_PARALLEL_TASK, ringWriter );
+
+  if ( !tubeCapping )
+  {
+    return;
+  }
+
+  // Cap vertices duplicate the first and last ring, with normals pointing along the curve
+  float* tubePointValues = tubePointsArray->GetPointer( 0 );
+  float* tubeNormalValues = tubeNormalsArray->GetPointer( 0 );
+  if ( firstRingIndex == 0 )
+  {
+    std::copy( tubePointValues + 3 * ringPointOffset, tubePointValues + 3 * ( ringPointOffset + tubeNumberOfSides ), tubePointValues );
+    const double* firstTangent = &tangents[ 0 ];
+    for ( int sideIndex = 0; sideIndex < tubeNumberOfSides; sideIndex++ )
+    {
+      for ( int i = 0; i < 3; i++ )
+      {
+        tubeNormalValues[ 3 * sideIndex + i ] = static_cast< float >( -firstTangent[ i ] );
+      }
+    }
+  }
+  if ( endRingIndex == numberOfRings )
+  {
+    vtkIdType lastRingStartPointIndex = ringPointOffset + ( numberOfRings - 1 ) * tubeNumberOfSides;
+    std::copy( tubePointValues + 3 * lastRingStartPointIndex, tubePointValues + 3 * ( lastRingStartPointIndex + tubeNumberOfSides ),
+      tubePointValues + 3 * tubeNumberOfSides );
+    const double* lastTangent = &tangents[ 3 * ( endRingIndex - firstRingIndex - 1 ) ];
+    for ( int sideIndex = 0; sideIndex < tubeNumberOfSides; sideIndex++ )
+    {
+      for ( int i = 0; i < 3; i++ )
+      {
+        tubeNormalValues[ 3 * ( tubeNumberOfSides + sideIndex ) + i ] = static_cast< float >( lastTangent[ i ] );
+      }
+    }
+  }
+}
+
+//------------------------------------------------------------------------------
+void vtkSlicerMarkupsToModelTubeGeneration::AppendStrips( vtkCellArray* strips, vtkIdType firstSegmentIndex, vtkIdType numberOfSegments,
+  int tubeNumberOfSides, vtkIdType ringPointOffset )
+{
+  for ( vtkIdType segmentIndex = firstSegmentIndex; segmentIndex < numberOfSegments; segmentIndex++ )
+  {
+    vtkIdType segmentStartPointIndex = ringPointOffset + segmentIndex * tubeNumberOfSides;
+    vtkIdType segmentEndPointIndex = segmentStartPointIndex + tubeNumberOfSides;
+    strips->InsertNextCell( 2 * ( tubeNumberOfSides + 1 ) );
+    for ( int sideIndex = 0; sideIndex <= tubeNumberOfSides; sideIndex++ )
+    {
+      int wrappedSideIndex = sideIndex % tubeNumberOfSides;
+      strips->InsertCellPoint( segmentEndPointIndex + wrappedSideIndex );
+      strips->InsertCellPoint( segmentStartPointIndex + wrappedSideIndex );
+    }
+  }
+}
+
+//------------------------------------------------------------------------------
+void vtkSlicerMarkupsToModelTubeGeneration::PrintSelf( ostream &os, vtkIndent indent )
+{
+  Superclass::PrintSelf( os, indent );
+}
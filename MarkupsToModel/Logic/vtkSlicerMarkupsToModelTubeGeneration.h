@@ -0,0 +1,76 @@
+#ifndef __vtkSlicerMarkupsToModelTubeGeneration_h
+#define __vtkSlicerMarkupsToModelTubeGeneration_h
+
+// vtk includes
+#include <vtkObject.h>
+#include <vtkPoints.h>
+#include <vtkPolyData.h>
+
+#include "vtkSlicerMarkupsToModelModuleLogicExport.h"
+
+// Generates a tube mesh around a polyline.
+//
+// The output is laid out ring by ring so that it can be updated incrementally:
+// - if capping is enabled, the first 2*numberOfSides points are the start cap and end cap vertices
+//   (duplicates of the first and last ring, with the cap normal),
+// - then there are numberOfSides points for each curve point (one ring per curve point),
+// - polys contain the two cap polygons (if capping is enabled),
+// - strips contain one triangle strip per curve segment, wrapping around the tube.
+// Cell connectivity only depends on the number of curve points, so rings can be
+// rewritten or appended without touching the existing cells.
+// Ring orientations follow rotation minimizing frames, so the tube does not twist around the curve.
+// Ring vertices and strip connectivity are written directly into the output arrays, in parallel for long curves.
+class VTK_SLICER_MARKUPSTOMODEL_MODULE_LOGIC_EXPORT vtkSlicerMarkupsToModelTubeGeneration : public vtkObject
+{
+  public:
+    // standard vtk object methods
+    vtkTypeMacro( vtkSlicerMarkupsToModelTubeGeneration, vtkObject );
+    void PrintSelf( ostream& os, vtkIndent indent ) override;
+    static vtkSlicerMarkupsToModelTubeGeneration *New();
+
+    // Generate a tube that passes through the curve points. Any previous content of outputTubePolyData is replaced.
+    // If outputTubePolyData already contains a tube with the same number of rings, sides and capping
+    // then its cells are kept and only the point coordinates and normals are overwritten.
+    static bool GenerateTubeModel( vtkPoints* curvePoints, vtkPolyData* outputTubePolyData,
+      double tubeRadius, int tubeNumberOfSides, bool tubeCapping );
+
+    // Update a tube previously created by GenerateTubeModel (with the same number of sides and capping)
+    // after the curve points starting at firstModifiedCurvePointIndex have changed or new points were appended.
+    // Rings before the modified range and all existing cells are kept.
+    // Returns false if the tube cannot be updated incrementally (the caller should then call GenerateTubeModel).
+    static bool UpdateTubeModel( vtkPoints* curvePoints, vtkIdType firstModifiedCurvePointIndex, vtkPolyData* tubePolyData,
+      double tubeRadius, int tubeNumberOfSides, bool tubeCapping );
+
+    // Update a tube previously created by GenerateTubeModel after the curve points in
+    // [firstModifiedCurvePointIndex, lastModifiedCurvePointIndex] have moved. The number of curve points must be unchanged.
+    // Only the rings around the modified range are recomputed. The rotation between the recomputed rings and the
+    // unchanged rings after them is spread along the recomputed range so that the tube does not twist suddenly.
+    // Returns false if the tube cannot be updated incrementally (the caller should then call GenerateTubeModel).
+    static bool UpdateTubeModelRange( vtkPoints* curvePoints, vtkIdType firstModifiedCurvePointIndex, vtkIdType lastModifiedCurvePointIndex,
+      vtkPolyData* tubePolyData, double tubeRadius, int tubeNumberOfSides, bool tubeCapping );
+
+    // Returns the number of curve points (rings) of a tube created by GenerateTubeModel, or -1 if the layout does not match.
+    static vtkIdType GetNumberOfTubeRings( vtkPolyData* tubePolyData, int tubeNumberOfSides, bool tubeCapping );
+
+  protected:
+    vtkSlicerMarkupsToModelTubeGeneration();
+    ~vtkSlicerMarkupsToModelTubeGeneration();
+
+  private:
+    // Compute the rings for curve points [firstRingIndex, endRingIndex) and write them into the tube.
+    // The frame of the first computed ring is propagated from initialNormal (or chosen arbitrarily if initialNormal is NULL).
+    // The rings are rotated around the curve by an increasing fraction of twistAngle, reaching the full angle after the last ring.
+    static void ComputeRings( vtkPoints* curvePoints, vtkIdType firstRingIndex, vtkIdType endRingIndex,
+      const double* initialNormal, double twistAngle,
+      vtkPoints* tubePoints, vtkDataArray* tubeNormals, double tubeRadius, int tubeNumberOfSides, bool tubeCapping );
+
+    // Append triangle strips for segments [firstSegmentIndex, numberOfSegments).
+    static void AppendStrips( vtkCellArray* strips, vtkIdType firstSegmentIndex, vtkIdType numberOfSegments,
+      int tubeNumberOfSides, vtkIdType ringPointOffset );
+
+    // not used
+    vtkSlicerMarkupsToModelTubeGeneration ( const vtkSlicerMarkupsToModelTubeGeneration& ) =delete;
+    void operator= ( const vtkSlicerMarkupsToModelTubeGeneration& ) =delete;
+};
+
+#endif
@@ -1,5 +1,6 @@
 // MarkupsToModel includes
 #include "vtkMRMLMarkupsToModelNode.h"
+#include "vtkMRMLMarkupsToModelTracer.h"
 
 // slicer includes
 #include "vtkMRMLModelDisplayNode.h"
@@ -15,6 +16,8 @@
 #include <vtkNew.h>
 
 // Other includes
+#include <algorithm>
+#include <cmath>
 #include <sstream>
 
 static const char* INPUT_ROLE = "InputMarkups";
@@ -22,6 +25,9 @@ static const char* OUTPUT_MODEL_ROLE = "OutputModel";
 
 static const char* OUTPUT_CURVE_LENGTH_ATTRIBUTE_NAME = "MarkupsToModel_OutputCurveLength";
 
+// Number of recent updates that the stage time statistics are computed from
+static const int STAGE_TIME_WINDOW_SIZE = 100;
+
 vtkMRMLNodeNewMacro(vtkMRMLMarkupsToModelNode);
 
 //-----------------------------------------------------------------
@@ -36,12 +42,19 @@ vtkMRMLMarkupsToModelNode::vtkMRMLMarkupsToModelNode()
   events->InsertNextValue(vtkMRMLMarkupsNode::PointRemovedEvent);
   events->InsertNextValue( vtkMRMLMarkupsNode::PointModifiedEvent );
   events->InsertNextValue( vtkMRMLModelNode::MeshModifiedEvent );
+  events->InsertNextValue( vtkMRMLMarkupsNode::PointStartInteractionEvent );
+  events->InsertNextValue( vtkMRMLMarkupsNode::PointEndInteractionEvent );
 
   this->AddNodeReferenceRole( INPUT_ROLE, NULL, events.GetPointer() );
-  this->AddNodeReferenceRole( OUTPUT_MODEL_ROLE );
+  vtkNew<vtkIntArray> outputModelEvents;
+  outputModelEvents->InsertNextValue( vtkMRMLDisplayableNode::DisplayModifiedEvent );
+  this->AddNodeReferenceRole( OUTPUT_MODEL_ROLE, NULL, outputModelEvents.GetPointer() );
 
   this->AutoUpdateOutput = true;
+  this->AsynchronousUpdate = false;
+  this->DeferHiddenOutputUpdate = false;
   this->CleanMarkups = true;
+  this->DuplicatePointTolerance = 0.01;
   this->ConvexHull = true;
   this->ButterflySubdivision = true;
   // DelaunayAlpha = 50 would work well most of the cases but in case if not then the user would not
@@ -50,6 +63,11 @@ vtkMRMLMarkupsToModelNode::vtkMRMLMarkupsToModelNode()
   this->DelaunayAlpha = 0.0;
   this->TubeRadius = 1.0;
   this->TubeSegmentsBetweenControlPoints = 5;
+  this->CurveSamplingMode = vtkMRMLMarkupsToModelNode::UniformSampling;
+  this->SamplingAngleTolerance = 5.0;
+  this->SamplingChordTolerance = 0.1;
+  this->MinimumSamplesPerSegment = 1;
+  this->MaximumSamplesPerSegment = 20;
   this->TubeNumberOfSides = 8;
   this->TubeLoop = false;
   this->TubeCapping = true;
@@ -67,6 +85,13 @@ vtkMRMLMarkupsToModelNode::vtkMRMLMarkupsToModelNode()
   this->PolynomialFitType = vtkMRMLMarkupsToModelNode::GlobalLeastSquares;
   this->PolynomialSampleWidth = 0.5;
   this->PolynomialWeightType = vtkMRMLMarkupsToModelNode::Gaussian;
+
+  this->InteractionLevelOfDetail = true;
+  this->InteractionTubeNumberOfSides = 4;
+  this->InteractionTubeSegmentsBetweenControlPoints = 2;
+  this->Interacting = false;
+
+  this->ResetStageTimes();
 }
 
 //-----------------------------------------------------------------
@@ -81,7 +106,10 @@ void vtkMRMLMarkupsToModelNode::WriteXML( ostream& of, int nIndent )
   vtkMRMLWriteXMLBeginMacro(of);
   vtkMRMLWriteXMLEnumMacro(ModelType, ModelType);
   vtkMRMLWriteXMLBooleanMacro(AutoUpdateOutput, AutoUpdateOutput);
+  vtkMRMLWriteXMLBooleanMacro(AsynchronousUpdate, AsynchronousUpdate);
+  vtkMRMLWriteXMLBooleanMacro(DeferHiddenOutputUpdate, DeferHiddenOutputUpdate);
   vtkMRMLWriteXMLBooleanMacro(CleanMarkups, CleanMarkups);
+  vtkMRMLWriteXMLFloatMacro(DuplicatePointTolerance, DuplicatePointTolerance);
   vtkMRMLWriteXMLBooleanMacro(ConvexHull, ConvexHull);
   vtkMRMLWriteXMLBooleanMacro(ButterflySubdivision, ButterflySubdivision);
   vtkMRMLWriteXMLFloatMacro(DelaunayAlpha, DelaunayAlpha);
@@ -90,6 +118,11 @@ void vtkMRMLMarkupsToModelNode::WriteXML( ostream& of, int nIndent )
   vtkMRMLWriteXMLFloatMacro(TubeRadius, TubeRadius);
   vtkMRMLWriteXMLIntMacro(TubeNumberOfSides, TubeNumberOfSides);
   vtkMRMLWriteXMLIntMacro(TubeSegmentsBetweenControlPoints, TubeSegmentsBetweenControlPoints);
+  vtkMRMLWriteXMLEnumMacro(CurveSamplingMode, CurveSamplingMode);
+  vtkMRMLWriteXMLFloatMacro(SamplingAngleTolerance, SamplingAngleTolerance);
+  vtkMRMLWriteXMLFloatMacro(SamplingChordTolerance, SamplingChordTolerance);
+  vtkMRMLWriteXMLIntMacro(MinimumSamplesPerSegment, MinimumSamplesPerSegment);
+  vtkMRMLWriteXMLIntMacro(MaximumSamplesPerSegment, MaximumSamplesPerSegment);
   vtkMRMLWriteXMLBooleanMacro(TubeLoop, TubeLoop);
   vtkMRMLWriteXMLBooleanMacro(TubeCapping, TubeCapping);
   vtkMRMLWriteXMLBooleanMacro(KochanekEndsCopyNearestDerivatives, KochanekEndsCopyNearestDerivatives);
@@ -100,6 +133,9 @@ void vtkMRMLMarkupsToModelNode::WriteXML( ostream& of, int nIndent )
   vtkMRMLWriteXMLEnumMacro(PolynomialFitType, PolynomialFitType);
   vtkMRMLWriteXMLFloatMacro(PolynomialSampleWidth, PolynomialSampleWidth);
   vtkMRMLWriteXMLEnumMacro(PolynomialWeightType, PolynomialWeightType);
+  vtkMRMLWriteXMLBooleanMacro(InteractionLevelOfDetail, InteractionLevelOfDetail);
+  vtkMRMLWriteXMLIntMacro(InteractionTubeNumberOfSides, InteractionTubeNumberOfSides);
+  vtkMRMLWriteXMLIntMacro(InteractionTubeSegmentsBetweenControlPoints, InteractionTubeSegmentsBetweenControlPoints);
   vtkMRMLWriteXMLEndMacro();
 }
 
@@ -111,7 +147,10 @@ void vtkMRMLMarkupsToModelNode::ReadXMLAttributes( const char** atts )
   vtkMRMLReadXMLBeginMacro(atts);
   vtkMRMLReadXMLEnumMacro(ModelType, ModelType);
   vtkMRMLReadXMLBooleanMacro(AutoUpdateOutput, AutoUpdateOutput);
+  vtkMRMLReadXMLBooleanMacro(AsynchronousUpdate, AsynchronousUpdate);
+  vtkMRMLReadXMLBooleanMacro(DeferHiddenOutputUpdate, DeferHiddenOutputUpdate);
   vtkMRMLReadXMLBooleanMacro(CleanMarkups, CleanMarkups);
+  vtkMRMLReadXMLFloatMacro(DuplicatePointTolerance, DuplicatePointTolerance);
   vtkMRMLReadXMLBooleanMacro(ConvexHull, ConvexHull);
   vtkMRMLReadXMLBooleanMacro(ButterflySubdivision, ButterflySubdivision);
   vtkMRMLReadXMLFloatMacro(DelaunayAlpha, DelaunayAlpha);
@@ -121,6 +160,11 @@ void vtkMRMLMarkupsToModelNode::ReadXMLAttributes( const char** atts )
   vtkMRMLReadXMLFloatMacro(TubeRadius, TubeRadius);
   vtkMRMLReadXMLIntMacro(TubeNumberOfSides, TubeNumberOfSides);
   vtkMRMLReadXMLIntMacro(TubeSegmentsBetweenControlPoints, TubeSegmentsBetweenControlPoints);
+  vtkMRMLReadXMLEnumMacro(CurveSamplingMode, CurveSamplingMode);
+  vtkMRMLReadXMLFloatMacro(SamplingAngleTolerance, SamplingAngleTolerance);
+  vtkMRMLReadXMLFloatMacro(SamplingChordTolerance, SamplingChordTolerance);
+  vtkMRMLReadXMLIntMacro(MinimumSamplesPerSegment, MinimumSamplesPerSegment);
+  vtkMRMLReadXMLIntMacro(MaximumSamplesPerSegment, MaximumSamplesPerSegment);
   vtkMRMLReadXMLBooleanMacro(TubeLoop, TubeLoop);
   vtkMRMLReadXMLBooleanMacro(TubeCapping, TubeCapping);
   vtkMRMLReadXMLBooleanMacro(KochanekEndsCopyNearestDerivatives, KochanekEndsCopyNearestDerivatives);
@@ -131,6 +175,9 @@ void vtkMRMLMarkupsToModelNode::ReadXMLAttributes( const char** atts )
   vtkMRMLReadXMLEnumMacro(PolynomialFitType, PolynomialFitType);
   vtkMRMLReadXMLFloatMacro(PolynomialSampleWidth, PolynomialSampleWidth);
   vtkMRMLReadXMLEnumMacro(PolynomialWeightType, PolynomialWeightType);
+  vtkMRMLReadXMLBooleanMacro(InteractionLevelOfDetail, InteractionLevelOfDetail);
+  vtkMRMLReadXMLIntMacro(InteractionTubeNumberOfSides, InteractionTubeNumberOfSides);
+  vtkMRMLReadXMLIntMacro(InteractionTubeSegmentsBetweenControlPoints, InteractionTubeSegmentsBetweenControlPoints);
   vtkMRMLReadXMLEndMacro();
   this->EndModify( disabledModify );
 }
@@ -143,7 +190,10 @@ void vtkMRMLMarkupsToModelNode::Copy( vtkMRMLNode *anode )
   vtkMRMLCopyBeginMacro(anode);
   vtkMRMLCopyEnumMacro(ModelType);
   vtkMRMLCopyBooleanMacro(AutoUpdateOutput);
+  vtkMRMLCopyBooleanMacro(AsynchronousUpdate);
+  vtkMRMLCopyBooleanMacro(DeferHiddenOutputUpdate);
   vtkMRMLCopyBooleanMacro(CleanMarkups);
+  vtkMRMLCopyFloatMacro(DuplicatePointTolerance);
   vtkMRMLCopyBooleanMacro(ConvexHull);
   vtkMRMLCopyBooleanMacro(ButterflySubdivision);
   vtkMRMLCopyFloatMacro(DelaunayAlpha);
@@ -152,6 +202,11 @@ void vtkMRMLMarkupsToModelNode::Copy( vtkMRMLNode *anode )
   vtkMRMLCopyFloatMacro(TubeRadius);
   vtkMRMLCopyIntMacro(TubeNumberOfSides);
   vtkMRMLCopyIntMacro(TubeSegmentsBetweenControlPoints);
+  vtkMRMLCopyEnumMacro(CurveSamplingMode);
+  vtkMRMLCopyFloatMacro(SamplingAngleTolerance);
+  vtkMRMLCopyFloatMacro(SamplingChordTolerance);
+  vtkMRMLCopyIntMacro(MinimumSamplesPerSegment);
+  vtkMRMLCopyIntMacro(MaximumSamplesPerSegment);
   vtkMRMLCopyBooleanMacro(TubeLoop);
   vtkMRMLCopyBooleanMacro(TubeCapping);
   vtkMRMLCopyBooleanMacro(KochanekEndsCopyNearestDerivatives);
@@ -162,6 +217,9 @@ void vtkMRMLMarkupsToModelNode::Copy( vtkMRMLNode *anode )
   vtkMRMLCopyEnumMacro(PolynomialFitType);
   vtkMRMLCopyFloatMacro(PolynomialSampleWidth);
   vtkMRMLCopyEnumMacro(PolynomialWeightType);
+  vtkMRMLCopyBooleanMacro(InteractionLevelOfDetail);
+  vtkMRMLCopyIntMacro(InteractionTubeNumberOfSides);
+  vtkMRMLCopyIntMacro(InteractionTubeSegmentsBetweenControlPoints);
   vtkMRMLCopyEndMacro();
   this->EndModify(disabledModify);
 }
@@ -173,7 +231,10 @@ void vtkMRMLMarkupsToModelNode::PrintSelf( ostream& os, vtkIndent indent )
   vtkMRMLPrintBeginMacro(os, indent);
   vtkMRMLPrintEnumMacro(ModelType);
   vtkMRMLPrintBooleanMacro(AutoUpdateOutput);
+  vtkMRMLPrintBooleanMacro(AsynchronousUpdate);
+  vtkMRMLPrintBooleanMacro(DeferHiddenOutputUpdate);
   vtkMRMLPrintBooleanMacro(CleanMarkups);
+  vtkMRMLPrintFloatMacro(DuplicatePointTolerance);
   vtkMRMLPrintBooleanMacro(ConvexHull);
   vtkMRMLPrintBooleanMacro(ButterflySubdivision);
   vtkMRMLPrintFloatMacro(DelaunayAlpha);
@@ -182,6 +243,11 @@ void vtkMRMLMarkupsToModelNode::PrintSelf( ostream& os, vtkIndent indent )
   vtkMRMLPrintFloatMacro(TubeRadius);
   vtkMRMLPrintIntMacro(TubeNumberOfSides);
   vtkMRMLPrintIntMacro(TubeSegmentsBetweenControlPoints);
+  vtkMRMLPrintEnumMacro(CurveSamplingMode);
+  vtkMRMLPrintFloatMacro(SamplingAngleTolerance);
+  vtkMRMLPrintFloatMacro(SamplingChordTolerance);
+  vtkMRMLPrintIntMacro(MinimumSamplesPerSegment);
+  vtkMRMLPrintIntMacro(MaximumSamplesPerSegment);
   vtkMRMLPrintBooleanMacro(TubeLoop);
   vtkMRMLPrintBooleanMacro(TubeCapping);
   vtkMRMLPrintBooleanMacro(KochanekEndsCopyNearestDerivatives);
@@ -192,7 +258,19 @@ void vtkMRMLMarkupsToModelNode::PrintSelf( ostream& os, vtkIndent indent )
   vtkMRMLPrintEnumMacro(PolynomialFitType);
   vtkMRMLPrintFloatMacro(PolynomialSampleWidth);
   vtkMRMLPrintEnumMacro(PolynomialWeightType);
+  vtkMRMLPrintBooleanMacro(InteractionLevelOfDetail);
+  vtkMRMLPrintIntMacro(InteractionTubeNumberOfSides);
+  vtkMRMLPrintIntMacro(InteractionTubeSegmentsBetweenControlPoints);
+  vtkMRMLPrintBooleanMacro(Interacting);
   vtkMRMLPrintEndMacro();
+  os << indent << "StageTimes (last / min / mean / 95th percentile, in ms):" << std::endl;
+  for ( int stage = 0; stage < TimedStage_Last; stage++ )
+  {
+    os << indent.GetNextIndent() << GetTimedStageAsString( stage ) << ": "
+      << this->GetLastStageTime( stage ) * 1000.0 << " / " << this->GetMinimumStageTime( stage ) * 1000.0 << " / "
+      << this->GetMeanStageTime( stage ) * 1000.0 << " / " << this->GetStageTimePercentile( stage, 95.0 ) * 1000.0
+      << " (" << this->GetNumberOfStageTimeSamples( stage ) << " samples)" << std::endl;
+  }
 }
 
 //-----------------------------------------------------------------
@@ -267,14 +345,213 @@ void vtkMRMLMarkupsToModelNode::SetOutputCurveLength( double curveLength )
 }
 
 //-----------------------------------------------------------------
-void vtkMRMLMarkupsToModelNode::ProcessMRMLEvents( vtkObject *caller, unsigned long /*event*/, void* /*callData*/ )
+double vtkMRMLMarkupsToModelNode::GetLastStageTime( int stage )
+{
+  if ( stage < 0 || stage >= TimedStage_Last )
+  {
+    vtkErrorMacro( "GetLastStageTime: invalid stage " << stage );
+    return 0.0;
+  }
+  return this->LastStageTimes[ stage ];
+}
+
+//-----------------------------------------------------------------
+double vtkMRMLMarkupsToModelNode::GetMinimumStageTime( int stage )
+{
+  if ( stage < 0 || stage >= TimedStage_Last )
+  {
+    vtkErrorMacro( "GetMinimumStageTime: invalid stage " << stage );
+    return 0.0;
+  }
+  const std::vector< double >& samples = this->StageTimeSamples[ stage ];
+  if ( samples.empty() )
+  {
+    return 0.0;
+  }
+  return *std::min_element( samples.begin(), samples.end() );
+}
+
+//-----------------------------------------------------------------
+double vtkMRMLMarkupsToModelNode::GetMeanStageTime( int stage )
+{
+  if ( stage < 0 || stage >= TimedStage_Last )
+  {
+    vtkErrorMacro( "GetMeanStageTime: invalid stage " << stage );
+    return 0.0;
+  }
+  const std::vector< double >& samples = this->StageTimeSamples[ stage ];
+  if ( samples.empty() )
+  {
+    return 0.0;
+  }
+  double sum = 0.0;
+  for ( std::vector< double >::const_iterator sampleIt = samples.begin(); sampleIt != samples.end(); ++sampleIt )
+  {
+    sum += *sampleIt;
+  }
+  return sum / samples.size();
+}
+
+//-----------------------------------------------------------------
+double vtkMRMLMarkupsToModelNode::GetStageTimePercentile( int stage, double percentile )
+{
+  if ( stage < 0 || stage >= TimedStage_Last )
+  {
+    vtkErrorMacro( "GetStageTimePercentile: invalid stage " << stage );
+    return 0.0;
+  }
+  if ( this->StageTimeSamples[ stage ].empty() )
+  {
+    return 0.0;
+  }
+  // nearest-rank method, on a copy so that the order of the circular buffer is kept
+  std::vector< double > samples = this->StageTimeSamples[ stage ];
+  percentile = std::min( std::max( percentile, 0.0 ), 100.0 );
+  size_t rank = static_cast< size_t >( std::ceil( percentile / 100.0 * samples.size() ) );
+  size_t sampleIndex = ( rank > 0 ? rank - 1 : 0 );
+  std::nth_element( samples.begin(), samples.begin() + sampleIndex, samples.end() );
+  return samples[ sampleIndex ];
+}
+
+//-----------------------------------------------------------------
+int vtkMRMLMarkupsToModelNode::GetNumberOfStageTimeSamples( int stage )
+{
+  if ( stage < 0 || stage >= TimedStage_Last )
+  {
+    vtkErrorMacro( "GetNumberOfStageTimeSamples: invalid stage " << stage );
+    return 0;
+  }
+  return static_cast< int >( this->StageTimeSamples[ stage ].size() );
+}
+
+//-----------------------------------------------------------------
+void vtkMRMLMarkupsToModelNode::ResetStageTimes()
+{
+  for ( int stage = 0; stage < TimedStage_Last; stage++ )
+  {
+    this->LastStageTimes[ stage ] = 0.0;
+    this->StageTimeSamples[ stage ].clear();
+    this->NextStageTimeSampleIndex[ stage ] = 0;
+  }
+}
+
+//-----------------------------------------------------------------
+void vtkMRMLMarkupsToModelNode::AddStageTimes( const double stageTimes[ TimedStage_Last ] )
+{
+  // Called after every output update, so it must be cheap: no events are invoked and no memory is allocated
+  // once the buffers are full. The statistics are computed when they are requested.
+  for ( int stage = 0; stage < TimedStage_Last; stage++ )
+  {
+    if ( stageTimes[ stage ] < 0.0 )
+    {
+      this->LastStageTimes[ stage ] = 0.0;
+      continue;
+    }
+    this->LastStageTimes[ stage ] = stageTimes[ stage ];
+    std::vector< double >& samples = this->StageTimeSamples[ stage ];
+    if ( static_cast< int >( samples.size() ) < STAGE_TIME_WINDOW_SIZE )
+    {
+      samples.push_back( stageTimes[ stage ] );
+    }
+    else
+    {
+      samples[ this->NextStageTimeSampleIndex[ stage ] ] = stageTimes[ stage ];
+    }
+    this->NextStageTimeSampleIndex[ stage ] = ( this->NextStageTimeSampleIndex[ stage ] + 1 ) % STAGE_TIME_WINDOW_SIZE;
+  }
+}
+
+//-----------------------------------------------------------------
+int vtkMRMLMarkupsToModelNode::GetFirstModifiedPipelineStage( vtkMTimeType time )
+{
+  for ( int stage = 0; stage < PipelineStage_Last; stage++ )
+  {
+    if ( this->PipelineStageModifiedTimes[ stage ].GetMTime() > time )
+    {
+      return stage;
+    }
+  }
+  return PipelineStage_Last;
+}
+
+//-----------------------------------------------------------------
+void vtkMRMLMarkupsToModelNode::SetInteractionLevelOfDetail( bool interactionLevelOfDetail )
+{
+  if ( this->InteractionLevelOfDetail == interactionLevelOfDetail )
+  {
+    return;
+  }
+  this->InteractionLevelOfDetail = interactionLevelOfDetail;
+  // the level of detail is only reduced during interaction
+  if ( this->Interacting )
+  {
+    this->PipelineStageModified( FitStage );
+  }
+  this->Modified();
+}
+
+//-----------------------------------------------------------------
+void vtkMRMLMarkupsToModelNode::SetInteracting( bool interacting )
+{
+  if ( this->Interacting == interacting )
+  {
+    return;
+  }
+  this->Interacting = interacting;
+  // the curve sampling and surface subdivision only change if the level of detail is reduced during interaction
+  if ( this->InteractionLevelOfDetail )
+  {
+    this->PipelineStageModified( FitStage );
+  }
+  this->Modified();
+}
+
+//-----------------------------------------------------------------
+void vtkMRMLMarkupsToModelNode::PipelineStageModified( int stage )
+{
+  if ( stage < 0 || stage >= PipelineStage_Last )
+  {
+    vtkErrorMacro( "PipelineStageModified: invalid stage " << stage );
+    return;
+  }
+  this->PipelineStageModifiedTimes[ stage ].Modified();
+}
+
+//-----------------------------------------------------------------
+void vtkMRMLMarkupsToModelNode::ProcessMRMLEvents( vtkObject *caller, unsigned long event, void* callData )
 {
+  MARKUPSTOMODEL_TRACE_SCOPE( "Node::ProcessMRMLEvents", "mrml" );
   vtkMRMLNode* callerNode = vtkMRMLNode::SafeDownCast( caller );
   if ( callerNode == NULL ) return;
 
+  if ( this->GetOutputModelNode() && this->GetOutputModelNode()==caller
+    && event == vtkMRMLDisplayableNode::DisplayModifiedEvent )
+  {
+    this->InvokeCustomModifiedEvent( OutputModelDisplayModifiedEvent );
+    return;
+  }
+
   if ( this->GetInputNode() && this->GetInputNode()==caller )
   {
-    this->InvokeCustomModifiedEvent(MarkupsPositionModifiedEvent);
+    if ( event == vtkMRMLMarkupsNode::PointStartInteractionEvent )
+    {
+      this->SetInteracting( true );
+      return;
+    }
+    else if ( event == vtkMRMLMarkupsNode::PointEndInteractionEvent )
+    {
+      this->SetInteracting( false );
+      return;
+    }
+    // pass on the index of the modified point so that observers can update only the affected part of the output
+    if ( event == vtkMRMLMarkupsNode::PointModifiedEvent && callData != NULL )
+    {
+      this->InvokeCustomModifiedEvent( MarkupsPositionModifiedEvent, callData );
+    }
+    else
+    {
+      this->InvokeCustomModifiedEvent( MarkupsPositionModifiedEvent );
+    }
   }
 }
 
@@ -297,6 +574,25 @@ const char* vtkMRMLMarkupsToModelNode::GetModelTypeAsString( int id )
   }
 }
 
+//------------------------------------------------------------------------------
+const char* vtkMRMLMarkupsToModelNode::GetTimedStageAsString( int stage )
+{
+  switch ( stage )
+  {
+  case MarkupsToPointsTimedStage: return "markupsToPoints";
+  case RemoveDuplicatePointsTimedStage: return "removeDuplicatePoints";
+  case CurveGenerationTimedStage: return "curveGeneration";
+  case TubeGenerationTimedStage: return "tubeGeneration";
+  case TriangulationTimedStage: return "triangulation";
+  case SubdivisionTimedStage: return "subdivision";
+  case NormalsTimedStage: return "normals";
+  case AssignOutputTimedStage: return "assignOutput";
+  default:
+    // invalid stage
+    return "";
+  }
+}
+
 //------------------------------------------------------------------------------
 const char* vtkMRMLMarkupsToModelNode::GetCurveTypeAsString( int id )
 {
@@ -312,6 +608,19 @@ const char* vtkMRMLMarkupsToModelNode::GetCurveTypeAsString( int id )
   }
 }
 
+//------------------------------------------------------------------------------
+const char* vtkMRMLMarkupsToModelNode::GetCurveSamplingModeAsString( int id )
+{
+  switch ( id )
+  {
+  case UniformSampling: return "uniform";
+  case AdaptiveSampling: return "adaptive";
+  default:
+    // invalid id
+    return "";
+  }
+}
+
 //------------------------------------------------------------------------------
 const char* vtkMRMLMarkupsToModelNode::GetPointParameterTypeAsString( int id )
 {
@@ -393,6 +702,26 @@ int vtkMRMLMarkupsToModelNode::GetCurveTypeFromString( const char* name )
   return -1;
 }
 
+//------------------------------------------------------------------------------
+int vtkMRMLMarkupsToModelNode::GetCurveSamplingModeFromString( const char* name )
+{
+  if ( name == NULL )
+  {
+    // invalid name
+    return -1;
+  }
+  for ( int i = 0; i < CurveSamplingMode_Last; i++ )
+  {
+    if ( strcmp( name, GetCurveSamplingModeAsString( i ) ) == 0 )
+    {
+      // found a matching name
+      return i;
+    }
+  }
+  // unknown name
+  return -1;
+}
+
 //------------------------------------------------------------------------------
 int vtkMRMLMarkupsToModelNode::GetPointParameterTypeFromString( const char* name )
 {
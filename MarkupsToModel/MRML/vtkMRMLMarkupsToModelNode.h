@@ -18,12 +18,14 @@
 // std includes
 #include <iostream>
 #include <list>
+#include <vector>
 
 // vtk includes
 #include <vtkCommand.h>
 #include <vtkObject.h>
 #include <vtkObjectBase.h>
 #include <vtkObjectFactory.h>
+#include <vtkTimeStamp.h>
 
 // Slicer includes
 #include "vtkMRMLNode.h"
@@ -56,6 +58,30 @@ struct MarkupsTool{
   }
 };
 
+// Set macros for parameters that are used for generating the model. In addition to setting the value (as vtkSetMacro
+// and vtkSetClampMacro), they mark the pipeline stage that uses the parameter as modified (see GetFirstModifiedPipelineStage).
+#define vtkMRMLMarkupsToModelSetStageMacro(name, type, stage) \
+  virtual void Set##name( type _arg ) \
+  { \
+    if ( this->name != _arg ) \
+    { \
+      this->name = _arg; \
+      this->PipelineStageModified( stage ); \
+      this->Modified(); \
+    } \
+  }
+#define vtkMRMLMarkupsToModelSetClampStageMacro(name, type, min, max, stage) \
+  virtual void Set##name( type _arg ) \
+  { \
+    type clampedValue = ( _arg < min ? min : ( _arg > max ? max : _arg ) ); \
+    if ( this->name != clampedValue ) \
+    { \
+      this->name = clampedValue; \
+      this->PipelineStageModified( stage ); \
+      this->Modified(); \
+    } \
+  }
+
 class
 VTK_SLICER_MARKUPSTOMODEL_MODULE_MRML_EXPORT
 vtkMRMLMarkupsToModelNode
@@ -67,8 +93,11 @@ public:
   {
     /// MarkupsPositionModifiedEvent is called when markup point positions are modified.
     /// This make it easier for logic or other classes to observe any changes in input data.
+    /// If a single markup point was modified then callData is a pointer to its index (int*), otherwise it is NULL.
     // vtkCommand::UserEvent + 777 is just a random value that is very unlikely to be used for anything else in this class
-    MarkupsPositionModifiedEvent = vtkCommand::UserEvent + 777
+    MarkupsPositionModifiedEvent = vtkCommand::UserEvent + 777,
+    /// OutputModelDisplayModifiedEvent is called when a display node of the output model is modified (e.g., shown or hidden).
+    OutputModelDisplayModifiedEvent = vtkCommand::UserEvent + 778
   };
 
   enum ModelType
@@ -87,6 +116,13 @@ public:
     CurveType_Last // insert valid types above this line
   };
 
+  enum CurveSamplingMode
+  {
+    UniformSampling = 0, // TubeSegmentsBetweenControlPoints samples in each segment
+    AdaptiveSampling, // samples are placed where the curve bends, according to the sampling tolerances
+    CurveSamplingMode_Last // insert valid types above this line
+  };
+
   enum PointParameterType
   {
     RawIndices = 0,
@@ -110,6 +146,30 @@ public:
     PolynomialWeightType_Last // insert valid types above this line
   };
 
+  // Stages of generating the model, in the order they are performed.
+  // If a parameter is modified then the stage that uses it and all later stages have to be performed again.
+  enum PipelineStage
+  {
+    PointsStage = 0, // extracting and cleaning the input points
+    FitStage, // evaluating and sampling the curve, or triangulating the surface
+    ModelStage, // generating the tube, or subdividing the surface and computing normals
+    PipelineStage_Last // insert valid types above this line
+  };
+
+  // Steps of updating the output whose duration is measured (see GetLastStageTime)
+  enum TimedStage
+  {
+    MarkupsToPointsTimedStage = 0, // getting the input points
+    RemoveDuplicatePointsTimedStage,
+    CurveGenerationTimedStage, // evaluating and sampling the curve
+    TubeGenerationTimedStage,
+    TriangulationTimedStage, // convex hull or Delaunay triangulation
+    SubdivisionTimedStage,
+    NormalsTimedStage,
+    AssignOutputTimedStage, // setting the model in the output node (includes rendering updates of observers)
+    TimedStage_Last // insert valid types above this line
+  };
+
   vtkTypeMacro( vtkMRMLMarkupsToModelNode, vtkMRMLNode );
 
   // Standard MRML node methods
@@ -123,58 +183,121 @@ public:
   virtual void Copy( vtkMRMLNode *node ) override;
 
   vtkGetMacro( KochanekTension, double );
-  vtkSetClampMacro( KochanekTension, double, -1.0, 1.0 );
+  vtkMRMLMarkupsToModelSetClampStageMacro( KochanekTension, double, -1.0, 1.0, FitStage );
   vtkGetMacro( KochanekBias, double );
-  vtkSetClampMacro(KochanekBias, double, -1.0, 1.0);
+  vtkMRMLMarkupsToModelSetClampStageMacro( KochanekBias, double, -1.0, 1.0, FitStage );
   vtkGetMacro( KochanekContinuity, double );
-  vtkSetClampMacro(KochanekContinuity, double, -1.0, 1.0);
+  vtkMRMLMarkupsToModelSetClampStageMacro( KochanekContinuity, double, -1.0, 1.0, FitStage );
 
   vtkGetMacro( PolynomialOrder, int );
-  vtkSetClampMacro( PolynomialOrder, int, 1, VTK_INT_MAX );
+  vtkMRMLMarkupsToModelSetClampStageMacro( PolynomialOrder, int, 1, VTK_INT_MAX, FitStage );
   vtkGetMacro( PolynomialFitType, int );
-  vtkSetClampMacro(PolynomialFitType, int, 0, PolynomialFitType_Last-1);
+  vtkMRMLMarkupsToModelSetClampStageMacro( PolynomialFitType, int, 0, PolynomialFitType_Last-1, FitStage );
   vtkGetMacro( PolynomialSampleWidth, double );
-  vtkSetClampMacro(PolynomialSampleWidth, double, 0.0, 1.0);
+  vtkMRMLMarkupsToModelSetClampStageMacro( PolynomialSampleWidth, double, 0.0, 1.0, FitStage );
   vtkGetMacro( PolynomialWeightType, int );
-  vtkSetClampMacro(PolynomialWeightType, int, 0, PolynomialWeightType_Last-1);
+  vtkMRMLMarkupsToModelSetClampStageMacro( PolynomialWeightType, int, 0, PolynomialWeightType_Last-1, FitStage );
 
   vtkGetMacro( ModelType, int );
-  vtkSetClampMacro(ModelType, int, 0, ModelType_Last-1);
+  vtkMRMLMarkupsToModelSetClampStageMacro( ModelType, int, 0, ModelType_Last-1, PointsStage );
   vtkGetMacro( CurveType, int );
-  vtkSetClampMacro(CurveType, int, 0, CurveType_Last-1);
+  vtkMRMLMarkupsToModelSetClampStageMacro( CurveType, int, 0, CurveType_Last-1, FitStage );
   vtkGetMacro( PointParameterType, int );
-  vtkSetClampMacro(PointParameterType, int, 0, PointParameterType_Last-1);
+  vtkMRMLMarkupsToModelSetClampStageMacro( PointParameterType, int, 0, PointParameterType_Last-1, FitStage );
   vtkGetMacro( TubeRadius, double );
-  vtkSetMacro( TubeRadius, double );
+  vtkMRMLMarkupsToModelSetStageMacro( TubeRadius, double, ModelStage );
   vtkGetMacro( TubeSegmentsBetweenControlPoints, int );
-  vtkSetMacro( TubeSegmentsBetweenControlPoints, int );
+  vtkMRMLMarkupsToModelSetStageMacro( TubeSegmentsBetweenControlPoints, int, FitStage );
+  vtkGetMacro( CurveSamplingMode, int );
+  vtkMRMLMarkupsToModelSetClampStageMacro( CurveSamplingMode, int, 0, CurveSamplingMode_Last-1, FitStage );
+  // Maximum change of curve direction between consecutive samples in adaptive sampling mode (in degrees)
+  vtkGetMacro( SamplingAngleTolerance, double );
+  vtkMRMLMarkupsToModelSetClampStageMacro( SamplingAngleTolerance, double, 0.01, 180.0, FitStage );
+  // Maximum distance between the curve and the line between consecutive samples in adaptive sampling mode (in mm)
+  vtkGetMacro( SamplingChordTolerance, double );
+  vtkMRMLMarkupsToModelSetClampStageMacro( SamplingChordTolerance, double, 0.0, VTK_DOUBLE_MAX, FitStage );
+  vtkGetMacro( MinimumSamplesPerSegment, int );
+  vtkMRMLMarkupsToModelSetClampStageMacro( MinimumSamplesPerSegment, int, 1, VTK_INT_MAX, FitStage );
+  vtkGetMacro( MaximumSamplesPerSegment, int );
+  vtkMRMLMarkupsToModelSetClampStageMacro( MaximumSamplesPerSegment, int, 1, VTK_INT_MAX, FitStage );
   vtkGetMacro( TubeNumberOfSides, int );
-  vtkSetMacro( TubeNumberOfSides, int );
+  vtkMRMLMarkupsToModelSetStageMacro( TubeNumberOfSides, int, ModelStage );
   vtkGetMacro( TubeLoop, bool );
-  vtkSetMacro( TubeLoop, bool );
+  vtkMRMLMarkupsToModelSetStageMacro( TubeLoop, bool, FitStage );
   vtkBooleanMacro( TubeLoop, bool );
   vtkGetMacro( TubeCapping, bool );
-  vtkSetMacro( TubeCapping, bool );
+  vtkMRMLMarkupsToModelSetStageMacro( TubeCapping, bool, ModelStage );
   vtkBooleanMacro(TubeCapping, bool);
   vtkGetMacro( KochanekEndsCopyNearestDerivatives, bool );
-  vtkSetMacro( KochanekEndsCopyNearestDerivatives, bool );
+  vtkMRMLMarkupsToModelSetStageMacro( KochanekEndsCopyNearestDerivatives, bool, FitStage );
   vtkBooleanMacro( KochanekEndsCopyNearestDerivatives, bool );
   
 
+  // Level of detail: while the user is interacting (moving a point, changing a parameter) the output is generated
+  // with a reduced number of tube sides and segments and without surface subdivision.
+  // Full quality output is generated when the interaction ends.
+  vtkGetMacro( InteractionLevelOfDetail, bool );
+  virtual void SetInteractionLevelOfDetail( bool interactionLevelOfDetail );
+  vtkBooleanMacro( InteractionLevelOfDetail, bool );
+  vtkGetMacro( InteractionTubeNumberOfSides, int );
+  vtkMRMLMarkupsToModelSetClampStageMacro( InteractionTubeNumberOfSides, int, 3, VTK_INT_MAX, ModelStage );
+  vtkGetMacro( InteractionTubeSegmentsBetweenControlPoints, int );
+  vtkMRMLMarkupsToModelSetClampStageMacro( InteractionTubeSegmentsBetweenControlPoints, int, 1, VTK_INT_MAX, FitStage );
+
+  // Indicates that the user is interacting with the input points or the parameters.
+  // Set automatically when a markup point is dragged. Not saved in the scene.
+  // It only modifies the fit stage if the level of detail changes (InteractionLevelOfDetail is enabled).
+  vtkGetMacro( Interacting, bool );
+  virtual void SetInteracting( bool interacting );
+  vtkBooleanMacro( Interacting, bool );
+
   vtkGetMacro( AutoUpdateOutput, bool );
   vtkSetMacro( AutoUpdateOutput, bool );
+  // If enabled then models that cannot be updated incrementally are generated on a worker thread and assigned
+  // to the output when ready, so that the application stays responsive. Updates that become outdated are cancelled.
+  vtkGetMacro( AsynchronousUpdate, bool );
+  vtkSetMacro( AsynchronousUpdate, bool );
+  vtkBooleanMacro( AsynchronousUpdate, bool );
+  // If enabled then the output model is not generated when the scene is loaded if the output model is hidden.
+  // It is generated when the output model is shown, or when the output is updated for any other reason.
+  vtkGetMacro( DeferHiddenOutputUpdate, bool );
+  vtkSetMacro( DeferHiddenOutputUpdate, bool );
+  vtkBooleanMacro( DeferHiddenOutputUpdate, bool );
   vtkGetMacro( CleanMarkups, bool );
-  vtkSetMacro( CleanMarkups, bool );
+  vtkMRMLMarkupsToModelSetStageMacro( CleanMarkups, bool, PointsStage );
+  // Input points closer to a previous input point than this distance are removed if CleanMarkups is enabled (in mm)
+  vtkGetMacro( DuplicatePointTolerance, double );
+  vtkMRMLMarkupsToModelSetClampStageMacro( DuplicatePointTolerance, double, 0.0, VTK_DOUBLE_MAX, PointsStage );
   vtkGetMacro( ButterflySubdivision, bool );
-  vtkSetMacro( ButterflySubdivision, bool );
+  vtkMRMLMarkupsToModelSetStageMacro( ButterflySubdivision, bool, ModelStage );
   vtkGetMacro( DelaunayAlpha, double );
-  vtkSetMacro( DelaunayAlpha, double );
+  vtkMRMLMarkupsToModelSetStageMacro( DelaunayAlpha, double, FitStage );
   vtkGetMacro( ConvexHull, bool );
-  vtkSetMacro( ConvexHull, bool );
+  vtkMRMLMarkupsToModelSetStageMacro( ConvexHull, bool, ModelStage );
 
   double GetOutputCurveLength();
   void SetOutputCurveLength( double );
 
+  // Durations of the stages of the last output update and statistics of the recent updates (in seconds).
+  // Only updates in which the stage was performed are included in the statistics (last 100 updates).
+  // The last time is 0 if the stage was not performed in the last update. Not saved in the scene.
+  double GetLastStageTime( int stage );
+  double GetMinimumStageTime( int stage );
+  double GetMeanStageTime( int stage );
+  // Percentile is in the range [0, 100] (e.g., 95 for the time that 95% of the updates did not exceed)
+  double GetStageTimePercentile( int stage, double percentile );
+  int GetNumberOfStageTimeSamples( int stage );
+  void ResetStageTimes();
+  // Record the durations of the stages of an output update, indexed by TimedStage. Negative if the stage was not performed.
+  // Called by the logic.
+  void AddStageTimes( const double stageTimes[ TimedStage_Last ] );
+  static const char* GetTimedStageAsString( int stage );
+
+  // Get the earliest pipeline stage that uses a parameter that was modified after the specified time
+  // (e.g., the time when the intermediate results of the stages were computed).
+  // Returns PipelineStage_Last if no parameter that is used for generating the model was modified since then.
+  int GetFirstModifiedPipelineStage( vtkMTimeType time );
+
 protected:
 
   // Constructor/destructor methods
@@ -183,6 +306,9 @@ protected:
   vtkMRMLMarkupsToModelNode ( const vtkMRMLMarkupsToModelNode& );
   void operator=( const vtkMRMLMarkupsToModelNode& );
 
+  // Indicate that a parameter that is used in the stage was modified
+  void PipelineStageModified( int stage );
+
 public:
 
   void SetAndObserveInputNodeID( const char* inputNodeId );
@@ -197,11 +323,13 @@ public:
   // Convert between model and interpolation types IDs and names.
   static const char* GetModelTypeAsString( int id );
   static const char* GetCurveTypeAsString( int id );
+  static const char* GetCurveSamplingModeAsString( int id );
   static const char* GetPointParameterTypeAsString( int id );
   static const char* GetPolynomialFitTypeAsString( int id );
   static const char* GetPolynomialWeightTypeAsString( int id );
   static int GetModelTypeFromString( const char* name );
   static int GetCurveTypeFromString( const char* name );
+  static int GetCurveSamplingModeFromString( const char* name );
   static int GetPointParameterTypeFromString( const char* name );
   static int GetPolynomialFitTypeFromString( const char* name );
   static int GetPolynomialWeightTypeFromString( const char* name );
@@ -229,12 +357,20 @@ private:
   int    CurveType;
   int    PointParameterType;
   bool   AutoUpdateOutput;
+  bool   AsynchronousUpdate;
+  bool   DeferHiddenOutputUpdate;
   bool   CleanMarkups;
+  double DuplicatePointTolerance;
   bool   ButterflySubdivision;
   double DelaunayAlpha;
   bool   ConvexHull;
   double TubeRadius;
   int    TubeSegmentsBetweenControlPoints;
+  int    CurveSamplingMode;
+  double SamplingAngleTolerance;
+  double SamplingChordTolerance;
+  int    MinimumSamplesPerSegment;
+  int    MaximumSamplesPerSegment;
   int    TubeNumberOfSides;
   bool   TubeLoop;
   bool   TubeCapping;
@@ -247,6 +383,17 @@ private:
   double PolynomialSampleWidth;
   int    PolynomialWeightType;
   double OutputCurveLength;
+  bool   InteractionLevelOfDetail;
+  int    InteractionTubeNumberOfSides;
+  int    InteractionTubeSegmentsBetweenControlPoints;
+  bool   Interacting;
+
+  vtkTimeStamp PipelineStageModifiedTimes[ PipelineStage_Last ];
+
+  double LastStageTimes[ TimedStage_Last ];
+  // Recent durations of each stage in a circular buffer
+  std::vector< double > StageTimeSamples[ TimedStage_Last ];
+  int NextStageTimeSampleIndex[ TimedStage_Last ];
 };
 
 #endif
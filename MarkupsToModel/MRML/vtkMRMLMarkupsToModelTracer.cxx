@@ -0,0 +1,291 @@
+#include "vtkMRMLMarkupsToModelTracer.h"
+
+// VTK includes
+#include <vtkObjectFactory.h>
+#include <vtkSmartPointer.h>
+
+// STD includes
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <map>
+#include <mutex>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+//------------------------------------------------------------------------------
+// constants within this file
+static const int DEFAULT_CAPACITY = 100000;
+
+// Set if the tracer instance is enabled, so that disabled tracing does not need to access the instance
+static std::atomic< bool > InstanceEnabled( false );
+
+//------------------------------------------------------------------------------
+// Span in the ring buffer. Times are in microseconds.
+struct TraceSpan
+{
+  const char* Name;
+  const char* Category;
+  double StartTime;
+  double Duration;
+  int ThreadIndex;
+};
+
+//------------------------------------------------------------------------------
+class vtkMRMLMarkupsToModelTracer::vtkInternal
+{
+public:
+  vtkInternal()
+    : Enabled( false )
+    , StartTime( std::chrono::steady_clock::now() )
+    , MainThreadId( std::this_thread::get_id() )
+    , NextSpanIndex( 0 )
+    , NumberOfWorkerThreads( 0 )
+  {
+    this->Spans.reserve( DEFAULT_CAPACITY );
+    this->Capacity = DEFAULT_CAPACITY;
+  }
+
+  // Thread index in the exported trace (1 for the thread that created the tracer). Must be called with the mutex locked.
+  int GetThreadIndex( std::thread::id threadId )
+  {
+    std::map< std::thread::id, int >::iterator threadIt = this->ThreadIndices.find( threadId );
+    if ( threadIt != this->ThreadIndices.end() )
+    {
+      return threadIt->second;
+    }
+    int threadIndex = 1;
+    if ( threadId != this->MainThreadId )
+    {
+      this->NumberOfWorkerThreads++;
+      threadIndex = this->NumberOfWorkerThreads + 1;
+    }
+    this->ThreadIndices[ threadId ] = threadIndex;
+    return threadIndex;
+  }
+
+  std::atomic< bool > Enabled;
+  std::chrono::steady_clock::time_point StartTime;
+  std::thread::id MainThreadId;
+
+  // Spans are recorded from the main thread and worker threads
+  std::mutex Mutex;
+  std::vector< TraceSpan > Spans;
+  int Capacity;
+  // Index of the span that is overwritten next when the buffer is full
+  size_t NextSpanIndex;
+  std::map< std::thread::id, int > ThreadIndices;
+  int NumberOfWorkerThreads;
+};
+
+//------------------------------------------------------------------------------
+// Write a string as a JSON string value
+static void WriteJSONString( std::ostream& os, const char* value )
+{
+  os << '"';
+  for ( const char* character = value; character != NULL && *character != 0; character++ )
+  {
+    if ( *character == '"' || *character == '\\' )
+    {
+      os << '\\';
+    }
+    os << *character;
+  }
+  os << '"';
+}
+
+//------------------------------------------------------------------------------
+vtkStandardNewMacro( vtkMRMLMarkupsToModelTracer );
+
+//------------------------------------------------------------------------------
+vtkMRMLMarkupsToModelTracer::vtkMRMLMarkupsToModelTracer()
+{
+  this->Internal = new vtkInternal;
+}
+
+//------------------------------------------------------------------------------
+vtkMRMLMarkupsToModelTracer::~vtkMRMLMarkupsToModelTracer()
+{
+  delete this->Internal;
+}
+
+//------------------------------------------------------------------------------
+vtkMRMLMarkupsToModelTracer* vtkMRMLMarkupsToModelTracer::GetInstance()
+{
+  static vtkSmartPointer< vtkMRMLMarkupsToModelTracer > instance = vtkSmartPointer< vtkMRMLMarkupsToModelTracer >::New();
+  return instance;
+}
+
+//------------------------------------------------------------------------------
+bool vtkMRMLMarkupsToModelTracer::IsTracing()
+{
+  return InstanceEnabled;
+}
+
+//------------------------------------------------------------------------------
+void vtkMRMLMarkupsToModelTracer::SetEnabled( bool enabled )
+{
+  if ( this->Internal->Enabled == enabled )
+  {
+    return;
+  }
+  this->Internal->Enabled = enabled;
+  if ( this == vtkMRMLMarkupsToModelTracer::GetInstance() )
+  {
+    InstanceEnabled = enabled;
+  }
+  this->Modified();
+}
+
+//------------------------------------------------------------------------------
+bool vtkMRMLMarkupsToModelTracer::GetEnabled()
+{
+  return this->Internal->Enabled;
+}
+
+//------------------------------------------------------------------------------
+void vtkMRMLMarkupsToModelTracer::SetCapacity( int capacity )
+{
+  if ( capacity < 1 )
+  {
+    vtkErrorMacro( "SetCapacity: capacity must be at least 1" );
+    return;
+  }
+  std::lock_guard< std::mutex > lock( this->Internal->Mutex );
+  this->Internal->Capacity = capacity;
+  this->Internal->Spans.clear();
+  this->Internal->Spans.shrink_to_fit();
+  this->Internal->Spans.reserve( capacity );
+  this->Internal->NextSpanIndex = 0;
+}
+
+//------------------------------------------------------------------------------
+int vtkMRMLMarkupsToModelTracer::GetCapacity()
+{
+  std::lock_guard< std::mutex > lock( this->Internal->Mutex );
+  return this->Internal->Capacity;
+}
+
+//------------------------------------------------------------------------------
+double vtkMRMLMarkupsToModelTracer::GetTime()
+{
+  return std::chrono::duration< double, std::micro >( std::chrono::steady_clock::now() - this->Internal->StartTime ).count();
+}
+
+//------------------------------------------------------------------------------
+void vtkMRMLMarkupsToModelTracer::AddSpan( const char* name, const char* category, double startTime )
+{
+  if ( !this->Internal->Enabled )
+  {
+    return;
+  }
+  TraceSpan span;
+  span.Name = name;
+  span.Category = category;
+  span.StartTime = startTime;
+  span.Duration = this->GetTime() - startTime;
+  std::thread::id threadId = std::this_thread::get_id();
+
+  std::lock_guard< std::mutex > lock( this->Internal->Mutex );
+  span.ThreadIndex = this->Internal->GetThreadIndex( threadId );
+  std::vector< TraceSpan >& spans = this->Internal->Spans;
+  if ( static_cast< int >( spans.size() ) < this->Internal->Capacity )
+  {
+    spans.push_back( span );
+  }
+  else
+  {
+    spans[ this->Internal->NextSpanIndex ] = span;
+    this->Internal->NextSpanIndex = ( this->Internal->NextSpanIndex + 1 ) % spans.size();
+  }
+}
+
+//------------------------------------------------------------------------------
+int vtkMRMLMarkupsToModelTracer::GetNumberOfSpans()
+{
+  std::lock_guard< std::mutex > lock( this->Internal->Mutex );
+  return static_cast< int >( this->Internal->Spans.size() );
+}
+
+//------------------------------------------------------------------------------
+void vtkMRMLMarkupsToModelTracer::Clear()
+{
+  std::lock_guard< std::mutex > lock( this->Internal->Mutex );
+  this->Internal->Spans.clear();
+  this->Internal->NextSpanIndex = 0;
+}
+
+//------------------------------------------------------------------------------
+std::string vtkMRMLMarkupsToModelTracer::GetTraceAsJSON()
+{
+  std::ostringstream os;
+  // microseconds with nanosecond resolution
+  os << std::fixed << std::setprecision( 3 );
+  os << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+
+  std::lock_guard< std::mutex > lock( this->Internal->Mutex );
+  bool firstEvent = true;
+  for ( std::map< std::thread::id, int >::iterator threadIt = this->Internal->ThreadIndices.begin();
+    threadIt != this->Internal->ThreadIndices.end(); ++threadIt )
+  {
+    std::ostringstream threadName;
+    if ( threadIt->second == 1 )
+    {
+      threadName << "Main thread";
+    }
+    else
+    {
+      threadName << "Worker thread " << threadIt->second - 1;
+    }
+    os << ( firstEvent ? "" : "," ) << "\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << threadIt->second
+      << ",\"args\":{\"name\":";
+    WriteJSONString( os, threadName.str().c_str() );
+    os << "}}";
+    firstEvent = false;
+  }
+
+  // complete events ("X"), so that nested spans need not be matched and overwritten spans do not leave unmatched events
+  const std::vector< TraceSpan >& spans = this->Internal->Spans;
+  for ( size_t spanCount = 0; spanCount < spans.size(); spanCount++ )
+  {
+    const TraceSpan& span = spans[ ( this->Internal->NextSpanIndex + spanCount ) % spans.size() ];
+    os << ( firstEvent ? "" : "," ) << "\n{\"name\":";
+    WriteJSONString( os, span.Name );
+    os << ",\"cat\":";
+    WriteJSONString( os, span.Category );
+    os << ",\"ph\":\"X\",\"ts\":" << span.StartTime << ",\"dur\":" << span.Duration
+      << ",\"pid\":1,\"tid\":" << span.ThreadIndex << "}";
+    firstEvent = false;
+  }
+  os << "\n]}\n";
+  return os.str();
+}
+
+//------------------------------------------------------------------------------
+bool vtkMRMLMarkupsToModelTracer::WriteTrace( const char* fileName )
+{
+  if ( fileName == NULL )
+  {
+    vtkErrorMacro( "WriteTrace: file name is not specified" );
+    return false;
+  }
+  std::ofstream file( fileName, std::ios::out | std::ios::trunc );
+  if ( !file )
+  {
+    vtkErrorMacro( "WriteTrace: cannot open file " << fileName );
+    return false;
+  }
+  file << this->GetTraceAsJSON();
+  return static_cast< bool >( file );
+}
+
+//------------------------------------------------------------------------------
+void vtkMRMLMarkupsToModelTracer::PrintSelf( ostream &os, vtkIndent indent )
+{
+  Superclass::PrintSelf( os, indent );
+  os << indent << "Enabled: " << ( this->GetEnabled() ? "true" : "false" ) << std::endl;
+  os << indent << "Capacity: " << this->GetCapacity() << std::endl;
+  os << indent << "NumberOfSpans: " << this->GetNumberOfSpans() << std::endl;
+}
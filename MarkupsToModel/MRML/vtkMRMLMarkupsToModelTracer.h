@@ -0,0 +1,110 @@
+#ifndef __vtkMRMLMarkupsToModelTracer_h
+#define __vtkMRMLMarkupsToModelTracer_h
+
+// vtk includes
+#include <vtkObject.h>
+
+// STD includes
+#include <string>
+
+#include "vtkSlicerMarkupsToModelModuleMRMLExport.h"
+
+// Records timelines of the output updates of the module (events of the parameter nodes, update scheduling in the logic,
+// generation stages, GUI updates), for finding the cause of latency spikes offline.
+//
+// Spans are recorded from any thread into a fixed size ring buffer (the oldest spans are overwritten) and can be
+// exported in the Trace Event Format (JSON), which can be opened in chrome://tracing or https://ui.perfetto.dev.
+// Tracing is disabled by default, then spans only cost checking a flag. Enable it from the Python console:
+//
+//   tracer = slicer.vtkMRMLMarkupsToModelTracer.GetInstance()
+//   tracer.EnabledOn()
+//   ... interact ...
+//   tracer.WriteTrace("/tmp/MarkupsToModelTrace.json")
+class VTK_SLICER_MARKUPSTOMODEL_MODULE_MRML_EXPORT vtkMRMLMarkupsToModelTracer : public vtkObject
+{
+  public:
+    // standard vtk object methods
+    vtkTypeMacro( vtkMRMLMarkupsToModelTracer, vtkObject );
+    void PrintSelf( ostream& os, vtkIndent indent ) override;
+    static vtkMRMLMarkupsToModelTracer *New();
+
+    // Tracer that the module classes record their spans to
+    static vtkMRMLMarkupsToModelTracer* GetInstance();
+
+    // Returns true if the tracer instance records spans
+    static bool IsTracing();
+
+    void SetEnabled( bool enabled );
+    bool GetEnabled();
+    vtkBooleanMacro( Enabled, bool );
+
+    // Maximum number of recorded spans. Changing the capacity removes the recorded spans.
+    void SetCapacity( int capacity );
+    int GetCapacity();
+
+    // Time since the tracer was created (in microseconds), the time base of the spans
+    double GetTime();
+
+    // Record a span that started at startTime and ends now (see GetTime), on the current thread.
+    // Name and category are stored as pointers, so they must be string literals (or otherwise never freed).
+    void AddSpan( const char* name, const char* category, double startTime );
+
+    // Number of recorded spans (at most the capacity)
+    int GetNumberOfSpans();
+    // Remove all recorded spans
+    void Clear();
+
+    // Get the recorded spans in Trace Event Format (JSON), oldest first
+    std::string GetTraceAsJSON();
+    // Write the recorded spans to a file in Trace Event Format. Returns false if the file cannot be written.
+    bool WriteTrace( const char* fileName );
+
+  protected:
+    vtkMRMLMarkupsToModelTracer();
+    ~vtkMRMLMarkupsToModelTracer();
+
+  private:
+    class vtkInternal;
+    vtkInternal* Internal;
+
+    // not used
+    vtkMRMLMarkupsToModelTracer ( const vtkMRMLMarkupsToModelTracer& ) =delete;
+    void operator= ( const vtkMRMLMarkupsToModelTracer& ) =delete;
+};
+
+// Records a span on the tracer instance for the lifetime of the object, if tracing is enabled when it is created
+// (see MARKUPSTOMODEL_TRACE_SCOPE)
+class VTK_SLICER_MARKUPSTOMODEL_MODULE_MRML_EXPORT vtkMRMLMarkupsToModelTraceScope
+{
+  public:
+    vtkMRMLMarkupsToModelTraceScope( const char* name, const char* category )
+      : Name( name )
+      , Category( category )
+      , StartTime( -1.0 )
+    {
+      if ( vtkMRMLMarkupsToModelTracer::IsTracing() )
+      {
+        this->StartTime = vtkMRMLMarkupsToModelTracer::GetInstance()->GetTime();
+      }
+    }
+    ~vtkMRMLMarkupsToModelTraceScope()
+    {
+      if ( this->StartTime >= 0.0 )
+      {
+        vtkMRMLMarkupsToModelTracer::GetInstance()->AddSpan( this->Name, this->Category, this->StartTime );
+      }
+    }
+
+  private:
+    const char* Name;
+    const char* Category;
+    double StartTime; // negative if the span is not recorded
+};
+
+#define MARKUPSTOMODEL_TRACE_SCOPE_CONCAT_IMPL( a, b ) a##b
+#define MARKUPSTOMODEL_TRACE_SCOPE_CONCAT( a, b ) MARKUPSTOMODEL_TRACE_SCOPE_CONCAT_IMPL( a, b )
+// Record a span from this point to the end of the enclosing scope
+#define MARKUPSTOMODEL_TRACE_SCOPE( name, category ) \
+  vtkMRMLMarkupsToModelTraceScope MARKUPSTOMODEL_TRACE_SCOPE_CONCAT( markupsToModelTraceScope, __LINE__ )( name, category )
+
+#endif
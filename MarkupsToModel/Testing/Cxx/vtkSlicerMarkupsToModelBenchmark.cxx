@@ -0,0 +1,545 @@
+/*==============================================================================
+
+  Program: 3D Slicer
+
+  Portions (c) Copyright Brigham and Women's Hospital (BWH) All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+  ==============================================================================*/
+
+// Benchmark of the model generation of the module on synthetic inputs.
+//
+// Times vtkSlicerMarkupsToModelLogic::UpdateOutputCurveModel for every curve type, polynomial fit type and weight function,
+// and vtkSlicerMarkupsToModelLogic::UpdateClosedSurfaceModel with combinations of Delaunay alpha, smoothing, force convex
+// and level of detail (smooth surfaces without subdivision, as generated while the user is interacting) settings. Inputs are generated deterministically (helices, noisy spheres, planar rings, collinear points
+// and point clouds of 10^2 to 10^6 points), so results of different builds and machines can be compared.
+// Each case uses one curve or closed surface generator for all its runs, as the logic does for a parameter node, so the
+// first run includes the setup of the generator and later runs measure the reuse of it.
+// Results are written as JSON (latency percentiles, first run latency, throughput and output mesh size of each case).
+//
+// It is not run as a test. Run it with the test driver:
+//
+//   qSlicerMarkupsToModelModuleCxxTests vtkSlicerMarkupsToModelBenchmark [--output results.json]
+//     [--max-points 1000000] [--time-budget 1.0] [--max-repetitions 100] [--filter curve/Polynomial]
+//
+// --max-points limits the size of the inputs, --time-budget is the time (in seconds) after which a case is not
+// repeated more, --filter only runs the cases whose name contains the text.
+
+// MarkupsToModel includes
+#include "vtkMRMLMarkupsToModelNode.h"
+#include "vtkSlicerMarkupsToModelClosedSurfaceGeneration.h"
+#include "vtkSlicerMarkupsToModelLogic.h"
+
+// VTK includes
+#include <vtkCurveGenerator.h>
+#include <vtkMath.h>
+#include <vtkPoints.h>
+#include <vtkPolyData.h>
+#include <vtkSmartPointer.h>
+
+// STD includes
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace
+{
+
+//------------------------------------------------------------------------------
+// constants within this file
+const int MINIMUM_REPETITIONS = 3; // unless a single run exceeds the time budget
+const vtkIdType CURVE_INPUT_SIZES[] = { 10, 100, 1000, 10000 };
+const vtkIdType SURFACE_INPUT_SIZES[] = { 100, 1000, 10000, 100000, 1000000 };
+
+//------------------------------------------------------------------------------
+struct BenchmarkSettings
+{
+  BenchmarkSettings()
+    : MaximumNumberOfPoints( 1000000 )
+    , TimeBudget( 1.0 )
+    , MaximumNumberOfRepetitions( 100 )
+  {
+  }
+
+  std::string OutputFileName; // results are written to the standard output if empty
+  vtkIdType MaximumNumberOfPoints;
+  double TimeBudget;
+  int MaximumNumberOfRepetitions;
+  std::string Filter;
+};
+
+//------------------------------------------------------------------------------
+// Uniform random numbers in [0, 1). The generated sequence of std::mt19937 is specified by the standard,
+// distributions are not, so they are computed here to get the same inputs on all platforms.
+class RandomSequence
+{
+public:
+  RandomSequence( unsigned int seed )
+    : Generator( seed )
+  {
+  }
+  double Uniform()
+  {
+    return this->Generator() / 4294967296.0;
+  }
+  // Standard normal distribution (Box-Muller transform)
+  double Normal()
+  {
+    double u1 = 1.0 - this->Uniform(); // in (0, 1]
+    double u2 = this->Uniform();
+    return std::sqrt( -2.0 * std::log( u1 ) ) * std::cos( 2.0 * vtkMath::Pi() * u2 );
+  }
+
+private:
+  std::mt19937 Generator;
+};
+
+//------------------------------------------------------------------------------
+// Synthetic inputs. Coordinates are in mm, in the range of typical markups.
+
+// Helix of radius 20 mm, 12 points per turn, 1 mm rise between points
+void GenerateHelix( vtkIdType numberOfPoints, vtkPoints* points )
+{
+  points->Reset();
+  for ( vtkIdType pointIndex = 0; pointIndex < numberOfPoints; pointIndex++ )
+  {
+    double angle = pointIndex * 2.0 * vtkMath::Pi() / 12.0;
+    points->InsertNextPoint( 20.0 * std::cos( angle ), 20.0 * std::sin( angle ), pointIndex * 1.0 );
+  }
+}
+
+// Points on a sphere of radius 50 mm, with 1 mm normally distributed noise in the radius
+void GenerateNoisySphere( vtkIdType numberOfPoints, vtkPoints* points )
+{
+  RandomSequence random( 1 );
+  points->Reset();
+  for ( vtkIdType pointIndex = 0; pointIndex < numberOfPoints; pointIndex++ )
+  {
+    double direction[ 3 ] = { random.Normal(), random.Normal(), random.Normal() };
+    if ( vtkMath::Normalize( direction ) == 0.0 )
+    {
+      direction[ 0 ] = 1.0;
+    }
+    double radius = 50.0 + random.Normal();
+    points->InsertNextPoint( radius * direction[ 0 ], radius * direction[ 1 ], radius * direction[ 2 ] );
+  }
+}
+
+// Points on a circle of radius 50 mm in the z=0 plane, with 1 mm uniform noise in the radius
+void GeneratePlanarRing( vtkIdType numberOfPoints, vtkPoints* points )
+{
+  RandomSequence random( 2 );
+  points->Reset();
+  for ( vtkIdType pointIndex = 0; pointIndex < numberOfPoints; pointIndex++ )
+  {
+    double angle = pointIndex * 2.0 * vtkMath::Pi() / numberOfPoints;
+    double radius = 50.0 + random.Uniform() - 0.5;
+    points->InsertNextPoint( radius * std::cos( angle ), radius * std::sin( angle ), 0.0 );
+  }
+}
+
+// Points along a line, 1 mm apart
+void GenerateCollinear( vtkIdType numberOfPoints, vtkPoints* points )
+{
+  points->Reset();
+  for ( vtkIdType pointIndex = 0; pointIndex < numberOfPoints; pointIndex++ )
+  {
+    points->InsertNextPoint( pointIndex * 1.0, pointIndex * 0.5, pointIndex * 0.25 );
+  }
+}
+
+// Points uniformly distributed in a 100 mm cube
+void GeneratePointCloud( vtkIdType numberOfPoints, vtkPoints* points )
+{
+  RandomSequence random( 3 );
+  points->Reset();
+  for ( vtkIdType pointIndex = 0; pointIndex < numberOfPoints; pointIndex++ )
+  {
+    points->InsertNextPoint( 100.0 * random.Uniform() - 50.0, 100.0 * random.Uniform() - 50.0, 100.0 * random.Uniform() - 50.0 );
+  }
+}
+
+typedef void ( *InputGenerator )( vtkIdType numberOfPoints, vtkPoints* points );
+
+struct InputType
+{
+  const char* Name;
+  InputGenerator Generator;
+  bool Loop; // curve is closed
+};
+
+const InputType CURVE_INPUTS[] =
+{
+  { "helix", GenerateHelix, false },
+  { "planarRing", GeneratePlanarRing, true },
+  { "collinear", GenerateCollinear, false },
+};
+
+const InputType SURFACE_INPUTS[] =
+{
+  { "noisySphere", GenerateNoisySphere, false },
+  { "pointCloud", GeneratePointCloud, false },
+  { "planarRing", GeneratePlanarRing, false },
+  { "collinear", GenerateCollinear, false },
+};
+
+//------------------------------------------------------------------------------
+// Generation parameters of a case. Curve parameters that are not listed have the defaults of the parameter node.
+struct CurveParameters
+{
+  int CurveType;
+  int PolynomialFitType;
+  int PolynomialWeightType;
+};
+
+struct SurfaceParameters
+{
+  double DelaunayAlpha;
+  bool Smoothing;
+  bool ForceConvex;
+  bool ReducedLevelOfDetail; // smooth surface is not subdivided
+};
+
+//------------------------------------------------------------------------------
+struct BenchmarkResult
+{
+  std::string Name;
+  std::string Operation;
+  std::string Input;
+  vtkIdType NumberOfInputPoints;
+  std::string Parameters; // JSON object
+  bool Success;
+  std::vector< double > Latencies; // in seconds, in the order of the runs
+  vtkIdType NumberOfOutputPoints;
+  vtkIdType NumberOfOutputCells;
+};
+
+//------------------------------------------------------------------------------
+// Nearest-rank percentile of sorted values
+double GetPercentile( const std::vector< double >& sortedValues, double percentile )
+{
+  if ( sortedValues.empty() )
+  {
+    return 0.0;
+  }
+  size_t rank = static_cast< size_t >( std::ceil( percentile / 100.0 * sortedValues.size() ) );
+  rank = std::min( std::max( rank, static_cast< size_t >( 1 ) ), sortedValues.size() );
+  return sortedValues[ rank - 1 ];
+}
+
+//------------------------------------------------------------------------------
+// Run the generation repeatedly until the time budget is used up (at least MINIMUM_REPETITIONS times,
+// unless a single run exceeds the time budget) and record the latency of each run.
+template< typename GenerateFunction >
+void RunBenchmark( const BenchmarkSettings& settings, GenerateFunction generate, vtkPolyData* outputPolyData, BenchmarkResult& result )
+{
+  result.Success = true;
+  double totalTime = 0.0;
+  for ( int repetition = 0; repetition < settings.MaximumNumberOfRepetitions; repetition++ )
+  {
+    std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+    bool success = generate();
+    double latency = std::chrono::duration< double >( std::chrono::steady_clock::now() - startTime ).count();
+    result.Latencies.push_back( latency );
+    result.Success = result.Success && success;
+    totalTime += latency;
+    if ( totalTime >= settings.TimeBudget && ( repetition + 1 >= MINIMUM_REPETITIONS || repetition == 0 ) )
+    {
+      break;
+    }
+  }
+  result.NumberOfOutputPoints = outputPolyData->GetNumberOfPoints();
+  result.NumberOfOutputCells = outputPolyData->GetNumberOfCells();
+}
+
+//------------------------------------------------------------------------------
+bool IsSelected( const BenchmarkSettings& settings, const std::string& name )
+{
+  return settings.Filter.empty() || name.find( settings.Filter ) != std::string::npos;
+}
+
+//------------------------------------------------------------------------------
+void RunCurveBenchmarks( const BenchmarkSettings& settings, std::vector< BenchmarkResult >& results )
+{
+  std::vector< CurveParameters > parameterSets;
+  for ( int curveType = 0; curveType < vtkMRMLMarkupsToModelNode::CurveType_Last; curveType++ )
+  {
+    if ( curveType != vtkMRMLMarkupsToModelNode::Polynomial )
+    {
+      CurveParameters parameters = { curveType, vtkMRMLMarkupsToModelNode::GlobalLeastSquares, vtkMRMLMarkupsToModelNode::Rectangular };
+      parameterSets.push_back( parameters );
+      continue;
+    }
+    for ( int fitType = 0; fitType < vtkMRMLMarkupsToModelNode::PolynomialFitType_Last; fitType++ )
+    {
+      // weight function is only used by moving least squares fitting
+      int numberOfWeightTypes = ( fitType == vtkMRMLMarkupsToModelNode::MovingLeastSquares ? vtkMRMLMarkupsToModelNode::PolynomialWeightType_Last : 1 );
+      for ( int weightType = 0; weightType < numberOfWeightTypes; weightType++ )
+      {
+        CurveParameters parameters = { curveType, fitType, weightType };
+        parameterSets.push_back( parameters );
+      }
+    }
+  }
+
+  // default parameters of the parameter node
+  vtkSmartPointer< vtkMRMLMarkupsToModelNode > defaults = vtkSmartPointer< vtkMRMLMarkupsToModelNode >::New();
+
+  vtkSmartPointer< vtkPoints > controlPoints = vtkSmartPointer< vtkPoints >::New();
+  for ( size_t inputIndex = 0; inputIndex < sizeof( CURVE_INPUTS ) / sizeof( CURVE_INPUTS[ 0 ] ); inputIndex++ )
+  {
+    const InputType& input = CURVE_INPUTS[ inputIndex ];
+    for ( size_t sizeIndex = 0; sizeIndex < sizeof( CURVE_INPUT_SIZES ) / sizeof( CURVE_INPUT_SIZES[ 0 ] ); sizeIndex++ )
+    {
+      vtkIdType numberOfPoints = CURVE_INPUT_SIZES[ sizeIndex ];
+      if ( numberOfPoints > settings.MaximumNumberOfPoints )
+      {
+        continue;
+      }
+      input.Generator( numberOfPoints, controlPoints );
+
+      for ( std::vector< CurveParameters >::iterator parametersIt = parameterSets.begin(); parametersIt != parameterSets.end(); ++parametersIt )
+      {
+        const CurveParameters& parameters = *parametersIt;
+        std::ostringstream name;
+        name << "curve/" << vtkMRMLMarkupsToModelNode::GetCurveTypeAsString( parameters.CurveType );
+        if ( parameters.CurveType == vtkMRMLMarkupsToModelNode::Polynomial )
+        {
+          name << "/" << vtkMRMLMarkupsToModelNode::GetPolynomialFitTypeAsString( parameters.PolynomialFitType );
+          if ( parameters.PolynomialFitType == vtkMRMLMarkupsToModelNode::MovingLeastSquares )
+          {
+            name << "/" << vtkMRMLMarkupsToModelNode::GetPolynomialWeightTypeAsString( parameters.PolynomialWeightType );
+          }
+        }
+        name << "/" << input.Name << "/" << numberOfPoints;
+        if ( !IsSelected( settings, name.str() ) )
+        {
+          continue;
+        }
+        std::cerr << name.str() << std::endl;
+
+        BenchmarkResult result;
+        result.Name = name.str();
+        result.Operation = "UpdateOutputCurveModel";
+        result.Input = input.Name;
+        result.NumberOfInputPoints = numberOfPoints;
+        std::ostringstream parametersJSON;
+        parametersJSON << "{\"curveType\":\"" << vtkMRMLMarkupsToModelNode::GetCurveTypeAsString( parameters.CurveType )
+          << "\",\"polynomialFitType\":\"" << vtkMRMLMarkupsToModelNode::GetPolynomialFitTypeAsString( parameters.PolynomialFitType )
+          << "\",\"polynomialWeightType\":\"" << vtkMRMLMarkupsToModelNode::GetPolynomialWeightTypeAsString( parameters.PolynomialWeightType )
+          << "\",\"tubeLoop\":" << ( input.Loop ? "true" : "false" ) << "}";
+        result.Parameters = parametersJSON.str();
+
+        vtkSmartPointer< vtkCurveGenerator > curveGenerator = vtkSmartPointer< vtkCurveGenerator >::New();
+        vtkSmartPointer< vtkPolyData > outputPolyData = vtkSmartPointer< vtkPolyData >::New();
+        RunBenchmark( settings, [&]()
+        {
+          return vtkSlicerMarkupsToModelLogic::UpdateOutputCurveModel( controlPoints, outputPolyData,
+            parameters.CurveType, input.Loop, defaults->GetTubeRadius(), defaults->GetTubeNumberOfSides(),
+            defaults->GetTubeSegmentsBetweenControlPoints(), defaults->GetCleanMarkups(), defaults->GetPolynomialOrder(),
+            defaults->GetPointParameterType(), defaults->GetKochanekEndsCopyNearestDerivatives(), defaults->GetKochanekBias(),
+            defaults->GetKochanekContinuity(), defaults->GetKochanekTension(), curveGenerator,
+            parameters.PolynomialFitType, defaults->GetPolynomialSampleWidth(), parameters.PolynomialWeightType,
+            defaults->GetTubeCapping() );
+        }, outputPolyData, result );
+        results.push_back( result );
+      }
+    }
+  }
+}
+
+//------------------------------------------------------------------------------
+void RunSurfaceBenchmarks( const BenchmarkSettings& settings, std::vector< BenchmarkResult >& results )
+{
+  // zero alpha generates the convex hull, non-zero alpha generates the alpha shape
+  std::vector< SurfaceParameters > parameterSets;
+  const double delaunayAlphas[] = { 0.0, 25.0 };
+  for ( size_t alphaIndex = 0; alphaIndex < sizeof( delaunayAlphas ) / sizeof( delaunayAlphas[ 0 ] ); alphaIndex++ )
+  {
+    for ( int smoothing = 0; smoothing < 2; smoothing++ )
+    {
+      for ( int forceConvex = 0; forceConvex < 2; forceConvex++ )
+      {
+        // level of detail only changes smooth surfaces
+        int numberOfLevelsOfDetail = ( smoothing ? 2 : 1 );
+        for ( int reducedLevelOfDetail = 0; reducedLevelOfDetail < numberOfLevelsOfDetail; reducedLevelOfDetail++ )
+        {
+          SurfaceParameters parameters = { delaunayAlphas[ alphaIndex ], smoothing != 0, forceConvex != 0, reducedLevelOfDetail != 0 };
+          parameterSets.push_back( parameters );
+        }
+      }
+    }
+  }
+
+  vtkSmartPointer< vtkMRMLMarkupsToModelNode > defaults = vtkSmartPointer< vtkMRMLMarkupsToModelNode >::New();
+
+  vtkSmartPointer< vtkPoints > controlPoints = vtkSmartPointer< vtkPoints >::New();
+  for ( size_t inputIndex = 0; inputIndex < sizeof( SURFACE_INPUTS ) / sizeof( SURFACE_INPUTS[ 0 ] ); inputIndex++ )
+  {
+    const InputType& input = SURFACE_INPUTS[ inputIndex ];
+    for ( size_t sizeIndex = 0; sizeIndex < sizeof( SURFACE_INPUT_SIZES ) / sizeof( SURFACE_INPUT_SIZES[ 0 ] ); sizeIndex++ )
+    {
+      vtkIdType numberOfPoints = SURFACE_INPUT_SIZES[ sizeIndex ];
+      if ( numberOfPoints > settings.MaximumNumberOfPoints )
+      {
+        continue;
+      }
+      input.Generator( numberOfPoints, controlPoints );
+
+      for ( std::vector< SurfaceParameters >::iterator parametersIt = parameterSets.begin(); parametersIt != parameterSets.end(); ++parametersIt )
+      {
+        const SurfaceParameters& parameters = *parametersIt;
+        std::ostringstream name;
+        name << "surface/alpha" << parameters.DelaunayAlpha << ( parameters.Smoothing ? "/smooth" : "/flat" )
+          << ( parameters.ForceConvex ? "/convex" : "" ) << ( parameters.ReducedLevelOfDetail ? "/reducedDetail" : "" )
+          << "/" << input.Name << "/" << numberOfPoints;
+        if ( !IsSelected( settings, name.str() ) )
+        {
+          continue;
+        }
+        std::cerr << name.str() << std::endl;
+
+        BenchmarkResult result;
+        result.Name = name.str();
+        result.Operation = "UpdateClosedSurfaceModel";
+        result.Input = input.Name;
+        result.NumberOfInputPoints = numberOfPoints;
+        std::ostringstream parametersJSON;
+        parametersJSON << "{\"delaunayAlpha\":" << parameters.DelaunayAlpha
+          << ",\"smoothing\":" << ( parameters.Smoothing ? "true" : "false" )
+          << ",\"forceConvex\":" << ( parameters.ForceConvex ? "true" : "false" )
+          << ",\"reducedLevelOfDetail\":" << ( parameters.ReducedLevelOfDetail ? "true" : "false" ) << "}";
+        result.Parameters = parametersJSON.str();
+
+        // the points do not change between runs, so runs after the first one reuse the triangulation
+        vtkSmartPointer< vtkSlicerMarkupsToModelClosedSurfaceGeneration > closedSurfaceGenerator =
+          vtkSmartPointer< vtkSlicerMarkupsToModelClosedSurfaceGeneration >::New();
+        vtkSmartPointer< vtkPolyData > outputPolyData = vtkSmartPointer< vtkPolyData >::New();
+        RunBenchmark( settings, [&]()
+        {
+          return vtkSlicerMarkupsToModelLogic::UpdateClosedSurfaceModel( controlPoints, outputPolyData,
+            parameters.Smoothing, parameters.ForceConvex, parameters.DelaunayAlpha, defaults->GetCleanMarkups(),
+            !parameters.ReducedLevelOfDetail, closedSurfaceGenerator, defaults->GetDuplicatePointTolerance() );
+        }, outputPolyData, result );
+        results.push_back( result );
+      }
+    }
+  }
+}
+
+//------------------------------------------------------------------------------
+void WriteResults( const BenchmarkSettings& settings, const std::vector< BenchmarkResult >& results, std::ostream& os )
+{
+  os << "{" << std::endl;
+  os << "  \"benchmark\": \"MarkupsToModel\"," << std::endl;
+  os << "  \"settings\": {\"maxPoints\": " << settings.MaximumNumberOfPoints << ", \"timeBudget\": " << settings.TimeBudget
+    << ", \"maxRepetitions\": " << settings.MaximumNumberOfRepetitions << "}," << std::endl;
+  os << "  \"results\": [";
+  for ( std::vector< BenchmarkResult >::const_iterator resultIt = results.begin(); resultIt != results.end(); ++resultIt )
+  {
+    const BenchmarkResult& result = *resultIt;
+    double firstRunLatency = ( result.Latencies.empty() ? 0.0 : result.Latencies.front() );
+    std::vector< double > latencies = result.Latencies;
+    std::sort( latencies.begin(), latencies.end() );
+    double totalTime = 0.0;
+    for ( std::vector< double >::iterator latencyIt = latencies.begin(); latencyIt != latencies.end(); ++latencyIt )
+    {
+      totalTime += *latencyIt;
+    }
+    double meanLatency = ( latencies.empty() ? 0.0 : totalTime / latencies.size() );
+    double runsPerSecond = ( totalTime > 0.0 ? latencies.size() / totalTime : 0.0 );
+
+    os << ( resultIt == results.begin() ? "" : "," ) << std::endl;
+    os << "    {\"name\": \"" << result.Name << "\", \"operation\": \"" << result.Operation << "\", \"input\": \"" << result.Input
+      << "\", \"numberOfInputPoints\": " << result.NumberOfInputPoints << ", \"parameters\": " << result.Parameters
+      << ", \"success\": " << ( result.Success ? "true" : "false" ) << ", \"repetitions\": " << latencies.size() << "," << std::endl;
+    // latencies in milliseconds, the first run includes the setup of the generator
+    os << "      \"latencyMs\": {\"firstRun\": " << firstRunLatency * 1000.0 << ", \"min\": " << GetPercentile( latencies, 0.0 ) * 1000.0 << ", \"mean\": " << meanLatency * 1000.0
+      << ", \"p50\": " << GetPercentile( latencies, 50.0 ) * 1000.0 << ", \"p90\": " << GetPercentile( latencies, 90.0 ) * 1000.0
+      << ", \"p99\": " << GetPercentile( latencies, 99.0 ) * 1000.0 << ", \"max\": " << GetPercentile( latencies, 100.0 ) * 1000.0
+      << "}," << std::endl;
+    os << "      \"throughput\": {\"runsPerSecond\": " << runsPerSecond << ", \"inputPointsPerSecond\": "
+      << runsPerSecond * result.NumberOfInputPoints << "}," << std::endl;
+    os << "      \"output\": {\"numberOfPoints\": " << result.NumberOfOutputPoints << ", \"numberOfCells\": "
+      << result.NumberOfOutputCells << "}}";
+  }
+  os << std::endl << "  ]" << std::endl << "}" << std::endl;
+}
+
+} // namespace
+
+//------------------------------------------------------------------------------
+int vtkSlicerMarkupsToModelBenchmark( int argc, char* argv[] )
+{
+  BenchmarkSettings settings;
+  for ( int argIndex = 1; argIndex < argc; argIndex++ )
+  {
+    std::string arg = argv[ argIndex ];
+    if ( argIndex + 1 >= argc )
+    {
+      std::cerr << "Missing value of argument " << arg << std::endl;
+      return EXIT_FAILURE;
+    }
+    const char* value = argv[ ++argIndex ];
+    if ( arg == "--output" )
+    {
+      settings.OutputFileName = value;
+    }
+    else if ( arg == "--max-points" )
+    {
+      settings.MaximumNumberOfPoints = std::atol( value );
+    }
+    else if ( arg == "--time-budget" )
+    {
+      settings.TimeBudget = std::atof( value );
+    }
+    else if ( arg == "--max-repetitions" )
+    {
+      settings.MaximumNumberOfRepetitions = std::max( std::atoi( value ), 1 );
+    }
+    else if ( arg == "--filter" )
+    {
+      settings.Filter = value;
+    }
+    else
+    {
+      std::cerr << "Unknown argument " << arg << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+
+  std::vector< BenchmarkResult > results;
+  RunCurveBenchmarks( settings, results );
+  RunSurfaceBenchmarks( settings, results );
+
+  if ( settings.OutputFileName.empty() )
+  {
+    WriteResults( settings, results, std::cout );
+    return EXIT_SUCCESS;
+  }
+  std::ofstream outputFile( settings.OutputFileName.c_str() );
+  if ( !outputFile )
+  {
+    std::cerr << "Cannot write results to " << settings.OutputFileName << std::endl;
+    return EXIT_FAILURE;
+  }
+  WriteResults( settings, results, outputFile );
+  return EXIT_SUCCESS;
+}
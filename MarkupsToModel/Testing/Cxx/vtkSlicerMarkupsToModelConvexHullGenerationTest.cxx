@@ -0,0 +1,325 @@
+/*==============================================================================
+
+  Program: 3D Slicer
+
+  Portions (c) Copyright Brigham and Women's Hospital (BWH) All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+  ==============================================================================*/
+
+// Regression test of vtkSlicerMarkupsToModelConvexHullGeneration.
+//
+// Degenerate inputs (too few points, points at a single position, on a line or on a plane) must be rejected,
+// duplicate points must not break the hull topology, and the hull of point clouds must be the same as
+// the surface of the vtkDelaunay3D tetrahedralization (extracted by vtkDataSetSurfaceFilter).
+
+// MarkupsToModel includes
+#include "vtkSlicerMarkupsToModelConvexHullGeneration.h"
+
+// VTK includes
+#include <vtkCellArray.h>
+#include <vtkDataSetSurfaceFilter.h>
+#include <vtkDelaunay3D.h>
+#include <vtkMassProperties.h>
+#include <vtkMath.h>
+#include <vtkPoints.h>
+#include <vtkPolyData.h>
+#include <vtkSmartPointer.h>
+
+// STD includes
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <map>
+#include <random>
+#include <string>
+#include <utility>
+
+namespace
+{
+
+//------------------------------------------------------------------------------
+// constants within this file
+const double RELATIVE_TOLERANCE = 1.0e-6;
+
+//------------------------------------------------------------------------------
+#define CHECK( condition, message ) \
+  if ( !( condition ) ) \
+  { \
+    std::cerr << "Line " << __LINE__ << ": " << message << std::endl; \
+    return false; \
+  }
+
+//------------------------------------------------------------------------------
+bool IsClose( double value, double expectedValue )
+{
+  return fabs( value - expectedValue ) <= RELATIVE_TOLERANCE * std::max( 1.0, fabs( expectedValue ) );
+}
+
+//------------------------------------------------------------------------------
+// Each directed edge of a closed, consistently oriented triangle mesh is used exactly once,
+// and its reverse is used by the neighbor triangle.
+bool IsClosedOrientedSurface( vtkPolyData* polyData )
+{
+  std::map< std::pair< vtkIdType, vtkIdType >, int > numberOfEdgeUses;
+  vtkCellArray* polys = polyData->GetPolys();
+  polys->InitTraversal();
+  vtkIdType numberOfCellPoints = 0;
+  const vtkIdType* cellPointIds = NULL;
+  while ( polys->GetNextCell( numberOfCellPoints, cellPointIds ) )
+  {
+    if ( numberOfCellPoints != 3 )
+    {
+      return false;
+    }
+    for ( int i = 0; i < 3; i++ )
+    {
+      numberOfEdgeUses[ std::make_pair( cellPointIds[ i ], cellPointIds[ ( i + 1 ) % 3 ] ) ]++;
+    }
+  }
+  for ( std::map< std::pair< vtkIdType, vtkIdType >, int >::iterator edgeIt = numberOfEdgeUses.begin(); edgeIt != numberOfEdgeUses.end(); ++edgeIt )
+  {
+    if ( edgeIt->second != 1 || numberOfEdgeUses.count( std::make_pair( edgeIt->first.second, edgeIt->first.first ) ) == 0 )
+    {
+      return false;
+    }
+  }
+  return !numberOfEdgeUses.empty();
+}
+
+//------------------------------------------------------------------------------
+// Signed volume of a closed triangle mesh (positive if the triangles are oriented outwards).
+double ComputeSignedVolume( vtkPolyData* polyData )
+{
+  double volume = 0.0;
+  vtkCellArray* polys = polyData->GetPolys();
+  polys->InitTraversal();
+  vtkIdType numberOfCellPoints = 0;
+  const vtkIdType* cellPointIds = NULL;
+  while ( polys->GetNextCell( numberOfCellPoints, cellPointIds ) )
+  {
+    double point0[ 3 ] = { 0.0, 0.0, 0.0 };
+    double point1[ 3 ] = { 0.0, 0.0, 0.0 };
+    double point2[ 3 ] = { 0.0, 0.0, 0.0 };
+    polyData->GetPoints()->GetPoint( cellPointIds[ 0 ], point0 );
+    polyData->GetPoints()->GetPoint( cellPointIds[ 1 ], point1 );
+    polyData->GetPoints()->GetPoint( cellPointIds[ 2 ], point2 );
+    double cross[ 3 ] = { 0.0, 0.0, 0.0 };
+    vtkMath::Cross( point1, point2, cross );
+    volume += vtkMath::Dot( point0, cross ) / 6.0;
+  }
+  return volume;
+}
+
+//------------------------------------------------------------------------------
+void AddCubeCorners( vtkPoints* points, double size )
+{
+  for ( int cornerIndex = 0; cornerIndex < 8; cornerIndex++ )
+  {
+    points->InsertNextPoint( ( cornerIndex & 1 ) ? size : 0.0, ( cornerIndex & 2 ) ? size : 0.0, ( cornerIndex & 4 ) ? size : 0.0 );
+  }
+}
+
+//------------------------------------------------------------------------------
+bool TestDegenerateInputs()
+{
+  vtkSmartPointer< vtkSlicerMarkupsToModelConvexHullGeneration > hull = vtkSmartPointer< vtkSlicerMarkupsToModelConvexHullGeneration >::New();
+  vtkSmartPointer< vtkPolyData > outputPolyData = vtkSmartPointer< vtkPolyData >::New();
+
+  vtkSmartPointer< vtkPoints > points = vtkSmartPointer< vtkPoints >::New();
+  CHECK( !hull->Build( points ), "Hull of no points must fail" );
+  points->InsertNextPoint( 0.0, 0.0, 0.0 );
+  points->InsertNextPoint( 1.0, 0.0, 0.0 );
+  points->InsertNextPoint( 0.0, 1.0, 0.0 );
+  CHECK( !hull->Build( points ), "Hull of three points must fail" );
+  CHECK( !hull->HasHull(), "Failed build must not leave a hull" );
+
+  vtkSmartPointer< vtkPoints > singularPoints = vtkSmartPointer< vtkPoints >::New();
+  for ( int i = 0; i < 10; i++ )
+  {
+    singularPoints->InsertNextPoint( 5.0, -3.0, 2.0 );
+  }
+  CHECK( !hull->Build( singularPoints ), "Hull of points at a single position must fail" );
+
+  vtkSmartPointer< vtkPoints > linearPoints = vtkSmartPointer< vtkPoints >::New();
+  for ( int i = 0; i < 10; i++ )
+  {
+    linearPoints->InsertNextPoint( i * 1.0, i * 2.0, i * -0.5 );
+  }
+  CHECK( !hull->Build( linearPoints ), "Hull of collinear points must fail" );
+
+  vtkSmartPointer< vtkPoints > planarPoints = vtkSmartPointer< vtkPoints >::New();
+  for ( int i = 0; i < 5; i++ )
+  {
+    for ( int j = 0; j < 5; j++ )
+    {
+      // plane x + y + z = 1
+      planarPoints->InsertNextPoint( i * 1.0, j * 1.0, 1.0 - i - j );
+    }
+  }
+  CHECK( !hull->Build( planarPoints ), "Hull of coplanar points must fail" );
+  CHECK( !vtkSlicerMarkupsToModelConvexHullGeneration::GenerateConvexHullModel( planarPoints, outputPolyData ),
+    "Hull model of coplanar points must fail" );
+  CHECK( !hull->HasHull(), "Failed build must not leave a hull" );
+  return true;
+}
+
+//------------------------------------------------------------------------------
+bool TestDuplicatePoints()
+{
+  // every corner three times, and the center of the cube (inside) twice
+  vtkSmartPointer< vtkPoints > points = vtkSmartPointer< vtkPoints >::New();
+  for ( int copyIndex = 0; copyIndex < 3; copyIndex++ )
+  {
+    AddCubeCorners( points, 2.0 );
+  }
+  points->InsertNextPoint( 1.0, 1.0, 1.0 );
+  points->InsertNextPoint( 1.0, 1.0, 1.0 );
+
+  vtkSmartPointer< vtkSlicerMarkupsToModelConvexHullGeneration > hull = vtkSmartPointer< vtkSlicerMarkupsToModelConvexHullGeneration >::New();
+  CHECK( hull->Build( points ), "Hull of duplicate cube corners failed" );
+  vtkSmartPointer< vtkPolyData > hullPolyData = vtkSmartPointer< vtkPolyData >::New();
+  hull->GetPolyData( hullPolyData );
+  CHECK( hullPolyData->GetNumberOfPoints() == 8, "Expected 8 hull vertices, got " << hullPolyData->GetNumberOfPoints() );
+  CHECK( hullPolyData->GetNumberOfPolys() == 12, "Expected 12 hull triangles, got " << hullPolyData->GetNumberOfPolys() );
+  CHECK( IsClosedOrientedSurface( hullPolyData ), "Hull of duplicate cube corners is not a closed oriented surface" );
+  CHECK( IsClose( ComputeSignedVolume( hullPolyData ), 8.0 ), "Wrong hull volume: " << ComputeSignedVolume( hullPolyData ) );
+
+  // inserting a duplicate of a hull vertex or of an interior point does not change the hull
+  double corner[ 3 ] = { 2.0, 2.0, 2.0 };
+  CHECK( !hull->InsertPoint( corner ), "Duplicate corner changed the hull" );
+  double center[ 3 ] = { 1.0, 1.0, 1.0 };
+  CHECK( !hull->InsertPoint( center ), "Interior point changed the hull" );
+  CHECK( hull->HasHull(), "Hull was removed by inserting duplicate points" );
+
+  // moving an interior point outside grows the hull
+  bool hullModified = false;
+  double outsidePoint[ 3 ] = { 1.0, 1.0, 3.0 };
+  CHECK( hull->SetPoint( points->GetNumberOfPoints() - 1, outsidePoint, hullModified ), "Moving an interior point failed" );
+  CHECK( hullModified, "Moving an interior point outside did not change the hull" );
+  hull->GetPolyData( hullPolyData );
+  CHECK( IsClosedOrientedSurface( hullPolyData ), "Updated hull is not a closed oriented surface" );
+  CHECK( IsClose( ComputeSignedVolume( hullPolyData ), 8.0 + 4.0 / 3.0 ), "Wrong updated hull volume: " << ComputeSignedVolume( hullPolyData ) );
+
+  // moving a hull vertex requires a full rebuild
+  CHECK( !hull->SetPoint( points->GetNumberOfPoints() - 1, center, hullModified ), "Moving a hull vertex must not be incremental" );
+  return true;
+}
+
+//------------------------------------------------------------------------------
+// Compare the hull with the surface of the Delaunay tetrahedralization of the points.
+bool CompareWithDelaunay( vtkPoints* points, const std::string& name )
+{
+  vtkSmartPointer< vtkPolyData > hullPolyData = vtkSmartPointer< vtkPolyData >::New();
+  CHECK( vtkSlicerMarkupsToModelConvexHullGeneration::GenerateConvexHullModel( points, hullPolyData ), name << ": hull generation failed" );
+  CHECK( IsClosedOrientedSurface( hullPolyData ), name << ": hull is not a closed oriented surface" );
+
+  vtkSmartPointer< vtkPolyData > pointsPolyData = vtkSmartPointer< vtkPolyData >::New();
+  pointsPolyData->SetPoints( points );
+  vtkSmartPointer< vtkDelaunay3D > delaunay = vtkSmartPointer< vtkDelaunay3D >::New();
+  delaunay->SetInputData( pointsPolyData );
+  delaunay->SetAlpha( 0.0 );
+  vtkSmartPointer< vtkDataSetSurfaceFilter > surfaceFilter = vtkSmartPointer< vtkDataSetSurfaceFilter >::New();
+  surfaceFilter->SetInputConnection( delaunay->GetOutputPort() );
+  surfaceFilter->Update();
+  vtkPolyData* delaunayPolyData = surfaceFilter->GetOutput();
+
+  vtkSmartPointer< vtkMassProperties > hullProperties = vtkSmartPointer< vtkMassProperties >::New();
+  hullProperties->SetInputData( hullPolyData );
+  hullProperties->Update();
+  vtkSmartPointer< vtkMassProperties > delaunayProperties = vtkSmartPointer< vtkMassProperties >::New();
+  delaunayProperties->SetInputData( delaunayPolyData );
+  delaunayProperties->Update();
+
+  CHECK( IsClose( ComputeSignedVolume( hullPolyData ), hullProperties->GetVolume() ), name << ": hull triangles are not oriented outwards" );
+  CHECK( IsClose( hullProperties->GetVolume(), delaunayProperties->GetVolume() ),
+    name << ": hull volume " << hullProperties->GetVolume() << " differs from Delaunay volume " << delaunayProperties->GetVolume() );
+  CHECK( IsClose( hullProperties->GetSurfaceArea(), delaunayProperties->GetSurfaceArea() ),
+    name << ": hull area " << hullProperties->GetSurfaceArea() << " differs from Delaunay area " << delaunayProperties->GetSurfaceArea() );
+  CHECK( hullPolyData->GetNumberOfPoints() == delaunayPolyData->GetNumberOfPoints(),
+    name << ": " << hullPolyData->GetNumberOfPoints() << " hull vertices, Delaunay surface has " << delaunayPolyData->GetNumberOfPoints() );
+  return true;
+}
+
+//------------------------------------------------------------------------------
+bool TestPointClouds()
+{
+  std::mt19937 randomGenerator( 12345 );
+  std::normal_distribution< double > normalDistribution( 0.0, 1.0 );
+  std::uniform_real_distribution< double > uniformDistribution( -1.0, 1.0 );
+
+  // points on a sphere (all are hull vertices) and inside a box (few are hull vertices)
+  vtkSmartPointer< vtkPoints > spherePoints = vtkSmartPointer< vtkPoints >::New();
+  vtkSmartPointer< vtkPoints > boxPoints = vtkSmartPointer< vtkPoints >::New();
+  for ( int i = 0; i < 500; i++ )
+  {
+    double direction[ 3 ] = { normalDistribution( randomGenerator ), normalDistribution( randomGenerator ), normalDistribution( randomGenerator ) };
+    vtkMath::Normalize( direction );
+    vtkMath::MultiplyScalar( direction, 50.0 );
+    spherePoints->InsertNextPoint( direction );
+    boxPoints->InsertNextPoint( 10.0 * uniformDistribution( randomGenerator ), 20.0 * uniformDistribution( randomGenerator ),
+      5.0 * uniformDistribution( randomGenerator ) );
+  }
+  if ( !CompareWithDelaunay( spherePoints, "sphere" ) || !CompareWithDelaunay( boxPoints, "box" ) )
+  {
+    return false;
+  }
+
+  // far from the origin (as in RAS coordinates of a patient)
+  vtkSmartPointer< vtkPoints > shiftedPoints = vtkSmartPointer< vtkPoints >::New();
+  for ( vtkIdType pointIndex = 0; pointIndex < boxPoints->GetNumberOfPoints(); pointIndex++ )
+  {
+    double point[ 3 ] = { 0.0, 0.0, 0.0 };
+    boxPoints->GetPoint( pointIndex, point );
+    shiftedPoints->InsertNextPoint( point[ 0 ] + 1000.0, point[ 1 ] - 2000.0, point[ 2 ] + 500.0 );
+  }
+  if ( !CompareWithDelaunay( shiftedPoints, "shifted box" ) )
+  {
+    return false;
+  }
+
+  // incremental insertion gives the same hull as building from all the points
+  vtkSmartPointer< vtkPoints > initialPoints = vtkSmartPointer< vtkPoints >::New();
+  for ( vtkIdType pointIndex = 0; pointIndex < 100; pointIndex++ )
+  {
+    initialPoints->InsertNextPoint( boxPoints->GetPoint( pointIndex ) );
+  }
+  vtkSmartPointer< vtkSlicerMarkupsToModelConvexHullGeneration > hull = vtkSmartPointer< vtkSlicerMarkupsToModelConvexHullGeneration >::New();
+  CHECK( hull->Build( initialPoints ), "Hull of the initial points failed" );
+  for ( vtkIdType pointIndex = 100; pointIndex < boxPoints->GetNumberOfPoints(); pointIndex++ )
+  {
+    hull->InsertPoint( boxPoints->GetPoint( pointIndex ) );
+    CHECK( hull->HasHull(), "Hull was removed while inserting point " << pointIndex );
+  }
+  vtkSmartPointer< vtkPolyData > incrementalPolyData = vtkSmartPointer< vtkPolyData >::New();
+  hull->GetPolyData( incrementalPolyData );
+  vtkSmartPointer< vtkPolyData > fullPolyData = vtkSmartPointer< vtkPolyData >::New();
+  vtkSlicerMarkupsToModelConvexHullGeneration::GenerateConvexHullModel( boxPoints, fullPolyData );
+  CHECK( IsClosedOrientedSurface( incrementalPolyData ), "Incremental hull is not a closed oriented surface" );
+  CHECK( incrementalPolyData->GetNumberOfPoints() == fullPolyData->GetNumberOfPoints(),
+    "Incremental hull has " << incrementalPolyData->GetNumberOfPoints() << " vertices, full hull has " << fullPolyData->GetNumberOfPoints() );
+  CHECK( IsClose( ComputeSignedVolume( incrementalPolyData ), ComputeSignedVolume( fullPolyData ) ), "Incremental hull volume differs from full hull" );
+  return true;
+}
+
+} // namespace
+
+//------------------------------------------------------------------------------
+int vtkSlicerMarkupsToModelConvexHullGenerationTest( int vtkNotUsed( argc ), char* vtkNotUsed( argv )[] )
+{
+  if ( !TestDegenerateInputs() || !TestDuplicatePoints() || !TestPointClouds() )
+  {
+    return EXIT_FAILURE;
+  }
+  std::cout << "Test passed" << std::endl;
+  return EXIT_SUCCESS;
+}
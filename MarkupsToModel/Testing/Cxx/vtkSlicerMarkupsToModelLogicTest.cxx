@@ -0,0 +1,690 @@
+/*==============================================================================
+
+  Program: 3D Slicer
+
+  Portions (c) Copyright Brigham and Women's Hospital (BWH) All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+  ==============================================================================*/
+
+// Test of vtkSlicerMarkupsToModelLogic.
+//
+// Output models that are updated incrementally (e.g., when points are added or moved within a convex surface)
+// must be the same as the models generated from all the points.
+// Curve models that are extended incrementally when points are appended must be the same as the curve models
+// generated from all the points, for each curve type. The same applies when a single point (first, middle or last)
+// of the curve is moved and only the nearby part of the curve and tube is updated.
+// Duplicate point removal must give the same points as vtkCleanPolyData.
+// The automatic Delaunay alpha must give a single closed surface that contains all the points.
+// The logic can be deleted while a background update is running.
+// Modifications of the input that do not move points (e.g., selection) must not update the output.
+
+// MarkupsToModel includes
+#include "vtkMRMLMarkupsToModelNode.h"
+#include "vtkSlicerMarkupsToModelLogic.h"
+
+// MRML includes
+#include <vtkMRMLMarkupsFiducialNode.h>
+#include <vtkMRMLModelNode.h>
+#include <vtkMRMLScene.h>
+
+// VTK includes
+#include <vtkCellArray.h>
+#include <vtkCleanPolyData.h>
+#include <vtkMassProperties.h>
+#include <vtkMath.h>
+#include <vtkPoints.h>
+#include <vtkPolyData.h>
+#include <vtkPolyDataConnectivityFilter.h>
+#include <vtkSelectEnclosedPoints.h>
+#include <vtkSmartPointer.h>
+
+// STD includes
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace
+{
+
+//------------------------------------------------------------------------------
+// constants within this file
+const double RELATIVE_TOLERANCE = 1.0e-6;
+// Curve segments of splines are re-evaluated from the nearby control points only, which is exact for Kochanek splines
+// but not for cardinal splines (the segments must connect within 0.001 mm), so tube points may differ slightly.
+const double CURVE_POINT_TOLERANCE_MM = 0.01;
+
+//------------------------------------------------------------------------------
+#define CHECK( condition, message ) \
+  if ( !( condition ) ) \
+  { \
+    std::cerr << "Line " << __LINE__ << ": " << message << std::endl; \
+    return false; \
+  }
+
+//------------------------------------------------------------------------------
+bool IsClose( double value, double expectedValue )
+{
+  return fabs( value - expectedValue ) <= RELATIVE_TOLERANCE * std::max( 1.0, fabs( expectedValue ) );
+}
+
+//------------------------------------------------------------------------------
+// Scene with a markups node that is converted to a model by a parameter node
+struct TestScene
+{
+  TestScene()
+  {
+    this->Scene = vtkSmartPointer< vtkMRMLScene >::New();
+    this->Logic = vtkSmartPointer< vtkSlicerMarkupsToModelLogic >::New();
+    this->Logic->SetMRMLScene( this->Scene );
+    this->MarkupsNode = vtkSmartPointer< vtkMRMLMarkupsFiducialNode >::New();
+    this->Scene->AddNode( this->MarkupsNode );
+    this->ModelNode = vtkSmartPointer< vtkMRMLModelNode >::New();
+    this->Scene->AddNode( this->ModelNode );
+    this->ParameterNode = vtkSmartPointer< vtkMRMLMarkupsToModelNode >::New();
+    this->Scene->AddNode( this->ParameterNode );
+    this->ParameterNode->SetAndObserveInputNodeID( this->MarkupsNode->GetID() );
+    this->ParameterNode->SetAndObserveOutputModelNodeID( this->ModelNode->GetID() );
+  }
+
+  ~TestScene()
+  {
+    this->Logic->SetMRMLScene( NULL );
+  }
+
+  vtkSmartPointer< vtkMRMLScene > Scene;
+  vtkSmartPointer< vtkSlicerMarkupsToModelLogic > Logic;
+  vtkSmartPointer< vtkMRMLMarkupsFiducialNode > MarkupsNode;
+  vtkSmartPointer< vtkMRMLModelNode > ModelNode;
+  vtkSmartPointer< vtkMRMLMarkupsToModelNode > ParameterNode;
+};
+
+//------------------------------------------------------------------------------
+// Compare the output model of the parameter node with the closed surface generated from all the points at once.
+bool CompareWithFullClosedSurfaceUpdate( TestScene& testScene, const std::string& name )
+{
+  vtkMRMLMarkupsToModelNode* parameterNode = testScene.ParameterNode;
+  vtkSmartPointer< vtkPoints > controlPoints = vtkSmartPointer< vtkPoints >::New();
+  vtkSlicerMarkupsToModelLogic::MarkupsToPoints( testScene.MarkupsNode, controlPoints );
+  vtkSmartPointer< vtkPolyData > expectedPolyData = vtkSmartPointer< vtkPolyData >::New();
+  CHECK( vtkSlicerMarkupsToModelLogic::UpdateClosedSurfaceModel( controlPoints, expectedPolyData, parameterNode->GetButterflySubdivision(),
+    parameterNode->GetConvexHull(), parameterNode->GetDelaunayAlpha(), parameterNode->GetCleanMarkups(), true, NULL,
+    parameterNode->GetDuplicatePointTolerance() ), name << ": full update failed" );
+
+  vtkPolyData* outputPolyData = testScene.ModelNode->GetPolyData();
+  CHECK( outputPolyData != NULL, name << ": no output model" );
+  CHECK( outputPolyData->GetNumberOfPoints() == expectedPolyData->GetNumberOfPoints(),
+    name << ": output has " << outputPolyData->GetNumberOfPoints() << " points, full update has " << expectedPolyData->GetNumberOfPoints() );
+  CHECK( outputPolyData->GetNumberOfPolys() == expectedPolyData->GetNumberOfPolys(),
+    name << ": output has " << outputPolyData->GetNumberOfPolys() << " triangles, full update has " << expectedPolyData->GetNumberOfPolys() );
+
+  vtkSmartPointer< vtkMassProperties > outputProperties = vtkSmartPointer< vtkMassProperties >::New();
+  outputProperties->SetInputData( outputPolyData );
+  outputProperties->Update();
+  vtkSmartPointer< vtkMassProperties > expectedProperties = vtkSmartPointer< vtkMassProperties >::New();
+  expectedProperties->SetInputData( expectedPolyData );
+  expectedProperties->Update();
+  CHECK( IsClose( outputProperties->GetVolume(), expectedProperties->GetVolume() ),
+    name << ": output volume " << outputProperties->GetVolume() << " differs from full update volume " << expectedProperties->GetVolume() );
+  CHECK( IsClose( outputProperties->GetSurfaceArea(), expectedProperties->GetSurfaceArea() ),
+    name << ": output area " << outputProperties->GetSurfaceArea() << " differs from full update area " << expectedProperties->GetSurfaceArea() );
+  return true;
+}
+
+//------------------------------------------------------------------------------
+bool TestIncrementalClosedSurfaceUpdate( bool smoothing )
+{
+  TestScene testScene;
+  vtkMRMLMarkupsToModelNode* parameterNode = testScene.ParameterNode;
+  vtkMRMLMarkupsFiducialNode* markupsNode = testScene.MarkupsNode;
+  parameterNode->SetModelType( vtkMRMLMarkupsToModelNode::ClosedSurface );
+  parameterNode->SetDelaunayAlpha( 0.0 ); // convex hull, which is updated incrementally
+  parameterNode->SetButterflySubdivision( smoothing );
+  std::string name = ( smoothing ? "smooth surface" : "surface" );
+
+  // points on a sphere, and a few inside
+  std::mt19937 randomGenerator( 2024 );
+  std::normal_distribution< double > normalDistribution( 0.0, 1.0 );
+  for ( int pointIndex = 0; pointIndex < 50; pointIndex++ )
+  {
+    double point[ 3 ] = { normalDistribution( randomGenerator ), normalDistribution( randomGenerator ), normalDistribution( randomGenerator ) };
+    vtkMath::Normalize( point );
+    vtkMath::MultiplyScalar( point, pointIndex < 40 ? 20.0 : 5.0 );
+    markupsNode->AddControlPoint( point );
+  }
+  const int interiorPointIndex = 45;
+  if ( !CompareWithFullClosedSurfaceUpdate( testScene, name + " initial" ) )
+  {
+    return false;
+  }
+
+  // moving a point within the surface does not modify the output
+  vtkPolyData* outputPolyData = testScene.ModelNode->GetPolyData();
+  vtkMTimeType outputModifiedTime = outputPolyData->GetMTime();
+  markupsNode->SetNthControlPointPosition( interiorPointIndex, 1.0, -2.0, 3.0 );
+  CHECK( testScene.ModelNode->GetPolyData() == outputPolyData && outputPolyData->GetMTime() == outputModifiedTime,
+    name << ": moving an interior point modified the output" );
+  if ( !CompareWithFullClosedSurfaceUpdate( testScene, name + " interior point moved" ) )
+  {
+    return false;
+  }
+
+  // moving the point outside grows the surface
+  markupsNode->SetNthControlPointPosition( interiorPointIndex, 0.0, 0.0, 30.0 );
+  if ( !CompareWithFullClosedSurfaceUpdate( testScene, name + " interior point moved outside" ) )
+  {
+    return false;
+  }
+
+  // adding points inside and outside
+  double insidePoint[ 3 ] = { 2.0, 2.0, -2.0 };
+  markupsNode->AddControlPoint( insidePoint );
+  if ( !CompareWithFullClosedSurfaceUpdate( testScene, name + " interior point added" ) )
+  {
+    return false;
+  }
+  double outsidePoint[ 3 ] = { -25.0, 5.0, 0.0 };
+  markupsNode->AddControlPoint( outsidePoint );
+  if ( !CompareWithFullClosedSurfaceUpdate( testScene, name + " exterior point added" ) )
+  {
+    return false;
+  }
+
+  // moving a hull vertex requires a full update
+  markupsNode->SetNthControlPointPosition( markupsNode->GetNumberOfControlPoints() - 1, -10.0, 5.0, 0.0 );
+  if ( !CompareWithFullClosedSurfaceUpdate( testScene, name + " hull vertex moved" ) )
+  {
+    return false;
+  }
+  return true;
+}
+
+//------------------------------------------------------------------------------
+bool CompareCells( vtkCellArray* cells, vtkCellArray* expectedCells, const std::string& name )
+{
+  CHECK( cells != NULL && expectedCells != NULL, name << ": cells are missing" );
+  CHECK( cells->GetNumberOfCells() == expectedCells->GetNumberOfCells(),
+    name << ": output has " << cells->GetNumberOfCells() << " cells, full update has " << expectedCells->GetNumberOfCells() );
+  for ( vtkIdType cellIndex = 0; cellIndex < cells->GetNumberOfCells(); cellIndex++ )
+  {
+    vtkIdType numberOfCellPoints = 0;
+    const vtkIdType* cellPoints = NULL;
+    vtkIdType expectedNumberOfCellPoints = 0;
+    const vtkIdType* expectedCellPoints = NULL;
+    cells->GetCellAtId( cellIndex, numberOfCellPoints, cellPoints );
+    expectedCells->GetCellAtId( cellIndex, expectedNumberOfCellPoints, expectedCellPoints );
+    CHECK( numberOfCellPoints == expectedNumberOfCellPoints
+      && std::equal( cellPoints, cellPoints + numberOfCellPoints, expectedCellPoints ),
+      name << ": cell " << cellIndex << " differs from the full update" );
+  }
+  return true;
+}
+
+//------------------------------------------------------------------------------
+// Compare the output model of the parameter node with the curve model generated from all the points at once.
+bool CompareWithFullCurveUpdate( TestScene& testScene, const std::string& name )
+{
+  vtkMRMLMarkupsToModelNode* parameterNode = testScene.ParameterNode;
+  vtkSmartPointer< vtkPoints > controlPoints = vtkSmartPointer< vtkPoints >::New();
+  vtkSlicerMarkupsToModelLogic::MarkupsToPoints( testScene.MarkupsNode, controlPoints );
+  vtkSmartPointer< vtkPolyData > expectedPolyData = vtkSmartPointer< vtkPolyData >::New();
+  CHECK( vtkSlicerMarkupsToModelLogic::UpdateOutputCurveModel( controlPoints, expectedPolyData, parameterNode->GetCurveType(),
+    parameterNode->GetTubeLoop(), parameterNode->GetTubeRadius(), parameterNode->GetTubeNumberOfSides(),
+    parameterNode->GetTubeSegmentsBetweenControlPoints(), parameterNode->GetCleanMarkups(), parameterNode->GetPolynomialOrder(),
+    parameterNode->GetPointParameterType(), parameterNode->GetKochanekEndsCopyNearestDerivatives(), parameterNode->GetKochanekBias(),
+    parameterNode->GetKochanekContinuity(), parameterNode->GetKochanekTension(), NULL, parameterNode->GetPolynomialFitType(),
+    parameterNode->GetPolynomialSampleWidth(), parameterNode->GetPolynomialWeightType(), parameterNode->GetTubeCapping(),
+    parameterNode->GetCurveSamplingMode(), parameterNode->GetSamplingAngleTolerance(), parameterNode->GetSamplingChordTolerance(),
+    parameterNode->GetMinimumSamplesPerSegment(), parameterNode->GetMaximumSamplesPerSegment(),
+    parameterNode->GetDuplicatePointTolerance() ), name << ": full update failed" );
+
+  vtkPolyData* outputPolyData = testScene.ModelNode->GetPolyData();
+  CHECK( outputPolyData != NULL, name << ": no output model" );
+  CHECK( outputPolyData->GetNumberOfPoints() == expectedPolyData->GetNumberOfPoints(),
+    name << ": output has " << outputPolyData->GetNumberOfPoints() << " points, full update has " << expectedPolyData->GetNumberOfPoints() );
+  for ( vtkIdType pointIndex = 0; pointIndex < outputPolyData->GetNumberOfPoints(); pointIndex++ )
+  {
+    double point[ 3 ] = { 0.0, 0.0, 0.0 };
+    double expectedPoint[ 3 ] = { 0.0, 0.0, 0.0 };
+    outputPolyData->GetPoint( pointIndex, point );
+    expectedPolyData->GetPoint( pointIndex, expectedPoint );
+    double distance = std::sqrt( vtkMath::Distance2BetweenPoints( point, expectedPoint ) );
+    CHECK( distance <= CURVE_POINT_TOLERANCE_MM,
+      name << ": point " << pointIndex << " is " << distance << " mm from the point of the full update" );
+  }
+  if ( !CompareCells( outputPolyData->GetPolys(), expectedPolyData->GetPolys(), name + " polygons" )
+    || !CompareCells( outputPolyData->GetStrips(), expectedPolyData->GetStrips(), name + " strips" )
+    || !CompareCells( outputPolyData->GetLines(), expectedPolyData->GetLines(), name + " lines" ) )
+  {
+    return false;
+  }
+  return true;
+}
+
+//------------------------------------------------------------------------------
+// The last output update was incremental: the curve and tube were updated in the output mesh, which is not assigned again
+// (the stage times are reset before the update)
+bool IsIncrementalCurveUpdate( vtkMRMLMarkupsToModelNode* parameterNode )
+{
+  return parameterNode->GetNumberOfStageTimeSamples( vtkMRMLMarkupsToModelNode::TubeGenerationTimedStage ) == 1
+    && parameterNode->GetNumberOfStageTimeSamples( vtkMRMLMarkupsToModelNode::AssignOutputTimedStage ) == 0;
+}
+
+//------------------------------------------------------------------------------
+// Point of a helix, so that consecutive segments are neither collinear nor coplanar
+void GetHelixPoint( int pointIndex, double point[ 3 ] )
+{
+  double angle = pointIndex * vtkMath::Pi() / 4.0;
+  point[ 0 ] = 20.0 * std::cos( angle );
+  point[ 1 ] = 20.0 * std::sin( angle );
+  point[ 2 ] = 3.0 * pointIndex;
+}
+
+//------------------------------------------------------------------------------
+bool TestIncrementalCurveAppend( int curveType )
+{
+  TestScene testScene;
+  vtkMRMLMarkupsToModelNode* parameterNode = testScene.ParameterNode;
+  vtkMRMLMarkupsFiducialNode* markupsNode = testScene.MarkupsNode;
+  parameterNode->SetModelType( vtkMRMLMarkupsToModelNode::Curve );
+  parameterNode->SetCurveType( curveType );
+  std::string name = std::string( vtkMRMLMarkupsToModelNode::GetCurveTypeAsString( curveType ) ) + " append";
+  // polynomial fit depends on all the points, so the curve is generated again when a point is appended
+  bool incremental = ( curveType != vtkMRMLMarkupsToModelNode::Polynomial );
+
+  const int initialNumberOfPoints = 3;
+  const int numberOfPoints = 12;
+  for ( int pointIndex = 0; pointIndex < numberOfPoints; pointIndex++ )
+  {
+    double point[ 3 ] = { 0.0, 0.0, 0.0 };
+    GetHelixPoint( pointIndex, point );
+    parameterNode->ResetStageTimes();
+    markupsNode->AddControlPoint( point );
+    std::ostringstream pointName;
+    pointName << name << " point " << pointIndex;
+    if ( incremental && pointIndex >= initialNumberOfPoints )
+    {
+      CHECK( IsIncrementalCurveUpdate( parameterNode ), pointName.str() << ": curve was not extended incrementally" );
+    }
+    if ( pointIndex > 0 && !CompareWithFullCurveUpdate( testScene, pointName.str() ) )
+    {
+      return false;
+    }
+  }
+
+  // the tube is extended in place, also with capping off
+  parameterNode->SetTubeCapping( false );
+  double point[ 3 ] = { 0.0, 0.0, 0.0 };
+  GetHelixPoint( numberOfPoints, point );
+  parameterNode->ResetStageTimes();
+  markupsNode->AddControlPoint( point );
+  if ( incremental )
+  {
+    CHECK( IsIncrementalCurveUpdate( parameterNode ), name << " without capping: curve was not extended incrementally" );
+  }
+  return CompareWithFullCurveUpdate( testScene, name + " without capping" );
+}
+
+//------------------------------------------------------------------------------
+bool TestIncrementalCurveDrag( int curveType, int polynomialFitType )
+{
+  TestScene testScene;
+  vtkMRMLMarkupsToModelNode* parameterNode = testScene.ParameterNode;
+  vtkMRMLMarkupsFiducialNode* markupsNode = testScene.MarkupsNode;
+  parameterNode->SetModelType( vtkMRMLMarkupsToModelNode::Curve );
+  parameterNode->SetCurveType( curveType );
+  parameterNode->SetPolynomialFitType( polynomialFitType );
+  std::string name = std::string( vtkMRMLMarkupsToModelNode::GetCurveTypeAsString( curveType ) ) + " drag";
+  if ( curveType == vtkMRMLMarkupsToModelNode::Polynomial )
+  {
+    name = name + " (" + vtkMRMLMarkupsToModelNode::GetPolynomialFitTypeAsString( polynomialFitType ) + ")";
+  }
+
+  const int numberOfPoints = 10;
+  for ( int pointIndex = 0; pointIndex < numberOfPoints; pointIndex++ )
+  {
+    double point[ 3 ] = { 0.0, 0.0, 0.0 };
+    GetHelixPoint( pointIndex, point );
+    markupsNode->AddControlPoint( point );
+  }
+  if ( !CompareWithFullCurveUpdate( testScene, name + " initial" ) )
+  {
+    return false;
+  }
+
+  // each point is moved in a few steps, as during dragging
+  const int draggedPointIndices[ 3 ] = { 0, numberOfPoints / 2, numberOfPoints - 1 };
+  for ( int draggedIndex = 0; draggedIndex < 3; draggedIndex++ )
+  {
+    int pointIndex = draggedPointIndices[ draggedIndex ];
+    double point[ 3 ] = { 0.0, 0.0, 0.0 };
+    markupsNode->GetNthControlPointPosition( pointIndex, point );
+    for ( int step = 1; step <= 3; step++ )
+    {
+      parameterNode->ResetStageTimes();
+      markupsNode->SetNthControlPointPosition( pointIndex, point[ 0 ] + 2.0 * step, point[ 1 ] - 1.5 * step, point[ 2 ] + step );
+      std::ostringstream stepName;
+      stepName << name << " point " << pointIndex << " step " << step;
+      CHECK( IsIncrementalCurveUpdate( parameterNode ), stepName.str() << ": curve was not updated locally" );
+      if ( !CompareWithFullCurveUpdate( testScene, stepName.str() ) )
+      {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+//------------------------------------------------------------------------------
+// Remove the duplicate points with vtkCleanPolyData (points are merged into the first point within the tolerance).
+void RemoveDuplicatePointsWithCleanPolyData( vtkPoints* points, double tolerance )
+{
+  vtkSmartPointer< vtkCellArray > vertices = vtkSmartPointer< vtkCellArray >::New();
+  for ( vtkIdType pointIndex = 0; pointIndex < points->GetNumberOfPoints(); pointIndex++ )
+  {
+    vertices->InsertNextCell( 1, &pointIndex );
+  }
+  vtkSmartPointer< vtkPolyData > polyData = vtkSmartPointer< vtkPolyData >::New();
+  polyData->SetPoints( points );
+  polyData->SetVerts( vertices );
+  vtkSmartPointer< vtkCleanPolyData > cleanPolyData = vtkSmartPointer< vtkCleanPolyData >::New();
+  cleanPolyData->SetInputData( polyData );
+  cleanPolyData->ToleranceIsAbsoluteOn();
+  cleanPolyData->SetAbsoluteTolerance( tolerance );
+  cleanPolyData->PointMergingOn();
+  cleanPolyData->Update();
+  points->DeepCopy( cleanPolyData->GetOutput()->GetPoints() );
+}
+
+//------------------------------------------------------------------------------
+bool CompareDuplicatePointRemoval( vtkPoints* inputPoints, double tolerance, const std::string& name )
+{
+  vtkSmartPointer< vtkPoints > points = vtkSmartPointer< vtkPoints >::New();
+  points->DeepCopy( inputPoints );
+  vtkIdType numberOfRemovedPoints = vtkSlicerMarkupsToModelLogic::RemoveDuplicatePoints( points, tolerance );
+  vtkSmartPointer< vtkPoints > expectedPoints = vtkSmartPointer< vtkPoints >::New();
+  expectedPoints->DeepCopy( inputPoints );
+  RemoveDuplicatePointsWithCleanPolyData( expectedPoints, tolerance );
+
+  CHECK( points->GetNumberOfPoints() == expectedPoints->GetNumberOfPoints(),
+    name << ": " << points->GetNumberOfPoints() << " points kept, vtkCleanPolyData kept " << expectedPoints->GetNumberOfPoints() );
+  CHECK( numberOfRemovedPoints == inputPoints->GetNumberOfPoints() - points->GetNumberOfPoints(),
+    name << ": wrong number of removed points reported: " << numberOfRemovedPoints );
+  for ( vtkIdType pointIndex = 0; pointIndex < points->GetNumberOfPoints(); pointIndex++ )
+  {
+    double point[ 3 ] = { 0.0, 0.0, 0.0 };
+    double expectedPoint[ 3 ] = { 0.0, 0.0, 0.0 };
+    points->GetPoint( pointIndex, point );
+    expectedPoints->GetPoint( pointIndex, expectedPoint );
+    CHECK( vtkMath::Distance2BetweenPoints( point, expectedPoint ) == 0.0, name << ": point " << pointIndex << " differs from vtkCleanPolyData" );
+  }
+  return true;
+}
+
+//------------------------------------------------------------------------------
+bool TestRemoveDuplicatePoints()
+{
+  // Clusters of points that are much closer to each other than the tolerance, clusters are much farther apart.
+  // Then the result does not depend on which points the duplicates are merged into, only the order of points matters.
+  const double tolerance = 0.01;
+  std::mt19937 randomGenerator( 11 );
+  std::uniform_real_distribution< double > clusterDistribution( -100.0, 100.0 );
+  std::uniform_real_distribution< double > offsetDistribution( -0.1 * tolerance, 0.1 * tolerance );
+  std::uniform_int_distribution< int > clusterSizeDistribution( 1, 4 );
+  vtkSmartPointer< vtkPoints > clusteredPoints = vtkSmartPointer< vtkPoints >::New();
+  clusteredPoints->SetDataTypeToDouble();
+  std::vector< double > clusterCenters;
+  for ( int clusterIndex = 0; clusterIndex < 1000; clusterIndex++ )
+  {
+    double center[ 3 ] = { clusterDistribution( randomGenerator ), clusterDistribution( randomGenerator ), clusterDistribution( randomGenerator ) };
+    clusterCenters.insert( clusterCenters.end(), center, center + 3 );
+  }
+  for ( int repetitionIndex = 0; repetitionIndex < 3; repetitionIndex++ )
+  {
+    // duplicates are interleaved with other points
+    for ( int clusterIndex = 0; clusterIndex < 1000; clusterIndex++ )
+    {
+      int clusterSize = clusterSizeDistribution( randomGenerator );
+      for ( int i = 0; i < clusterSize; i++ )
+      {
+        clusteredPoints->InsertNextPoint( clusterCenters[ 3 * clusterIndex ] + offsetDistribution( randomGenerator ),
+          clusterCenters[ 3 * clusterIndex + 1 ] + offsetDistribution( randomGenerator ),
+          clusterCenters[ 3 * clusterIndex + 2 ] + offsetDistribution( randomGenerator ) );
+      }
+    }
+  }
+  if ( !CompareDuplicatePointRemoval( clusteredPoints, tolerance, "clusters" ) )
+  {
+    return false;
+  }
+
+  // Exact duplicates far from the origin, with a tolerance that is tiny compared to the coordinates
+  // (grid cell indices would overflow if the cell size was not limited)
+  vtkSmartPointer< vtkPoints > distantPoints = vtkSmartPointer< vtkPoints >::New();
+  distantPoints->SetDataTypeToDouble();
+  for ( int repetitionIndex = 0; repetitionIndex < 2; repetitionIndex++ )
+  {
+    for ( int pointIndex = 0; pointIndex < 100; pointIndex++ )
+    {
+      distantPoints->InsertNextPoint( 1.0e8 + pointIndex, -1.0e8 - 2.0 * pointIndex, 5.0e7 );
+    }
+  }
+  vtkIdType numberOfRemovedPoints = vtkSlicerMarkupsToModelLogic::RemoveDuplicatePoints( distantPoints, 1.0e-300 );
+  CHECK( numberOfRemovedPoints == 100 && distantPoints->GetNumberOfPoints() == 100,
+    "Exact duplicates with tiny tolerance: " << numberOfRemovedPoints << " points removed, expected 100" );
+  double secondPoint[ 3 ] = { 0.0, 0.0, 0.0 };
+  distantPoints->GetPoint( 1, secondPoint );
+  CHECK( secondPoint[ 0 ] == 1.0e8 + 1.0 && secondPoint[ 1 ] == -1.0e8 - 2.0, "Order of the kept points changed" );
+  return true;
+}
+
+//------------------------------------------------------------------------------
+// Check that the closed surface generated with the alpha value is a single piece, and all the points are on it or inside it.
+bool CheckSingleSurfaceContainsPoints( vtkPoints* points, double delaunayAlpha, const std::string& name )
+{
+  vtkSmartPointer< vtkPolyData > surfacePolyData = vtkSmartPointer< vtkPolyData >::New();
+  CHECK( vtkSlicerMarkupsToModelLogic::UpdateClosedSurfaceModel( points, surfacePolyData, false, false, delaunayAlpha, true, false ),
+    name << ": surface generation failed" );
+
+  vtkSmartPointer< vtkPolyDataConnectivityFilter > connectivityFilter = vtkSmartPointer< vtkPolyDataConnectivityFilter >::New();
+  connectivityFilter->SetInputData( surfacePolyData );
+  connectivityFilter->SetExtractionModeToAllRegions();
+  connectivityFilter->Update();
+  CHECK( connectivityFilter->GetNumberOfExtractedRegions() == 1,
+    name << ": surface has " << connectivityFilter->GetNumberOfExtractedRegions() << " pieces" );
+
+  vtkSmartPointer< vtkSelectEnclosedPoints > enclosedPoints = vtkSmartPointer< vtkSelectEnclosedPoints >::New();
+  enclosedPoints->Initialize( surfacePolyData );
+  vtkPoints* surfacePoints = surfacePolyData->GetPoints();
+  for ( vtkIdType pointIndex = 0; pointIndex < points->GetNumberOfPoints(); pointIndex++ )
+  {
+    double point[ 3 ] = { 0.0, 0.0, 0.0 };
+    points->GetPoint( pointIndex, point );
+    bool onSurface = false;
+    for ( vtkIdType surfacePointIndex = 0; surfacePointIndex < surfacePoints->GetNumberOfPoints() && !onSurface; surfacePointIndex++ )
+    {
+      double surfacePoint[ 3 ] = { 0.0, 0.0, 0.0 };
+      surfacePoints->GetPoint( surfacePointIndex, surfacePoint );
+      onSurface = ( vtkMath::Distance2BetweenPoints( point, surfacePoint ) < 1.0e-10 );
+    }
+    if ( !onSurface && !enclosedPoints->IsInsideSurface( point ) )
+    {
+      enclosedPoints->Complete();
+      std::cerr << name << ": point " << pointIndex << " is outside of the surface" << std::endl;
+      return false;
+    }
+  }
+  enclosedPoints->Complete();
+  return true;
+}
+
+//------------------------------------------------------------------------------
+bool TestAutomaticDelaunayAlpha()
+{
+  TestScene testScene;
+  vtkMRMLMarkupsToModelNode* parameterNode = testScene.ParameterNode;
+  vtkMRMLMarkupsFiducialNode* markupsNode = testScene.MarkupsNode;
+  parameterNode->SetAutoUpdateOutput( false );
+
+  // Non-convex shape: points on the surface of two overlapping spheres, and a few inside
+  std::mt19937 randomGenerator( 7 );
+  std::normal_distribution< double > normalDistribution( 0.0, 1.0 );
+  const double sphereRadius = 10.0;
+  const double sphereCenterX[ 2 ] = { -8.0, 8.0 };
+  int disabledModify = markupsNode->StartModify();
+  for ( int pointIndex = 0; pointIndex < 600; pointIndex++ )
+  {
+    int sphereIndex = pointIndex % 2;
+    double point[ 3 ] = { normalDistribution( randomGenerator ), normalDistribution( randomGenerator ), normalDistribution( randomGenerator ) };
+    vtkMath::Normalize( point );
+    vtkMath::MultiplyScalar( point, pointIndex < 580 ? sphereRadius : 0.5 * sphereRadius );
+    point[ 0 ] += sphereCenterX[ sphereIndex ];
+    double otherCenter[ 3 ] = { sphereCenterX[ 1 - sphereIndex ], 0.0, 0.0 };
+    if ( pointIndex < 580 && vtkMath::Distance2BetweenPoints( point, otherCenter ) < sphereRadius * sphereRadius )
+    {
+      // inside the other sphere
+      continue;
+    }
+    markupsNode->AddControlPoint( point );
+  }
+  markupsNode->EndModify( disabledModify );
+
+  double delaunayAlpha = testScene.Logic->ComputeAutomaticDelaunayAlpha( parameterNode );
+  CHECK( delaunayAlpha > 0.0, "Automatic Delaunay alpha could not be computed" );
+  vtkSmartPointer< vtkPoints > controlPoints = vtkSmartPointer< vtkPoints >::New();
+  vtkSlicerMarkupsToModelLogic::MarkupsToPoints( markupsNode, controlPoints );
+  if ( !CheckSingleSurfaceContainsPoints( controlPoints, delaunayAlpha, "automatic alpha" ) )
+  {
+    return false;
+  }
+  // the module rounds the value up to the precision of the GUI, which must not change the result
+  if ( !CheckSingleSurfaceContainsPoints( controlPoints, delaunayAlpha + 0.001, "rounded automatic alpha" ) )
+  {
+    return false;
+  }
+  return true;
+}
+
+//------------------------------------------------------------------------------
+// Deleting the logic while a background update is running must stop and join the worker thread
+// (the job must not access the logic or the scene after that).
+bool TestDeleteLogicDuringAsynchronousUpdate()
+{
+  std::unique_ptr< TestScene > testScene( new TestScene );
+  vtkMRMLMarkupsToModelNode* parameterNode = testScene->ParameterNode;
+  vtkMRMLMarkupsFiducialNode* markupsNode = testScene->MarkupsNode;
+  parameterNode->SetModelType( vtkMRMLMarkupsToModelNode::ClosedSurface );
+  parameterNode->SetDelaunayAlpha( 100.0 ); // tetrahedralization and subdivision take long enough to delete the logic meanwhile
+  parameterNode->SetButterflySubdivision( true );
+  parameterNode->SetAsynchronousUpdate( true );
+  // points are added without updating the output after each point
+  parameterNode->SetAutoUpdateOutput( false );
+
+  std::mt19937 randomGenerator( 2024 );
+  std::uniform_real_distribution< double > uniformDistribution( -50.0, 50.0 );
+  for ( int pointIndex = 0; pointIndex < 20000; pointIndex++ )
+  {
+    double point[ 3 ] = { uniformDistribution( randomGenerator ), uniformDistribution( randomGenerator ), uniformDistribution( randomGenerator ) };
+    markupsNode->AddControlPoint( point );
+  }
+  testScene->Logic->UpdateOutputModel( parameterNode );
+  CHECK( testScene->Logic->GetAsynchronousUpdateStatus( parameterNode ) == vtkSlicerMarkupsToModelLogic::AsynchronousUpdateRunning,
+    "Background update is not running" );
+  CHECK( testScene->Logic->HasPendingUpdates(), "Running background update is not reported as pending" );
+
+  // returns when the job has stopped
+  testScene.reset();
+  return true;
+}
+
+//------------------------------------------------------------------------------
+// Output model was replaced or modified since the time of the last check (which is updated)
+bool IsOutputModified( TestScene& testScene, vtkPolyData*& outputPolyData, vtkMTimeType& outputModifiedTime )
+{
+  vtkPolyData* currentOutputPolyData = testScene.ModelNode->GetPolyData();
+  bool modified = ( currentOutputPolyData != outputPolyData
+    || ( currentOutputPolyData != NULL && currentOutputPolyData->GetMTime() != outputModifiedTime ) );
+  outputPolyData = currentOutputPolyData;
+  outputModifiedTime = ( currentOutputPolyData != NULL ? currentOutputPolyData->GetMTime() : 0 );
+  return modified;
+}
+
+//------------------------------------------------------------------------------
+bool TestInputModificationWithoutPointChange()
+{
+  TestScene testScene;
+  vtkSlicerMarkupsToModelLogic* logic = testScene.Logic;
+  vtkMRMLMarkupsFiducialNode* markupsNode = testScene.MarkupsNode;
+  testScene.ParameterNode->SetModelType( vtkMRMLMarkupsToModelNode::Curve );
+  for ( int pointIndex = 0; pointIndex < 5; pointIndex++ )
+  {
+    double point[ 3 ] = { 10.0 * pointIndex, 5.0 * ( pointIndex % 2 ), 0.0 };
+    markupsNode->AddControlPoint( point );
+  }
+  vtkPolyData* outputPolyData = NULL;
+  vtkMTimeType outputModifiedTime = 0;
+  IsOutputModified( testScene, outputPolyData, outputModifiedTime );
+  CHECK( outputPolyData != NULL && outputPolyData->GetNumberOfPoints() > 0, "No output model" );
+  logic->ResetUpdateRequestCounters();
+
+  // selection and label do not change the points
+  markupsNode->SetNthControlPointSelected( 1, false );
+  markupsNode->SetNthControlPointLabel( 2, "renamed" );
+  CHECK( logic->GetNumberOfUpdateRequests() == 0,
+    "Modifications that do not move points requested " << logic->GetNumberOfUpdateRequests() << " updates" );
+  CHECK( logic->GetNumberOfSkippedUpdateRequests() >= 2,
+    "Modifications that do not move points were not skipped (" << logic->GetNumberOfSkippedUpdateRequests() << " skipped)" );
+  CHECK( !IsOutputModified( testScene, outputPolyData, outputModifiedTime ), "Selecting or renaming a point modified the output" );
+
+  // moving a point does
+  vtkTypeUInt64 numberOfSkippedUpdateRequests = logic->GetNumberOfSkippedUpdateRequests();
+  markupsNode->SetNthControlPointPosition( 1, 10.0, -5.0, 2.0 );
+  CHECK( logic->GetNumberOfUpdateRequests() == 1,
+    "Moving a point requested " << logic->GetNumberOfUpdateRequests() << " updates instead of 1" );
+  CHECK( logic->GetNumberOfSkippedUpdateRequests() == numberOfSkippedUpdateRequests, "Moving a point was skipped" );
+  CHECK( IsOutputModified( testScene, outputPolyData, outputModifiedTime ), "Moving a point did not modify the output" );
+
+  // setting the same position again does not
+  markupsNode->SetNthControlPointPosition( 1, 10.0, -5.0, 2.0 );
+  CHECK( logic->GetNumberOfUpdateRequests() == 1, "Setting the same position requested an update" );
+  CHECK( !IsOutputModified( testScene, outputPolyData, outputModifiedTime ), "Setting the same position modified the output" );
+  return true;
+}
+
+} // namespace
+
+//------------------------------------------------------------------------------
+int vtkSlicerMarkupsToModelLogicTest( int vtkNotUsed( argc ), char* vtkNotUsed( argv )[] )
+{
+  if ( !TestIncrementalClosedSurfaceUpdate( false ) || !TestIncrementalClosedSurfaceUpdate( true )
+    || !TestIncrementalCurveAppend( vtkMRMLMarkupsToModelNode::Linear )
+    || !TestIncrementalCurveAppend( vtkMRMLMarkupsToModelNode::CardinalSpline )
+    || !TestIncrementalCurveAppend( vtkMRMLMarkupsToModelNode::KochanekSpline )
+    || !TestIncrementalCurveAppend( vtkMRMLMarkupsToModelNode::Polynomial )
+    || !TestIncrementalCurveDrag( vtkMRMLMarkupsToModelNode::Linear, vtkMRMLMarkupsToModelNode::GlobalLeastSquares )
+    || !TestIncrementalCurveDrag( vtkMRMLMarkupsToModelNode::CardinalSpline, vtkMRMLMarkupsToModelNode::GlobalLeastSquares )
+    || !TestIncrementalCurveDrag( vtkMRMLMarkupsToModelNode::KochanekSpline, vtkMRMLMarkupsToModelNode::GlobalLeastSquares )
+    || !TestIncrementalCurveDrag( vtkMRMLMarkupsToModelNode::Polynomial, vtkMRMLMarkupsToModelNode::GlobalLeastSquares )
+    || !TestIncrementalCurveDrag( vtkMRMLMarkupsToModelNode::Polynomial, vtkMRMLMarkupsToModelNode::MovingLeastSquares )
+    || !TestRemoveDuplicatePoints() || !TestAutomaticDelaunayAlpha() || !TestDeleteLogicDuringAsynchronousUpdate()
+    || !TestInputModificationWithoutPointChange() )
+  {
+    return EXIT_FAILURE;
+  }
+  std::cout << "Test passed" << std::endl;
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,335 @@
+/*==============================================================================
+
+  Program: 3D Slicer
+
+  Portions (c) Copyright Brigham and Women's Hospital (BWH) All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+  ==============================================================================*/
+
+// Test of vtkSlicerMarkupsToModelMeshCache.
+//
+// Stored models must be loaded unchanged, both while the file is being written and from the file in a later session.
+// Corrupt files (truncated, or with array sizes that exceed the file) must be rejected and removed.
+// Files of other keys and models with invalid cells (offsets or point ids out of range) must be rejected as well.
+// The test takes a temporary directory as argument, the cache files are written into a subdirectory of it.
+
+// MarkupsToModel includes
+#include "vtkSlicerMarkupsToModelMeshCache.h"
+
+// VTK includes
+#include <vtkCellArray.h>
+#include <vtkDataArray.h>
+#include <vtkPointData.h>
+#include <vtkPolyData.h>
+#include <vtkSmartPointer.h>
+#include <vtkSphereSource.h>
+#include <vtkTypeInt64Array.h>
+#include <vtksys/SystemTools.hxx>
+
+// STD includes
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+namespace
+{
+
+//------------------------------------------------------------------------------
+// constants within this file
+const double CURVE_LENGTH = 123.5;
+const char* MODEL_KEY = "0123456789abcdef";
+const char* OTHER_MODEL_KEY = "fedcba9876543210";
+// position of the number of tuples of the point array in a cache file:
+// magic, version, key length, key, curve length, data type, components
+const std::streamoff POINT_ARRAY_NUMBER_OF_TUPLES_POSITION = 4 + 4 + 4 + 16 + 8 + 4 + 4;
+
+//------------------------------------------------------------------------------
+#define CHECK( condition, message ) \
+  if ( !( condition ) ) \
+  { \
+    std::cerr << "Line " << __LINE__ << ": " << message << std::endl; \
+    return false; \
+  }
+
+//------------------------------------------------------------------------------
+bool CompareArrays( vtkDataArray* array, vtkDataArray* expectedArray, const std::string& name )
+{
+  CHECK( array != NULL && expectedArray != NULL, name << ": array is missing" );
+  CHECK( array->GetDataType() == expectedArray->GetDataType(), name << ": data type mismatch" );
+  CHECK( array->GetNumberOfComponents() == expectedArray->GetNumberOfComponents(), name << ": number of components mismatch" );
+  CHECK( array->GetNumberOfTuples() == expectedArray->GetNumberOfTuples(), name << ": number of tuples mismatch" );
+  for ( vtkIdType tupleIndex = 0; tupleIndex < array->GetNumberOfTuples(); tupleIndex++ )
+  {
+    for ( int componentIndex = 0; componentIndex < array->GetNumberOfComponents(); componentIndex++ )
+    {
+      CHECK( array->GetComponent( tupleIndex, componentIndex ) == expectedArray->GetComponent( tupleIndex, componentIndex ),
+        name << ": value mismatch at tuple " << tupleIndex );
+    }
+  }
+  return true;
+}
+
+//------------------------------------------------------------------------------
+bool ComparePolyData( vtkPolyData* polyData, vtkPolyData* expectedPolyData, const std::string& name )
+{
+  CHECK( polyData->GetPoints() != NULL, name << ": no points" );
+  if ( !CompareArrays( polyData->GetPoints()->GetData(), expectedPolyData->GetPoints()->GetData(), name + " points" )
+    || !CompareArrays( polyData->GetPolys()->GetOffsetsArray(), expectedPolyData->GetPolys()->GetOffsetsArray(), name + " polygon offsets" )
+    || !CompareArrays( polyData->GetPolys()->GetConnectivityArray(), expectedPolyData->GetPolys()->GetConnectivityArray(), name + " polygon connectivity" )
+    || !CompareArrays( polyData->GetPointData()->GetNormals(), expectedPolyData->GetPointData()->GetNormals(), name + " normals" ) )
+  {
+    return false;
+  }
+  return true;
+}
+
+//------------------------------------------------------------------------------
+vtkSmartPointer< vtkPolyData > CreateModel()
+{
+  vtkSmartPointer< vtkSphereSource > sphereSource = vtkSmartPointer< vtkSphereSource >::New();
+  sphereSource->SetRadius( 10.0 );
+  sphereSource->SetThetaResolution( 16 );
+  sphereSource->SetPhiResolution( 12 );
+  sphereSource->Update();
+  return sphereSource->GetOutput();
+}
+
+//------------------------------------------------------------------------------
+// Cache in an empty directory, with the model stored and written to the file
+vtkSmartPointer< vtkSlicerMarkupsToModelMeshCache > CreateCacheWithModel( const std::string& cacheDirectory, vtkPolyData* model )
+{
+  vtksys::SystemTools::RemoveADirectory( cacheDirectory );
+  vtkSmartPointer< vtkSlicerMarkupsToModelMeshCache > cache = vtkSmartPointer< vtkSlicerMarkupsToModelMeshCache >::New();
+  cache->SetCacheDirectory( cacheDirectory.c_str() );
+  cache->Store( MODEL_KEY, model, CURVE_LENGTH );
+  cache->Flush();
+  return cache;
+}
+
+//------------------------------------------------------------------------------
+bool TestStoreAndLoad( const std::string& cacheDirectory )
+{
+  vtkSmartPointer< vtkPolyData > model = CreateModel();
+  vtksys::SystemTools::RemoveADirectory( cacheDirectory );
+  vtkSmartPointer< vtkSlicerMarkupsToModelMeshCache > cache = vtkSmartPointer< vtkSlicerMarkupsToModelMeshCache >::New();
+  cache->SetCacheDirectory( cacheDirectory.c_str() );
+  CHECK( cache->IsEnabled(), "Cache is not enabled" );
+  CHECK( cache->Store( MODEL_KEY, model, CURVE_LENGTH ), "Store failed" );
+
+  // loaded from the stored copy or from the file, depending on whether the file is written already
+  vtkSmartPointer< vtkPolyData > loadedModel = vtkSmartPointer< vtkPolyData >::New();
+  double curveLength = 0.0;
+  CHECK( cache->Load( MODEL_KEY, loadedModel, curveLength ), "Load after Store failed" );
+  CHECK( curveLength == CURVE_LENGTH, "Curve length mismatch after Store" );
+  if ( !ComparePolyData( loadedModel, model, "after Store" ) )
+  {
+    return false;
+  }
+  CHECK( !cache->Load( OTHER_MODEL_KEY, loadedModel, curveLength ), "Load of a model that was not stored succeeded" );
+
+  cache->Flush();
+  CHECK( cache->GetNumberOfEntries() == 1, "Number of entries is " << cache->GetNumberOfEntries() << " instead of 1" );
+  CHECK( cache->GetCacheSize() > 0, "Cache size is 0" );
+
+  // later session
+  vtkSmartPointer< vtkSlicerMarkupsToModelMeshCache > nextCache = vtkSmartPointer< vtkSlicerMarkupsToModelMeshCache >::New();
+  nextCache->SetCacheDirectory( cacheDirectory.c_str() );
+  CHECK( nextCache->GetNumberOfEntries() == 1, "Stored file is not found in the cache directory" );
+  loadedModel = vtkSmartPointer< vtkPolyData >::New();
+  curveLength = 0.0;
+  CHECK( nextCache->Load( MODEL_KEY, loadedModel, curveLength ), "Load from file failed" );
+  CHECK( curveLength == CURVE_LENGTH, "Curve length mismatch after loading from file" );
+  if ( !ComparePolyData( loadedModel, model, "from file" ) )
+  {
+    return false;
+  }
+  CHECK( nextCache->GetNumberOfHits() == 1 && nextCache->GetNumberOfMisses() == 0, "Wrong number of hits or misses" );
+  return true;
+}
+
+//------------------------------------------------------------------------------
+// Replace the cache file of the model by the first numberOfBytes bytes of it, with the point array size modified if
+// numberOfPoints is not negative. The cache is reopened, so that the entry is found in the directory.
+bool LoadCorruptFile( const std::string& cacheDirectory, std::streamoff numberOfBytes, vtkTypeInt64 numberOfPoints,
+  const std::string& name )
+{
+  vtkSmartPointer< vtkPolyData > model = CreateModel();
+  vtkSmartPointer< vtkSlicerMarkupsToModelMeshCache > cache = CreateCacheWithModel( cacheDirectory, model );
+  std::string filePath = cacheDirectory + "/" + MODEL_KEY + ".mtmmesh";
+  CHECK( vtksys::SystemTools::FileExists( filePath ), name << ": cache file " << filePath << " was not written" );
+
+  std::vector< char > contents;
+  {
+    std::ifstream inputStream( filePath.c_str(), std::ios::in | std::ios::binary );
+    contents.assign( std::istreambuf_iterator< char >( inputStream ), std::istreambuf_iterator< char >() );
+  }
+  if ( numberOfBytes >= 0 && numberOfBytes < static_cast< std::streamoff >( contents.size() ) )
+  {
+    contents.resize( numberOfBytes );
+  }
+  if ( numberOfPoints >= 0 )
+  {
+    CHECK( static_cast< std::streamoff >( contents.size() ) >= POINT_ARRAY_NUMBER_OF_TUPLES_POSITION + 8, name << ": file is too short" );
+    std::copy( reinterpret_cast< const char* >( &numberOfPoints ), reinterpret_cast< const char* >( &numberOfPoints ) + 8,
+      contents.begin() + POINT_ARRAY_NUMBER_OF_TUPLES_POSITION );
+  }
+  {
+    std::ofstream outputStream( filePath.c_str(), std::ios::out | std::ios::binary | std::ios::trunc );
+    outputStream.write( contents.data(), contents.size() );
+  }
+
+  vtkSmartPointer< vtkSlicerMarkupsToModelMeshCache > nextCache = vtkSmartPointer< vtkSlicerMarkupsToModelMeshCache >::New();
+  nextCache->SetCacheDirectory( cacheDirectory.c_str() );
+  CHECK( nextCache->GetNumberOfEntries() == 1, name << ": cache file is not found in the cache directory" );
+  vtkSmartPointer< vtkPolyData > loadedModel = vtkSmartPointer< vtkPolyData >::New();
+  double curveLength = 0.0;
+  CHECK( !nextCache->Load( MODEL_KEY, loadedModel, curveLength ), name << ": corrupt file was loaded" );
+  CHECK( nextCache->GetNumberOfEntries() == 0, name << ": corrupt file is still in the cache" );
+  CHECK( !vtksys::SystemTools::FileExists( filePath ), name << ": corrupt file was not removed" );
+  return true;
+}
+
+//------------------------------------------------------------------------------
+// Reopen the cache and check that the file of the model is rejected and removed
+bool CheckFileRejected( const std::string& cacheDirectory, const std::string& name )
+{
+  std::string filePath = cacheDirectory + "/" + MODEL_KEY + ".mtmmesh";
+  vtkSmartPointer< vtkSlicerMarkupsToModelMeshCache > cache = vtkSmartPointer< vtkSlicerMarkupsToModelMeshCache >::New();
+  cache->SetCacheDirectory( cacheDirectory.c_str() );
+  CHECK( cache->GetNumberOfEntries() == 1, name << ": cache file is not found in the cache directory" );
+  vtkSmartPointer< vtkPolyData > loadedModel = vtkSmartPointer< vtkPolyData >::New();
+  double curveLength = 0.0;
+  CHECK( !cache->Load( MODEL_KEY, loadedModel, curveLength ), name << ": invalid file was loaded" );
+  CHECK( cache->GetNumberOfEntries() == 0, name << ": invalid file is still in the cache" );
+  CHECK( !vtksys::SystemTools::FileExists( filePath ), name << ": invalid file was not removed" );
+  return true;
+}
+
+//------------------------------------------------------------------------------
+// The file of another key, renamed to the file name of the model, must not be loaded
+bool TestFileOfOtherKey( const std::string& cacheDirectory )
+{
+  vtksys::SystemTools::RemoveADirectory( cacheDirectory );
+  vtkSmartPointer< vtkSlicerMarkupsToModelMeshCache > cache = vtkSmartPointer< vtkSlicerMarkupsToModelMeshCache >::New();
+  cache->SetCacheDirectory( cacheDirectory.c_str() );
+  cache->Store( OTHER_MODEL_KEY, CreateModel(), CURVE_LENGTH );
+  cache->Flush();
+  std::string otherFilePath = cacheDirectory + "/" + OTHER_MODEL_KEY + ".mtmmesh";
+  CHECK( vtksys::SystemTools::FileExists( otherFilePath ), "cache file " << otherFilePath << " was not written" );
+  CHECK( vtksys::SystemTools::RenameFile( otherFilePath, cacheDirectory + "/" + MODEL_KEY + ".mtmmesh" ), "cache file cannot be renamed" );
+  return CheckFileRejected( cacheDirectory, "file of other key" );
+}
+
+//------------------------------------------------------------------------------
+// A model with the given polygon offsets and connectivity is written into the cache file, it must not be loaded
+bool LoadInvalidCells( const std::string& cacheDirectory, const std::vector< vtkTypeInt64 >& offsetValues,
+  const std::vector< vtkTypeInt64 >& connectivityValues, const std::string& name )
+{
+  vtkSmartPointer< vtkPolyData > model = CreateModel();
+  vtkSmartPointer< vtkTypeInt64Array > offsets = vtkSmartPointer< vtkTypeInt64Array >::New();
+  for ( std::vector< vtkTypeInt64 >::const_iterator offsetIt = offsetValues.begin(); offsetIt != offsetValues.end(); ++offsetIt )
+  {
+    offsets->InsertNextValue( *offsetIt );
+  }
+  vtkSmartPointer< vtkTypeInt64Array > connectivity = vtkSmartPointer< vtkTypeInt64Array >::New();
+  for ( std::vector< vtkTypeInt64 >::const_iterator pointIdIt = connectivityValues.begin(); pointIdIt != connectivityValues.end(); ++pointIdIt )
+  {
+    connectivity->InsertNextValue( *pointIdIt );
+  }
+  vtkSmartPointer< vtkCellArray > polys = vtkSmartPointer< vtkCellArray >::New();
+  polys->SetData( offsets, connectivity );
+  model->SetPolys( polys );
+  CreateCacheWithModel( cacheDirectory, model );
+  std::string filePath = cacheDirectory + "/" + MODEL_KEY + ".mtmmesh";
+  CHECK( vtksys::SystemTools::FileExists( filePath ), name << ": cache file " << filePath << " was not written" );
+  return CheckFileRejected( cacheDirectory, name );
+}
+
+//------------------------------------------------------------------------------
+bool TestInvalidCells( const std::string& cacheDirectory )
+{
+  vtkTypeInt64 numberOfPoints = CreateModel()->GetNumberOfPoints();
+  std::vector< vtkTypeInt64 > offsets;
+  std::vector< vtkTypeInt64 > connectivity;
+  connectivity.push_back( 0 );
+  connectivity.push_back( 1 );
+  connectivity.push_back( 2 );
+  connectivity.push_back( 3 );
+  connectivity.push_back( 4 );
+  connectivity.push_back( numberOfPoints );
+  offsets.push_back( 0 );
+  offsets.push_back( 3 );
+  offsets.push_back( 6 );
+  if ( !LoadInvalidCells( cacheDirectory, offsets, connectivity, "point id out of range" ) )
+  {
+    return false;
+  }
+  connectivity.back() = 5;
+  offsets[ 1 ] = 7;
+  if ( !LoadInvalidCells( cacheDirectory, offsets, connectivity, "decreasing offsets" ) )
+  {
+    return false;
+  }
+  offsets[ 0 ] = 1;
+  offsets[ 1 ] = 3;
+  if ( !LoadInvalidCells( cacheDirectory, offsets, connectivity, "offsets not starting at 0" ) )
+  {
+    return false;
+  }
+  offsets[ 0 ] = 0;
+  offsets[ 2 ] = 5;
+  return LoadInvalidCells( cacheDirectory, offsets, connectivity, "offsets not ending at the connectivity size" );
+}
+
+//------------------------------------------------------------------------------
+bool TestCorruptFiles( const std::string& cacheDirectory )
+{
+  std::string fileName = cacheDirectory + "/" + MODEL_KEY + ".mtmmesh";
+  vtkSmartPointer< vtkPolyData > model = CreateModel();
+  CreateCacheWithModel( cacheDirectory, model );
+  std::streamoff fileSize = static_cast< std::streamoff >( vtksys::SystemTools::FileLength( fileName ) );
+  CHECK( fileSize > 0, "Cache file was not written" );
+
+  if ( !LoadCorruptFile( cacheDirectory, fileSize / 2, -1, "truncated file" )
+    || !LoadCorruptFile( cacheDirectory, -1, fileSize, "point array larger than the file" )
+    // would not fit in memory if the array was allocated before checking the file size
+    || !LoadCorruptFile( cacheDirectory, -1, static_cast< vtkTypeInt64 >( 1 ) << 60, "huge point array" ) )
+  {
+    return false;
+  }
+  return true;
+}
+
+} // namespace
+
+//------------------------------------------------------------------------------
+int vtkSlicerMarkupsToModelMeshCacheTest( int argc, char* argv[] )
+{
+  if ( argc < 2 )
+  {
+    std::cerr << "Usage: vtkSlicerMarkupsToModelMeshCacheTest <temporary directory>" << std::endl;
+    return EXIT_FAILURE;
+  }
+  std::string cacheDirectory = std::string( argv[ 1 ] ) + "/MarkupsToModelMeshCacheTest";
+  bool success = TestStoreAndLoad( cacheDirectory ) && TestCorruptFiles( cacheDirectory )
+    && TestFileOfOtherKey( cacheDirectory ) && TestInvalidCells( cacheDirectory );
+  vtksys::SystemTools::RemoveADirectory( cacheDirectory );
+  if ( !success )
+  {
+    return EXIT_FAILURE;
+  }
+  std::cout << "Test passed" << std::endl;
+  return EXIT_SUCCESS;
+}
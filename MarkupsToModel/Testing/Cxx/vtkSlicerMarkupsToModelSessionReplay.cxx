@@ -0,0 +1,95 @@
+/*==============================================================================
+
+  Program: 3D Slicer
+
+  Portions (c) Copyright Brigham and Women's Hospital (BWH) All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+  ==============================================================================*/
+
+// Replays a session recorded by vtkSlicerMarkupsToModelSessionRecorder without GUI and reports the end-to-end latency
+// of each event and the coalesced and dropped updates as JSON (see vtkSlicerMarkupsToModelSessionReplayer).
+//
+// It is not run as a test. Run it with the test driver:
+//
+//   qSlicerMarkupsToModelModuleCxxTests vtkSlicerMarkupsToModelSessionReplay session.txt [--output report.json]
+//     [--speed 1.0] [--minimum-interaction-update-interval 0.05]
+//
+// --speed 0 replays at maximum speed.
+
+// MarkupsToModel includes
+#include "vtkSlicerMarkupsToModelLogic.h"
+#include "vtkSlicerMarkupsToModelSessionReplayer.h"
+
+// VTK includes
+#include <vtkSmartPointer.h>
+
+// STD includes
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+//------------------------------------------------------------------------------
+int vtkSlicerMarkupsToModelSessionReplay( int argc, char* argv[] )
+{
+  if ( argc < 2 )
+  {
+    std::cerr << "Usage: vtkSlicerMarkupsToModelSessionReplay <recording> [--output report.json] [--speed 1.0]"
+      << " [--minimum-interaction-update-interval seconds]" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  vtkSmartPointer< vtkSlicerMarkupsToModelSessionReplayer > replayer = vtkSmartPointer< vtkSlicerMarkupsToModelSessionReplayer >::New();
+  std::string outputFileName;
+  for ( int argIndex = 2; argIndex < argc; argIndex++ )
+  {
+    std::string arg = argv[ argIndex ];
+    if ( argIndex + 1 >= argc )
+    {
+      std::cerr << "Missing value of argument " << arg << std::endl;
+      return EXIT_FAILURE;
+    }
+    const char* value = argv[ ++argIndex ];
+    if ( arg == "--output" )
+    {
+      outputFileName = value;
+    }
+    else if ( arg == "--speed" )
+    {
+      replayer->SetSpeed( std::atof( value ) );
+    }
+    else if ( arg == "--minimum-interaction-update-interval" )
+    {
+      replayer->GetLogic()->SetMinimumInteractionUpdateInterval( std::atof( value ) );
+    }
+    else
+    {
+      std::cerr << "Unknown argument " << arg << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+
+  if ( !replayer->ReadRecording( argv[ 1 ] ) )
+  {
+    return EXIT_FAILURE;
+  }
+  bool success = replayer->Replay();
+
+  if ( outputFileName.empty() )
+  {
+    std::cout << replayer->GetReportAsJSON();
+  }
+  else if ( !replayer->WriteReport( outputFileName.c_str() ) )
+  {
+    return EXIT_FAILURE;
+  }
+  return ( success ? EXIT_SUCCESS : EXIT_FAILURE );
+}
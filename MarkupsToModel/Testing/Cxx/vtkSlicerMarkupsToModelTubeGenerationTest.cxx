@@ -0,0 +1,191 @@
+/*==============================================================================
+
+  Program: 3D Slicer
+
+  Portions (c) Copyright Brigham and Women's Hospital (BWH) All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+  ==============================================================================*/
+
+// Regression test of vtkSlicerMarkupsToModelTubeGeneration.
+//
+// Tubes must be equivalent to the tubes of vtkTubeFilter around the same polyline (straight and curved),
+// for several numbers of sides, with and without capping: same number of points, same number of triangles
+// (the triangle strips are laid out differently: one per segment instead of one per side), bounds and
+// surface area within tolerance (the rings may be rotated differently around the curve).
+
+// MarkupsToModel includes
+#include "vtkSlicerMarkupsToModelTubeGeneration.h"
+
+// VTK includes
+#include <vtkCellArray.h>
+#include <vtkMassProperties.h>
+#include <vtkMath.h>
+#include <vtkPoints.h>
+#include <vtkPolyData.h>
+#include <vtkSmartPointer.h>
+#include <vtkTriangleFilter.h>
+#include <vtkTubeFilter.h>
+
+// STD includes
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <sstream>
+#include <string>
+
+namespace
+{
+
+//------------------------------------------------------------------------------
+// constants within this file
+const double TUBE_RADIUS = 2.0;
+// surface areas differ slightly at bends, where the rings are rotated differently
+const double SURFACE_AREA_RELATIVE_TOLERANCE = 0.01;
+const double BOUNDS_TOLERANCE_MM = 1.0e-3;
+
+//------------------------------------------------------------------------------
+#define CHECK( condition, message ) \
+  if ( !( condition ) ) \
+  { \
+    std::cerr << "Line " << __LINE__ << ": " << message << std::endl; \
+    return false; \
+  }
+
+//------------------------------------------------------------------------------
+// Number of triangles in the polygons and triangle strips
+vtkIdType GetNumberOfTriangles( vtkPolyData* polyData )
+{
+  vtkIdType numberOfTriangles = 0;
+  vtkCellArray* cellArrays[ 2 ] = { polyData->GetPolys(), polyData->GetStrips() };
+  for ( int cellArrayIndex = 0; cellArrayIndex < 2; cellArrayIndex++ )
+  {
+    vtkCellArray* cells = cellArrays[ cellArrayIndex ];
+    for ( vtkIdType cellIndex = 0; cellIndex < cells->GetNumberOfCells(); cellIndex++ )
+    {
+      vtkIdType numberOfCellPoints = 0;
+      const vtkIdType* cellPoints = NULL;
+      cells->GetCellAtId( cellIndex, numberOfCellPoints, cellPoints );
+      numberOfTriangles += numberOfCellPoints - 2;
+    }
+  }
+  return numberOfTriangles;
+}
+
+//------------------------------------------------------------------------------
+double ComputeSurfaceArea( vtkPolyData* polyData )
+{
+  // vtkMassProperties only accepts triangles
+  vtkSmartPointer< vtkTriangleFilter > triangleFilter = vtkSmartPointer< vtkTriangleFilter >::New();
+  triangleFilter->SetInputData( polyData );
+  vtkSmartPointer< vtkMassProperties > massProperties = vtkSmartPointer< vtkMassProperties >::New();
+  massProperties->SetInputConnection( triangleFilter->GetOutputPort() );
+  massProperties->Update();
+  return massProperties->GetSurfaceArea();
+}
+
+//------------------------------------------------------------------------------
+bool CompareWithTubeFilter( vtkPoints* curvePoints, int tubeNumberOfSides, bool tubeCapping, const std::string& name )
+{
+  vtkSmartPointer< vtkPolyData > tubePolyData = vtkSmartPointer< vtkPolyData >::New();
+  CHECK( vtkSlicerMarkupsToModelTubeGeneration::GenerateTubeModel( curvePoints, tubePolyData, TUBE_RADIUS, tubeNumberOfSides, tubeCapping ),
+    name << ": tube generation failed" );
+
+  vtkIdType numberOfCurvePoints = curvePoints->GetNumberOfPoints();
+  vtkSmartPointer< vtkCellArray > lines = vtkSmartPointer< vtkCellArray >::New();
+  lines->InsertNextCell( numberOfCurvePoints );
+  for ( vtkIdType pointIndex = 0; pointIndex < numberOfCurvePoints; pointIndex++ )
+  {
+    lines->InsertCellPoint( pointIndex );
+  }
+  vtkSmartPointer< vtkPolyData > curvePolyData = vtkSmartPointer< vtkPolyData >::New();
+  curvePolyData->SetPoints( curvePoints );
+  curvePolyData->SetLines( lines );
+  vtkSmartPointer< vtkTubeFilter > tubeFilter = vtkSmartPointer< vtkTubeFilter >::New();
+  tubeFilter->SetInputData( curvePolyData );
+  tubeFilter->SetRadius( TUBE_RADIUS );
+  tubeFilter->SetNumberOfSides( tubeNumberOfSides );
+  tubeFilter->SetCapping( tubeCapping );
+  tubeFilter->Update();
+  vtkPolyData* expectedPolyData = tubeFilter->GetOutput();
+
+  CHECK( tubePolyData->GetNumberOfPoints() == expectedPolyData->GetNumberOfPoints(),
+    name << ": " << tubePolyData->GetNumberOfPoints() << " points, vtkTubeFilter has " << expectedPolyData->GetNumberOfPoints() );
+  CHECK( tubePolyData->GetNumberOfPolys() == expectedPolyData->GetNumberOfPolys(),
+    name << ": " << tubePolyData->GetNumberOfPolys() << " cap polygons, vtkTubeFilter has " << expectedPolyData->GetNumberOfPolys() );
+  CHECK( GetNumberOfTriangles( tubePolyData ) == GetNumberOfTriangles( expectedPolyData ),
+    name << ": " << GetNumberOfTriangles( tubePolyData ) << " triangles, vtkTubeFilter has " << GetNumberOfTriangles( expectedPolyData ) );
+
+  // Vertices of both tubes are on the same circles, so an extreme of the bounds can only differ by the distance
+  // between a circle and its inscribed polygon.
+  double boundsTolerance = TUBE_RADIUS * ( 1.0 - cos( vtkMath::Pi() / tubeNumberOfSides ) ) + BOUNDS_TOLERANCE_MM;
+  double bounds[ 6 ] = { 0.0, 0.0, 0.0, 0.0, 0.0, 0.0 };
+  double expectedBounds[ 6 ] = { 0.0, 0.0, 0.0, 0.0, 0.0, 0.0 };
+  tubePolyData->GetBounds( bounds );
+  expectedPolyData->GetBounds( expectedBounds );
+  for ( int boundIndex = 0; boundIndex < 6; boundIndex++ )
+  {
+    CHECK( fabs( bounds[ boundIndex ] - expectedBounds[ boundIndex ] ) <= boundsTolerance,
+      name << ": bound " << boundIndex << " is " << bounds[ boundIndex ] << ", vtkTubeFilter has " << expectedBounds[ boundIndex ] );
+  }
+
+  double surfaceArea = ComputeSurfaceArea( tubePolyData );
+  double expectedSurfaceArea = ComputeSurfaceArea( expectedPolyData );
+  CHECK( fabs( surfaceArea - expectedSurfaceArea ) <= SURFACE_AREA_RELATIVE_TOLERANCE * expectedSurfaceArea,
+    name << ": surface area " << surfaceArea << " differs from vtkTubeFilter surface area " << expectedSurfaceArea );
+  return true;
+}
+
+//------------------------------------------------------------------------------
+bool TestCompareWithTubeFilter()
+{
+  vtkSmartPointer< vtkPoints > linePoints = vtkSmartPointer< vtkPoints >::New();
+  for ( int pointIndex = 0; pointIndex < 10; pointIndex++ )
+  {
+    linePoints->InsertNextPoint( 5.0 * pointIndex, 2.0 * pointIndex, -3.0 * pointIndex );
+  }
+  // smooth curve, sampled densely as by the curve generator
+  vtkSmartPointer< vtkPoints > helixPoints = vtkSmartPointer< vtkPoints >::New();
+  for ( int pointIndex = 0; pointIndex < 200; pointIndex++ )
+  {
+    double angle = pointIndex * vtkMath::Pi() / 50.0;
+    helixPoints->InsertNextPoint( 30.0 * cos( angle ), 30.0 * sin( angle ), 0.5 * pointIndex );
+  }
+
+  const int tubeNumberOfSidesValues[ 4 ] = { 3, 8, 16, 32 };
+  for ( int sidesIndex = 0; sidesIndex < 4; sidesIndex++ )
+  {
+    for ( int capping = 0; capping < 2; capping++ )
+    {
+      std::ostringstream parameters;
+      parameters << " (" << tubeNumberOfSidesValues[ sidesIndex ] << " sides" << ( capping ? ", capped" : "" ) << ")";
+      if ( !CompareWithTubeFilter( linePoints, tubeNumberOfSidesValues[ sidesIndex ], capping != 0, "line" + parameters.str() )
+        || !CompareWithTubeFilter( helixPoints, tubeNumberOfSidesValues[ sidesIndex ], capping != 0, "helix" + parameters.str() ) )
+      {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+} // namespace
+
+//------------------------------------------------------------------------------
+int vtkSlicerMarkupsToModelTubeGenerationTest( int vtkNotUsed( argc ), char* vtkNotUsed( argv )[] )
+{
+  if ( !TestCompareWithTubeFilter() )
+  {
+    return EXIT_FAILURE;
+  }
+  std::cout << "Test passed" << std::endl;
+  return EXIT_SUCCESS;
+}
@@ -17,6 +17,7 @@
 
 // MarkupsToModel Logic includes
 #include <vtkSlicerMarkupsToModelLogic.h>
+#include <vtkSlicerMarkupsToModelMeshCache.h>
 
 // MarkupsToModel includes
 #include "qSlicerMarkupsToModelModule.h"
@@ -24,6 +25,18 @@
 #include "qSlicerCoreApplication.h"
 #include "qSlicerModuleManager.h"
 
+// Qt includes
+#include <QSettings>
+#include <QTimer>
+
+// VTK includes
+#include <vtkCallbackCommand.h>
+#include <vtkSmartPointer.h>
+
+// Output updates that were postponed during interaction or run in the background are checked this often
+// (only while there are such updates)
+static const int PENDING_UPDATES_CHECK_INTERVAL_MSEC = 10;
+
 //-----------------------------------------------------------------------------
 #if (QT_VERSION < QT_VERSION_CHECK(5, 0, 0))
 #include <QtPlugin>
@@ -36,6 +49,12 @@ class qSlicerMarkupsToModelModulePrivate
 {
 public:
   qSlicerMarkupsToModelModulePrivate();
+
+  static void onPendingUpdateAdded(vtkObject* caller, unsigned long eid, void* clientData, void* callData);
+
+  QTimer PendingUpdatesTimer;
+  vtkSmartPointer<vtkCallbackCommand> PendingUpdateAddedCallback;
+  unsigned long PendingUpdateAddedObserverTag;
 };
 
 //-----------------------------------------------------------------------------
@@ -43,9 +62,21 @@ public:
 
 //-----------------------------------------------------------------------------
 qSlicerMarkupsToModelModulePrivate::qSlicerMarkupsToModelModulePrivate()
+  : PendingUpdateAddedObserverTag(0)
 {
 }
 
+//-----------------------------------------------------------------------------
+void qSlicerMarkupsToModelModulePrivate::onPendingUpdateAdded(vtkObject* vtkNotUsed(caller), unsigned long vtkNotUsed(eid),
+  void* clientData, void* vtkNotUsed(callData))
+{
+  qSlicerMarkupsToModelModulePrivate* self = reinterpret_cast<qSlicerMarkupsToModelModulePrivate*>(clientData);
+  if (!self->PendingUpdatesTimer.isActive())
+  {
+    self->PendingUpdatesTimer.start();
+  }
+}
+
 //-----------------------------------------------------------------------------
 // qSlicerMarkupsToModelModule methods
 
@@ -59,6 +90,12 @@ qSlicerMarkupsToModelModule::qSlicerMarkupsToModelModule(QObject* _parent)
 //-----------------------------------------------------------------------------
 qSlicerMarkupsToModelModule::~qSlicerMarkupsToModelModule()
 {
+  Q_D(qSlicerMarkupsToModelModule);
+  vtkSlicerMarkupsToModelLogic* markupsToModelLogic = vtkSlicerMarkupsToModelLogic::SafeDownCast( this->logic() );
+  if ( markupsToModelLogic && d->PendingUpdateAddedCallback )
+  {
+    markupsToModelLogic->RemoveObserver( d->PendingUpdateAddedObserverTag );
+  }
 }
 
 //-----------------------------------------------------------------------------
@@ -122,6 +159,43 @@ void qSlicerMarkupsToModelModule::setup()
     markupsToModelLogic->MarkupsLogic = vtkSlicerMarkupsLogic::SafeDownCast( markupsModule->logic() );
   }
 
+  // Generated models are cached on disk if a cache directory is set in the application settings
+  QSettings settings;
+  QString meshCacheDirectory = settings.value( "MarkupsToModel/MeshCacheDirectory" ).toString();
+  if ( !meshCacheDirectory.isEmpty() )
+  {
+    vtkSlicerMarkupsToModelMeshCache* meshCache = markupsToModelLogic->GetMeshCache();
+    if ( settings.contains( "MarkupsToModel/MeshCacheMaximumSizeMB" ) )
+    {
+      meshCache->SetMaximumCacheSize( settings.value( "MarkupsToModel/MeshCacheMaximumSizeMB" ).toULongLong() * 1024 * 1024 );
+    }
+    meshCache->SetCacheDirectory( meshCacheDirectory.toUtf8().constData() );
+  }
+
+  Q_D(qSlicerMarkupsToModelModule);
+  d->PendingUpdatesTimer.setInterval( PENDING_UPDATES_CHECK_INTERVAL_MSEC );
+  connect( &d->PendingUpdatesTimer, SIGNAL( timeout() ), this, SLOT( processPendingUpdates() ) );
+  // the timer only runs while the logic has pending updates
+  d->PendingUpdateAddedCallback = vtkSmartPointer<vtkCallbackCommand>::New();
+  d->PendingUpdateAddedCallback->SetCallback( qSlicerMarkupsToModelModulePrivate::onPendingUpdateAdded );
+  d->PendingUpdateAddedCallback->SetClientData( d );
+  d->PendingUpdateAddedObserverTag = markupsToModelLogic->AddObserver(
+    vtkSlicerMarkupsToModelLogic::PendingUpdateAddedEvent, d->PendingUpdateAddedCallback );
+}
+
+//-----------------------------------------------------------------------------
+void qSlicerMarkupsToModelModule::processPendingUpdates()
+{
+  Q_D(qSlicerMarkupsToModelModule);
+  vtkSlicerMarkupsToModelLogic* markupsToModelLogic = vtkSlicerMarkupsToModelLogic::SafeDownCast( this->logic() );
+  if ( markupsToModelLogic )
+  {
+    markupsToModelLogic->ProcessPendingUpdates();
+  }
+  if ( markupsToModelLogic == NULL || !markupsToModelLogic->HasPendingUpdates() )
+  {
+    d->PendingUpdatesTimer.stop();
+  }
 }
 
 //-----------------------------------------------------------------------------
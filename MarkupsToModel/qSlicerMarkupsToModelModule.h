@@ -50,6 +50,10 @@ public:
   virtual QStringList categories()const;
   virtual QStringList dependencies() const;
 
+protected slots:
+  /// Update outputs that were postponed while the user was interacting
+  void processPendingUpdates();
+
 protected:
 
   /// Initialize the module. Register the volumes reader/writer
@@ -17,8 +17,10 @@
 
 // Qt includes
 #include <QtGui>
+#include <QString>
 #include <QDebug>
 #include <QButtonGroup>
+#include <QTimer>
 
 #include "qSlicerApplication.h"
 
@@ -37,8 +39,15 @@
 
 // module includes
 #include "vtkMRMLMarkupsToModelNode.h"
+#include "vtkMRMLMarkupsToModelTracer.h"
 #include "vtkSlicerMarkupsToModelLogic.h"
 
+// STD includes
+#include <cmath>
+
+// Full quality output is generated if a parameter value has not changed for this long
+static const int INTERACTION_IDLE_TIMEOUT_MSEC = 500;
+
 //-----------------------------------------------------------------------------
 /// \ingroup Slicer_QtModules_ExtensionTemplate
 class qSlicerMarkupsToModelModuleWidgetPrivate : public Ui_qSlicerMarkupsToModelModuleWidget
@@ -50,9 +59,16 @@ protected:
 public:
   qSlicerMarkupsToModelModuleWidgetPrivate(qSlicerMarkupsToModelModuleWidget& object);
   vtkSlicerMarkupsToModelLogic* logic() const;
+  // Returns true if the widget sets a parameter whose value changes continuously while it is dragged
+  bool isInteractiveParameterWidget(QObject* widget) const;
 
   QButtonGroup modeButtonGroup;
 
+  // Ends parameter interaction (and so reduced level of detail) when the parameter stops changing
+  QTimer InteractionIdleTimer;
+  // Parameter node that Interacting was set for, it is cleared on this node even if another node is selected meanwhile
+  vtkWeakPointer<vtkMRMLMarkupsToModelNode> InteractingMarkupsToModelNode;
+
   // Observed nodes (to keep GUI up-to-date)
   vtkWeakPointer<vtkMRMLMarkupsToModelNode> MarkupsToModelNode;
   vtkWeakPointer<vtkMRMLMarkupsDisplayNode> MarkupsDisplayNode;
@@ -73,6 +89,15 @@ vtkSlicerMarkupsToModelLogic* qSlicerMarkupsToModelModuleWidgetPrivate::logic()
   return vtkSlicerMarkupsToModelLogic::SafeDownCast(q->logic());
 }
 
+//-----------------------------------------------------------------------------
+bool qSlicerMarkupsToModelModuleWidgetPrivate::isInteractiveParameterWidget(QObject* widget) const
+{
+  return widget != NULL
+    && (widget == this->DelaunayAlphaDoubleSpinBox || widget == this->TubeRadiusDoubleSpinBox
+    || widget == this->KochanekBiasDoubleSpinBox || widget == this->KochanekContinuityDoubleSpinBox
+    || widget == this->KochanekTensionDoubleSpinBox || widget == this->PolynomialSampleWidthDoubleSpinBox);
+}
+
 //-----------------------------------------------------------------------------
 // qSlicerMarkupsToModelModuleWidget methods
 //-----------------------------------------------------------------------------
@@ -107,13 +132,21 @@ void qSlicerMarkupsToModelModuleWidget::setup()
   connect( d->UpdateButton, SIGNAL( clicked() ), this, SLOT( onUpdateButtonClicked() ) );
   connect( d->UpdateButton, SIGNAL( checkBoxToggled( bool ) ), this, SLOT( onUpdateButtonCheckboxToggled( bool ) ) );
 
+  d->InteractionIdleTimer.setSingleShot( true );
+  d->InteractionIdleTimer.setInterval( INTERACTION_IDLE_TIMEOUT_MSEC );
+  connect( &d->InteractionIdleTimer, SIGNAL( timeout() ), this, SLOT( onInteractionIdleTimeout() ) );
+
   connect(d->ButterflySubdivisionCheckBox, SIGNAL(toggled(bool)), this, SLOT(updateMRMLFromGUI()));
   connect(d->ConvexHullCheckBox, SIGNAL(toggled(bool)), this, SLOT(updateMRMLFromGUI()));
   connect(d->CleanDuplicateInputPointsCheckbox, SIGNAL(toggled(bool)), this, SLOT(updateMRMLFromGUI()));
+  connect(d->AsynchronousUpdateCheckBox, SIGNAL(toggled(bool)), this, SLOT(updateMRMLFromGUI()));
+  // show the progress of background updates
+  qvtkConnect(d->logic(), vtkSlicerMarkupsToModelLogic::AsynchronousUpdateStatusModifiedEvent, this, SLOT(updateGUIFromMRML()));
 
   connect(d->ModeClosedSurfaceRadioButton, SIGNAL(clicked()), this, SLOT(updateMRMLFromGUI()));
   connect(d->ModeCurveRadioButton, SIGNAL(clicked()), this, SLOT(updateMRMLFromGUI()));
   connect(d->DelaunayAlphaDoubleSpinBox, SIGNAL(valueChanged(double)), this, SLOT(updateMRMLFromGUI()));
+  connect(d->DelaunayAlphaAutoButton, SIGNAL(clicked()), this, SLOT(onDelaunayAlphaAutoButtonClicked()));
   connect(d->TubeRadiusDoubleSpinBox, SIGNAL(valueChanged(double)), this, SLOT(updateMRMLFromGUI()));
   connect(d->TubeSegmentsSpinBox, SIGNAL(valueChanged(double)), this, SLOT(updateMRMLFromGUI()));
   connect(d->TubeSidesSpinBox, SIGNAL(valueChanged(double)), this, SLOT(updateMRMLFromGUI()));
@@ -185,9 +218,20 @@ void qSlicerMarkupsToModelModuleWidget::onParameterNodeSelectionChanged()
 {
   Q_D(qSlicerMarkupsToModelModuleWidget);
   vtkMRMLMarkupsToModelNode* selectedMarkupsToModelNode = vtkMRMLMarkupsToModelNode::SafeDownCast(d->ParameterNodeSelector->currentNode());
+  if (d->InteractingMarkupsToModelNode != selectedMarkupsToModelNode)
+  {
+    // the previous node would keep generating reduced quality output
+    d->InteractionIdleTimer.stop();
+    this->onInteractionIdleTimeout();
+  }
   qvtkReconnect(d->MarkupsToModelNode, selectedMarkupsToModelNode, vtkCommand::ModifiedEvent, this, SLOT(updateGUIFromMRML()));
   d->MarkupsToModelNode = selectedMarkupsToModelNode;
   d->logic()->UpdateSelectionNode(d->MarkupsToModelNode);
+  // the output of the node is needed now, even if it was not generated at scene load because it was hidden
+  if (d->MarkupsToModelNode && d->logic()->IsOutputModelUpdateDeferred(d->MarkupsToModelNode))
+  {
+    d->logic()->UpdateOutputModel(d->MarkupsToModelNode);
+  }
   this->updateGUIFromMRML();
 }
 
@@ -322,6 +366,46 @@ void qSlicerMarkupsToModelModuleWidget::onInputNodeComboBoxNodeAdded( vtkMRMLNod
   }
 }
 
+//-----------------------------------------------------------------------------
+void qSlicerMarkupsToModelModuleWidget::onInteractionIdleTimeout()
+{
+  Q_D(qSlicerMarkupsToModelModuleWidget);
+  vtkMRMLMarkupsToModelNode* markupsToModelModuleNode = d->InteractingMarkupsToModelNode;
+  d->InteractingMarkupsToModelNode = NULL;
+  if (markupsToModelModuleNode == NULL)
+  {
+    return;
+  }
+  markupsToModelModuleNode->SetInteracting(false);
+}
+
+//-----------------------------------------------------------------------------
+void qSlicerMarkupsToModelModuleWidget::onDelaunayAlphaAutoButtonClicked()
+{
+  Q_D(qSlicerMarkupsToModelModuleWidget);
+  vtkMRMLMarkupsToModelNode* markupsToModelModuleNode = vtkMRMLMarkupsToModelNode::SafeDownCast(d->ParameterNodeSelector->currentNode());
+  if (markupsToModelModuleNode == NULL)
+  {
+    return;
+  }
+  double delaunayAlpha = d->logic()->ComputeAutomaticDelaunayAlpha(markupsToModelModuleNode);
+  // The value is rounded up to the precision of the spinbox (as the spinbox would round it), so that the value written back
+  // from the GUI is the same. A larger alpha still gives a single surface that contains all the points.
+  int decimals = d->DelaunayAlphaDoubleSpinBox->decimals();
+  double precision = pow(10.0, -decimals);
+  double roundedDelaunayAlpha = QString::number(ceil(delaunayAlpha / precision) * precision, 'f', decimals).toDouble();
+  if (roundedDelaunayAlpha < delaunayAlpha)
+  {
+    roundedDelaunayAlpha = QString::number(roundedDelaunayAlpha + precision, 'f', decimals).toDouble();
+  }
+  if (roundedDelaunayAlpha > d->DelaunayAlphaDoubleSpinBox->maximum())
+  {
+    d->DelaunayAlphaDoubleSpinBox->setMaximum(roundedDelaunayAlpha);
+  }
+  // the tetrahedralization is reused, so the output is updated without triangulating the points again
+  markupsToModelModuleNode->SetDelaunayAlpha(roundedDelaunayAlpha);
+}
+
 //-----------------------------------------------------------------------------
 void qSlicerMarkupsToModelModuleWidget::updateMRMLFromGUI()
 {
@@ -334,7 +418,21 @@ void qSlicerMarkupsToModelModuleWidget::updateMRMLFromGUI()
     return;
   }
 
+  // Values change continuously while a spin box is dragged or its arrow is held down,
+  // generate reduced quality output until the value settles. Interacting is set in the same modification
+  // as the new value, so that no full quality output is generated when the interaction starts.
+  bool interactiveParameterChanged = d->isInteractiveParameterWidget(this->sender());
+  if (interactiveParameterChanged && d->InteractingMarkupsToModelNode != markupsToModelModuleNode)
+  {
+    this->onInteractionIdleTimeout();
+  }
+
   int markupsToModelModuleNodeWasModified = markupsToModelModuleNode->StartModify();
+  if (interactiveParameterChanged)
+  {
+    d->InteractingMarkupsToModelNode = markupsToModelModuleNode;
+    markupsToModelModuleNode->SetInteracting(true);
+  }
   if (d->ModeClosedSurfaceRadioButton->isChecked())
   {
     markupsToModelModuleNode->SetModelType(vtkMRMLMarkupsToModelNode::ClosedSurface);
@@ -350,6 +448,7 @@ void qSlicerMarkupsToModelModuleWidget::updateMRMLFromGUI()
   markupsToModelModuleNode->SetAutoUpdateOutput(d->UpdateButton->isChecked());
 
   markupsToModelModuleNode->SetCleanMarkups(d->CleanDuplicateInputPointsCheckbox->isChecked());
+  markupsToModelModuleNode->SetAsynchronousUpdate(d->AsynchronousUpdateCheckBox->isChecked());
   markupsToModelModuleNode->SetDelaunayAlpha(d->DelaunayAlphaDoubleSpinBox->value());
   markupsToModelModuleNode->SetConvexHull(d->ConvexHullCheckBox->isChecked());
   markupsToModelModuleNode->SetButterflySubdivision(d->ButterflySubdivisionCheckBox->isChecked());
@@ -415,6 +514,10 @@ void qSlicerMarkupsToModelModuleWidget::updateMRMLFromGUI()
   }
 
   markupsToModelModuleNode->EndModify(markupsToModelModuleNodeWasModified);
+  if (interactiveParameterChanged)
+  {
+    d->InteractionIdleTimer.start();
+  }
 
   vtkMRMLModelDisplayNode* modelDisplayNode = vtkMRMLModelDisplayNode::SafeDownCast(
     this->GetOutputModelNode() ? this->GetOutputModelNode()->GetDisplayNode() : NULL);
@@ -443,6 +546,7 @@ void qSlicerMarkupsToModelModuleWidget::updateMRMLFromGUI()
 void qSlicerMarkupsToModelModuleWidget::updateGUIFromMRML()
 {
   Q_D(qSlicerMarkupsToModelModuleWidget);
+  MARKUPSTOMODEL_TRACE_SCOPE("ModuleWidget::updateGUIFromMRML", "gui");
 
   vtkMRMLMarkupsToModelNode* markupsToModelModuleNode = vtkMRMLMarkupsToModelNode::SafeDownCast( d->ParameterNodeSelector->currentNode() );
   if (markupsToModelModuleNode == NULL)
@@ -497,9 +601,16 @@ void qSlicerMarkupsToModelModuleWidget::updateGUIFromMRML()
     d->UpdateButton->setCheckable(false);
     d->UpdateButton->blockSignals(wasBlocked);
   }
+  int asynchronousUpdateStatus = d->logic()->GetAsynchronousUpdateStatus(markupsToModelModuleNode);
+  if (asynchronousUpdateStatus == vtkSlicerMarkupsToModelLogic::AsynchronousUpdatePending
+    || asynchronousUpdateStatus == vtkSlicerMarkupsToModelLogic::AsynchronousUpdateRunning)
+  {
+    d->UpdateButton->setText(d->UpdateButton->text() + tr(" (updating...)"));
+  }
 
   // Advanced options
   d->CleanDuplicateInputPointsCheckbox->setChecked(markupsToModelModuleNode->GetCleanMarkups());
+  d->AsynchronousUpdateCheckBox->setChecked(markupsToModelModuleNode->GetAsynchronousUpdate());
   // closed surface
   d->ButterflySubdivisionCheckBox->setChecked(markupsToModelModuleNode->GetButterflySubdivision());
   d->DelaunayAlphaDoubleSpinBox->setValue(markupsToModelModuleNode->GetDelaunayAlpha());
@@ -698,6 +809,7 @@ void qSlicerMarkupsToModelModuleWidget::blockAllSignals(bool block)
 
   // advanced options
   d->CleanDuplicateInputPointsCheckbox->blockSignals(block);
+  d->AsynchronousUpdateCheckBox->blockSignals(block);
   // closed surface options
   d->ButterflySubdivisionCheckBox->blockSignals(block);
   d->DelaunayAlphaDoubleSpinBox->blockSignals(block);
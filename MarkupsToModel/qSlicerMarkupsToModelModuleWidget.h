@@ -61,6 +61,10 @@ protected slots:
 
   void updateMRMLFromGUI();
 
+  void onInteractionIdleTimeout();
+
+  void onDelaunayAlphaAutoButtonClicked();
+
   void updateGUIFromMRML();
 
   void blockAllSignals(bool block);